@@ -0,0 +1,66 @@
+// Tests the latency percentiles, interval reports and fixed rate mode of benchRun.
+(function() {
+    "use strict";
+    var t = db.bench_latency_percentiles;
+    t.drop();
+    assert.writeOK(t.insert({_id: 1, x: 1}));
+
+    function runBench(extraArgs) {
+        var benchArgs = {
+            ops: [
+                {op: "findOne", ns: t.getFullName(), query: {_id: 1}},
+                {op: "update", ns: t.getFullName(), query: {_id: 1}, update: {$inc: {x: 1}}}
+            ],
+            parallel: 2,
+            seconds: 2,
+            host: db.getMongo().host
+        };
+        if (jsTest.options().auth) {
+            benchArgs['db'] = 'admin';
+            benchArgs['username'] = jsTest.options().adminUser;
+            benchArgs['password'] = jsTest.options().adminPassword;
+        }
+        Object.extend(benchArgs, extraArgs);
+        return benchRun(benchArgs);
+    }
+
+    function checkPercentiles(percentiles, res) {
+        assert.gt(percentiles.count, 0, tojson(res));
+        assert.lte(percentiles.p50, percentiles.p95, tojson(res));
+        assert.lte(percentiles.p95, percentiles.p99, tojson(res));
+        assert.lte(percentiles.p99, percentiles.p999, tojson(res));
+        assert.lte(percentiles.p999, percentiles.max, tojson(res));
+    }
+
+    var res = runBench({});
+    ["findOne", "update"].forEach(function(op) {
+        checkPercentiles(res.latencyPercentilesMicros[op], res);
+    });
+    assert.eq(undefined, res.latencyPercentilesMicros.insert, tojson(res));
+    assert.eq(undefined, res.intervals, tojson(res));
+
+    // At a fixed rate, the throughput does not exceed the target, and the statistics of each
+    // interval are reported.
+    res = runBench({opsPerSecond: 100, reportIntervalSeconds: 0.5});
+    assert.lte(res["totalOps/s"], 100 * 1.2, tojson(res));
+    assert.gt(res["totalOps/s"], 0, tojson(res));
+    checkPercentiles(res.latencyPercentilesMicros.findOne, res);
+    assert.gte(res.intervals.length, 2, tojson(res));
+    res.intervals.forEach(function(interval, i) {
+        assert.gt(interval.seconds, 0, tojson(res));
+        if (i > 0) {
+            assert.gt(interval.seconds, res.intervals[i - 1].seconds, tojson(res));
+        }
+        assert.lte(interval["totalOps/s"], 100 * 1.5, tojson(res));
+        if (interval.findOne) {
+            checkPercentiles(interval.findOne, res);
+        }
+    });
+
+    assert.throws(function() {
+        runBench({opsPerSecond: -1});
+    });
+    assert.throws(function() {
+        runBench({reportIntervalSeconds: -1});
+    });
+})();
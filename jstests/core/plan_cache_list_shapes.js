@@ -48,3 +48,21 @@ assert.eq({query: {a: 1, b: 1}, sort: {a: -1}, projection: {_id: 1, a: 1}}, shap
 assert.eq(1, t.find({a: 1, b: 1}).itcount(), 'unexpected document count');
 shapes = getShapes();
 assert.eq(2, shapes.length, 'unexpected number of shapes in planCacheListQueryShapes result');
+
+// With 'stats', each shape also reports statistics about the executions of queries of its shape.
+for (var i = 0; i < 3; i++) {
+    assert.eq(1, t.find({a: 1, b: 1}).itcount(), 'unexpected document count');
+}
+var res = t.runCommand('planCacheListQueryShapes', {stats: true});
+assert.commandWorked(res, 'planCacheListQueryShapes with stats failed');
+shapes = res.shapes.filter(function(shape) {
+    return bsonWoCompare(shape.sort, {}) == 0;
+});
+assert.eq(1, shapes.length, tojson(res));
+assert.eq('string', typeof(shapes[0].queryHash), tojson(shapes[0]));
+var stats = shapes[0].stats;
+assert.gte(stats.executions, 3, tojson(stats));
+assert.gte(stats.totalKeysExamined, stats.executions, tojson(stats));
+assert.eq(stats.executions, stats.latencyHistogram.reduce(function(sum, bucket) {
+    return sum + bucket.count;
+}, 0), tojson(stats));
@@ -98,7 +98,7 @@ for(i = 0; i < numRecords; i++) {
 checkStats("commands", numRecords);
 
 for(key in lastTop) {
-   if (!(key in checked)) {
+   if (!(key in checked) && key != "latencyStats") {
       printjson({key:key, stats:diffTop(key)});
    }
 }
@@ -0,0 +1,80 @@
+// Tests that journal sections written with each journal compressor are recovered after an unclean
+// shutdown, including a journal whose compressor changed while it was written, that compressors
+// other than snappy must be allowed at startup, and that the dur serverStatus section reports the
+// latencies of the group commit phases.
+(function() {
+    "use strict";
+    var path = MongoRunner.dataPath + "journal_compressor";
+
+    function runMongod(compressor, restart, allowNew) {
+        return MongoRunner.runMongod({
+            restart: restart,
+            cleanData: !restart,
+            dbpath: path,
+            journal: "",
+            smallfiles: "",
+            setParameter: {journalCompressor: compressor, journalAllowNewCompressors: allowNew}
+        });
+    }
+
+    function startMongod(compressor, restart) {
+        var conn = runMongod(compressor, restart, true);
+        assert.neq(null, conn, "mongod failed to start with journalCompressor " + compressor);
+        return conn;
+    }
+
+    // Older versions cannot recover sections that are not compressed with snappy, so the other
+    // compressors must be allowed explicitly.
+    resetDbpath(path);
+    assert.eq(null, runMongod("zlib", false, false), "mongod started with journalCompressor zlib");
+    var snappyOnly = runMongod("snappy", false, false);
+    assert.neq(null, snappyOnly, "mongod failed to start with journalCompressor snappy");
+    assert.commandFailedWithCode(
+        snappyOnly.getDB("admin").runCommand({setParameter: 1, journalCompressor: "none"}),
+        ErrorCodes.BadValue);
+    MongoRunner.stopMongod(snappyOnly);
+
+    // Inserts 'n' documents tagged with 'compressor', each in its own journaled commit.
+    function insertJournaled(conn, compressor, n) {
+        var coll = conn.getDB("test").journal_compressor;
+        var pad = new Array(500).join("x");
+        for (var i = 0; i < n; i++) {
+            assert.writeOK(
+                coll.insert({compressor: compressor, i: i, pad: pad}, {writeConcern: {j: true}}));
+        }
+    }
+
+    ["none", "snappy", "zlib"].forEach(function(compressor) {
+        jsTest.log("Testing journalCompressor " + compressor);
+        resetDbpath(path);
+        var conn = startMongod(compressor, false);
+        var admin = conn.getDB("admin");
+        assert.eq(compressor,
+                  assert.commandWorked(admin.runCommand({getParameter: 1, journalCompressor: 1}))
+                      .journalCompressor);
+
+        insertJournaled(conn, compressor, 50);
+
+        var latency = assert.commandWorked(admin.serverStatus()).dur.latencyMicros;
+        ["prepLogBuffer", "compress", "writeToJournal", "fsync", "writeToDataFiles"].forEach(
+            function(phase) {
+                assert.gt(latency[phase].count, 0, phase + ": " + tojson(latency));
+                assert(Array.isArray(latency[phase].histogram), tojson(latency));
+            });
+
+        // Change the compressor while the journal is being written.
+        var other = compressor === "zlib" ? "none" : "zlib";
+        assert.commandWorked(admin.runCommand({setParameter: 1, journalCompressor: other}));
+        insertJournaled(conn, other, 50);
+        assert.commandFailed(admin.runCommand({setParameter: 1, journalCompressor: "lz4"}));
+
+        MongoRunner.stopMongod(conn.port, /*signal*/ 9);
+
+        // Recovery replays the sections of both compressors.
+        conn = startMongod("snappy", true);
+        var coll = conn.getDB("test").journal_compressor;
+        assert.eq(50, coll.find({compressor: compressor}).itcount());
+        assert.eq(50, coll.find({compressor: other}).itcount());
+        MongoRunner.stopMongod(conn.port);
+    });
+})();
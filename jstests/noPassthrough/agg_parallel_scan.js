@@ -0,0 +1,123 @@
+// Tests that an aggregation whose $group reads a collection scan may split the scan among several
+// threads, and that it gets the same results as when the collection is scanned by one thread.
+(function() {
+    "use strict";
+    var conn = MongoRunner.runMongod({
+        setParameter: {
+            internalDocumentSourceParallelScanMaxWorkers: 4,
+            internalDocumentSourceParallelScanMinRecords: 1000
+        }
+    });
+    assert.neq(null, conn, "mongod failed to start");
+
+    var testDB = conn.getDB("test");
+    var coll = testDB.agg_parallel_scan;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 20000; i++) {
+        bulk.insert({a: i % 37, b: i, tags: ["x", "y", "z"].slice(0, i % 4)});
+    }
+    assert.writeOK(bulk.execute());
+
+    function runAgg(pipeline, maxParallelism) {
+        var cmd = {aggregate: coll.getName(), pipeline: pipeline, cursor: {}};
+        if (maxParallelism !== undefined) {
+            cmd.maxParallelism = maxParallelism;
+        }
+        return new DBCommandCursor(conn, assert.commandWorked(testDB.runCommand(cmd))).toArray();
+    }
+
+    function getScanMetrics() {
+        return assert.commandWorked(testDB.adminCommand({serverStatus: 1}))
+            .metrics.aggregation.parallelScan;
+    }
+
+    var pipelines = [
+        [{$group: {_id: "$a", count: {$sum: 1}, total: {$sum: "$b"}, avg: {$avg: "$b"}}}],
+        [
+          {$match: {b: {$gte: 5000}}},
+          {$project: {a: 1, b: 1}},
+          {$group: {_id: null, min: {$min: "$b"}, max: {$max: "$b"}, count: {$sum: 1}}}
+        ],
+        [
+          {$unwind: "$tags"},
+          {$group: {_id: "$tags", count: {$sum: 1}, as: {$addToSet: "$a"}}},
+          {$project: {count: 1, numAs: {$size: "$as"}}}
+        ],
+    ];
+
+    pipelines.forEach(function(pipeline) {
+        pipeline = pipeline.concat([{$sort: {_id: 1}}]);
+
+        var before = getScanMetrics();
+        var parallel = runAgg(pipeline);
+        var after = getScanMetrics();
+        assert.eq(before.scans + 1, after.scans, tojson(pipeline));
+        assert.gt(after.workers, before.workers, tojson(pipeline));
+
+        var serial = runAgg(pipeline, 1);
+        assert.eq(after.scans, getScanMetrics().scans, tojson(pipeline));
+        assert.eq(serial, parallel, tojson(pipeline));
+    });
+
+    // The workers share the memory limit of one $group, and spill or fail on it like a $group.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalDocumentSourceGroupMaxMemoryBytes: 1000000}));
+    var manyGroups = [{$group: {_id: "$b", count: {$sum: 1}}}, {$sort: {_id: 1}}];
+    var res = testDB.runCommand({aggregate: coll.getName(), pipeline: manyGroups, cursor: {}});
+    assert.commandFailedWithCode(res, 16945);
+    var spilled = new DBCommandCursor(conn,
+                                      assert.commandWorked(testDB.runCommand({
+                                          aggregate: coll.getName(),
+                                          pipeline: manyGroups,
+                                          cursor: {},
+                                          allowDiskUse: true
+                                      }))).toArray();
+    assert.eq(20000, spilled.length);
+    assert.commandWorked(testDB.adminCommand(
+        {setParameter: 1, internalDocumentSourceGroupMaxMemoryBytes: 100 * 1024 * 1024}));
+
+    // Explain shows the scan and the stages each worker runs.
+    var explain = assert.commandWorked(testDB.runCommand({
+        aggregate: coll.getName(),
+        pipeline: [{$match: {a: 1}}, {$group: {_id: "$b"}}],
+        explain: true
+    }));
+    var scan = explain.stages[0].$parallelCursor;
+    assert(scan, tojson(explain));
+    assert.eq({a: 1}, scan.query, tojson(explain));
+    assert.eq(4, scan.maxWorkers, tojson(explain));
+    assert.eq(1, scan.workerPipeline.length, tojson(explain));
+    assert(explain.stages[1].$group, tojson(explain));
+
+    // Pipelines with a blocking stage before the $group, queries using $where, and groups whose
+    // results depend on the order of the documents are not split.
+    var before = getScanMetrics();
+    runAgg([{$sort: {b: 1}}, {$group: {_id: "$a"}}]);
+    runAgg([{$match: {$where: "this.a == 1"}}, {$group: {_id: "$a"}}]);
+    runAgg([{$group: {_id: "$a", first: {$first: "$b"}}}]);
+    runAgg([{$group: {_id: "$a", last: {$last: "$b"}}}]);
+    runAgg([{$group: {_id: "$a", bs: {$push: "$b"}}}]);
+    assert.eq(before.scans, getScanMetrics().scans);
+
+    // The parallelCollectionScan command still gets the collection's own partitioning, which is a
+    // single cursor on WiredTiger, rather than the ranges used for aggregation.
+    res = assert.commandWorked(
+        testDB.runCommand({parallelCollectionScan: coll.getName(), numCursors: 4}));
+    if (testDB.serverStatus().storageEngine.name == "wiredTiger") {
+        assert.eq(1, res.cursors.length, tojson(res));
+    }
+    var total = 0;
+    res.cursors.forEach(function(cursor) {
+        total += new DBCommandCursor(conn, cursor).itcount();
+    });
+    assert.eq(20000, total);
+
+    assert.commandFailed(testDB.runCommand(
+        {aggregate: coll.getName(), pipeline: [], cursor: {}, maxParallelism: 0}));
+    assert.commandFailed(testDB.runCommand(
+        {aggregate: coll.getName(), pipeline: [], cursor: {}, maxParallelism: "2"}));
+
+    MongoRunner.stopMongod(conn);
+})();
@@ -0,0 +1,88 @@
+// Tests that a foreground index build may scan the collection and sort its keys with several
+// threads, and that the indexes it builds hold the same keys as indexes built by one thread.
+(function() {
+    "use strict";
+    var conn = MongoRunner.runMongod({
+        setParameter: {
+            internalIndexBuildMaxWorkers: 4,
+            internalIndexBuildParallelMinRecords: 1000,
+            maxIndexBuildMemoryUsageMegabytes: 50
+        }
+    });
+    assert.neq(null, conn, "mongod failed to start");
+
+    var testDB = conn.getDB("test");
+    var coll = testDB.index_build_parallel;
+    coll.drop();
+
+    // Only storage engines with document level locking build indexes in parallel.
+    var expectParallel =
+        assert.commandWorked(testDB.serverStatus()).storageEngine.name === "wiredTiger";
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 20000; i++) {
+        bulk.insert({a: i % 37, b: i, c: -i, tags: ["x", "y", "z"].slice(0, i % 4)});
+    }
+    assert.writeOK(bulk.execute());
+
+    function getBuildMetrics() {
+        return assert.commandWorked(testDB.adminCommand({serverStatus: 1}))
+            .metrics.indexBuild.parallel;
+    }
+
+    // Returns the index keys of 'indexName' by scanning it with a covered projection.
+    function getKeys(keyPattern, indexName) {
+        var projection = {_id: 0};
+        Object.keys(keyPattern).forEach(function(field) {
+            projection[field] = 1;
+        });
+        return coll.find({}, projection).hint(indexName).toArray();
+    }
+
+    // Several indexes are built together, including multikey and partial indexes.
+    var before = getBuildMetrics();
+    assert.commandWorked(testDB.runCommand({
+        createIndexes: coll.getName(),
+        indexes: [
+            {key: {a: 1, b: -1}, name: "a_1_b_-1"},
+            {key: {b: 1}, name: "b_1", unique: true},
+            {key: {tags: 1}, name: "tags_1"},
+            {key: {c: 1}, name: "c_1", partialFilterExpression: {a: {$lt: 5}}}
+        ]
+    }));
+    var after = getBuildMetrics();
+    if (expectParallel) {
+        assert.eq(before.builds + 1, after.builds, tojson(after));
+        assert.gt(after.workers, before.workers, tojson(after));
+    }
+    assert.commandWorked(coll.validate(true));
+
+    assert.eq(20000, coll.find().hint("b_1").itcount());
+    assert.eq(10000, coll.find({tags: "y"}).hint("tags_1").itcount());
+    assert.eq(coll.find({a: {$lt: 5}}).itcount(), coll.find({a: {$lt: 5}}).hint("c_1").itcount());
+
+    // Rebuilding an index with parallel builds turned off gives the same keys in the same order.
+    var parallelKeys = getKeys({a: 1, b: -1}, "a_1_b_-1");
+    assert.eq(20000, parallelKeys.length);
+    assert.commandWorked(coll.dropIndex("a_1_b_-1"));
+    assert.commandWorked(testDB.adminCommand({setParameter: 1, internalIndexBuildMaxWorkers: 1}));
+    before = getBuildMetrics();
+    assert.commandWorked(coll.createIndex({a: 1, b: -1}));
+    assert.eq(before.builds, getBuildMetrics().builds);
+    assert.eq(parallelKeys, getKeys({a: 1, b: -1}, "a_1_b_-1"));
+    assert.commandWorked(testDB.adminCommand({setParameter: 1, internalIndexBuildMaxWorkers: 4}));
+
+    // Duplicates found by different threads still fail a unique index build.
+    assert.writeOK(coll.insert({a: 1, b: 20001, d: 1}));
+    assert.writeOK(coll.insert({a: 2, b: 20002, d: 1}));
+    var res = coll.createIndex({d: 1}, {unique: true, sparse: true});
+    assert.commandFailedWithCode(res, ErrorCodes.DuplicateKey);
+    res = coll.createIndex({a: 1}, {unique: true});
+    assert.commandFailedWithCode(res, ErrorCodes.DuplicateKey);
+    assert.eq(5, coll.getIndexes().length);
+
+    assert.commandFailed(
+        testDB.adminCommand({setParameter: 1, maxIndexBuildMemoryUsageMegabytes: 10}));
+
+    MongoRunner.stopMongod(conn);
+})();
@@ -0,0 +1,115 @@
+// Tests that the background index statistics sampler samples indexes, persists the statistics in
+// local.system.indexStatistics, reports them in collStats, reloads them after a restart and
+// uses them to estimate counts.
+(function() {
+    "use strict";
+    var dbpath = MongoRunner.dataPath + "index_statistics_sampler";
+    resetDbpath(dbpath);
+
+    var options = {
+        dbpath: dbpath,
+        noCleanData: true,
+        setParameter: {
+            internalQueryIndexStatisticsSamplerEnabled: true,
+            internalQueryIndexStatisticsSamplerSleepSecs: 1
+        }
+    };
+    var conn = MongoRunner.runMongod(options);
+    assert.neq(null, conn, "mongod failed to start");
+
+    var testDB = conn.getDB("test");
+    var coll = testDB.index_statistics_sampler;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 5000; i++) {
+        bulk.insert({a: i, b: i % 10});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+
+    function getIndexStatistics(indexName) {
+        var stats = assert.commandWorked(testDB.runCommand({collStats: coll.getName()}));
+        return stats.indexStatistics[indexName];
+    }
+
+    assert.soon(function() {
+        return getIndexStatistics("a_1") !== undefined;
+    }, "index a_1 was never sampled");
+
+    var info = getIndexStatistics("a_1");
+    assert.eq(5000, info.numRecordsAtSample, tojson(info));
+    assert.eq(5000, info.numKeys, tojson(info));
+    assert.eq(false, info.stale, tojson(info));
+
+    function getPersisted() {
+        return conn.getDB("local").system.indexStatistics.findOne(
+            {_id: {ns: coll.getFullName(), index: "a_1"}});
+    }
+
+    var persisted = getPersisted();
+    assert.neq(null, persisted);
+    assert.eq(info.sampledAt, persisted.sampledAt, tojson(persisted));
+
+    // A range over the leading field of a sampled index is estimated without running the query.
+    var res = assert.commandWorked(
+        testDB.runCommand({count: coll.getName(), query: {a: {$lt: 1000}}, estimate: true}));
+    assert.eq(true, res.estimated, tojson(res));
+    assert.gte(res.n, 900, tojson(res));
+    assert.lte(res.n, 1100, tojson(res));
+
+    // A negative limit bounds the estimate like its absolute value, as it does an exact count.
+    res = assert.commandWorked(testDB.runCommand(
+        {count: coll.getName(), query: {a: {$lt: 1000}}, limit: -10, estimate: true}));
+    assert.eq(true, res.estimated, tojson(res));
+    assert.eq(10, res.n, tojson(res));
+
+    // Other predicates are still counted exactly.
+    res = assert.commandWorked(
+        testDB.runCommand({count: coll.getName(), query: {b: 3}, estimate: true}));
+    assert.eq(undefined, res.estimated, tojson(res));
+    assert.eq(500, res.n, tojson(res));
+
+    // Bounds on trailing fields of a compound index are not reflected in its statistics.
+    assert.commandWorked(coll.ensureIndex({b: 1, a: 1}));
+    assert.soon(function() {
+        return getIndexStatistics("b_1_a_1") !== undefined;
+    }, "index b_1_a_1 was never sampled");
+    res = assert.commandWorked(testDB.runCommand({
+        count: coll.getName(),
+        query: {b: 3, a: {$lt: 1000}},
+        hint: {b: 1, a: 1},
+        estimate: true
+    }));
+    assert.eq(undefined, res.estimated, tojson(res));
+    assert.eq(100, res.n, tojson(res));
+
+    // Plans that combine several scans are counted exactly.
+    res = assert.commandWorked(testDB.runCommand({
+        count: coll.getName(),
+        query: {$or: [{a: {$lt: 1000}}, {b: 3, a: {$gte: 4000}}]},
+        estimate: true
+    }));
+    assert.eq(undefined, res.estimated, tojson(res));
+    assert.eq(1100, res.n, tojson(res));
+
+    // Statistics survive a restart.
+    MongoRunner.stopMongod(conn);
+    conn = MongoRunner.runMongod(options);
+    assert.neq(null, conn, "mongod failed to restart");
+    testDB = conn.getDB("test");
+    coll = testDB.index_statistics_sampler;
+
+    assert.soon(function() {
+        return getIndexStatistics("a_1") !== undefined;
+    }, "statistics of index a_1 were not reloaded");
+    assert.eq(info.sampledAt, getIndexStatistics("a_1").sampledAt);
+
+    // Statistics of dropped indexes are removed.
+    assert.commandWorked(coll.dropIndex({a: 1}));
+    assert.soon(function() {
+        return getPersisted() === null;
+    }, "statistics of dropped index a_1 were not removed");
+
+    MongoRunner.stopMongod(conn);
+})();
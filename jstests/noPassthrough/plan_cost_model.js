@@ -0,0 +1,59 @@
+// Tests that with the cost model enabled, a query whose candidate plans differ widely in
+// estimated cost runs the cheapest one without a trial run, and that close calls still go
+// through the multi-planner.
+(function() {
+    "use strict";
+    // Planning samples at most internalQueryCostModelMaxKeysScannedInline keys of each index, so
+    // raise it to sample the whole of these small indexes.
+    var conn = MongoRunner.runMongod({
+        setParameter: {
+            internalQueryPlannerEnableCostModel: true,
+            internalQueryCostModelMaxKeysScannedInline: 10000
+        }
+    });
+    assert.neq(null, conn, "mongod failed to start");
+
+    var testDB = conn.getDB("test");
+    var coll = testDB.plan_cost_model;
+    coll.drop();
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 5000; i++) {
+        bulk.insert({a: i, b: i % 2, c: i % 100});
+    }
+    assert.writeOK(bulk.execute());
+    assert.commandWorked(coll.ensureIndex({a: 1}));
+    assert.commandWorked(coll.ensureIndex({b: 1}));
+    assert.commandWorked(coll.ensureIndex({c: 1}));
+
+    function queryPlanner(query) {
+        var explain = coll.find(query).explain("queryPlanner");
+        return explain.queryPlanner;
+    }
+
+    // 'a' matches one document and 'b' half of the collection.
+    var planner = queryPlanner({a: 17, b: 1});
+    assert.eq(0, planner.rejectedPlans.length, tojson(planner));
+    assert.eq("IXSCAN", planner.winningPlan.inputStage.stage, tojson(planner));
+    assert.eq({a: 1}, planner.winningPlan.inputStage.keyPattern, tojson(planner));
+    assert.eq(1, coll.find({a: 17, b: 1}).itcount());
+
+    // 'a' and 'c' are about as selective as each other.
+    planner = queryPlanner({a: {$gte: 1000, $lt: 1050}, c: 7});
+    assert.gt(planner.rejectedPlans.length, 0, tojson(planner));
+
+    // A margin this wide always defers to the trial run.
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryPlannerCostModelMargin: 1000}));
+    planner = queryPlanner({a: 17, b: 1});
+    assert.gt(planner.rejectedPlans.length, 0, tojson(planner));
+
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryPlannerEnableCostModel: false}));
+    assert.commandWorked(
+        testDB.adminCommand({setParameter: 1, internalQueryPlannerCostModelMargin: 1.0}));
+    planner = queryPlanner({a: 17, b: 1});
+    assert.gt(planner.rejectedPlans.length, 0, tojson(planner));
+
+    MongoRunner.stopMongod(conn);
+})();
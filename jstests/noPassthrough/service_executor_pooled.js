@@ -0,0 +1,38 @@
+// Tests that mongod services connections correctly when they are multiplexed over a pool of
+// worker threads with the "pooled" service executor.
+(function() {
+    "use strict";
+    var conn = MongoRunner.runMongod({setParameter: "serviceExecutor=pooled"});
+    assert.neq(null, conn, "mongod failed to start with the pooled service executor");
+
+    var coll = conn.getDB("test").service_executor_pooled;
+    coll.drop();
+
+    // Open many more connections than there are worker threads, and interleave requests on them
+    // so that each connection is serviced by several different workers.
+    var conns = [];
+    for (var i = 0; i < 50; i++) {
+        conns.push(new Mongo(conn.host));
+    }
+    for (var round = 0; round < 5; round++) {
+        conns.forEach(function(c, i) {
+            assert.writeOK(c.getDB("test").service_executor_pooled.insert({conn: i, round: round}));
+        });
+    }
+    assert.eq(250, coll.count());
+
+    // Per-connection state such as the last error must follow the connection between workers.
+    conns.forEach(function(c, i) {
+        var testDB = c.getDB("test");
+        testDB.service_executor_pooled.insert({_id: i});
+        testDB.service_executor_pooled.insert({_id: i});
+        assert.eq(11000, testDB.getLastErrorObj().code);
+    });
+
+    var metrics = assert.commandWorked(conn.getDB("admin").serverStatus()).metrics;
+    assert(metrics.serviceExecutor, tojson(metrics));
+    assert.gte(metrics.serviceExecutor.sessionsIdle, 50, tojson(metrics.serviceExecutor));
+    assert.eq(1, metrics.serviceExecutor.sessionsInProgress, tojson(metrics.serviceExecutor));
+
+    MongoRunner.stopMongod(conn);
+})();
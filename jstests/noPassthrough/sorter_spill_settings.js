@@ -0,0 +1,34 @@
+// Tests the server parameters that control how Sorters spill to disk, and that their spill
+// statistics are reported by serverStatus.
+(function() {
+    "use strict";
+    var conn = MongoRunner.runMongod({setParameter: {sorterSpillCompressor: "zlib"}});
+    assert.neq(null, conn, "mongod failed to start");
+    var admin = conn.getDB("admin");
+
+    var res = assert.commandWorked(admin.runCommand({getParameter: 1, sorterSpillCompressor: 1}));
+    assert.eq("zlib", res.sorterSpillCompressor);
+
+    assert.commandWorked(admin.runCommand({setParameter: 1, sorterSpillCompressor: "none"}));
+    assert.commandWorked(admin.runCommand({setParameter: 1, sorterSpillCompressor: "snappy"}));
+    assert.commandFailed(admin.runCommand({setParameter: 1, sorterSpillCompressor: "lz4"}));
+    assert.commandFailed(admin.runCommand({setParameter: 1, sorterSpillCompressor: 1}));
+    res = assert.commandWorked(admin.runCommand({getParameter: 1, sorterSpillCompressor: 1}));
+    assert.eq("snappy", res.sorterSpillCompressor);
+
+    assert.commandWorked(admin.runCommand({setParameter: 1, sorterSpillReadAhead: false}));
+
+    var spill = assert.commandWorked(admin.serverStatus()).metrics.sorter.spill;
+    ["blocksWritten",
+     "bytesWritten",
+     "rawBytesWritten",
+     "writeMicros",
+     "blocksRead",
+     "bytesRead",
+     "readMicros",
+     "blocksReadAhead"].forEach(function(field) {
+        assert(spill.hasOwnProperty(field), tojson(spill));
+    });
+
+    MongoRunner.stopMongod(conn);
+})();
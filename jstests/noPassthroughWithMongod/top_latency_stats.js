@@ -0,0 +1,50 @@
+// Tests that top and collStats report the latency histograms of the reads, writes and commands on a
+// collection, and that dropping the collection resets them.
+(function() {
+    "use strict";
+    var testDB = db.getSiblingDB("top_latency_stats");
+    var coll = testDB.coll;
+    coll.drop();
+
+    function getLatencyStats() {
+        var stats = assert.commandWorked(testDB.runCommand({collStats: coll.getName()}));
+        var top = assert.commandWorked(testDB.adminCommand("top")).totals[coll.getFullName()];
+        assert.eq(stats.latencyStats.writes.count, top.latencyStats.writes.count, tojson(top));
+        return stats.latencyStats;
+    }
+
+    for (var i = 0; i < 20; i++) {
+        assert.writeOK(coll.insert({_id: i}));
+    }
+    for (i = 0; i < 10; i++) {
+        assert.writeOK(coll.update({_id: i}, {$set: {x: i}}));
+    }
+    for (i = 0; i < 10; i++) {
+        assert.eq(1, coll.find({_id: i}).itcount());
+    }
+    assert.eq(20, coll.find().batchSize(2).itcount());
+    for (i = 0; i < 5; i++) {
+        assert.eq(20, coll.count());
+    }
+
+    var latency = getLatencyStats();
+    assert.gte(latency.writes.count, 30, tojson(latency));
+    assert.gte(latency.reads.count, 11, tojson(latency));
+    assert.gte(latency.commands.count, 5, tojson(latency));
+    ["reads", "writes", "commands"].forEach(function(type) {
+        var histogram = latency[type].histogram;
+        assert(Array.isArray(histogram), tojson(latency));
+        var count = 0;
+        histogram.forEach(function(bucket) {
+            count += bucket.count;
+        });
+        assert.eq(latency[type].count, count, tojson(latency));
+    });
+
+    assert(coll.drop());
+    assert.writeOK(coll.insert({_id: 0}));
+    latency = getLatencyStats();
+    assert.gte(latency.writes.count, 1, tojson(latency));
+    assert.lt(latency.writes.count, 30, tojson(latency));
+    assert.eq(0, latency.reads.count, tojson(latency));
+})();
@@ -0,0 +1,43 @@
+// Tests that the size of the oplog applier's writer pool can be set at startup and changed at
+// runtime, and that the change takes effect for the next batch.
+(function() {
+    "use strict";
+    var name = "repl_writer_thread_count";
+    var replTest = new ReplSetTest({name: name,
+                                    nodes: 2,
+                                    oplogSize: 5,
+                                    nodeOptions: {setParameter: "replWriterThreadCount=4"}});
+    replTest.startSet();
+    replTest.initiate();
+
+    var master = replTest.getMaster();
+    var slave = replTest.liveNodes.slaves[0];
+    var slaveAdmin = slave.getDB("admin");
+
+    function writeAndGetWriterStats() {
+        for (var i = 0; i < 100; i++) {
+            assert.writeOK(master.getDB("test").foo.insert({x: i}));
+        }
+        replTest.awaitReplication();
+        var metrics = assert.commandWorked(slaveAdmin.serverStatus()).metrics;
+        return metrics.repl.apply.writers;
+    }
+
+    var res = assert.commandWorked(slaveAdmin.runCommand({getParameter: 1,
+                                                          replWriterThreadCount: 1}));
+    assert.eq(4, res.replWriterThreadCount);
+    assert.eq(4, writeAndGetWriterStats().length);
+
+    assert.commandWorked(slaveAdmin.runCommand({setParameter: 1, replWriterThreadCount: 8}));
+    assert.eq(8, writeAndGetWriterStats().length);
+
+    // 0 selects a size automatically, which is never less than the old fixed size of 16.
+    assert.commandWorked(slaveAdmin.runCommand({setParameter: 1, replWriterThreadCount: 0}));
+    assert.gte(writeAndGetWriterStats().length, 16);
+
+    assert.commandFailed(slaveAdmin.runCommand({setParameter: 1, replWriterThreadCount: -1}));
+    assert.commandFailed(slaveAdmin.runCommand({setParameter: 1, replWriterThreadCount: 257}));
+    assert.commandWorked(slaveAdmin.runCommand({setParameter: 1, replPrefetcherThreadCount: 2}));
+
+    replTest.stopSet();
+})();
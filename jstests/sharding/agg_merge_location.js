@@ -0,0 +1,104 @@
+// Tests that mongos merges a sharded aggregation itself when the merge only streams the shards'
+// output and returns all of it in the first batch, and that the results match a merge on the
+// primary shard.
+(function() {
+    "use strict";
+    var st = new ShardingTest({shards: 2, mongos: 1});
+    st.stopBalancer();
+
+    var admin = st.s0.getDB("admin");
+    var testDB = st.s0.getDB("test");
+    var coll = testDB.agg_merge_location;
+
+    assert.commandWorked(admin.runCommand({enableSharding: "test"}));
+    st.ensurePrimaryShard("test", "shard0000");
+    assert.commandWorked(admin.runCommand({shardCollection: coll.getFullName(), key: {_id: 1}}));
+    assert.commandWorked(admin.runCommand({split: coll.getFullName(), middle: {_id: 500}}));
+    assert.commandWorked(
+        admin.runCommand({moveChunk: coll.getFullName(), find: {_id: 500}, to: "shard0001"}));
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; i++) {
+        bulk.insert({_id: i, a: (i * 7) % 1000, b: i % 10});
+    }
+    assert.writeOK(bulk.execute());
+
+    function getMergeLocation(pipeline, cursor) {
+        var cmd = {aggregate: coll.getName(), pipeline: pipeline, explain: true};
+        if (cursor) {
+            cmd.cursor = cursor;
+        }
+        return assert.commandWorked(testDB.runCommand(cmd)).mergeLocation;
+    }
+
+    function runAgg(pipeline, cursor) {
+        var cmd = {aggregate: coll.getName(), pipeline: pipeline};
+        if (cursor) {
+            cmd.cursor = cursor;
+            var res = assert.commandWorked(testDB.runCommand(cmd));
+            return new DBCommandCursor(testDB.getMongo(), res).toArray();
+        }
+        return assert.commandWorked(testDB.runCommand(cmd)).result;
+    }
+
+    // Runs 'pipeline' with the merge on mongos allowed and not, and checks that both give the same
+    // results.
+    function checkSameResults(pipeline, cursor) {
+        var merged = runAgg(pipeline, cursor);
+        assert.commandWorked(
+            admin.runCommand({setParameter: 1, internalAggregationMergeInRouter: false}));
+        assert.eq("primaryShard", getMergeLocation(pipeline, cursor));
+        var mergedOnShard = runAgg(pipeline, cursor);
+        assert.commandWorked(
+            admin.runCommand({setParameter: 1, internalAggregationMergeInRouter: true}));
+        assert.eq(mergedOnShard, merged, tojson(pipeline));
+        return merged;
+    }
+
+    // A top-k sort is limited on every shard and merged on mongos.
+    var topK = [{$match: {b: {$lt: 5}}}, {$sort: {a: -1}}, {$skip: 3}, {$limit: 20}];
+    assert.eq("mongos", getMergeLocation(topK, {}));
+    var results = checkSameResults(topK, {});
+    assert.eq(20, results.length);
+    for (var j = 1; j < results.length; j++) {
+        assert.gt(results[j - 1].a, results[j].a, tojson(results));
+    }
+    assert.eq(results, checkSameResults(topK));
+
+    // The results would not fit in the requested first batch, so a shard merges them.
+    assert.eq("primaryShard", getMergeLocation(topK, {batchSize: 10}));
+    assert.eq(results, checkSameResults(topK, {batchSize: 10}));
+
+    // An unbounded sorted merge is only done on mongos when all results are returned inline.
+    var sortOnly = [{$sort: {a: 1}}, {$project: {_id: 0, a: 1}}];
+    assert.eq("mongos", getMergeLocation(sortOnly));
+    assert.eq("primaryShard", getMergeLocation(sortOnly, {}));
+    assert.eq(1000, checkSameResults(sortOnly).length);
+    assert.eq(1000, checkSameResults(sortOnly, {}).length);
+
+    // A $group is partially computed on each shard and merged on the primary shard.
+    var group = [{$group: {_id: "$b", n: {$sum: 1}}}, {$sort: {_id: 1}}];
+    assert.eq("primaryShard", getMergeLocation(group, {}));
+    results = runAgg(group, {});
+    assert.eq(10, results.length);
+    results.forEach(function(doc) {
+        assert.eq(100, doc.n, tojson(doc));
+    });
+
+    // The merge is picked for mongos, but the documents are too large to return in one reply, so
+    // the aggregation is run again with the merge on the primary shard.
+    var bigString = new Array(512 * 1024).join("x");
+    var large = [{$sort: {a: 1}}, {$limit: 50}, {$project: {a: 1, pad: {$literal: bigString}}}];
+    assert.eq("mongos", getMergeLocation(large, {}));
+    results = runAgg(large, {});
+    assert.eq(50, results.length);
+    for (var k = 0; k < results.length; k++) {
+        assert.eq(k, results[k].a, tojson(results[k].a));
+        assert.eq(bigString.length, results[k].pad.length);
+    }
+    assert.throws(function() {
+        runAgg(large);
+    });
+
+    st.stop();
+})();
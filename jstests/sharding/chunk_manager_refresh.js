@@ -0,0 +1,54 @@
+// Tests that a stale mongos reloads its chunk manager after chunks are split and moved through
+// another mongos, and that it reports the reloads in serverStatus.
+(function() {
+    "use strict";
+    var st = new ShardingTest({shards: 2, mongos: 2});
+    st.stopBalancer();
+
+    var admin = st.s0.getDB("admin");
+    var coll = st.s0.getCollection("test.chunk_manager_refresh");
+    var staleColl = st.s1.getCollection(coll.getFullName());
+
+    assert.commandWorked(admin.runCommand({enableSharding: "test"}));
+    st.ensurePrimaryShard("test", "shard0000");
+    assert.commandWorked(admin.runCommand({shardCollection: coll.getFullName(), key: {x: 1}}));
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 100; i++) {
+        bulk.insert({x: i});
+    }
+    assert.writeOK(bulk.execute());
+
+    // Load the collection's routing information on the second mongos.
+    assert.eq(100, staleColl.find().itcount());
+
+    function getRefreshMetrics() {
+        return assert.commandWorked(st.s1.getDB("admin").serverStatus())
+            .metrics.chunkManager.refresh;
+    }
+    var before = getRefreshMetrics();
+
+    // Split and move chunks through the first mongos only.
+    for (var split = 10; split < 100; split += 10) {
+        assert.commandWorked(admin.runCommand({split: coll.getFullName(), middle: {x: split}}));
+    }
+    for (var move = 10; move < 100; move += 20) {
+        assert.commandWorked(
+            admin.runCommand({moveChunk: coll.getFullName(), find: {x: move}, to: "shard0001"}));
+    }
+
+    // The second mongos finds out that it is stale and routes the operations correctly.
+    assert.eq(100, staleColl.find().itcount());
+    for (var x = 0; x < 100; x += 5) {
+        assert.eq(1, staleColl.find({x: x}).itcount(), "x: " + x);
+    }
+    assert.writeOK(staleColl.update({x: 55}, {$set: {y: 1}}));
+    assert.eq(1, coll.find({y: 1}).itcount());
+
+    var after = getRefreshMetrics();
+    assert.gt(after.latency.num, before.latency.num, tojson(after));
+    assert.gte(after.coalesced, before.coalesced, tojson(after));
+    assert.gte(after.background, before.background, tojson(after));
+
+    st.stop();
+})();
@@ -0,0 +1,79 @@
+// Tests that mongos reports the results it received from each shard while merging a find, and how
+// long it waited for each, in explain output and in its currentOp entry for the query.
+(function() {
+    "use strict";
+    var st = new ShardingTest({shards: 2, mongos: 1});
+    st.stopBalancer();
+
+    var admin = st.s0.getDB("admin");
+    var testDB = st.s0.getDB("test");
+    var coll = testDB.find_remote_stats;
+
+    assert.commandWorked(admin.runCommand({enableSharding: "test"}));
+    st.ensurePrimaryShard("test", "shard0000");
+    assert.commandWorked(admin.runCommand({shardCollection: coll.getFullName(), key: {_id: 1}}));
+    assert.commandWorked(admin.runCommand({split: coll.getFullName(), middle: {_id: 50}}));
+    assert.commandWorked(
+        admin.runCommand({moveChunk: coll.getFullName(), find: {_id: 50}, to: "shard0001"}));
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 100; i++) {
+        bulk.insert({_id: i});
+    }
+    assert.writeOK(bulk.execute());
+
+    function checkRemoteStats(remoteStats, expectedDocs) {
+        assert.eq(2, remoteStats.length, tojson(remoteStats));
+        var docs = 0;
+        remoteStats.forEach(function(remote) {
+            assert(remote.host, tojson(remote));
+            assert.gte(remote.waitMicros, 0, tojson(remote));
+            docs += remote.docs;
+        });
+        if (expectedDocs !== undefined) {
+            assert.eq(expectedDocs, docs, tojson(remoteStats));
+        }
+    }
+
+    // Only explains that execute the query report the merge.
+    var explain = assert.commandWorked(testDB.runCommand(
+        {explain: {find: coll.getName(), sort: {_id: 1}}, verbosity: "queryPlanner"}));
+    assert.eq(undefined, explain.remoteStats, tojson(explain));
+
+    explain = assert.commandWorked(testDB.runCommand(
+        {explain: {find: coll.getName(), sort: {_id: 1}}, verbosity: "executionStats"}));
+    checkRemoteStats(explain.remoteStats, 100);
+
+    // A query waiting for a shard shows up in currentOp on mongos while its results are merged.
+    // The shard is kept busy by holding its global lock.
+    var shard1Admin = st.shard1.getDB("admin");
+    var awaitSleep = startParallelShell(function() {
+        assert.commandWorked(db.adminCommand({sleep: 1, w: true, secs: 10}));
+    }, st.shard1.port);
+    assert.soon(function() {
+        return shard1Admin.currentOp({"query.sleep": 1}).inprog.length > 0;
+    }, "the shard never started sleeping");
+
+    var awaitFind = startParallelShell(function() {
+        assert.commandWorked(
+            db.getSiblingDB("test").runCommand({find: "find_remote_stats", sort: {_id: 1}}));
+    }, st.s0.port);
+
+    assert.soon(function() {
+        var res = assert.commandWorked(admin.runCommand(
+            {currentOp: 1, ns: coll.getFullName(), remoteStats: {$exists: true}}));
+        var inprog = res.inprog;
+        if (inprog.length === 0) {
+            return false;
+        }
+        assert.eq(1, inprog.length, tojson(inprog));
+        assert.eq("query", inprog[0].op, tojson(inprog));
+        checkRemoteStats(inprog[0].remoteStats);
+        return true;
+    }, "the merged query never appeared in currentOp");
+
+    awaitFind();
+    awaitSleep();
+
+    st.stop();
+})();
@@ -0,0 +1,47 @@
+// Tests that a chunk is migrated completely both when the donor clones it by scanning its range of
+// the shard key index and when it clones it from the record ids collected up front, including when
+// the chunk needs several clone batches and many documents share a shard key value.
+(function() {
+    "use strict";
+    var st = new ShardingTest({shards: 2, mongos: 1});
+    st.stopBalancer();
+
+    var admin = st.s0.getDB("admin");
+    var coll = st.s0.getCollection("test.migration_clone_by_range");
+
+    assert.commandWorked(admin.runCommand({enableSharding: "test"}));
+    st.ensurePrimaryShard("test", "shard0000");
+    assert.commandWorked(admin.runCommand({shardCollection: coll.getFullName(), key: {x: 1}}));
+
+    // About 30MB of documents, which takes at least two batches of the clone phase.
+    var pad = new Array(10 * 1024).join("x");
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 3000; i++) {
+        bulk.insert({_id: i, x: i % 100, pad: pad});
+    }
+    assert.writeOK(bulk.execute());
+
+    function moveAndCheck(cloneByRange, to) {
+        [st.shard0, st.shard1].forEach(function(shard) {
+            assert.commandWorked(shard.adminCommand(
+                {setParameter: 1, internalMigrationCloneByRange: cloneByRange}));
+        });
+
+        assert.commandWorked(admin.runCommand(
+            {moveChunk: coll.getFullName(), find: {x: 0}, to: to, _waitForDelete: true}));
+
+        var toShard = to === "shard0000" ? st.shard0 : st.shard1;
+        var toColl = toShard.getCollection(coll.getFullName());
+        assert.eq(3000, toColl.find().itcount(), "cloneByRange: " + cloneByRange);
+        for (var x = 0; x < 100; x += 33) {
+            assert.eq(30, toColl.find({x: x}).itcount(), "x: " + x);
+        }
+        assert.eq(3000, coll.find().itcount());
+    }
+
+    moveAndCheck(true, "shard0001");
+    moveAndCheck(false, "shard0000");
+    moveAndCheck(true, "shard0001");
+
+    st.stop();
+})();
@@ -0,0 +1,43 @@
+// Tests that the range deleter removes a migrated chunk in batches, respects its deletion rate
+// limit, and reports its progress in the rangeDeleter serverStatus section.
+(function() {
+    "use strict";
+    var st = new ShardingTest({shards: 2, mongos: 1});
+    st.stopBalancer();
+
+    var admin = st.s0.getDB("admin");
+    var coll = st.s0.getCollection("test.range_deleter_batches");
+
+    assert.commandWorked(admin.runCommand({enableSharding: "test"}));
+    st.ensurePrimaryShard("test", "shard0000");
+    assert.commandWorked(admin.runCommand({shardCollection: coll.getFullName(), key: {x: 1}}));
+
+    var bulk = coll.initializeUnorderedBulkOp();
+    for (var i = 0; i < 1000; i++) {
+        bulk.insert({x: i});
+    }
+    assert.writeOK(bulk.execute());
+
+    var donor = st.shard0.getDB("admin");
+    assert.commandWorked(donor.runCommand({setParameter: 1, rangeDeleterBatchSize: 100}));
+    assert.commandWorked(donor.runCommand({setParameter: 1, rangeDeleterMaxDocsPerSecond: 500}));
+
+    var start = new Date();
+    assert.commandWorked(admin.runCommand(
+        {moveChunk: coll.getFullName(), find: {x: 0}, to: "shard0001", _waitForDelete: true}));
+
+    // 1000 documents at 500 documents per second, after a first second's worth of deletes.
+    assert.gte(new Date() - start, 900);
+    assert.eq(0, st.shard0.getCollection(coll.getFullName()).count());
+    assert.eq(1000, coll.find().itcount());
+
+    var stats = assert.commandWorked(donor.serverStatus({rangeDeleter: 1})).rangeDeleter;
+    assert.eq(1000, stats.deletedDocs, tojson(stats));
+    assert.eq(10, stats.deletedBatches, tojson(stats));
+    assert.gt(stats.deletedBytes, 0, tojson(stats));
+    assert.gt(stats.throttledMillis, 0, tojson(stats));
+    assert.eq(0, stats.pendingDeletes, tojson(stats));
+    assert.eq(1000, stats.lastDeleteStats[stats.lastDeleteStats.length - 1].deletedDocs);
+
+    st.stop();
+})();
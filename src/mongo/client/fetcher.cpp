@@ -195,7 +195,8 @@ Status Fetcher::schedule() {
     if (_active) {
         return Status(ErrorCodes::IllegalOperation, "fetcher already scheduled");
     }
-    return _schedule_inlock(_cmdObj, kFirstBatchFieldName);
+    const bool isGetMore = str::equals(_cmdObj.firstElementFieldName(), "getMore");
+    return _schedule_inlock(_cmdObj, isGetMore ? kNextBatchFieldName : kFirstBatchFieldName);
 }
 
 void Fetcher::cancel() {
@@ -287,6 +288,11 @@ void Fetcher::_callback(const RemoteCommandCallbackArgs& rcbd, const char* batch
 
     // Callback function _work may modify nextAction to request the fetcher
     // not to schedule a getMore command.
+    if (nextAction == NextAction::kExitAndKeepCursorAlive) {
+        _finishCallback();
+        return;
+    }
+
     if (nextAction != NextAction::kGetMore) {
         _sendKillCursors(batchData.cursorId, batchData.nss);
         _finishCallback();
@@ -74,8 +74,16 @@ public:
 
     /**
      * Represents next steps of fetcher.
+     *
+     * kExitAndKeepCursorAlive stops the fetcher without killing the remote cursor, so that a
+     * new fetcher may resume reading from it later with a getMore command.
      */
-    enum class NextAction : int { kInvalid = 0, kNoAction = 1, kGetMore = 2 };
+    enum class NextAction : int {
+        kInvalid = 0,
+        kNoAction = 1,
+        kGetMore = 2,
+        kExitAndKeepCursorAlive = 3
+    };
 
     /**
      * Type of a fetcher callback function.
@@ -90,6 +98,9 @@ public:
      * of 'cmdObj' must contain a cursor response object.
      * See Commands::appendCursorResponseObject.
      *
+     * If 'cmdObj' is a getMore command, the fetcher resumes reading from an existing cursor
+     * and expects its first response to contain a 'nextBatch' field.
+     *
      * Callback function 'work' will be called 1 or more times after a successful
      * schedule() call depending on the results of the remote command.
      *
@@ -640,6 +640,64 @@ TEST_F(FetcherTest, UpdateNextActionAfterSecondBatch) {
     ASSERT_FALSE(fetcher->isActive());
 }
 
+void setNextActionToExitAndKeepCursorAlive(const StatusWith<Fetcher::QueryResponse>& fetchResult,
+                                           Fetcher::NextAction* nextAction,
+                                           BSONObjBuilder* getMoreBob) {
+    *nextAction = Fetcher::NextAction::kExitAndKeepCursorAlive;
+}
+
+TEST_F(FetcherTest, ExitAndKeepCursorAliveAfterFirstBatch) {
+    callbackHook = setNextActionToExitAndKeepCursorAlive;
+
+    ASSERT_OK(fetcher->schedule());
+    const BSONObj doc = BSON("_id" << 1);
+    processNetworkResponse(
+        BSON("cursor" << BSON("id" << 1LL << "ns"
+                                   << "db.coll"
+                                   << "firstBatch" << BSON_ARRAY(doc)) << "ok" << 1));
+    ASSERT_OK(status);
+    ASSERT_EQUALS(1LL, cursorId);
+    ASSERT_EQUALS(1U, documents.size());
+    ASSERT_TRUE(Fetcher::NextAction::kExitAndKeepCursorAlive == nextAction);
+
+    // Neither a getMore nor a killCursors command is sent.
+    ASSERT_FALSE(getNet()->hasReadyRequests());
+    ASSERT_FALSE(fetcher->isActive());
+}
+
+TEST_F(FetcherTest, ResumeCursorWithGetMoreCommand) {
+    Status resumeStatus = getDetectableErrorStatus();
+    Fetcher::Documents resumeDocuments;
+    Fetcher resumeFetcher(&getExecutor(),
+                          target,
+                          "db",
+                          BSON("getMore" << 1LL << "collection"
+                                         << "coll"),
+                          [&](const StatusWith<Fetcher::QueryResponse>& fetchResult,
+                              Fetcher::NextAction* nextAction,
+                              BSONObjBuilder* getMoreBob) {
+                              resumeStatus = fetchResult.getStatus();
+                              if (fetchResult.isOK()) {
+                                  resumeDocuments = fetchResult.getValue().documents;
+                              }
+                          });
+
+    ASSERT_OK(resumeFetcher.schedule());
+    const BSONObj doc = BSON("_id" << 2);
+    scheduleNetworkResponseFor(BSON("getMore" << 1LL),
+                               BSON("cursor" << BSON("id" << 0LL << "ns"
+                                                          << "db.coll"
+                                                          << "nextBatch" << BSON_ARRAY(doc))
+                                             << "ok" << 1));
+    getNet()->runReadyNetworkOperations();
+    resumeFetcher.wait();
+
+    ASSERT_OK(resumeStatus);
+    ASSERT_EQUALS(1U, resumeDocuments.size());
+    ASSERT_EQUALS(doc, resumeDocuments.front());
+    ASSERT_FALSE(resumeFetcher.isActive());
+}
+
 /**
  * This will be invoked twice before the fetcher returns control to the replication executor.
  */
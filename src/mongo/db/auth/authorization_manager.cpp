@@ -60,6 +60,7 @@
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -435,51 +436,105 @@ Status AuthorizationManager::acquireUser(OperationContext* txn,
         return Status::OK();
     }
 
-    unordered_map<UserName, User*>::iterator it;
+    stdx::unique_lock<stdx::mutex> lk(_cacheMutex);
+    while (true) {
+        unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
+        if (it != _userCache.end()) {
+            fassert(16914, it->second);
+            fassert(17003, it->second->isValid());
+            fassert(17008, it->second->getRefCount() > 0);
+            it->second->incrementRefCount();
+            *acquiredUser = it->second;
+            return Status::OK();
+        }
 
-    CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
-    while ((_userCache.end() == (it = _userCache.find(userName))) &&
-           guard.otherUpdateInFetchPhase()) {
-        guard.wait();
-    }
+        unordered_map<UserName, std::shared_ptr<UserFetch>>::iterator fetchIt =
+            _userFetches.find(userName);
+        if (fetchIt == _userFetches.end()) {
+            break;
+        }
 
-    if (it != _userCache.end()) {
-        fassert(16914, it->second);
-        fassert(17003, it->second->isValid());
-        fassert(17008, it->second->getRefCount() > 0);
-        it->second->incrementRefCount();
-        *acquiredUser = it->second;
-        return Status::OK();
+        // Another thread is reading this user, so wait for it instead of reading it again.
+        std::shared_ptr<UserFetch> fetch = fetchIt->second;
+        while (!fetch->done) {
+            fetch->fetched.wait(lk);
+        }
+
+        // A user that does not exist is not worth reading again right away.  Other errors may be
+        // specific to the thread that read the user, such as it being interrupted, and a user
+        // that was invalidated while it was read has not been cached, so look again.
+        if (fetch->status == ErrorCodes::UserNotFound) {
+            return fetch->status;
+        }
     }
 
+    std::shared_ptr<UserFetch> fetch = std::make_shared<UserFetch>();
+    _userFetches.insert(std::make_pair(userName, fetch));
+    int authzVersion = _version;
+    lk.unlock();
+
     std::unique_ptr<User> user;
+    Status status(ErrorCodes::InternalError, "Reading the user did not complete");
+    {
+        // Completes the fetch and wakes up the threads waiting for it, even if reading throws.
+        ScopeGuard fetchCompleter = MakeGuard([&] {
+            if (!lk.owns_lock()) {
+                lk.lock();
+            }
+            _userFetches.erase(userName);
+            fetch->done = true;
+            fetch->status = status;
+            fetch->fetched.notify_all();
+        });
+        status = _fetchUser(txn, userName, &authzVersion, &user);
+    }
+    if (!status.isOK())
+        return status;
 
-    int authzVersion = _version;
-    guard.beginFetchPhase();
+    user->incrementRefCount();
+    // NOTE: It is not safe to throw an exception from here to the end of the method.
+    if (!fetch->invalidated) {
+        _userCache.insert(std::make_pair(userName, user.get()));
+        if (_version == schemaVersionInvalid)
+            _version = authzVersion;
+    } else {
+        // If the user was invalidated while this thread was reading it, the data associated
+        // with the user may now be invalid, so we must mark it as such.  The caller may still
+        // opt to use the information for a short while, but not indefinitely.
+        user->invalidate();
+    }
+    *acquiredUser = user.release();
+
+    return Status::OK();
+}
 
+Status AuthorizationManager::_fetchUser(OperationContext* txn,
+                                        const UserName& userName,
+                                        int* authzVersion,
+                                        std::unique_ptr<User>* acquiredUser) {
     // Number of times to retry a user document that fetches due to transient
     // AuthSchemaIncompatible errors.  These errors should only ever occur during and shortly
     // after schema upgrades.
     static const int maxAcquireRetries = 2;
     Status status = Status::OK();
     for (int i = 0; i < maxAcquireRetries; ++i) {
-        if (authzVersion == schemaVersionInvalid) {
-            Status status = _externalState->getStoredAuthorizationVersion(txn, &authzVersion);
+        if (*authzVersion == schemaVersionInvalid) {
+            Status status = _externalState->getStoredAuthorizationVersion(txn, authzVersion);
             if (!status.isOK())
                 return status;
         }
 
-        switch (authzVersion) {
+        switch (*authzVersion) {
             default:
                 status = Status(ErrorCodes::BadValue,
                                 mongoutils::str::stream()
                                     << "Illegal value for authorization data schema version, "
-                                    << authzVersion);
+                                    << *authzVersion);
                 break;
             case schemaVersion28SCRAM:
             case schemaVersion26Final:
             case schemaVersion26Upgrade:
-                status = _fetchUserV2(txn, userName, &user);
+                status = _fetchUserV2(txn, userName, acquiredUser);
                 break;
             case schemaVersion24:
                 status = Status(ErrorCodes::AuthSchemaIncompatible,
@@ -493,28 +548,9 @@ Status AuthorizationManager::acquireUser(OperationContext* txn,
         if (status != ErrorCodes::AuthSchemaIncompatible)
             return status;
 
-        authzVersion = schemaVersionInvalid;
+        *authzVersion = schemaVersionInvalid;
     }
-    if (!status.isOK())
-        return status;
-
-    guard.endFetchPhase();
-
-    user->incrementRefCount();
-    // NOTE: It is not safe to throw an exception from here to the end of the method.
-    if (guard.isSameCacheGeneration()) {
-        _userCache.insert(std::make_pair(userName, user.get()));
-        if (_version == schemaVersionInvalid)
-            _version = authzVersion;
-    } else {
-        // If the cache generation changed while this thread was in fetch mode, the data
-        // associated with the user may now be invalid, so we must mark it as such.  The caller
-        // may still opt to use the information for a short while, but not indefinitely.
-        user->invalidate();
-    }
-    *acquiredUser = user.release();
-
-    return Status::OK();
+    return status;
 }
 
 Status AuthorizationManager::_fetchUserV2(OperationContext* txn,
@@ -558,6 +594,12 @@ void AuthorizationManager::releaseUser(User* user) {
 void AuthorizationManager::invalidateUserByName(const UserName& userName) {
     CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
     _updateCacheGeneration_inlock();
+    unordered_map<UserName, std::shared_ptr<UserFetch>>::iterator fetchIt =
+        _userFetches.find(userName);
+    if (fetchIt != _userFetches.end()) {
+        fetchIt->second->invalidated = true;
+    }
+
     unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
     if (it == _userCache.end()) {
         return;
@@ -571,6 +613,15 @@ void AuthorizationManager::invalidateUserByName(const UserName& userName) {
 void AuthorizationManager::invalidateUsersFromDB(const std::string& dbname) {
     CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
     _updateCacheGeneration_inlock();
+    for (unordered_map<UserName, std::shared_ptr<UserFetch>>::iterator fetchIt =
+             _userFetches.begin();
+         fetchIt != _userFetches.end();
+         ++fetchIt) {
+        if (fetchIt->first.getDB() == dbname) {
+            fetchIt->second->invalidated = true;
+        }
+    }
+
     unordered_map<UserName, User*>::iterator it = _userCache.begin();
     while (it != _userCache.end()) {
         User* user = it->second;
@@ -583,6 +634,38 @@ void AuthorizationManager::invalidateUsersFromDB(const std::string& dbname) {
     }
 }
 
+namespace {
+bool isMemberOfRole(const User* user, const RoleName& role) {
+    if (user->hasRole(role)) {
+        return true;
+    }
+    for (RoleNameIterator roles = user->getIndirectRoles(); roles.more(); roles.next()) {
+        if (roles.get() == role) {
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+void AuthorizationManager::invalidateUsersWithRole(const RoleName& role) {
+    CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
+    _updateCacheGeneration_inlock();
+    // The roles of the users being read are not known yet.
+    _invalidateUserFetches_inlock();
+
+    unordered_map<UserName, User*>::iterator it = _userCache.begin();
+    while (it != _userCache.end()) {
+        User* user = it->second;
+        if (isMemberOfRole(user, role)) {
+            _userCache.erase(it++);
+            user->invalidate();
+        } else {
+            ++it;
+        }
+    }
+}
+
 void AuthorizationManager::invalidateUserCache() {
     CacheGuard guard(this, CacheGuard::fetchSynchronizationManual);
     _invalidateUserCache_inlock();
@@ -596,6 +679,7 @@ void AuthorizationManager::_invalidateUserCache_inlock() {
         it->second->invalidate();
     }
     _userCache.clear();
+    _invalidateUserFetches_inlock();
 
     // Reread the schema version before acquiring the next user.
     _version = schemaVersionInvalid;
@@ -661,18 +745,20 @@ bool appliesToAuthzData(const char* op, const char* ns, const BSONObj& o) {
     }
 }
 
-// Updates to users in the oplog are done by matching on the _id, which will always have the
-// form "<dbname>.<username>".  This function extracts the UserName from that string.
-StatusWith<UserName> extractUserNameFromIdString(StringData idstr) {
+// Updates to users and roles in the oplog are done by matching on the _id, which will always
+// have the form "<dbname>.<name>".  This function extracts the UserName or RoleName from that
+// string.
+template <typename NameType>
+StatusWith<NameType> extractNameFromIdString(StringData idstr) {
     size_t splitPoint = idstr.find('.');
     if (splitPoint == string::npos) {
-        return StatusWith<UserName>(ErrorCodes::FailedToParse,
+        return StatusWith<NameType>(ErrorCodes::FailedToParse,
                                     mongoutils::str::stream()
-                                        << "_id entries for user documents must be of "
-                                           "the form <dbname>.<username>.  Found: " << idstr);
+                                        << "_id entries for user and role documents must be of "
+                                           "the form <dbname>.<name>.  Found: " << idstr);
     }
-    return StatusWith<UserName>(
-        UserName(idstr.substr(splitPoint + 1), idstr.substr(0, splitPoint)));
+    return StatusWith<NameType>(
+        NameType(idstr.substr(splitPoint + 1), idstr.substr(0, splitPoint)));
 }
 
 }  // namespace
@@ -681,24 +767,52 @@ void AuthorizationManager::_updateCacheGeneration_inlock() {
     _cacheGeneration = OID::gen();
 }
 
+void AuthorizationManager::_invalidateUserFetches_inlock() {
+    for (unordered_map<UserName, std::shared_ptr<UserFetch>>::iterator it = _userFetches.begin();
+         it != _userFetches.end();
+         ++it) {
+        it->second->invalidated = true;
+    }
+}
+
 void AuthorizationManager::_invalidateRelevantCacheData(const char* op,
                                                         const char* ns,
                                                         const BSONObj& o,
                                                         const BSONObj* o2) {
-    if (ns == AuthorizationManager::rolesCollectionNamespace.ns() ||
-        ns == AuthorizationManager::versionCollectionNamespace.ns()) {
+    if (ns == AuthorizationManager::versionCollectionNamespace.ns()) {
         invalidateUserCache();
         return;
     }
 
+    if (ns == AuthorizationManager::rolesCollectionNamespace.ns()) {
+        if (*op != 'i' && *op != 'd' && *op != 'u') {
+            invalidateUserCache();
+            return;
+        }
+
+        // Only the members of the changed role are affected by the change.
+        StatusWith<RoleName> roleName = (*op == 'u')
+            ? extractNameFromIdString<RoleName>((*o2)["_id"].str())
+            : extractNameFromIdString<RoleName>(o["_id"].str());
+
+        if (!roleName.isOK()) {
+            warning() << "Invalidating user cache based on role being updated failed, will "
+                         "invalidate the entire cache instead: " << roleName.getStatus() << endl;
+            invalidateUserCache();
+            return;
+        }
+        invalidateUsersWithRole(roleName.getValue());
+        return;
+    }
+
     if (*op == 'i' || *op == 'd' || *op == 'u') {
         // If you got into this function isAuthzNamespace() must have returned true, and we've
         // already checked that it's not the roles or version collection.
         invariant(ns == AuthorizationManager::usersCollectionNamespace.ns());
 
         StatusWith<UserName> userName = (*op == 'u')
-            ? extractUserNameFromIdString((*o2)["_id"].str())
-            : extractUserNameFromIdString(o["_id"].str());
+            ? extractNameFromIdString<UserName>((*o2)["_id"].str())
+            : extractNameFromIdString<UserName>(o["_id"].str());
 
         if (!userName.isOK()) {
             warning() << "Invalidating user cache based on user being updated failed, will "
@@ -38,6 +38,7 @@
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/resource_pattern.h"
 #include "mongo/db/auth/role_graph.h"
+#include "mongo/db/auth/role_name.h"
 #include "mongo/db/auth/user.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/auth/user_name_hash.h"
@@ -259,6 +260,9 @@ public:
      *  exists yet in the cache, reads the user's privilege document from disk, builds up
      *  a User object, sets the refcount to 1, and gives that out.  The returned user may
      *  be invalid by the time the caller gets access to it.
+     *  Only one thread at a time reads the document of a given user; other threads acquiring
+     *  the same user wait for that read to complete, while users with different names are read
+     *  concurrently.
      *  The AuthorizationManager retains ownership of the returned User object.
      *  On non-OK Status return values, acquiredUser will not be modified.
      */
@@ -280,6 +284,12 @@ public:
      */
     void invalidateUsersFromDB(const std::string& dbname);
 
+    /**
+     * Invalidates all users who are members of "role", directly or through other roles, and
+     * removes them from the user cache.
+     */
+    void invalidateUsersWithRole(const RoleName& role);
+
     /**
      * Initializes the authorization manager.  Depending on what version the authorization
      * system is at, this may involve building up the user cache and/or the roles graph.
@@ -338,6 +348,24 @@ private:
      */
     void _updateCacheGeneration_inlock();
 
+    /**
+     * Fetches the user information for the named user according to the authorization schema
+     * version in *authzVersion, rereading the version first if it is schemaVersionInvalid, and
+     * stores a pointer to a new user object into *acquiredUser on success.  On return,
+     * *authzVersion holds the version that was used.  Must be called without holding
+     * _cacheMutex.
+     */
+    Status _fetchUser(OperationContext* txn,
+                      const UserName& userName,
+                      int* authzVersion,
+                      std::unique_ptr<User>* acquiredUser);
+
+    /**
+     * Marks every user fetch in progress as invalidated.  Should only be called when already
+     * holding _cacheMutex.
+     */
+    void _invalidateUserFetches_inlock();
+
     /**
      * Fetches user information from a v2-schema user document for the named user,
      * and stores a pointer to a new user object into *acquiredUser on success.
@@ -382,6 +410,28 @@ private:
      */
     unordered_map<UserName, User*> _userCache;
 
+    /**
+     * A read of a user's information that is in progress.  Threads acquiring a user while it
+     * is being read wait for that read instead of starting their own.
+     */
+    struct UserFetch {
+        // Set once the read has completed, along with its status.
+        bool done = false;
+        Status status = Status::OK();
+
+        // Set if the user was invalidated while it was being read, in which case the information
+        // read must not be cached.
+        bool invalidated = false;
+
+        // Signaled when the read completes.
+        stdx::condition_variable fetched;
+    };
+
+    /**
+     * The reads of user information in progress, by user name.  Protected by _cacheMutex.
+     */
+    unordered_map<UserName, std::shared_ptr<UserFetch>> _userFetches;
+
     /**
      * Current generation of cached data.  Updated every time part of the cache gets
      * invalidated.  Protected by CacheGuard.
@@ -397,8 +447,8 @@ private:
     bool _isFetchPhaseBusy;
 
     /**
-     * Protects _userCache, _cacheGeneration, _version and _isFetchPhaseBusy.  Manipulated
-     * via CacheGuard.
+     * Protects _userCache, _userFetches, _cacheGeneration, _version and _isFetchPhaseBusy.
+     * Manipulated via CacheGuard, except when fetching users.
      */
     stdx::mutex _cacheMutex;
 
@@ -28,6 +28,8 @@
 /**
  * Unit tests of the AuthorizationManager type.
  */
+#include <vector>
+
 #include "mongo/base/status.h"
 #include "mongo/bson/mutable/document.h"
 #include "mongo/db/auth/action_set.h"
@@ -40,6 +42,7 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/stdx/memory.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/map_util.h"
 
@@ -229,5 +232,110 @@ TEST_F(AuthorizationManagerTest, testAcquireV2User) {
     authzManager->releaseUser(v2cluster);
 }
 
+TEST_F(AuthorizationManagerTest, testInvalidateUsersWithRole) {
+    OperationContextNoop txn;
+
+    ASSERT_OK(externalState->insertPrivilegeDocument(
+        &txn,
+        BSON("_id"
+             << "test.reader"
+             << "user"
+             << "reader"
+             << "db"
+             << "test"
+             << "credentials" << BSON("MONGODB-CR"
+                                      << "password")
+             << "roles" << BSON_ARRAY(BSON("role"
+                                           << "read"
+                                           << "db"
+                                           << "test"))),
+        BSONObj()));
+    ASSERT_OK(externalState->insertPrivilegeDocument(
+        &txn,
+        BSON("_id"
+             << "admin.clusterUser"
+             << "user"
+             << "clusterUser"
+             << "db"
+             << "admin"
+             << "credentials" << BSON("MONGODB-CR"
+                                      << "password")
+             << "roles" << BSON_ARRAY(BSON("role"
+                                           << "clusterAdmin"
+                                           << "db"
+                                           << "admin"))),
+        BSONObj()));
+
+    User* reader;
+    ASSERT_OK(authzManager->acquireUser(&txn, UserName("reader", "test"), &reader));
+    User* clusterUser;
+    ASSERT_OK(authzManager->acquireUser(&txn, UserName("clusterUser", "admin"), &clusterUser));
+
+    // Only the members of the role are invalidated
+    authzManager->invalidateUsersWithRole(RoleName("read", "test"));
+    ASSERT_FALSE(reader->isValid());
+    ASSERT(clusterUser->isValid());
+
+    // Including those who are members through another role
+    authzManager->invalidateUsersWithRole(RoleName("clusterMonitor", "admin"));
+    ASSERT_FALSE(clusterUser->isValid());
+
+    User* newReader;
+    ASSERT_OK(authzManager->acquireUser(&txn, UserName("reader", "test"), &newReader));
+    ASSERT(newReader != reader);
+    ASSERT(newReader->isValid());
+
+    authzManager->releaseUser(reader);
+    authzManager->releaseUser(clusterUser);
+    authzManager->releaseUser(newReader);
+}
+
+TEST_F(AuthorizationManagerTest, testConcurrentAcquiresShareUser) {
+    OperationContextNoop txn;
+
+    ASSERT_OK(externalState->insertPrivilegeDocument(
+        &txn,
+        BSON("_id"
+             << "test.reader"
+             << "user"
+             << "reader"
+             << "db"
+             << "test"
+             << "credentials" << BSON("MONGODB-CR"
+                                      << "password")
+             << "roles" << BSON_ARRAY(BSON("role"
+                                           << "read"
+                                           << "db"
+                                           << "test"))),
+        BSONObj()));
+
+    const int numThreads = 10;
+    std::vector<User*> users(numThreads, nullptr);
+    std::vector<Status> statuses(numThreads, Status::OK());
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < numThreads; i++) {
+        threads.emplace_back([this, i, &users, &statuses] {
+            OperationContextNoop threadTxn;
+            statuses[i] =
+                authzManager->acquireUser(&threadTxn, UserName("reader", "test"), &users[i]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // All threads got the single cached copy of the user
+    for (int i = 0; i < numThreads; i++) {
+        ASSERT_OK(statuses[i]);
+        ASSERT_EQUALS(users[0], users[i]);
+    }
+    ASSERT(users[0]->isValid());
+    ASSERT_EQUALS(static_cast<uint32_t>(numThreads), users[0]->getRefCount());
+
+    for (int i = 0; i < numThreads; i++) {
+        authzManager->releaseUser(users[i]);
+    }
+}
+
 }  // namespace
 }  // namespace mongo
@@ -211,6 +211,12 @@ vector<std::unique_ptr<RecordCursor>> Collection::getManyCursors(OperationContex
     return _recordStore->getManyCursors(txn);
 }
 
+vector<std::unique_ptr<RecordCursor>> Collection::getParallelCursors(OperationContext* txn) const {
+    dassert(txn->lockState()->isCollectionLockedForMode(ns().toString(), MODE_IS));
+
+    return _recordStore->getParallelCursors(txn);
+}
+
 Snapshotted<BSONObj> Collection::docFor(OperationContext* txn, const RecordId& loc) const {
     return Snapshotted<BSONObj>(txn->recoveryUnit()->getSnapshotId(),
                                 _recordStore->dataFor(txn, loc).releaseToBson());
@@ -211,6 +211,12 @@ public:
      */
     std::vector<std::unique_ptr<RecordCursor>> getManyCursors(OperationContext* txn) const;
 
+    /**
+     * Like getManyCursors(), but possibly split into more pieces for scanning with several threads.
+     * See RecordStore::getParallelCursors().
+     */
+    std::vector<std::unique_ptr<RecordCursor>> getParallelCursors(OperationContext* txn) const;
+
     void deleteDocument(OperationContext* txn,
                         const RecordId& loc,
                         bool cappedOK = false,
@@ -34,18 +34,136 @@
 
 #include "mongo/db/catalog/collection_info_cache.h"
 
+#include <cstdlib>
+#include <unordered_set>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/fts/fts_spec.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_legacy.h"
+#include "mongo/db/keypattern.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
+namespace {
+
+/**
+ * Returns true for about one in eight records, chosen by a hash of 'id'.
+ */
+bool isTrackedRecord(const RecordId& id) {
+    return (static_cast<uint64_t>(id.repr()) * 0x9E3779B97F4A7C15ULL) >> 61 == 0;
+}
+
+/**
+ * Reads up to 'maxKeysScanned' keys of 'desc' in order, keeping the leading field of every n-th
+ * key. n doubles whenever twice internalQueryCostModelSampleSize keys have been kept, so the stride
+ * follows the number of keys read rather than an estimate of how many keys the index has. Returns
+ * null if the scan yielded and was killed.
+ *
+ * If the index has more keys than may be read, the rest are accounted for as a single tail bucket,
+ * and the cost model leaves scans reaching into it to the trial run. A multikey index may have
+ * several keys per document, so the size of the tail is extrapolated from the number of keys per
+ * document seen in the keys that were read.
+ */
+std::shared_ptr<const IndexStatistics> sampleIndex(OperationContext* txn,
+                                                   const Collection* collection,
+                                                   const IndexDescriptor* desc,
+                                                   long long numRecords,
+                                                   long long maxKeysScanned,
+                                                   PlanExecutor::YieldPolicy yieldPolicy) {
+    const bool isMultikey = desc->isMultikey(txn);
+    const long long sampleSize = std::min(
+        maxKeysScanned, static_cast<long long>(std::max(1, internalQueryCostModelSampleSize)));
+    long long stride = 1;
+
+    std::vector<BSONObj> sample;
+    long long keysScanned = 0;
+    bool exhausted = true;
+
+    // Keys and distinct documents seen among the tracked records of a multikey index.
+    std::unordered_set<RecordId, RecordId::Hasher> trackedRecords;
+    long long trackedKeys = 0;
+
+    // Every key counts, so the keys of a multikey index are not deduplicated by record.
+    const KeyPattern keyPattern(desc->keyPattern());
+    IndexScanParams params;
+    params.descriptor = desc;
+    params.bounds.isSimpleRange = true;
+    params.bounds.startKey = Helpers::toKeyFormat(keyPattern.globalMin());
+    params.bounds.endKey = Helpers::toKeyFormat(keyPattern.globalMax());
+    params.bounds.endKeyInclusive = true;
+    params.doNotDedup = true;
+
+    auto ws = stdx::make_unique<WorkingSet>();
+    auto root = stdx::make_unique<IndexScan>(txn, params, ws.get(), nullptr);
+    auto exec = uassertStatusOK(
+        PlanExecutor::make(txn, std::move(ws), std::move(root), collection, yieldPolicy));
+
+    BSONObj key;
+    RecordId loc;
+    PlanExecutor::ExecState state;
+    while (PlanExecutor::ADVANCED == (state = exec->getNext(&key, &loc))) {
+        if (keysScanned == maxKeysScanned) {
+            exhausted = false;
+            break;
+        }
+        if (keysScanned % stride == 0) {
+            BSONObjBuilder bob;
+            bob.appendAs(key.firstElement(), "");
+            sample.push_back(bob.obj());
+
+            if (static_cast<long long>(sample.size()) == 2 * sampleSize) {
+                // Keep every other key, which are those at multiples of the doubled stride.
+                for (size_t i = 1; 2 * i < sample.size(); ++i) {
+                    sample[i] = std::move(sample[2 * i]);
+                }
+                sample.resize(sampleSize);
+                stride *= 2;
+            }
+        }
+        if (isMultikey && isTrackedRecord(loc)) {
+            trackedRecords.insert(loc);
+            ++trackedKeys;
+        }
+        ++keysScanned;
+    }
+    if (PlanExecutor::DEAD == state || PlanExecutor::FAILURE == state) {
+        // Killed while yielding, as the collection or the index was dropped.
+        return nullptr;
+    }
+
+    double unsampledKeys = 0;
+    if (!exhausted) {
+        const double keysPerRecord =
+            trackedRecords.empty() ? 1.0 : double(trackedKeys) / trackedRecords.size();
+        unsampledKeys = std::max(0.0, numRecords * keysPerRecord - keysScanned);
+    }
+
+    const double sampleWeight = sample.empty() ? 1.0 : double(keysScanned) / sample.size();
+    const size_t numBuckets = std::max(1, internalQueryCostModelHistogramBuckets);
+    return std::make_shared<const IndexStatistics>(
+        std::move(sample), sampleWeight, unsampledKeys, numBuckets);
+}
+
+/**
+ * Statistics go stale once the collection size has drifted by a fifth since they were sampled.
+ */
+bool isStale(const CollectionInfoCache::IndexStatisticsEntry& entry, long long numRecords) {
+    return std::abs(numRecords - entry.numRecords) > std::max(100LL, entry.numRecords / 5);
+}
+
+}  // namespace
+
 CollectionInfoCache::CollectionInfoCache(Collection* collection)
     : _collection(collection),
       _keysComputed(false),
@@ -56,6 +174,10 @@ void CollectionInfoCache::reset(OperationContext* txn) {
     LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
     clearQueryCache();
     _keysComputed = false;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+        _indexStatistics.clear();
+    }
     computeIndexKeys(txn);
     updatePlanCacheIndexEntries(txn);
     // query settings is not affected by info cache reset.
@@ -69,6 +191,77 @@ const UpdateIndexData& CollectionInfoCache::indexKeys(OperationContext* txn) con
     return _indexedPaths;
 }
 
+std::shared_ptr<const IndexStatistics> CollectionInfoCache::getIndexStatistics(
+    const std::string& indexName) {
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    auto it = _indexStatistics.find(indexName);
+    return it == _indexStatistics.end() ? nullptr : it->second.stats;
+}
+
+boost::optional<CollectionInfoCache::IndexStatisticsEntry>
+CollectionInfoCache::refreshIndexStatistics(OperationContext* txn,
+                                            const IndexDescriptor* desc,
+                                            long long maxKeysScanned,
+                                            PlanExecutor::YieldPolicy yieldPolicy) {
+    dassert(txn->lockState()->isCollectionLockedForMode(_collection->ns().ns(), MODE_IS));
+
+    if (desc->getAccessMethodName() != IndexNames::BTREE) {
+        return boost::none;
+    }
+
+    const long long numRecords = _collection->numRecords(txn);
+    {
+        stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+        auto it = _indexStatistics.find(desc->indexName());
+        if (it != _indexStatistics.end() && !isStale(it->second, numRecords)) {
+            return boost::none;
+        }
+    }
+
+    // Sample without holding the mutex. Concurrent callers may sample the same index, in which
+    // case the last one wins.
+    IndexStatisticsEntry entry{
+        sampleIndex(
+            txn, _collection, desc, numRecords, std::max(1LL, maxKeysScanned), yieldPolicy),
+        numRecords,
+        Date_t::now()};
+    if (!entry.stats) {
+        // 'this' may be gone.
+        return boost::none;
+    }
+    LOG(1) << _collection->ns() << ": sampled " << entry.stats->getSampleSize()
+           << " keys of index " << desc->indexName();
+
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    _indexStatistics[desc->indexName()] = entry;
+    return entry;
+}
+
+void CollectionInfoCache::setIndexStatistics(const std::string& indexName,
+                                             IndexStatisticsEntry entry) {
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    _indexStatistics[indexName] = std::move(entry);
+}
+
+void CollectionInfoCache::appendIndexStatisticsInfo(OperationContext* txn,
+                                                    BSONObjBuilder* builder) {
+    const long long numRecords = _collection->numRecords(txn);
+    const Date_t now = Date_t::now();
+
+    stdx::lock_guard<stdx::mutex> lk(_indexStatisticsMutex);
+    for (const auto& indexAndEntry : _indexStatistics) {
+        const IndexStatisticsEntry& entry = indexAndEntry.second;
+        BSONObjBuilder bob(builder->subobjStart(indexAndEntry.first));
+        bob.appendDate("sampledAt", entry.sampledAt);
+        bob.appendNumber("ageSecs", durationCount<Seconds>(now - entry.sampledAt));
+        bob.appendNumber("numRecordsAtSample", entry.numRecords);
+        bob.appendNumber("sampleSize", static_cast<long long>(entry.stats->getSampleSize()));
+        bob.append("numKeys", entry.stats->getNumKeys());
+        bob.append("distinct", entry.stats->getDistinctEstimate());
+        bob.append("stale", isStale(entry, numRecords));
+    }
+}
+
 void CollectionInfoCache::computeIndexKeys(OperationContext* txn) {
     // This function modified objects attached to the Collection so we need a write lock
     invariant(txn->lockState()->isCollectionLockedForMode(_collection->ns().ns(), MODE_X));
@@ -30,14 +30,23 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
+#include <map>
+#include <memory>
+#include <string>
 
+#include "mongo/db/query/index_statistics.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/update_index_data.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
 class Collection;
+class IndexDescriptor;
 
 /**
  * this is for storing things that you want to cache about a single collection
@@ -73,6 +82,51 @@ public:
     */
     const UpdateIndexData& indexKeys(OperationContext* txn) const;
 
+    /**
+     * Statistics sampled from one index, along with when they were taken and how many documents
+     * the collection held at the time.
+     */
+    struct IndexStatisticsEntry {
+        std::shared_ptr<const IndexStatistics> stats;
+        long long numRecords;
+        Date_t sampledAt;
+    };
+
+    /**
+     * Get the statistics last sampled from the index named 'indexName', or null if there are
+     * none.
+     */
+    std::shared_ptr<const IndexStatistics> getIndexStatistics(const std::string& indexName);
+
+    /**
+     * Samples the btree index 'desc' if it has no statistics yet, or if the collection has grown
+     * or shrunk considerably since they were sampled, and returns the new statistics. At most
+     * 'maxKeysScanned' keys are read. Returns boost::none if the existing statistics are still
+     * fresh or the index is not a btree.
+     *
+     * The index is read according to 'yieldPolicy'. If the scan yields, the collection or the
+     * index may be dropped meanwhile, in which case boost::none is returned and neither this
+     * cache nor 'desc' may be used any more.
+     *
+     * Requires at least a MODE_IS collection lock.
+     */
+    boost::optional<IndexStatisticsEntry> refreshIndexStatistics(
+        OperationContext* txn,
+        const IndexDescriptor* desc,
+        long long maxKeysScanned,
+        PlanExecutor::YieldPolicy yieldPolicy);
+
+    /**
+     * Installs statistics for the index named 'indexName' that were sampled earlier, for
+     * instance loaded from where the background sampler persists them.
+     */
+    void setIndexStatistics(const std::string& indexName, IndexStatisticsEntry entry);
+
+    /**
+     * Appends how old and how stale the statistics of each index are, for collStats.
+     */
+    void appendIndexStatisticsInfo(OperationContext* txn, BSONObjBuilder* builder);
+
     // ---------------------
 
     /**
@@ -98,6 +152,11 @@ private:
     // Includes index filters.
     std::unique_ptr<QuerySettings> _querySettings;
 
+    // Index statistics by index name, guarded by '_indexStatisticsMutex' since readers sample
+    // indexes concurrently under shared locks.
+    stdx::mutex _indexStatisticsMutex;
+    std::map<std::string, IndexStatisticsEntry> _indexStatistics;
+
     /**
      * Must be called under exclusive DB lock.
      */
@@ -35,6 +35,9 @@
 #include "mongo/db/catalog/index_create.h"
 
 
+#include <algorithm>
+
+#include "mongo/base/counter.h"
 #include "mongo/base/error_codes.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
@@ -42,12 +45,21 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
@@ -58,6 +70,97 @@ using std::unique_ptr;
 using std::string;
 using std::endl;
 
+// Maximum number of threads one foreground index build may scan its collection and sort keys
+// with. 1 disables parallel index builds.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildMaxWorkers, int, 1);
+
+// Collections with fewer records than this are always indexed by a single thread.
+MONGO_EXPORT_SERVER_PARAMETER(internalIndexBuildParallelMinRecords, int, 100000);
+
+// Memory shared by the external sorters of all the indexes built together by one
+// MultiIndexBlock.
+int maxIndexBuildMemoryUsageMegabytes = 500;
+
+namespace {
+
+class ExportedMaxIndexBuildMemoryUsageParameter : public ExportedServerParameter<int> {
+public:
+    ExportedMaxIndexBuildMemoryUsageParameter()
+        : ExportedServerParameter<int>(ServerParameterSet::getGlobal(),
+                                       "maxIndexBuildMemoryUsageMegabytes",
+                                       &maxIndexBuildMemoryUsageMegabytes,
+                                       true,
+                                       true) {}
+
+    virtual Status validate(const int& potentialNewValue) {
+        if (potentialNewValue < 50) {
+            return Status(ErrorCodes::BadValue,
+                          "maxIndexBuildMemoryUsageMegabytes must be at least 50");
+        }
+        return Status::OK();
+    }
+} exportedMaxIndexBuildMemoryUsageParam;
+
+// Upper bound on the number of threads all parallel index builds share. Builds queue for threads
+// when they are all busy.
+const size_t kMaxIndexBuildThreads = 64;
+
+// Each sorter of a parallel build gets at least this much memory. Builds of many indexes use fewer
+// threads so that they stay within maxIndexBuildMemoryUsageMegabytes.
+const size_t kMinParallelSorterMemoryBytes = 8 * 1024 * 1024;
+
+// How often a parallel build updates its progress and checks whether it has been interrupted.
+const Milliseconds kProgressInterval(100);
+
+Counter64 parallelIndexBuilds;
+Counter64 parallelIndexBuildWorkers;
+
+ServerStatusMetricField<Counter64> displayParallelIndexBuilds("indexBuild.parallel.builds",
+                                                              &parallelIndexBuilds);
+ServerStatusMetricField<Counter64> displayParallelIndexBuildWorkers("indexBuild.parallel.workers",
+                                                                    &parallelIndexBuildWorkers);
+
+stdx::mutex indexBuildPoolMutex;
+ThreadPool* indexBuildPool = nullptr;
+
+ThreadPool* getIndexBuildPool() {
+    stdx::lock_guard<stdx::mutex> lk(indexBuildPoolMutex);
+    if (!indexBuildPool) {
+        ThreadPool::Options options;
+        options.poolName = "IndexBuild";
+        options.threadNamePrefix = "indexBuild-";
+        options.minThreads = 0;
+        options.maxThreads = kMaxIndexBuildThreads;
+
+        // Intentionally leaked, so that it never has to be shut down.
+        indexBuildPool = new ThreadPool(options);
+        indexBuildPool->startup();
+    }
+    return indexBuildPool;
+}
+
+size_t getMaxIndexBuildMemoryUsageBytes() {
+    return static_cast<size_t>(maxIndexBuildMemoryUsageMegabytes) * 1024 * 1024;
+}
+
+/**
+ * The state of one thread of a parallel index build.
+ */
+struct IndexBuildWorker {
+    // The ranges of the collection this worker reads. Detached until the worker picks them up.
+    std::vector<unique_ptr<RecordCursor>> cursors;
+
+    // One per index being built, in the order of MultiIndexBlock::_indexes.
+    std::vector<unique_ptr<IndexAccessMethod::BulkBuilder>> bulks;
+
+    // Set while the worker runs so that it can be interrupted. Guarded by the build's mutex.
+    OperationContext* txn = nullptr;
+
+    Status status = Status::OK();
+};
+
+}  // namespace
+
 /**
  * On rollback sets MultiIndexBlock::_needToCleanup to true.
  */
@@ -187,7 +290,8 @@ Status MultiIndexBlock::init(const std::vector<BSONObj>& indexSpecs) {
         if (!_buildInBackground) {
             // Bulk build process requires foreground building as it assumes nothing is changing
             // under it.
-            index.bulk = index.real->initiateBulk();
+            index.bulk =
+                index.real->initiateBulk(getMaxIndexBuildMemoryUsageBytes() / indexSpecs.size());
         }
 
         const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
@@ -222,6 +326,14 @@ Status MultiIndexBlock::init(const std::vector<BSONObj>& indexSpecs) {
 Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsOut) {
     const char* curopMessage = _buildInBackground ? "Index Build (background)" : "Index Build";
     const auto numRecords = _collection->numRecords(_txn);
+
+    if (_canInsertInParallel(numRecords)) {
+        auto cursors = _collection->getParallelCursors(_txn);
+        if (cursors.size() > 1) {
+            return _insertAllDocumentsInParallel(std::move(cursors), dupsOut);
+        }
+    }
+
     stdx::unique_lock<Client> lk(*_txn->getClient());
     ProgressMeterHolder progress(*_txn->setMessage_inlock(curopMessage, curopMessage, numRecords));
     lk.unlock();
@@ -312,6 +424,204 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(std::set<RecordId>* dupsO
     return Status::OK();
 }
 
+bool MultiIndexBlock::_canInsertInParallel(long long numRecords) const {
+    // Background builds insert into the live indexes while yielding, so only foreground builds,
+    // which sort all keys before inserting them, are split. Workers read the collection without
+    // taking locks of their own while this operation holds the database lock exclusively, which
+    // is only safe for storage engines with document level locking.
+    if (_buildInBackground || _indexes.empty() || internalIndexBuildMaxWorkers <= 1 ||
+        numRecords < internalIndexBuildParallelMinRecords || !supportsDocLocking()) {
+        return false;
+    }
+
+    for (auto&& index : _indexes) {
+        if (!index.bulk)
+            return false;
+    }
+    return true;
+}
+
+Status MultiIndexBlock::_insertAllDocumentsInParallel(std::vector<unique_ptr<RecordCursor>> cursors,
+                                                      std::set<RecordId>* dupsOut) {
+    // Every worker has a sorter per index, and all of them share the memory limit.
+    const size_t memoryBytes = getMaxIndexBuildMemoryUsageBytes();
+    const size_t maxWorkersForMemory =
+        std::max<size_t>(1, memoryBytes / (_indexes.size() * kMinParallelSorterMemoryBytes));
+    const size_t numWorkers = std::min({cursors.size(),
+                                        static_cast<size_t>(internalIndexBuildMaxWorkers),
+                                        maxWorkersForMemory});
+    const size_t sorterMemoryBytes = memoryBytes / (_indexes.size() * numWorkers);
+
+    // Deal the ranges out to the workers round robin.
+    std::vector<unique_ptr<IndexBuildWorker>> workers;
+    for (size_t i = 0; i < numWorkers; i++) {
+        workers.push_back(stdx::make_unique<IndexBuildWorker>());
+        for (auto&& index : _indexes) {
+            workers.back()->bulks.push_back(index.real->initiateBulk(sorterMemoryBytes));
+        }
+    }
+    for (size_t i = 0; i < cursors.size(); i++) {
+        cursors[i]->saveUnpositioned();
+        cursors[i]->detachFromOperationContext();
+        workers[i % numWorkers]->cursors.push_back(std::move(cursors[i]));
+    }
+
+    const string curopMessage = str::stream() << "Index Build: (1/3) scanning and sorting with "
+                                              << numWorkers << " threads";
+    stdx::unique_lock<Client> lk(*_txn->getClient());
+    ProgressMeterHolder progress(*_txn->setMessage_inlock(curopMessage.c_str(),
+                                                          "Index: (1/3) Parallel Scan Progress",
+                                                          _collection->numRecords(_txn)));
+    lk.unlock();
+
+    Timer t;
+
+    stdx::mutex mutex;
+    stdx::condition_variable workerDone;
+    size_t workersRunning = 0;
+    bool workerFailed = false;
+    bool killed = false;
+    AtomicUInt64 docsScanned;
+
+    const auto runWorker = [&](IndexBuildWorker* worker) {
+        Client::initThreadIfNotAlready();
+        OperationContextImpl txn;
+
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (killed) {
+                txn.markKilled();
+            }
+            worker->txn = &txn;
+        }
+
+        try {
+            for (auto&& cursor : worker->cursors) {
+                cursor->reattachToOperationContext(&txn);
+                invariant(cursor->restore());
+
+                int retries = 0;  // non-zero when retrying the read of our next document.
+                while (true) {
+                    boost::optional<Record> record;
+                    try {
+                        txn.checkForInterrupt();
+                        record = cursor->next();
+                    } catch (const WriteConflictException& wce) {
+                        retries++;  // logAndBackoff expects this to be 1 on first call.
+                        wce.logAndBackoff(retries, "index creation", _collection->ns().ns());
+                        cursor->savePositioned();
+                        txn.recoveryUnit()->abandonSnapshot();
+                        invariant(cursor->restore());
+                        continue;
+                    }
+                    retries = 0;
+
+                    if (!record)
+                        break;
+
+                    const BSONObj doc = record->data.releaseToBson();
+                    for (size_t i = 0; i < _indexes.size(); i++) {
+                        if (_indexes[i].filterExpression &&
+                            !_indexes[i].filterExpression->matchesBSON(doc)) {
+                            continue;
+                        }
+                        uassertStatusOK(worker->bulks[i]->insert(
+                            &txn, doc, record->id, _indexes[i].options, nullptr));
+                    }
+                    docsScanned.fetchAndAdd(1);
+                }
+            }
+
+            for (auto&& bulk : worker->bulks) {
+                bulk->sortKeys();
+            }
+        } catch (const DBException& ex) {
+            worker->status = ex.toStatus();
+        }
+
+        // The cursors hold storage engine state belonging to this thread's OperationContext.
+        worker->cursors.clear();
+
+        stdx::lock_guard<stdx::mutex> lk(mutex);
+        worker->txn = nullptr;
+        workerFailed = workerFailed || !worker->status.isOK();
+        workersRunning--;
+        workerDone.notify_all();
+    };
+
+    parallelIndexBuilds.increment();
+    parallelIndexBuildWorkers.increment(numWorkers);
+
+    Status status = Status::OK();
+    for (auto&& worker : workers) {
+        IndexBuildWorker* w = worker.get();
+        {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            workersRunning++;
+        }
+        status = getIndexBuildPool()->schedule([&runWorker, w] { runWorker(w); });
+        if (!status.isOK()) {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            workersRunning--;
+            break;
+        }
+    }
+
+    // Wait for the workers, reporting their progress as they go. Stop them all if one fails or
+    // could not be scheduled, or if this operation is interrupted.
+    unsigned long long n = 0;
+    {
+        stdx::unique_lock<stdx::mutex> lk(mutex);
+        while (workersRunning > 0) {
+            if (status.isOK() && _allowInterruption) {
+                status = _txn->checkForInterruptNoAssert();
+            }
+
+            if ((workerFailed || !status.isOK()) && !killed) {
+                killed = true;
+                for (auto&& worker : workers) {
+                    if (worker->txn) {
+                        stdx::lock_guard<Client> clientLock(*worker->txn->getClient());
+                        worker->txn->markKilled();
+                    }
+                }
+            }
+
+            workerDone.wait_for(lk, kProgressInterval);
+
+            const unsigned long long scanned = docsScanned.load();
+            progress->hit(scanned - n);
+            n = scanned;
+        }
+    }
+
+    uassertStatusOK(status);
+    for (auto&& worker : workers) {
+        if (!worker->status.isOK())
+            return worker->status;
+    }
+
+    for (size_t i = 0; i < _indexes.size(); i++) {
+        for (auto&& worker : workers) {
+            _indexes[i].bulk->merge(std::move(worker->bulks[i]));
+        }
+    }
+
+    progress->finished();
+
+    LOG(1) << "\t scanned and sorted " << n << " records with " << numWorkers << " threads in "
+           << t.seconds() << " secs";
+
+    Status ret = doneInserting(dupsOut);
+    if (!ret.isOK())
+        return ret;
+
+    log() << "build index done.  scanned " << n << " total records with " << numWorkers
+          << " threads. " << t.seconds() << " secs";
+
+    return Status::OK();
+}
+
 Status MultiIndexBlock::insert(const BSONObj& doc, const RecordId& loc) {
     for (size_t i = 0; i < _indexes.size(); i++) {
         if (_indexes[i].filterExpression && !_indexes[i].filterExpression->matchesBSON(doc)) {
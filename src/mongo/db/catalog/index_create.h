@@ -46,6 +46,7 @@ class BackgroundOperation;
 class BSONObj;
 class Collection;
 class OperationContext;
+class RecordCursor;
 
 /**
  * Builds one or more indexes.
@@ -123,6 +124,9 @@ public:
      * This is a simplified replacement for insert and doneInserting. Do not call this if you
      * are calling either of them.
      *
+     * Foreground builds of large collections may scan the collection and sort the keys with
+     * several threads. See internalIndexBuildMaxWorkers.
+     *
      * If dupsOut is passed as non-NULL, violators of uniqueness constraints will be added to
      * the set rather than failing the build. Documents added to this set are not indexed, so
      * callers MUST either fail this index build or delete the documents from the collection.
@@ -191,6 +195,20 @@ private:
     class SetNeedToCleanupOnRollback;
     class CleanupIndexesVectorOnRollback;
 
+    /**
+     * Returns whether insertAllDocumentsInCollection() may split the scan of a collection with
+     * 'numRecords' records among several threads.
+     */
+    bool _canInsertInParallel(long long numRecords) const;
+
+    /**
+     * Implements insertAllDocumentsInCollection() for parallel builds. Each thread reads its
+     * share of 'cursors' and generates and sorts keys into bulk builders of its own, which are
+     * merged into the indexes' bulk builders when all threads are done.
+     */
+    Status _insertAllDocumentsInParallel(std::vector<std::unique_ptr<RecordCursor>> cursors,
+                                         std::set<RecordId>* dupsOut);
+
     struct IndexToBuild {
 #if defined(_MSC_VER) && _MSC_VER < 1900  // MVSC++ <= 2013 can't generate default move operations
         IndexToBuild() = default;
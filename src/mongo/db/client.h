@@ -75,6 +75,18 @@ public:
      */
     static void initThreadIfNotAlready();
 
+    /**
+     * Detaches the Client from the current thread and returns it, leaving the thread without a
+     * Client. Used to move a connection's Client between threads in between operations.
+     */
+    static ServiceContext::UniqueClient releaseCurrent();
+
+    /**
+     * Attaches "client" to the current thread, which must not already have a Client, and sets the
+     * thread name to the Client's description.
+     */
+    static void setCurrent(ServiceContext::UniqueClient client);
+
     std::string clientAddress(bool includePort = false) const;
     const std::string& desc() const {
         return _desc;
@@ -151,7 +163,7 @@ private:
     const std::string _desc;
 
     // OS id of the thread, which owns this client
-    const stdx::thread::id _threadId;
+    stdx::thread::id _threadId;
 
     // > 0 for things "conn", 0 otherwise
     const ConnectionId _connectionId;
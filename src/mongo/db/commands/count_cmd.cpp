@@ -131,6 +131,15 @@ public:
         AutoGetCollectionForRead ctx(txn, request.getValue().getNs());
         Collection* collection = ctx.getCollection();
 
+        if (request.getValue().isEstimate()) {
+            auto estimate = estimateCount(txn, collection, request.getValue());
+            if (estimate) {
+                result.appendNumber("n", *estimate);
+                result.append("estimated", true);
+                return true;
+            }
+        }
+
         // Prevent chunks from being cleaned up during yields - this allows us to only check the
         // version on initial entry into count.
         RangePreserver preserver(collection);
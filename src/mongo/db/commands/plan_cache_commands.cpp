@@ -44,6 +44,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 
 namespace {
@@ -237,11 +238,13 @@ Status PlanCacheListQueryShapes::runPlanCacheCommand(OperationContext* txn,
         arrayBuilder.doneFast();
         return Status::OK();
     }
-    return list(*planCache, bob);
+    return list(*planCache, bob, cmdObj["stats"].trueValue());
 }
 
 // static
-Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder* bob) {
+Status PlanCacheListQueryShapes::list(const PlanCache& planCache,
+                                      BSONObjBuilder* bob,
+                                      bool includeStats) {
     invariant(bob);
 
     // Fetch all cached solutions from plan cache.
@@ -256,6 +259,12 @@ Status PlanCacheListQueryShapes::list(const PlanCache& planCache, BSONObjBuilder
         shapeBuilder.append("query", entry->query);
         shapeBuilder.append("sort", entry->sort);
         shapeBuilder.append("projection", entry->projection);
+        if (includeStats) {
+            shapeBuilder.append("queryHash", integerToHex(entry->keyHash));
+            BSONObjBuilder statsBuilder(shapeBuilder.subobjStart("stats"));
+            entry->stats->appendTo(&statsBuilder);
+            statsBuilder.doneFast();
+        }
         shapeBuilder.doneFast();
 
         // Release resources for cached solution after extracting query shape.
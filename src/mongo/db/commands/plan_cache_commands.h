@@ -106,8 +106,10 @@ private:
 /**
  * planCacheListQueryShapes
  *
- * { planCacheListQueryShapes: <collection> }
+ * { planCacheListQueryShapes: <collection>, stats: <bool> }
  *
+ * With 'stats', each shape also reports its key hash and statistics about the executions of
+ * queries of that shape.
  */
 class PlanCacheListQueryShapes : public PlanCacheCommand {
 public:
@@ -119,9 +121,11 @@ public:
 
     /**
      * Looks up cache keys for collection's plan cache.
-     * Inserts keys for query into BSON builder.
+     * Inserts keys for query into BSON builder, with execution statistics if 'includeStats'.
      */
-    static Status list(const PlanCache& planCache, BSONObjBuilder* bob);
+    static Status list(const PlanCache& planCache,
+                       BSONObjBuilder* bob,
+                       bool includeStats = false);
 };
 
 /**
@@ -32,6 +32,10 @@
 
 #include <vector>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #include "mongo/db/concurrency/lock_manager.h"
 
 #include "mongo/config.h"
@@ -238,6 +242,12 @@ struct LockHead {
      */
     void migratePartitionedLockHeads();
 
+    /**
+     * True iff any of the PartitionedLockHeads for this resource has granted requests. Locks
+     * each partition in turn, so the answer may be stale by the time it is returned.
+     */
+    bool hasPartitionedRequests() const;
+
     // Methods to maintain the granted queue
     void incGrantedModeCount(LockMode mode) {
         invariant(grantedCounts[mode] >= 0);
@@ -337,8 +347,8 @@ struct LockHead {
  * The PartitionedLockHead allows optimizing the case where requests overwhelmingly use
  * the intent lock modes MODE_IS and MODE_IX, which are compatible with each other.
  * Having to use a single LockHead causes contention where none would be needed.
- * So, each Locker is associated with a specific partition containing a mapping
- * of resourceId to PartitionedLockHead.
+ * So, each intent request is associated with a specific partition, chosen by the CPU of the
+ * locking thread, containing a mapping of resourceId to PartitionedLockHead.
  *
  * As long as all lock requests for a resource have an intent mode, as opposed to a conflicting
  * mode, its LockHead may reference ParitionedLockHeads. A partitioned LockHead will not have
@@ -409,6 +419,18 @@ void LockHead::migratePartitionedLockHeads() {
     }
 }
 
+bool LockHead::hasPartitionedRequests() const {
+    for (LockManager::Partition* partition : partitions) {
+        stdx::lock_guard<SimpleMutex> scopedLock(partition->mutex);
+
+        LockManager::Partition::Map::const_iterator it = partition->data.find(resourceId);
+        if (it != partition->data.end() && !it->second->grantedList.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 //
 // LockManager
 //
@@ -417,8 +439,9 @@ void LockHead::migratePartitionedLockHeads() {
 const unsigned LockManager::_numLockBuckets(128);
 
 // Balance scalability of intent locks against potential added cost of conflicting locks.
-// The exact value doesn't appear very important, but should be power of two
-const unsigned LockManager::_numPartitions = 32;
+// The exact value doesn't appear very important, but should be power of two. Intent requests
+// are spread by CPU, so this should cover the number of cores of common machines.
+const unsigned LockManager::_numPartitions = 64;
 
 LockManager::LockManager() {
     _lockBuckets = new LockBucket[_numLockBuckets];
@@ -445,7 +468,7 @@ LockResult LockManager::lock(ResourceId resId, LockRequest* request, LockMode mo
 
     // For intent modes, try the PartitionedLockHead
     if (request->partitioned) {
-        Partition* partition = _getPartition(request);
+        Partition* partition = _choosePartition(request);
         stdx::lock_guard<SimpleMutex> scopedLock(partition->mutex);
 
         // Fast path for intent locks
@@ -668,6 +691,14 @@ void LockManager::cleanupUnusedLocks() {
         while (it != bucket->data.end()) {
             LockHead* lock = it->second;
             if (lock->partitioned()) {
+                // Leave resources that are still held through their partitions alone, such as
+                // the global and database locks of a busy server. Migrating them would only send
+                // the following intent requests through the bucket mutex until they become
+                // partitioned again.
+                if (lock->grantedModes != 0 || lock->hasPartitionedRequests()) {
+                    it++;
+                    continue;
+                }
                 lock->migratePartitionedLockHeads();
             }
             if (lock->grantedModes == 0) {
@@ -789,8 +820,23 @@ LockManager::LockBucket* LockManager::_getBucket(ResourceId resId) const {
     return &_lockBuckets[resId % _numLockBuckets];
 }
 
+LockManager::Partition* LockManager::_choosePartition(LockRequest* request) const {
+    // Threads running at the same time are on different CPUs, so choosing the partition by CPU
+    // keeps concurrent intent requests on different partition mutexes. The locker id is only a
+    // fallback, as lockers with colliding ids would share a partition no matter where they run.
+    unsigned id = static_cast<unsigned>(request->locker->getId());
+#if defined(__linux__)
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        id = static_cast<unsigned>(cpu);
+    }
+#endif
+    request->partitionId = id % _numPartitions;
+    return &_partitions[request->partitionId];
+}
+
 LockManager::Partition* LockManager::_getPartition(LockRequest* request) const {
-    return &_partitions[request->locker->getId() % _numPartitions];
+    return &_partitions[request->partitionId];
 }
 
 void LockManager::dump() const {
@@ -1079,6 +1125,7 @@ void LockRequest::initNew(Locker* locker, LockGrantNotification* notify) {
     next = NULL;
     status = STATUS_NEW;
     partitioned = false;
+    partitionId = 0;
     mode = MODE_NONE;
     convertMode = MODE_NONE;
 }
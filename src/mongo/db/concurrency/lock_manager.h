@@ -128,24 +128,35 @@ private:
     // The lockheads need access to the partitions
     friend struct LockHead;
 
-    // These types describe the locks hash table
+    // These types describe the locks hash table. Both are padded to a multiple of
+    // kLockTableEntryPadding bytes, so that the mutexes of neighbouring buckets or partitions are
+    // never on the same cache line and lockers working on different ones do not contend. They are
+    // padded rather than over-aligned because the arrays holding them come from plain new[].
+    static const size_t kLockTableEntryPadding = 128;
 
     struct LockBucket {
         SimpleMutex mutex;
         typedef unordered_map<ResourceId, LockHead*> Map;
         Map data;
         LockHead* findOrInsert(ResourceId resId);
+
+        char padding[kLockTableEntryPadding -
+                     (sizeof(SimpleMutex) + sizeof(Map)) % kLockTableEntryPadding];
     };
 
-    // Each locker maps to a partition that is used for resources acquired in intent modes
-    // modes and potentially other modes that don't conflict with themselves. This avoids
-    // contention on the regular LockHead in the lock manager.
+    // Each intent lock request maps to a partition, chosen by the CPU the locking thread runs on,
+    // that is used for resources acquired in intent modes and potentially other modes that don't
+    // conflict with themselves. This avoids contention on the regular LockHead in the lock
+    // manager, which is important for the global and database locks that every operation takes.
     struct Partition {
         PartitionedLockHead* find(ResourceId resId);
         PartitionedLockHead* findOrInsert(ResourceId resId);
         typedef unordered_map<ResourceId, PartitionedLockHead*> Map;
         SimpleMutex mutex;
         Map data;
+
+        char padding[kLockTableEntryPadding -
+                     (sizeof(SimpleMutex) + sizeof(Map)) % kLockTableEntryPadding];
     };
 
     /**
@@ -156,7 +167,15 @@ private:
 
 
     /**
-     * Retrieves the Partition that a particular LockRequest should use for intent locking.
+     * Chooses the partition that a new intent LockRequest should use and remembers it in the
+     * request. Requests from threads running on different CPUs preferably use different
+     * partitions.
+     */
+    Partition* _choosePartition(LockRequest* request) const;
+
+    /**
+     * Retrieves the Partition that a particular LockRequest uses for intent locking, as chosen
+     * when it was locked.
      */
     Partition* _getPartition(LockRequest* request) const;
 
@@ -381,6 +381,11 @@ struct LockRequest {
     // only transition from 'partitionedLock' to 'lock', never the other way around.
     PartitionedLockHead* partitionedLock;
 
+    // Index of the partition chosen for this request when it was first locked in an intent
+    // mode. Unlocking and migration must use the same partition, even if the locking thread has
+    // since moved to a different CPU. Only meaningful if 'partitioned' is set.
+    unsigned partitionId;
+
     // The reason intrusive linked list is used instead of the std::list class is to allow
     // for entries to be removed from the middle of the list in O(1) time, if they are known
     // instead of having to search for them and we cannot persist iterators, because the list
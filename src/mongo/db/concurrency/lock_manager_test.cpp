@@ -816,4 +816,49 @@ TEST(LockManager, CompatibleFirstCancelWaiting) {
     ASSERT(lockMgr.unlock(&requestX));
 }
 
+TEST(LockManager, IntentLocksStayPartitionedUntilConflict) {
+    LockManager lockMgr;
+    const ResourceId resId(RESOURCE_GLOBAL, 0);
+
+    MMAPV1LockerImpl lockerIS;
+    LockRequestCombo requestIS(&lockerIS);
+    ASSERT(LOCK_OK == lockMgr.lock(resId, &requestIS, MODE_IS));
+    ASSERT(requestIS.partitionedLock != NULL);
+
+    MMAPV1LockerImpl lockerIX;
+    LockRequestCombo requestIX(&lockerIX);
+    ASSERT(LOCK_OK == lockMgr.lock(resId, &requestIX, MODE_IX));
+    ASSERT(requestIX.partitionedLock != NULL);
+
+    // Cleanup leaves the held intent locks on their partitions
+    lockMgr.cleanupUnusedLocks();
+    ASSERT(requestIS.partitionedLock != NULL);
+    ASSERT(requestIX.partitionedLock != NULL);
+
+    // A conflicting request moves the intent requests to the regular LockHead and waits for them
+    MMAPV1LockerImpl lockerX;
+    LockRequestCombo requestX(&lockerX);
+    ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestX, MODE_X));
+    ASSERT(requestIS.partitionedLock == NULL);
+    ASSERT(requestIS.lock != NULL);
+    ASSERT(requestIX.partitionedLock == NULL);
+    ASSERT(requestIX.lock != NULL);
+
+    ASSERT(lockMgr.unlock(&requestIS));
+    ASSERT(requestX.numNotifies == 0);
+    ASSERT(lockMgr.unlock(&requestIX));
+    ASSERT(requestX.numNotifies == 1);
+    ASSERT(requestX.lastResult == LOCK_OK);
+
+    // Intent requests are not partitioned while the X lock is held
+    MMAPV1LockerImpl lockerPending;
+    LockRequestCombo requestPending(&lockerPending);
+    ASSERT(LOCK_WAITING == lockMgr.lock(resId, &requestPending, MODE_IX));
+    ASSERT(requestPending.partitionedLock == NULL);
+
+    ASSERT(lockMgr.unlock(&requestX));
+    ASSERT(requestPending.numNotifies == 1);
+    ASSERT(lockMgr.unlock(&requestPending));
+}
+
 }  // namespace mongo
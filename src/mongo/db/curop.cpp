@@ -253,6 +253,7 @@ void CurOp::reportState(BSONObjBuilder* builder) {
             BSONObjBuilder sub(builder->subobjStart("progress"));
             sub.appendNumber("done", (long long)_progressMeter.done());
             sub.appendNumber("total", (long long)_progressMeter.total());
+            sub.append("ratePerSec", _progressMeter.ratePerSecond());
             sub.done();
         } else {
             builder->append("msg", _message);
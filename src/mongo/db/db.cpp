@@ -40,6 +40,7 @@
 #include <signal.h>
 #include <string>
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
 #include "mongo/base/initializer.h"
 #include "mongo/base/status.h"
@@ -62,6 +63,7 @@
 #include "mongo/db/dbwebserver.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/index_rebuilder.h"
+#include "mongo/db/index_statistics_sampler.h"
 #include "mongo/db/initialize_server_global_state.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
@@ -146,6 +148,17 @@ ntservice::NtServiceDefaultStrings defaultServiceStrings = {
 
 Timer startupSrandTimer;
 
+/**
+ * Holds a connection's Client while it is detached from any thread between messages.
+ */
+class ClientSessionState : public MessageHandler::SessionState {
+public:
+    explicit ClientSessionState(ServiceContext::UniqueClient client)
+        : client(std::move(client)) {}
+
+    ServiceContext::UniqueClient client;
+};
+
 class MyMessageHandler : public MessageHandler {
 public:
     virtual void connected(AbstractMessagingPort* p) {
@@ -196,6 +209,17 @@ public:
             break;
         }
     }
+
+    virtual std::unique_ptr<SessionState> detachSession(AbstractMessagingPort* p) {
+        if (!haveClient()) {
+            return {};
+        }
+        return stdx::make_unique<ClientSessionState>(Client::releaseCurrent());
+    }
+
+    virtual void attachSession(AbstractMessagingPort* p, std::unique_ptr<SessionState> state) {
+        Client::setCurrent(std::move(checked_cast<ClientSessionState*>(state.get())->client));
+    }
 };
 
 static void logStartup() {
@@ -577,6 +601,7 @@ static void _initAndListen(int listenPort) {
         }
     }
 
+    startIndexStatisticsSamplerBackgroundJob();
     startClientCursorMonitor();
 
     PeriodicTask::startRunningPeriodicTasks();
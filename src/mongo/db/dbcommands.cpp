@@ -84,6 +84,7 @@
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/s/sharding_state.h"
+#include "mongo/db/stats/top.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/rpc/request_interface.h"
 #include "mongo/rpc/reply_builder_interface.h"
@@ -921,6 +922,14 @@ public:
         result.appendNumber("totalIndexSize", indexSize / scale);
         result.append("indexSizes", indexSizes.obj());
 
+        BSONObjBuilder indexStatistics(result.subobjStart("indexStatistics"));
+        collection->infoCache()->appendIndexStatisticsInfo(txn, &indexStatistics);
+        indexStatistics.doneFast();
+
+        BSONObjBuilder latencyStats(result.subobjStart("latencyStats"));
+        Top::get(txn->getClient()->getServiceContext()).appendLatencyStats(nss.ns(), &latencyStats);
+        latencyStats.doneFast();
+
         return true;
     }
 
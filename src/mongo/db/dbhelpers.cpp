@@ -34,6 +34,8 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
+#include <utility>
+#include <vector>
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/index_create.h"
@@ -302,7 +304,10 @@ long long Helpers::removeRange(OperationContext* txn,
                                const WriteConcernOptions& writeConcern,
                                RemoveSaver* callback,
                                bool fromMigrate,
-                               bool onlyRemoveOrphanedDocs) {
+                               bool onlyRemoveOrphanedDocs,
+                               int batchSize,
+                               const RemoveRangeBatchFn& onBatchDeleted) {
+    invariant(batchSize > 0);
     Timer rangeRemoveTimer;
     const string& ns = range.ns;
 
@@ -336,6 +341,10 @@ long long Helpers::removeRange(OperationContext* txn,
     Milliseconds millisWaitingForReplication{0};
 
     while (1) {
+        long long batchDocs = 0;
+        long long batchBytes = 0;
+        bool collectionChanged = false;
+
         // Scoping for write lock.
         {
             OldClientWriteContext ctx(txn, ns);
@@ -346,6 +355,8 @@ long long Helpers::removeRange(OperationContext* txn,
             IndexDescriptor* desc =
                 collection->getIndexCatalog()->findIndexByKeyPattern(txn, indexKeyPattern.toBSON());
 
+            // Find the whole batch with one walk of the index. The scan does not yield so that
+            // the documents found are still there when they are deleted below.
             unique_ptr<PlanExecutor> exec(
                 InternalPlanner::indexScan(txn,
                                            collection,
@@ -355,16 +366,18 @@ long long Helpers::removeRange(OperationContext* txn,
                                            maxInclusive,
                                            InternalPlanner::FORWARD,
                                            InternalPlanner::IXSCAN_FETCH));
-            exec->setYieldPolicy(PlanExecutor::YIELD_AUTO);
 
+            std::vector<std::pair<RecordId, BSONObj>> batch;
             RecordId rloc;
             BSONObj obj;
-            PlanExecutor::ExecState state;
-            // This may yield so we cannot touch nsd after this.
-            state = exec->getNext(&obj, &rloc);
-            exec.reset();
-            if (PlanExecutor::IS_EOF == state) {
-                break;
+            PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
+            while (static_cast<int>(batch.size()) < batchSize) {
+                state = exec->getNext(&obj, &rloc);
+                if (PlanExecutor::ADVANCED != state) {
+                    break;
+                }
+
+                batch.emplace_back(rloc, obj.getOwned());
             }
 
             if (PlanExecutor::FAILURE == state || PlanExecutor::DEAD == state) {
@@ -377,57 +390,73 @@ long long Helpers::removeRange(OperationContext* txn,
                 break;
             }
 
-            verify(PlanExecutor::ADVANCED == state);
+            exec.reset();
+            if (batch.empty()) {
+                break;
+            }
 
-            WriteUnitOfWork wuow(txn);
+            NamespaceString nss(ns);
+            if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(nss)) {
+                warning() << "stepped down from primary while deleting chunk; "
+                          << "orphaning data in " << ns << " in range [" << min << ", " << max
+                          << ")";
+                return numDeleted;
+            }
 
+            // In write lock, so will be the most up-to-date version
+            std::shared_ptr<CollectionMetadata> metadataNow;
             if (onlyRemoveOrphanedDocs) {
-                // Do a final check in the write lock to make absolutely sure that our
-                // collection hasn't been modified in a way that invalidates our migration
-                // cleanup.
-
                 // We should never be able to turn off the sharding state once enabled, but
                 // in the future we might want to.
                 verify(ShardingState::get(getGlobalServiceContext())->enabled());
+                metadataNow =
+                    ShardingState::get(getGlobalServiceContext())->getCollectionMetadata(ns);
+            }
 
-                bool docIsOrphan;
+            WriteUnitOfWork wuow(txn);
 
-                // In write lock, so will be the most up-to-date version
-                std::shared_ptr<CollectionMetadata> metadataNow =
-                    ShardingState::get(getGlobalServiceContext())->getCollectionMetadata(ns);
-                if (metadataNow) {
-                    ShardKeyPattern kp(metadataNow->getKeyPattern());
-                    BSONObj key = kp.extractShardKeyFromDoc(obj);
-                    docIsOrphan =
-                        !metadataNow->keyBelongsToMe(key) && !metadataNow->keyIsPending(key);
-                } else {
-                    docIsOrphan = false;
+            for (const auto& entry : batch) {
+                const BSONObj& doc = entry.second;
+
+                if (onlyRemoveOrphanedDocs) {
+                    // Do a final check in the write lock to make absolutely sure that our
+                    // collection hasn't been modified in a way that invalidates our migration
+                    // cleanup.
+                    bool docIsOrphan;
+                    if (metadataNow) {
+                        ShardKeyPattern kp(metadataNow->getKeyPattern());
+                        BSONObj key = kp.extractShardKeyFromDoc(doc);
+                        docIsOrphan =
+                            !metadataNow->keyBelongsToMe(key) && !metadataNow->keyIsPending(key);
+                    } else {
+                        docIsOrphan = false;
+                    }
+
+                    if (!docIsOrphan) {
+                        warning(LogComponent::kSharding)
+                            << "aborting migration cleanup for chunk " << min << " to " << max
+                            << (metadataNow ? (string) " at document " + doc.toString() : "")
+                            << ", collection " << ns << " has changed " << endl;
+                        collectionChanged = true;
+                        break;
+                    }
                 }
 
-                if (!docIsOrphan) {
-                    warning(LogComponent::kSharding)
-                        << "aborting migration cleanup for chunk " << min << " to " << max
-                        << (metadataNow ? (string) " at document " + obj.toString() : "")
-                        << ", collection " << ns << " has changed " << endl;
-                    break;
-                }
-            }
+                if (callback)
+                    callback->goingToDelete(doc);
 
-            NamespaceString nss(ns);
-            if (!repl::getGlobalReplicationCoordinator()->canAcceptWritesFor(nss)) {
-                warning() << "stepped down from primary while deleting chunk; "
-                          << "orphaning data in " << ns << " in range [" << min << ", " << max
-                          << ")";
-                return numDeleted;
+                BSONObj deletedId;
+                collection->deleteDocument(txn, entry.first, false, false, &deletedId);
+                batchDocs++;
+                batchBytes += doc.objsize();
             }
 
-            if (callback)
-                callback->goingToDelete(obj);
-
-            BSONObj deletedId;
-            collection->deleteDocument(txn, rloc, false, false, &deletedId);
             wuow.commit();
-            numDeleted++;
+            numDeleted += batchDocs;
+        }
+
+        if (onBatchDeleted && batchDocs > 0) {
+            onBatchDeleted(batchDocs, batchBytes);
         }
 
         // TODO remove once the yielding below that references this timer has been removed
@@ -447,6 +476,10 @@ long long Helpers::removeRange(OperationContext* txn,
             }
             millisWaitingForReplication += replStatus.duration;
         }
+
+        if (collectionChanged) {
+            break;
+        }
     }
 
     if (writeConcern.shouldWaitForOtherNodes())
@@ -32,6 +32,7 @@
 
 #include "mongo/db/db.h"
 #include "mongo/db/record_id.h"
+#include "mongo/stdx/functional.h"
 
 namespace mongo {
 
@@ -50,6 +51,12 @@ struct WriteConcernOptions;
 struct Helpers {
     class RemoveSaver;
 
+    /**
+     * Called by removeRange after each batch of deletes is committed and the collection lock
+     * released, with the number of documents and bytes deleted by the batch.
+     */
+    using RemoveRangeBatchFn = stdx::function<void(long long docs, long long bytes)>;
+
     /* ensure the specified index exists.
 
        @param keyPattern key pattern, e.g., { ts : 1 }
@@ -163,6 +170,9 @@ struct Helpers {
      *
      * Returns -1 when no usable index exists
      *
+     * Documents are deleted in batches of up to 'batchSize' documents, each found by a single
+     * walk of the index and deleted in a single unit of work under the collection lock.
+     *
      * Does oplog the individual document deletions.
      * // TODO: Refactor this mechanism, it is growing too large
      */
@@ -172,7 +182,9 @@ struct Helpers {
                                  const WriteConcernOptions& secondaryThrottle,
                                  RemoveSaver* callback = NULL,
                                  bool fromMigrate = false,
-                                 bool onlyRemoveOrphanedDocs = false);
+                                 bool onlyRemoveOrphanedDocs = false,
+                                 int batchSize = 1,
+                                 const RemoveRangeBatchFn& onBatchDeleted = RemoveRangeBatchFn());
 
 
     // TODO: This will supersede Chunk::MaxObjectsPerChunk
@@ -39,6 +39,7 @@
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cost_model.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/plan_yield_policy.h"
 #include "mongo/db/query/query_knobs.h"
@@ -234,6 +235,26 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache) {
         return Status::OK();
     }
 
+    // If the cost model can tell the candidates apart, use the cheapest one without a trial. As
+    // with a single solution, nothing is cached.
+    if (internalQueryPlannerEnableCostModel && !internalQueryForceIntersectionPlans) {
+        PlanCostModel costModel(_collection->numRecords(_txn),
+                                PlanCostModel::lookupIn(_plannerParams.indices));
+        auto best = costModel.pickBest(solutions.vector(), internalQueryPlannerCostModelMargin);
+        if (best) {
+            if (shouldCache) {
+                PlanCache* cache = _collection->infoCache()->getPlanCache();
+                cache->remove(*_canonicalQuery);
+            }
+
+            PlanStage* newRoot;
+            verify(StageBuilder::build(_txn, _collection, *solutions[*best], _ws, &newRoot));
+            _children.emplace_back(newRoot);
+            _replannedQs.reset(solutions.releaseAt(*best));
+            return Status::OK();
+        }
+    }
+
     // Many solutions. Create a MultiPlanStage to pick the best, update the cache,
     // and so on. The working set will be shared by all candidate plans.
     _children.emplace_back(new MultiPlanStage(_txn, _collection, _canonicalQuery, shouldCache));
@@ -86,12 +86,40 @@ private:
     const int _version;
 };
 
+/**
+ * Orders KeyStrings by their bytes. Sorted keys include their RecordIds, so there are no ties.
+ */
+class KeyStringSortComparison {
+public:
+    typedef std::pair<KeyString::Value, NullValue> Data;
+
+    int operator()(const Data& l, const Data& r) const {
+        return l.first.compare(r.first);
+    }
+};
+
+namespace {
+
+/**
+ * Returns an iterator over all of 'runs', which were sorted by 'comp', in order.
+ */
+template <typename Iterator, typename Comparator>
+std::shared_ptr<Iterator> mergeSortedRuns(const std::vector<std::shared_ptr<Iterator>>& runs,
+                                          const Comparator& comp) {
+    if (runs.size() == 1) {
+        return runs.front();
+    }
+    return std::shared_ptr<Iterator>(Iterator::merge(runs, SortOptions(), comp));
+}
+
+}  // namespace
+
 IndexAccessMethod::IndexAccessMethod(IndexCatalogEntry* btreeState, SortedDataInterface* btree)
     : _btreeState(btreeState), _descriptor(btreeState->descriptor()), _newInterface(btree) {
     verify(0 == _descriptor->version() || 1 == _descriptor->version());
 }
 
-bool IndexAccessMethod::ignoreKeyTooLong(OperationContext* txn) {
+bool IndexAccessMethod::ignoreKeyTooLong(OperationContext* txn) const {
     // Ignore this error if we're on a secondary or if the user requested it
     return !txn->isPrimaryFor(_btreeState->ns()) || !failIndexKeyTooLong;
 }
@@ -318,32 +346,59 @@ Status IndexAccessMethod::update(OperationContext* txn,
     return Status::OK();
 }
 
-std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk() {
-    return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor));
+std::unique_ptr<IndexAccessMethod::BulkBuilder> IndexAccessMethod::initiateBulk(
+    size_t maxMemoryUsageBytes) {
+    return std::unique_ptr<BulkBuilder>(new BulkBuilder(this, _descriptor, maxMemoryUsageBytes));
 }
 
 IndexAccessMethod::BulkBuilder::BulkBuilder(const IndexAccessMethod* index,
-                                            const IndexDescriptor* descriptor)
-    : _sorter(Sorter::make(
-          SortOptions()
-              .TempDir(storageGlobalParams.dbpath + "/_tmp")
-              .ExtSortAllowed()
-              .MaxMemoryUsageBytes(100 * 1024 * 1024),
-          BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version()))),
-      _real(index) {}
+                                            const IndexDescriptor* descriptor,
+                                            size_t maxMemoryUsageBytes)
+    // Version 0 indexes order keys differently than KeyStrings do.
+    : _useKeyStrings(descriptor->version() == 1 && index->_newInterface->storesKeyStrings()),
+      _ordering(Ordering::make(descriptor->keyPattern())),
+      _real(index) {
+    const SortOptions options = SortOptions()
+                                    .TempDir(storageGlobalParams.dbpath + "/_tmp")
+                                    .ExtSortAllowed()
+                                    .MaxMemoryUsageBytes(maxMemoryUsageBytes);
+    if (_useKeyStrings) {
+        _keyStringSorter.reset(KeyStringSorter::make(options, KeyStringSortComparison()));
+    } else {
+        _sorter.reset(Sorter::make(
+            options,
+            BtreeExternalSortComparison(descriptor->keyPattern(), descriptor->version())));
+    }
+}
 
 Status IndexAccessMethod::BulkBuilder::insert(OperationContext* txn,
                                               const BSONObj& obj,
                                               const RecordId& loc,
                                               const InsertDeleteOptions& options,
                                               int64_t* numInserted) {
+    invariant(_sorter || _keyStringSorter);
+
     BSONObjSet keys;
     _real->getKeys(obj, &keys);
 
     _isMultiKey = _isMultiKey || (keys.size() > 1);
 
     for (BSONObjSet::iterator it = keys.begin(); it != keys.end(); ++it) {
-        _sorter->add(*it, loc);
+        if (_useKeyStrings) {
+            // Keys that are too long are found here, as they can't be told apart once encoded.
+            Status status = _real->_newInterface->checkKeyLength(*it);
+            if (!status.isOK()) {
+                if (status.code() == ErrorCodes::KeyTooLong && _real->ignoreKeyTooLong(txn)) {
+                    continue;
+                }
+                return status;
+            }
+
+            _keyString.resetToKey(*it, _ordering, loc);
+            _keyStringSorter->add(_keyString.getValue(), NullValue());
+        } else {
+            _sorter->add(*it, loc);
+        }
         _keysInserted++;
     }
 
@@ -354,6 +409,28 @@ Status IndexAccessMethod::BulkBuilder::insert(OperationContext* txn,
     return Status::OK();
 }
 
+void IndexAccessMethod::BulkBuilder::sortKeys() {
+    if (_sorter) {
+        _sortedRuns.emplace_back(_sorter->done());
+        _sorter.reset();
+    }
+    if (_keyStringSorter) {
+        _sortedKeyStringRuns.emplace_back(_keyStringSorter->done());
+        _keyStringSorter.reset();
+    }
+}
+
+void IndexAccessMethod::BulkBuilder::merge(std::unique_ptr<BulkBuilder> other) {
+    invariant(other->_real == _real);
+
+    other->sortKeys();
+    _sortedRuns.insert(_sortedRuns.end(), other->_sortedRuns.begin(), other->_sortedRuns.end());
+    _sortedKeyStringRuns.insert(_sortedKeyStringRuns.end(),
+                                other->_sortedKeyStringRuns.begin(),
+                                other->_sortedKeyStringRuns.end());
+    _keysInserted += other->_keysInserted;
+    _isMultiKey = _isMultiKey || other->_isMultiKey;
+}
 
 Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                      std::unique_ptr<BulkBuilder> bulk,
@@ -362,7 +439,18 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
                                      set<RecordId>* dupsToDrop) {
     Timer timer;
 
-    std::unique_ptr<BulkBuilder::Sorter::Iterator> i(bulk->_sorter->done());
+    // Keys sorted separately by merged builders are combined as they are added to the index.
+    // Only one of 'keys' and 'keyStrings' is set, depending on the form the keys were sorted in.
+    bulk->sortKeys();
+    std::shared_ptr<BulkBuilder::Sorter::Iterator> keys;
+    std::shared_ptr<BulkBuilder::KeyStringSorter::Iterator> keyStrings;
+    if (bulk->_useKeyStrings) {
+        keyStrings = mergeSortedRuns(bulk->_sortedKeyStringRuns, KeyStringSortComparison());
+    } else {
+        keys = mergeSortedRuns(
+            bulk->_sortedRuns,
+            BtreeExternalSortComparison(_descriptor->keyPattern(), _descriptor->version()));
+    }
 
     stdx::unique_lock<Client> lk(*txn->getClient());
     ProgressMeterHolder pm(*txn->setMessage_inlock("Index Bulk Build: (2/3) btree bottom up",
@@ -385,7 +473,7 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
     }
     MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "setting index multikey flag", "");
 
-    while (i->more()) {
+    while (keys ? keys->more() : keyStrings->more()) {
         if (mayInterrupt) {
             txn->checkForInterrupt();
         }
@@ -398,8 +486,19 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
         txn->recoveryUnit()->setRollbackWritesDisabled();
 
         // Get the next datum and add it to the builder.
-        BulkBuilder::Sorter::Data d = i->next();
-        Status status = builder->addKey(d.first, d.second);
+        RecordId loc;
+        Status status = Status::OK();
+        if (keys) {
+            BulkBuilder::Sorter::Data d = keys->next();
+            loc = d.second;
+            status = builder->addKey(d.first, d.second);
+        } else {
+            const KeyString::Value keyString = keyStrings->next().first;
+            status = builder->addKeyString(keyString);
+            if (status.code() == ErrorCodes::DuplicateKey) {
+                loc = KeyString::decodeRecordIdAtEnd(keyString.getBuffer(), keyString.getSize());
+            }
+        }
 
         if (!status.isOK()) {
             // Overlong key that's OK to skip?
@@ -412,7 +511,7 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
                 invariant(!dupsAllowed);  // shouldn't be getting DupKey errors if dupsAllowed.
 
                 if (dupsToDrop) {
-                    dupsToDrop->insert(d.second);
+                    dupsToDrop->insert(loc);
                     continue;
                 }
             }
@@ -444,3 +543,4 @@ Status IndexAccessMethod::commitBulk(OperationContext* txn,
 
 #include "mongo/db/sorter/sorter.cpp"
 MONGO_CREATE_SORTER(mongo::BSONObj, mongo::RecordId, mongo::BtreeExternalSortComparison);
+MONGO_CREATE_SORTER(mongo::KeyString::Value, mongo::NullValue, mongo::KeyStringSortComparison);
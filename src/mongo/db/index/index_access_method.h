@@ -36,6 +36,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/db/storage/sorted_data_interface.h"
 
 namespace mongo {
@@ -193,14 +194,47 @@ public:
                       const InsertDeleteOptions& options,
                       int64_t* numInserted);
 
+        /**
+         * Sorts the keys inserted so far. No more keys may be inserted afterwards.
+         *
+         * commitBulk does this if it has not been done already. Builders filled on separate
+         * threads call it on those threads, so that their keys are sorted concurrently.
+         */
+        void sortKeys();
+
+        /**
+         * Takes over the keys of 'other', which must be a BulkBuilder for the same index. The
+         * sorted keys of both are merged as commitBulk inserts them into the index.
+         */
+        void merge(std::unique_ptr<BulkBuilder> other);
+
+        int64_t getKeysInserted() const {
+            return _keysInserted;
+        }
+
     private:
         friend class IndexAccessMethod;
 
         using Sorter = mongo::Sorter<BSONObj, RecordId>;
 
-        BulkBuilder(const IndexAccessMethod* index, const IndexDescriptor* descriptor);
+        // Sorts keys encoded as KeyStrings with the index's ordering and followed by their
+        // RecordIds, which order the same way when their bytes are compared.
+        using KeyStringSorter = mongo::Sorter<KeyString::Value, NullValue>;
+
+        BulkBuilder(const IndexAccessMethod* index,
+                    const IndexDescriptor* descriptor,
+                    size_t maxMemoryUsageBytes);
 
+        // Keys of indexes whose storage stores KeyStrings are sorted as KeyStrings, and keys of
+        // other indexes as BSON. Only the sorter for the form in use is set, until sortKeys().
+        const bool _useKeyStrings;
+        const Ordering _ordering;
         std::unique_ptr<Sorter> _sorter;
+        std::unique_ptr<KeyStringSorter> _keyStringSorter;
+        std::vector<std::shared_ptr<Sorter::Iterator>> _sortedRuns;
+        std::vector<std::shared_ptr<KeyStringSorter::Iterator>> _sortedKeyStringRuns;
+        KeyString _keyString;  // Reused to encode each key.
+
         const IndexAccessMethod* _real;
         int64_t _keysInserted = 0;
         bool _isMultiKey = false;
@@ -211,9 +245,12 @@ public:
      * You work on the returned BulkBuilder and then call commitBulk.
      * This can return NULL, meaning bulk mode is not available.
      *
+     * The BulkBuilder sorts keys in memory up to 'maxMemoryUsageBytes' and spills them to disk
+     * beyond that.
+     *
      * It is only legal to initiate bulk when the index is new and empty.
      */
-    std::unique_ptr<BulkBuilder> initiateBulk();
+    std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes);
 
     /**
      * Call this when you are ready to finish your bulk work.
@@ -237,7 +274,7 @@ public:
 
 protected:
     // Determines whether it's OK to ignore ErrorCodes::KeyTooLong for this OperationContext
-    bool ignoreKeyTooLong(OperationContext* txn);
+    bool ignoreKeyTooLong(OperationContext* txn) const;
 
     IndexCatalogEntry* _btreeState;  // owned by IndexCatalogEntry
     const IndexDescriptor* _descriptor;
@@ -0,0 +1,352 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/index_statistics_sampler.h"
+
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_info_cache.h"
+#include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/ops/delete.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_knobs.h"
+#include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/util/background.h"
+#include "mongo/util/exit.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+namespace {
+
+// Statistics describe this node's copy of the data, so they are kept out of the oplog.
+const NamespaceString kIndexStatisticsNamespace("local.system.indexStatistics");
+
+const char kIdField[] = "_id";
+const char kNsField[] = "ns";
+const char kIndexField[] = "index";
+const char kKeyPatternField[] = "keyPattern";
+const char kSampledAtField[] = "sampledAt";
+const char kNumRecordsField[] = "numRecords";
+const char kStatisticsField[] = "statistics";
+
+Counter64 samplerPasses;
+Counter64 samplerIndexesSampled;
+
+ServerStatusMetricField<Counter64> samplerPassesDisplay("indexStatisticsSampler.passes",
+                                                        &samplerPasses);
+ServerStatusMetricField<Counter64> samplerIndexesSampledDisplay(
+    "indexStatisticsSampler.indexesSampled", &samplerIndexesSampled);
+
+BSONObj makeId(StringData ns, StringData indexName) {
+    return BSON(kNsField << ns << kIndexField << indexName);
+}
+
+class IndexStatisticsSampler : public BackgroundJob {
+public:
+    IndexStatisticsSampler() {}
+    virtual ~IndexStatisticsSampler() {}
+
+    virtual std::string name() const {
+        return "IndexStatisticsSampler";
+    }
+
+    virtual void run() {
+        Client::initThread(name().c_str());
+        AuthorizationSession::get(cc())->grantInternalAuthorization();
+
+        bool loaded = false;
+        while (!inShutdown()) {
+            sleepsecs(internalQueryIndexStatisticsSamplerSleepSecs);
+
+            LOG(3) << "IndexStatisticsSampler thread awake";
+
+            if (!internalQueryIndexStatisticsSamplerEnabled) {
+                LOG(1) << "IndexStatisticsSampler is disabled";
+                continue;
+            }
+
+            try {
+                OperationContextImpl txn;
+                if (!loaded) {
+                    loadPersistedStatistics(&txn);
+                    loaded = true;
+                }
+                doPass(&txn);
+            } catch (const DBException& ex) {
+                warning() << "IndexStatisticsSampler pass failed: " << ex.toStatus();
+            }
+        }
+    }
+
+private:
+    void doPass(OperationContext* txn) {
+        // If part of a replica set but not in a readable state (e.g. during initial sync), skip.
+        if (repl::getGlobalReplicationCoordinator()->getReplicationMode() ==
+                repl::ReplicationCoordinator::modeReplSet &&
+            !repl::getGlobalReplicationCoordinator()->getMemberState().readable()) {
+            return;
+        }
+
+        std::set<std::string> dbs;
+        dbHolder().getAllShortNames(dbs);
+
+        samplerPasses.increment();
+
+        BSONObjSet sampledIndexes;
+        for (const std::string& dbName : dbs) {
+            if (dbName == kIndexStatisticsNamespace.db()) {
+                continue;
+            }
+
+            for (const std::string& ns : getCollectionNamespaces(txn, dbName)) {
+                sampleCollection(txn, ns, &sampledIndexes);
+            }
+        }
+
+        pruneStatistics(txn, sampledIndexes);
+    }
+
+    std::list<std::string> getCollectionNamespaces(OperationContext* txn,
+                                                   const std::string& dbName) {
+        std::list<std::string> namespaces;
+        ScopedTransaction transaction(txn, MODE_IS);
+        Lock::DBLock dbLock(txn->lockState(), dbName, MODE_IS);
+
+        Database* db = dbHolder().get(txn, dbName);
+        if (db) {
+            db->getDatabaseCatalogEntry()->getCollectionNamespaces(&namespaces);
+        }
+        return namespaces;
+    }
+
+    /**
+     * Refreshes the statistics of each btree index of 'ns' that has none or whose statistics
+     * went stale, and persists the new ones. Adds the _id under which each btree index's
+     * statistics are persisted to 'sampledIndexes'.
+     *
+     * Each index is sampled by a yielding scan, so the collection and its indexes are looked up
+     * again for every index.
+     */
+    void sampleCollection(OperationContext* txn,
+                          const std::string& ns,
+                          BSONObjSet* sampledIndexes) {
+        std::vector<std::string> indexNames;
+        {
+            ScopedTransaction transaction(txn, MODE_IS);
+            AutoGetDb autoDb(txn, ns, MODE_IS);
+            Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+
+            Database* db = autoDb.getDb();
+            Collection* collection = db ? db->getCollection(ns) : nullptr;
+            if (!collection) {
+                return;
+            }
+
+            IndexCatalog::IndexIterator ii =
+                collection->getIndexCatalog()->getIndexIterator(txn, false);
+            while (ii.more()) {
+                const IndexDescriptor* desc = ii.next();
+                if (desc->getAccessMethodName() == IndexNames::BTREE) {
+                    indexNames.push_back(desc->indexName());
+                    sampledIndexes->insert(makeId(ns, desc->indexName()));
+                }
+            }
+        }
+
+        std::vector<BSONObj> docs;
+        for (const std::string& indexName : indexNames) {
+            ScopedTransaction transaction(txn, MODE_IS);
+            AutoGetDb autoDb(txn, ns, MODE_IS);
+            Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+
+            Database* db = autoDb.getDb();
+            Collection* collection = db ? db->getCollection(ns) : nullptr;
+            if (!collection) {
+                return;
+            }
+            const IndexDescriptor* desc =
+                collection->getIndexCatalog()->findIndexByName(txn, indexName);
+            if (!desc) {
+                continue;
+            }
+
+            auto entry = collection->infoCache()->refreshIndexStatistics(
+                txn, desc, internalQueryCostModelMaxKeysScanned, PlanExecutor::YIELD_AUTO);
+            if (!entry) {
+                continue;
+            }
+            samplerIndexesSampled.increment();
+
+            // Key patterns may have dotted field names, which cannot be stored as is.
+            docs.push_back(BSON(kIdField << makeId(ns, indexName) << kKeyPatternField
+                                         << desc->keyPattern().toString() << kSampledAtField
+                                         << entry->sampledAt << kNumRecordsField
+                                         << entry->numRecords << kStatisticsField
+                                         << entry->stats->toBSON()));
+        }
+
+        for (const BSONObj& doc : docs) {
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                ScopedTransaction transaction(txn, MODE_IX);
+                Lock::DBLock dbLock(txn->lockState(), kIndexStatisticsNamespace.db(), MODE_X);
+                Helpers::upsert(txn, kIndexStatisticsNamespace.ns(), doc);
+            }
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_END(
+                txn, "persist index statistics", kIndexStatisticsNamespace.ns());
+        }
+    }
+
+    /**
+     * Removes the persisted statistics of indexes that no longer exist.
+     */
+    void pruneStatistics(OperationContext* txn, const BSONObjSet& sampledIndexes) {
+        std::vector<BSONObj> dropped;
+        {
+            DBDirectClient client(txn);
+            const BSONObj fields = BSON(kIdField << 1);
+            auto cursor = client.query(kIndexStatisticsNamespace.ns(), Query(), 0, 0, &fields);
+            while (cursor && cursor->more()) {
+                BSONElement idElt = cursor->nextSafe()[kIdField];
+                if (idElt.type() == Object && !sampledIndexes.count(idElt.Obj())) {
+                    dropped.push_back(idElt.Obj().getOwned());
+                }
+            }
+        }
+
+        for (const BSONObj& id : dropped) {
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+                ScopedTransaction transaction(txn, MODE_IX);
+                AutoGetDb autoDb(txn, kIndexStatisticsNamespace.db(), MODE_X);
+                if (!autoDb.getDb()) {
+                    return;
+                }
+                deleteObjects(txn,
+                              autoDb.getDb(),
+                              kIndexStatisticsNamespace.ns(),
+                              BSON(kIdField << id),
+                              PlanExecutor::YIELD_MANUAL,
+                              true,   // justOne
+                              true);  // god
+            }
+            MONGO_WRITE_CONFLICT_RETRY_LOOP_END(
+                txn, "prune index statistics", kIndexStatisticsNamespace.ns());
+        }
+    }
+
+    /**
+     * Installs the statistics persisted by an earlier run for every index that still exists with
+     * the same key pattern.
+     */
+    void loadPersistedStatistics(OperationContext* txn) {
+        std::vector<BSONObj> docs;
+        {
+            DBDirectClient client(txn);
+            auto cursor = client.query(kIndexStatisticsNamespace.ns(), Query());
+            while (cursor && cursor->more()) {
+                docs.push_back(cursor->nextSafe().getOwned());
+            }
+        }
+
+        size_t numLoaded = 0;
+        for (const BSONObj& doc : docs) {
+            BSONElement idElt = doc[kIdField];
+            BSONElement statsElt = doc[kStatisticsField];
+            if (idElt.type() != Object || statsElt.type() != Object ||
+                doc[kSampledAtField].type() != Date || !doc[kNumRecordsField].isNumber()) {
+                warning() << "ignoring malformed index statistics: " << doc[kIdField];
+                continue;
+            }
+
+            auto stats = IndexStatistics::fromBSON(statsElt.Obj());
+            if (!stats.isOK()) {
+                warning() << "ignoring malformed index statistics: " << doc[kIdField] << ": "
+                          << stats.getStatus();
+                continue;
+            }
+
+            const std::string ns = idElt.Obj()[kNsField].str();
+            const std::string indexName = idElt.Obj()[kIndexField].str();
+            if (!NamespaceString(ns).isValid()) {
+                continue;
+            }
+
+            ScopedTransaction transaction(txn, MODE_IS);
+            AutoGetDb autoDb(txn, ns, MODE_IS);
+            Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+
+            Database* db = autoDb.getDb();
+            Collection* collection = db ? db->getCollection(ns) : nullptr;
+            const IndexDescriptor* desc = collection
+                ? collection->getIndexCatalog()->findIndexByName(txn, indexName)
+                : nullptr;
+            if (!desc || desc->keyPattern().toString() != doc[kKeyPatternField].str()) {
+                continue;
+            }
+
+            collection->infoCache()->setIndexStatistics(
+                indexName,
+                {std::make_shared<const IndexStatistics>(std::move(stats.getValue())),
+                 doc[kNumRecordsField].numberLong(),
+                 doc[kSampledAtField].Date()});
+            ++numLoaded;
+        }
+
+        LOG(1) << "IndexStatisticsSampler loaded persisted statistics for " << numLoaded
+               << " indexes";
+    }
+};
+
+}  // namespace
+
+void startIndexStatisticsSamplerBackgroundJob() {
+    IndexStatisticsSampler* sampler = new IndexStatisticsSampler();
+    sampler->go();
+}
+
+}  // namespace mongo
@@ -58,6 +58,10 @@ public:
         return &_pattern;
     };
 
+    const MatchExpression* getMatchExpression() const {
+        return _expression.get();
+    }
+
     std::string toString() const {
         return _pattern.toString();
     }
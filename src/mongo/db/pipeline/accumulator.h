@@ -75,6 +75,11 @@ public:
     /// The name of the op as used in a serialization of the pipeline.
     virtual const char* getOpName() const = 0;
 
+    /// True if the result depends on the order in which the inputs are processed.
+    virtual bool isOrderSensitive() const {
+        return false;
+    }
+
     int memUsageForSorter() const {
         dassert(_memUsageBytes != 0);  // This would mean subclass didn't set it
         return _memUsageBytes;
@@ -133,6 +138,9 @@ public:
     Value getValue(bool toBeMerged) const final;
     const char* getOpName() const final;
     void reset() final;
+    bool isOrderSensitive() const final {
+        return true;
+    }
 
     static boost::intrusive_ptr<Accumulator> create();
 
@@ -150,6 +158,9 @@ public:
     Value getValue(bool toBeMerged) const final;
     const char* getOpName() const final;
     void reset() final;
+    bool isOrderSensitive() const final {
+        return true;
+    }
 
     static boost::intrusive_ptr<Accumulator> create();
 
@@ -207,6 +218,9 @@ public:
     Value getValue(bool toBeMerged) const final;
     const char* getOpName() const final;
     void reset() final;
+    bool isOrderSensitive() const final {
+        return true;
+    }
 
     static boost::intrusive_ptr<Accumulator> create();
 
@@ -31,10 +31,15 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
 
+// Batches start small so that a pipeline which only needs a few documents doesn't read ahead,
+// and double up to this size.
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceVectorizedBatchSize, int, 1024);
+
 using Parser = DocumentSource::Parser;
 using boost::intrusive_ptr;
 using std::string;
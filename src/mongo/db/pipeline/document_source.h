@@ -50,6 +50,7 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/vectorized_expression.h"
 #include "mongo/db/sorter/sorter.h"
 #include "mongo/s/strategy.h"
 #include "mongo/stdx/functional.h"
@@ -387,6 +388,115 @@ private:
 };
 
 
+// Maximum number of threads a single aggregation may scan its collection with, and the number of
+// records a collection needs for a scan to be split at all.
+extern int internalDocumentSourceParallelScanMaxWorkers;
+extern int internalDocumentSourceParallelScanMinRecords;
+
+/**
+ * Scans a collection with several threads. Each worker reads its share of the ranges the
+ * collection's RecordStore divides itself into (see RecordStore::getParallelCursors()), filters
+ * them with the query, and passes the documents through its own copy of the stages preceding a
+ * $group and of the $group itself. The $group of each worker produces partial groups, which this
+ * source returns and the $group's merge source must then combine.
+ *
+ * The workers' $groups and the partial groups waiting to be returned share the memory limit of a
+ * single $group. Each worker's $group spills or fails on its share like any other $group, and a
+ * worker waits for getNext() while the partial groups waiting to be returned exceed theirs.
+ *
+ * Created by PipelineD in place of a DocumentSourceCursor; never parsed. Workers are only started
+ * by the first call to getNext(), and are stopped by dispose() if not all results are read.
+ */
+class DocumentSourceParallelScan final : public DocumentSource {
+public:
+    // virtuals from DocumentSource
+    ~DocumentSourceParallelScan() final;
+    boost::optional<Document> getNext() final;
+    const char* getSourceName() const final;
+    Value serialize(bool explain = false) const final;
+    void setSource(DocumentSource* pSource) final;
+    bool isValidInitialSource() const final {
+        return true;
+    }
+    void dispose() final;
+
+    /**
+     * Creates a source scanning 'ns' with at most 'maxWorkers' threads. The documents matching
+     * 'query' are reduced to the fields in 'deps' and run through 'workerStages', which must end
+     * with a $group. 'workerStages' are only used as a template; each worker parses its own copy.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelScan> create(
+        const std::string& ns,
+        const BSONObj& query,
+        const DepsTracker& deps,
+        const std::vector<boost::intrusive_ptr<DocumentSource>>& workerStages,
+        int maxWorkers,
+        const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
+
+    /**
+     * What each worker did, reported by explain once the scan has run.
+     */
+    struct WorkerStats {
+        long long ranges = 0;
+        long long partialGroups = 0;
+        long long executionTimeMillis = 0;
+    };
+
+private:
+    struct Worker;
+    struct SharedState;
+
+    DocumentSourceParallelScan(const std::string& ns,
+                               const BSONObj& query,
+                               const DepsTracker& deps,
+                               std::vector<BSONObj> workerStageSpecs,
+                               int maxWorkers,
+                               const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
+
+    /**
+     * Splits the collection among the workers and schedules them on the shared pool. Leaves _state
+     * unset if the collection no longer exists.
+     */
+    void startScan();
+
+    /**
+     * Called once the workers have returned all their results or one of them failed. Waits for
+     * them, throws the first error any worker hit, and records their stats.
+     */
+    void finishScan();
+
+    /**
+     * Body of a worker. Runs on a pool thread with its own Client and OperationContext.
+     */
+    void runWorker(Worker* worker) const;
+
+    /**
+     * Waits for all scheduled workers to finish, interrupting them if this operation is
+     * interrupted or 'kill' is true. Then releases the executors of workers which never ran.
+     */
+    void waitForWorkers(bool kill);
+
+    const std::string _ns;
+    const int _maxWorkers;
+
+    // _query must outlive the workers' filter, which has views into it.
+    const BSONObj _query;
+    const BSONObj _projection;
+    const boost::optional<ParsedDeps> _dependencies;
+    const std::vector<BSONObj> _workerStageSpecs;
+
+    // Workers and what they share. Only exists while the scan runs.
+    std::unique_ptr<SharedState> _state;
+
+    bool _scanned = false;
+    std::vector<WorkerStats> _workerStats;
+};
+
+
+// Memory a $group may use before spilling, and the number of partitions it spills by.
+extern int internalDocumentSourceGroupMaxMemoryBytes;
+extern int internalDocumentSourceGroupNumPartitions;
+
 class DocumentSourceGroup final : public DocumentSource, public SplittableDocumentSource {
 public:
     // virtuals from DocumentSource
@@ -421,6 +531,9 @@ public:
         _doingMerge = doingMerge;
     }
 
+    /// True if any accumulator's result depends on the order of the input, e.g. $first.
+    bool hasOrderSensitiveAccumulator() const;
+
     /**
       Create a grouping DocumentSource from BSON.
 
@@ -439,9 +552,101 @@ public:
     boost::intrusive_ptr<DocumentSource> getShardSource() final;
     boost::intrusive_ptr<DocumentSource> getMergeSource() final;
 
+    /**
+     * Statistics about the data this stage wrote to disk because it exceeded its memory limit.
+     */
+    struct SpillStats {
+        // Number of times a partition, or the groups of a partition being re-aggregated, were
+        // written to disk.
+        long long spills = 0;
+        long long spilledGroups = 0;
+        // Approximate in-memory size of the spilled groups.
+        long long spilledBytes = 0;
+        // Number of spilled partitions which had to be re-aggregated from disk.
+        long long partitionsReaggregated = 0;
+    };
+
+    const SpillStats& getSpillStats() const {
+        return _spillStats;
+    }
+
+    /**
+     * Overrides the internalDocumentSourceGroupMaxMemoryBytes limit, for a $group which shares the
+     * limit with others. Must be called before the first getNext().
+     */
+    void setMaxMemoryUsageBytes(long long bytes) {
+        _maxMemoryUsageBytes = bytes;
+    }
+
 private:
     explicit DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
+    typedef std::vector<boost::intrusive_ptr<Accumulator>> Accumulators;
+    typedef std::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
+
+    /**
+     * The groups whose keys hash to one slice of the key space.
+     *
+     * While the input is consumed, partitions are spilled to disk one at a time whenever the
+     * groups use more than _maxMemoryUsageBytes. Groups of a spilled partition continue to be
+     * aggregated in memory until the partition is spilled again, and the partial aggregates on
+     * disk are merged back together once the input is exhausted.
+     */
+    struct Partition {
+        GroupsMap groups;
+        long long memoryUsageBytes = 0;
+
+        // Set while the input is consumed for a partition which has been spilled.
+        std::unique_ptr<SortedFileWriter<Value, Value>> spillWriter;
+
+        // Set once the input is exhausted for a partition which has been spilled.
+        std::unique_ptr<Sorter<Value, Value>::Iterator> spilledData;
+
+        bool isSpilled() const {
+            return spillWriter || spilledData;
+        }
+    };
+
+    /**
+     * Returns the partition which the group with key "id" belongs to.
+     */
+    Partition& partitionFor(const Value& id);
+
+    /**
+     * Writes the groups of "partition" to its spill file and frees their memory.
+     */
+    void spillPartition(Partition* partition);
+
+    /**
+     * Spills partitions until the memory used by the groups is back under half the limit.
+     * Partitions which have already been spilled are preferred, so that the groups of the others
+     * can stay in memory for the duration of the aggregation.
+     */
+    void spillPartitions();
+
+    /**
+     * Accounts for "numGroups" groups using "bytes" of memory having been written to disk.
+     */
+    void recordSpill(size_t numGroups, long long bytes);
+
+    /**
+     * Makes the next partition with groups available to getNext(), either by moving its groups
+     * into 'groups' or by re-aggregating them from disk. Returns false if there are no more.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Merges the partial aggregates spilled for "partition" into 'groups', falling back to an
+     * external sort of the groups through _sorterIterator if they do not fit in memory.
+     */
+    void reaggregatePartition(Partition* partition);
+
+    /**
+     * Converts the state of "accums" to a single Value, which mergeAccumulators() can add back.
+     */
+    Value serializeAccumulators(const Accumulators& accums) const;
+    void mergeAccumulators(const Value& serialized, Accumulators* accums) const;
+
     /// Spill groups map to disk and returns an iterator to the file.
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
@@ -474,8 +679,7 @@ private:
     Value expandId(const Value& val);
 
 
-    typedef std::vector<boost::intrusive_ptr<Accumulator>> Accumulators;
-    typedef std::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
+    // The groups currently being output.
     GroupsMap groups;
 
     /*
@@ -498,23 +702,30 @@ private:
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     bool _doingMerge;
-    bool _spilled;
     const bool _extSortAllowed;
-    const int _maxMemoryUsageBytes;
+    long long _maxMemoryUsageBytes;
     std::unique_ptr<Variables> _variables;
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
 
-    // only used when !_spilled
+    std::vector<Partition> _partitions;
+    size_t _nextPartition;
+    long long _memoryUsageBytes;
+    SpillStats _spillStats;
+
+    // only used when !_sorterIterator
     GroupsMap::iterator groupsIterator;
 
-    // only used when _spilled
+    // only used when the groups of the partition being output did not fit in memory
     std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
     std::pair<Value, Value> _firstPartOfNextGroup;
     Value _currentId;
     Accumulators _currentAccumulators;
 };
 
+// Largest number of documents $match and $project evaluate together as one batch. 0 evaluates
+// them one at a time.
+extern int internalDocumentSourceVectorizedBatchSize;
 
 class DocumentSourceMatch final : public DocumentSource {
 public:
@@ -559,8 +770,22 @@ private:
     DocumentSourceMatch(const BSONObj& query,
                         const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
+    /**
+     * Refills '_batch' from the source, evaluating '_predicate' over it. Returns false at EOF.
+     */
+    bool loadBatch();
+
     std::unique_ptr<Matcher> matcher;
     bool _isTextQuery;
+
+    // Batch evaluation state. '_predicate' is compiled from 'matcher' on the first getNext(), and
+    // is null if the query has nothing it can decide.
+    bool _compiled = false;
+    std::unique_ptr<VectorizedPredicate> _predicate;
+    std::vector<Document> _batch;
+    std::vector<VectorizedPredicate::Result> _batchResults;
+    size_t _batchPosition = 0;
+    size_t _nextBatchSize = 0;
 };
 
 class DocumentSourceMergeCursors : public DocumentSource {
@@ -736,10 +961,23 @@ private:
     DocumentSourceProject(const boost::intrusive_ptr<ExpressionContext>& pExpCtx,
                           const boost::intrusive_ptr<ExpressionObject>& exprObj);
 
+    /**
+     * Refills '_batch' from the source, evaluating '_vectorized' over it. Returns false at EOF.
+     */
+    bool loadBatch();
+
     // configuration state
     std::unique_ptr<Variables> _variables;
     boost::intrusive_ptr<ExpressionObject> pEO;
     BSONObj _raw;
+
+    // Batch evaluation state. On the first getNext(), the computed fields of 'pEO' which can be
+    // evaluated a batch at a time are replaced by the ExpressionVectorized in '_vectorized'.
+    bool _compiled = false;
+    std::vector<boost::intrusive_ptr<ExpressionVectorized>> _vectorized;
+    std::vector<Document> _batch;
+    size_t _batchPosition = 0;
+    size_t _nextBatchSize = 0;
 };
 
 class DocumentSourceRedact final : public DocumentSource {
@@ -845,6 +1083,11 @@ public:
         return limitSrc;
     }
 
+    /// Returns true if this stage merges the presorted output of the shards' cursors.
+    bool isMergingPresorted() const {
+        return _mergingPresorted;
+    }
+
 private:
     explicit DocumentSourceSort(const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
@@ -28,7 +28,10 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
@@ -36,9 +39,33 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+// Memory the groups of a $group may use before they are spilled to disk, if allowDiskUse is set.
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupMaxMemoryBytes, int, 100 * 1024 * 1024);
+
+// Number of partitions the key space of a $group is divided into for spilling.
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupNumPartitions, int, 32);
+
+namespace {
+
+Counter64 groupSpills;
+Counter64 groupSpilledGroups;
+Counter64 groupSpilledBytes;
+Counter64 groupPartitionsReaggregated;
+
+ServerStatusMetricField<Counter64> displayGroupSpills("aggregation.group.spills", &groupSpills);
+ServerStatusMetricField<Counter64> displayGroupSpilledGroups("aggregation.group.spilledGroups",
+                                                             &groupSpilledGroups);
+ServerStatusMetricField<Counter64> displayGroupSpilledBytes("aggregation.group.spilledBytes",
+                                                            &groupSpilledBytes);
+ServerStatusMetricField<Counter64> displayGroupPartitionsReaggregated(
+    "aggregation.group.partitionsReaggregated", &groupPartitionsReaggregated);
+
+}  // namespace
+
 using boost::intrusive_ptr;
 using std::shared_ptr;
 using std::pair;
@@ -56,67 +83,53 @@ boost::optional<Document> DocumentSourceGroup::getNext() {
     if (!populated)
         populate();
 
-    if (_spilled) {
-        if (!_sorterIterator)
-            return boost::none;
-
-        const size_t numAccumulators = vpAccumulatorFactory.size();
-        for (size_t i = 0; i < numAccumulators; i++) {
-            _currentAccumulators[i]->reset();  // prep accumulators for a new group
-        }
-
-        _currentId = _firstPartOfNextGroup.first;
-        while (_currentId == _firstPartOfNextGroup.first) {
-            // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
-            // At loop exit, it is the first value to be processed in the next group.
-
-            switch (numAccumulators) {  // mirrors switch in spill()
-                case 0:                 // no Accumulators so no Values
-                    break;
+    while (true) {
+        if (_sorterIterator) {
+            const size_t numAccumulators = vpAccumulatorFactory.size();
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators[i]->reset();  // prep accumulators for a new group
+            }
 
-                case 1:  // single accumulators serialize as a single Value
-                    _currentAccumulators[0]->process(_firstPartOfNextGroup.second,
-                                                     /*merging=*/true);
-                    break;
+            _currentId = _firstPartOfNextGroup.first;
+            while (_currentId == _firstPartOfNextGroup.first) {
+                // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
+                // At loop exit, it is the first value to be processed in the next group.
+                mergeAccumulators(_firstPartOfNextGroup.second, &_currentAccumulators);
 
-                default: {  // multiple accumulators serialize as an array
-                    const vector<Value>& accumulatorStates =
-                        _firstPartOfNextGroup.second.getArray();
-                    for (size_t i = 0; i < numAccumulators; i++) {
-                        _currentAccumulators[i]->process(accumulatorStates[i],
-                                                         /*merging=*/true);
-                    }
+                if (!_sorterIterator->more()) {
+                    _sorterIterator.reset();
                     break;
                 }
-            }
 
-            if (!_sorterIterator->more()) {
-                dispose();
-                break;
+                _firstPartOfNextGroup = _sorterIterator->next();
             }
 
-            _firstPartOfNextGroup = _sorterIterator->next();
+            return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
         }
 
-        return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+        if (groupsIterator != groups.end()) {
+            Document out =
+                makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->inShard);
+            ++groupsIterator;
+            return out;
+        }
 
-    } else {
-        if (groups.empty())
+        if (_partitions.empty()) {
+            // Already disposed.
             return boost::none;
+        }
 
-        Document out =
-            makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->inShard);
-
-        if (++groupsIterator == groups.end())
+        if (!loadNextPartition()) {
             dispose();
-
-        return out;
+            return boost::none;
+        }
     }
 }
 
 void DocumentSourceGroup::dispose() {
     // free our resources
     GroupsMap().swap(groups);
+    _partitions.clear();
     _sorterIterator.reset();
 
     // make us look done
@@ -201,9 +214,19 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
     : DocumentSource(pExpCtx),
       populated(false),
       _doingMerge(false),
-      _spilled(false),
       _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter),
-      _maxMemoryUsageBytes(100 * 1024 * 1024) {}
+      _maxMemoryUsageBytes(internalDocumentSourceGroupMaxMemoryBytes),
+      _nextPartition(0),
+      _memoryUsageBytes(0) {}
+
+bool DocumentSourceGroup::hasOrderSensitiveAccumulator() const {
+    for (const Accumulator::Factory& factory : vpAccumulatorFactory) {
+        if (factory()->isOrderSensitive()) {
+            return true;
+        }
+    }
+    return false;
+}
 
 void DocumentSourceGroup::addAccumulator(const std::string& fieldName,
                                          Accumulator::Factory accumulatorFactory,
@@ -305,23 +328,27 @@ public:
 };
 }
 
+DocumentSourceGroup::Partition& DocumentSourceGroup::partitionFor(const Value& id) {
+    // Scramble the hash so that the choice of partition is independent of the bucket the group
+    // lands in within the partition's hash table.
+    const uint64_t hash = static_cast<uint64_t>(Value::Hash()(id)) * 0x9E3779B97F4A7C15ULL;
+    return _partitions[(hash >> 32) % _partitions.size()];
+}
+
 void DocumentSourceGroup::populate() {
     const size_t numAccumulators = vpAccumulatorFactory.size();
     dassert(numAccumulators == vpExpression.size());
 
-    // pushed to on spill()
-    vector<shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles;
-    int memoryUsageBytes = 0;
+    _partitions.resize(std::max(1, internalDocumentSourceGroupNumPartitions));
 
     // This loop consumes all input from pSource and buckets it based on pIdExpression.
     while (boost::optional<Document> input = pSource->getNext()) {
-        if (memoryUsageBytes > _maxMemoryUsageBytes) {
+        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
             uassert(16945,
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _extSortAllowed);
-            sortedFiles.push_back(spill());
-            memoryUsageBytes = 0;
+            spillPartitions();
         }
 
         _variables->setRoot(*input);
@@ -334,15 +361,17 @@ void DocumentSourceGroup::populate() {
             id = Value(BSONNULL);
 
         /*
-          Look for the _id value in the map; if it's not there, add a
+          Look for the _id value in its partition; if it's not there, add a
           new entry with a blank accumulator.
         */
-        const size_t oldSize = groups.size();
-        vector<intrusive_ptr<Accumulator>>& group = groups[id];
-        const bool inserted = groups.size() != oldSize;
+        Partition& partition = partitionFor(id);
+        const long long oldMemoryUsageBytes = partition.memoryUsageBytes;
+        const size_t oldSize = partition.groups.size();
+        vector<intrusive_ptr<Accumulator>>& group = partition.groups[id];
+        const bool inserted = partition.groups.size() != oldSize;
 
         if (inserted) {
-            memoryUsageBytes += id.getApproximateSize();
+            partition.memoryUsageBytes += id.getApproximateSize();
 
             // Add the accumulators
             group.reserve(numAccumulators);
@@ -352,7 +381,7 @@ void DocumentSourceGroup::populate() {
         } else {
             for (size_t i = 0; i < numAccumulators; i++) {
                 // subtract old mem usage. New usage added back after processing.
-                memoryUsageBytes -= group[i]->memUsageForSorter();
+                partition.memoryUsageBytes -= group[i]->memUsageForSorter();
             }
         }
 
@@ -360,8 +389,9 @@ void DocumentSourceGroup::populate() {
         dassert(numAccumulators == group.size());
         for (size_t i = 0; i < numAccumulators; i++) {
             group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-            memoryUsageBytes += group[i]->memUsageForSorter();
+            partition.memoryUsageBytes += group[i]->memUsageForSorter();
         }
+        _memoryUsageBytes += partition.memoryUsageBytes - oldMemoryUsageBytes;
 
         // We are done with the ROOT document so release it.
         _variables->clearRoot();
@@ -374,40 +404,221 @@ void DocumentSourceGroup::populate() {
                 &&
                 !_extSortAllowed  // don't change behavior when testing external sort
                 &&
-                sortedFiles.size() < 20  // don't open too many FDs
+                _spillStats.spills < 20  // don't write too many times
                 ) {
-                sortedFiles.push_back(spill());
+                spillPartition(&partition);
+            }
+        }
+    }
+
+    // Finish the spill files, so that the spilled partitions hold nothing in memory until they are
+    // re-aggregated. The partitions which were never spilled are output first, which frees their
+    // memory before any re-aggregation starts.
+    for (auto&& partition : _partitions) {
+        if (partition.isSpilled()) {
+            if (!partition.groups.empty()) {
+                spillPartition(&partition);
+            }
+            partition.spilledData.reset(partition.spillWriter->done());
+            partition.spillWriter.reset();
+        }
+    }
+    std::stable_partition(_partitions.begin(),
+                          _partitions.end(),
+                          [](const Partition& partition) { return !partition.isSpilled(); });
+
+    // prepare current to accumulate data
+    _currentAccumulators.reserve(numAccumulators);
+    for (size_t i = 0; i < numAccumulators; i++) {
+        _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+    }
+
+    // getNext() will load the first partition.
+    _nextPartition = 0;
+    groupsIterator = groups.end();
+
+    populated = true;
+}
+
+void DocumentSourceGroup::spillPartition(Partition* partition) {
+    if (!partition->spillWriter) {
+        partition->spillWriter.reset(
+            new SortedFileWriter<Value, Value>(SortOptions().TempDir(pExpCtx->tempDir)));
+    }
+
+    // The partial aggregates of a partition are only read back sequentially, never merged, so
+    // they are written in hash table order.
+    for (GroupsMap::const_iterator it = partition->groups.begin(), end = partition->groups.end();
+         it != end;
+         ++it) {
+        partition->spillWriter->addAlreadySorted(it->first, serializeAccumulators(it->second));
+    }
+
+    recordSpill(partition->groups.size(), partition->memoryUsageBytes);
+
+    _memoryUsageBytes -= partition->memoryUsageBytes;
+    partition->memoryUsageBytes = 0;
+    GroupsMap().swap(partition->groups);
+}
+
+void DocumentSourceGroup::spillPartitions() {
+    while (_memoryUsageBytes > _maxMemoryUsageBytes / 2) {
+        // Writing out the groups of a partition which was already spilled costs no more than the
+        // write itself, so those are always chosen before spilling another partition.
+        Partition* victim = nullptr;
+        for (auto&& partition : _partitions) {
+            if (partition.isSpilled() && partition.memoryUsageBytes > 0 &&
+                (!victim || partition.memoryUsageBytes > victim->memoryUsageBytes)) {
+                victim = &partition;
+            }
+        }
+
+        if (!victim) {
+            for (auto&& partition : _partitions) {
+                if (partition.memoryUsageBytes > 0 &&
+                    (!victim || partition.memoryUsageBytes > victim->memoryUsageBytes)) {
+                    victim = &partition;
+                }
+            }
+        }
+
+        if (!victim) {
+            break;
+        }
+        spillPartition(victim);
+    }
+}
+
+void DocumentSourceGroup::recordSpill(size_t numGroups, long long bytes) {
+    _spillStats.spills++;
+    _spillStats.spilledGroups += numGroups;
+    _spillStats.spilledBytes += bytes;
+
+    groupSpills.increment();
+    groupSpilledGroups.increment(numGroups);
+    groupSpilledBytes.increment(bytes);
+}
+
+bool DocumentSourceGroup::loadNextPartition() {
+    // Free the groups of the previous partition before loading the next one.
+    GroupsMap().swap(groups);
+    _memoryUsageBytes = 0;
+
+    while (_nextPartition < _partitions.size()) {
+        Partition& partition = _partitions[_nextPartition++];
+        if (partition.isSpilled()) {
+            reaggregatePartition(&partition);
+        } else {
+            groups.swap(partition.groups);
+            _memoryUsageBytes = partition.memoryUsageBytes;
+            partition.memoryUsageBytes = 0;
+        }
+
+        groupsIterator = groups.begin();
+        if (_sorterIterator || !groups.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DocumentSourceGroup::reaggregatePartition(Partition* partition) {
+    const size_t numAccumulators = vpAccumulatorFactory.size();
+    _spillStats.partitionsReaggregated++;
+    groupPartitionsReaggregated.increment();
+
+    // pushed to on spill()
+    vector<shared_ptr<Sorter<Value, Value>::Iterator>> sortedFiles;
+
+    while (partition->spilledData->more()) {
+        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+            // The partition alone does not fit in memory, so sort its groups instead.
+            recordSpill(groups.size(), _memoryUsageBytes);
+            sortedFiles.push_back(spill());
+            _memoryUsageBytes = 0;
+        }
+
+        const Sorter<Value, Value>::Data data = partition->spilledData->next();
+
+        const size_t oldSize = groups.size();
+        Accumulators& group = groups[data.first];
+        const bool inserted = groups.size() != oldSize;
+
+        if (inserted) {
+            _memoryUsageBytes += data.first.getApproximateSize();
+
+            group.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group.push_back(vpAccumulatorFactory[i]());
+            }
+        } else {
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _memoryUsageBytes -= group[i]->memUsageForSorter();
             }
         }
+
+        mergeAccumulators(data.second, &group);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _memoryUsageBytes += group[i]->memUsageForSorter();
+        }
     }
 
-    // These blocks do any final steps necessary to prepare to output results.
+    // Done with the partition's spill file, which removes it.
+    partition->spilledData.reset();
+
     if (!sortedFiles.empty()) {
-        _spilled = true;
         if (!groups.empty()) {
             sortedFiles.push_back(spill());
         }
 
-        // We won't be using groups again so free its memory.
+        // We won't be using groups for this partition so free its memory.
         GroupsMap().swap(groups);
+        _memoryUsageBytes = 0;
 
         _sorterIterator.reset(
             Sorter<Value, Value>::Iterator::merge(sortedFiles, SortOptions(), SorterComparator()));
 
-        // prepare current to accumulate data
-        _currentAccumulators.reserve(numAccumulators);
-        for (size_t i = 0; i < numAccumulators; i++) {
-            _currentAccumulators.push_back(vpAccumulatorFactory[i]());
-        }
-
         verify(_sorterIterator->more());  // we put data in, we should get something out.
         _firstPartOfNextGroup = _sorterIterator->next();
-    } else {
-        // start the group iterator
-        groupsIterator = groups.begin();
     }
+}
 
-    populated = true;
+Value DocumentSourceGroup::serializeAccumulators(const Accumulators& accums) const {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            return Value();
+
+        case 1:  // just one value, use optimized serialization as single Value
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> values;
+            values.reserve(accums.size());
+            for (size_t i = 0; i < accums.size(); i++) {
+                values.push_back(accums[i]->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(values));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeAccumulators(const Value& serialized, Accumulators* accums) const {
+    switch (accums->size()) {  // mirrors switch in serializeAccumulators()
+        case 0:                // no Accumulators so no Values
+            break;
+
+        case 1:  // single accumulators serialize as a single Value
+            (*accums)[0]->process(serialized, /*merging=*/true);
+            break;
+
+        default: {  // multiple accumulators serialize as an array
+            const vector<Value>& accumulatorStates = serialized.getArray();
+            for (size_t i = 0; i < accums->size(); i++) {
+                (*accums)[i]->process(accumulatorStates[i], /*merging=*/true);
+            }
+            break;
+        }
+    }
 }
 
 class DocumentSourceGroup::SpillSTLComparator {
@@ -427,29 +638,8 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
 
     SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-    switch (vpAccumulatorFactory.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                             // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
-            }
-            break;
-
-        case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
-            }
-            break;
-
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
-                }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
-            }
-            break;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, serializeAccumulators(ptrs[i]->second));
     }
 
     groups.clear();
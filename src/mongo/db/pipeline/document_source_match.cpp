@@ -28,6 +28,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <cctype>
 
 #include "mongo/db/jsobj.h"
@@ -35,6 +36,7 @@
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/vectorized_expression.h"
 #include "mongo/util/stringutils.h"
 
 namespace mongo {
@@ -63,16 +65,52 @@ boost::optional<Document> DocumentSourceMatch::getNext() {
     // The user facing error should have been generated earlier.
     massert(17309, "Should never call getNext on a $match stage with $text clause", !_isTextQuery);
 
-    while (boost::optional<Document> next = pSource->getNext()) {
+    if (!_compiled) {
+        // Done here rather than at construction since coalesce() may replace the matcher.
+        _compiled = true;
+        if (internalDocumentSourceVectorizedBatchSize > 0)
+            _predicate = VectorizedPredicate::compile(matcher->getMatchExpression());
+        _nextBatchSize = _predicate ? 16 : 1;
+    }
+
+    while (_batchPosition < _batch.size() || loadBatch()) {
+        const size_t row = _batchPosition++;
+        const VectorizedPredicate::Result result =
+            _predicate ? _batchResults[row] : VectorizedPredicate::kUndecided;
+        if (result == VectorizedPredicate::kNoMatch)
+            continue;
+
         // The matcher only takes BSON documents, so we have to make one.
-        if (matcher->matches(next->toBson()))
-            return next;
+        if (result == VectorizedPredicate::kMatch || matcher->matches(_batch[row].toBson()))
+            return std::move(_batch[row]);
     }
 
     // Nothing matched
     return boost::none;
 }
 
+bool DocumentSourceMatch::loadBatch() {
+    _batch.clear();
+    _batchPosition = 0;
+    while (_batch.size() < _nextBatchSize) {
+        boost::optional<Document> next = pSource->getNext();
+        if (!next)
+            break;
+        _batch.push_back(std::move(*next));
+    }
+
+    if (_batch.empty())
+        return false;
+
+    if (_predicate) {
+        _predicate->evaluate(_batch, &_batchResults);
+
+        const size_t maxBatchSize = std::max(internalDocumentSourceVectorizedBatchSize, 1);
+        _nextBatchSize = std::min(_nextBatchSize * 2, maxBatchSize);
+    }
+    return true;
+}
+
 bool DocumentSourceMatch::coalesce(const intrusive_ptr<DocumentSource>& nextSource) {
     DocumentSourceMatch* otherMatch = dynamic_cast<DocumentSourceMatch*>(nextSource.get());
     if (!otherMatch)
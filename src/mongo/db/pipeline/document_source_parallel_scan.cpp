@@ -0,0 +1,508 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/fetch.h"
+#include "mongo/db/exec/multi_iterator.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+// Maximum number of threads one aggregation may scan its collection with. 1 disables parallel
+// scans.
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceParallelScanMaxWorkers, int, 1);
+
+// Collections with fewer records than this are always scanned by a single thread.
+MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceParallelScanMinRecords, int, 100000);
+
+namespace {
+
+// Upper bound on the number of threads all parallel scans share. Scans queue for threads when
+// they are all busy.
+const size_t kMaxParallelScanThreads = 64;
+
+// How often a scan waiting for its workers checks whether it has been interrupted.
+const Milliseconds kInterruptCheckInterval(100);
+
+Counter64 parallelScans;
+Counter64 parallelScanWorkers;
+
+ServerStatusMetricField<Counter64> displayParallelScans("aggregation.parallelScan.scans",
+                                                        &parallelScans);
+ServerStatusMetricField<Counter64> displayParallelScanWorkers("aggregation.parallelScan.workers",
+                                                              &parallelScanWorkers);
+
+stdx::mutex parallelScanPoolMutex;
+ThreadPool* parallelScanPool = nullptr;
+
+ThreadPool* getParallelScanPool() {
+    stdx::lock_guard<stdx::mutex> lk(parallelScanPoolMutex);
+    if (!parallelScanPool) {
+        ThreadPool::Options options;
+        options.poolName = "AggParallelScan";
+        options.threadNamePrefix = "aggParallelScan-";
+        options.minThreads = 0;
+        options.maxThreads = kMaxParallelScanThreads;
+
+        // Intentionally leaked, so that it never has to be shut down.
+        parallelScanPool = new ThreadPool(options);
+        parallelScanPool->startup();
+    }
+    return parallelScanPool;
+}
+
+}  // namespace
+
+struct DocumentSourceParallelScan::Worker {
+    // Executor over this worker's ranges. Saved and detached until the worker picks it up.
+    std::shared_ptr<PlanExecutor> exec;
+
+    // Set while the worker runs so that it can be interrupted. Guarded by SharedState::mutex.
+    OperationContext* txn = nullptr;
+
+    Status status = Status::OK();
+    WorkerStats stats;
+};
+
+struct DocumentSourceParallelScan::SharedState {
+    // Applied to the documents of the collection by all workers.
+    unique_ptr<MatchExpression> filter;
+
+    vector<unique_ptr<Worker>> workers;
+
+    // The $group memory limit, split evenly between the $group of each worker and 'results'.
+    long long memoryShareBytes = 0;
+
+    stdx::mutex mutex;
+
+    // Signalled when a worker adds to 'results' or finishes.
+    stdx::condition_variable resultAdded;
+
+    // Signalled when getNext() takes from 'results' or the workers are killed.
+    stdx::condition_variable resultTaken;
+
+    // Partial groups which the workers produced and getNext() has not returned yet.
+    std::deque<Document> results;
+    long long resultsBytes = 0;
+
+    size_t workersRunning = 0;
+    bool killed = false;
+
+    // The error of the first worker which failed.
+    Status failure = Status::OK();
+};
+
+DocumentSourceParallelScan::DocumentSourceParallelScan(
+    const string& ns,
+    const BSONObj& query,
+    const DepsTracker& deps,
+    vector<BSONObj> workerStageSpecs,
+    int maxWorkers,
+    const intrusive_ptr<ExpressionContext>& pExpCtx)
+    : DocumentSource(pExpCtx),
+      _ns(ns),
+      _maxWorkers(maxWorkers),
+      _query(query.getOwned()),
+      _projection(deps.toProjection()),
+      _dependencies(deps.toParsedDeps()),
+      _workerStageSpecs(std::move(workerStageSpecs)) {}
+
+DocumentSourceParallelScan::~DocumentSourceParallelScan() {
+    dispose();
+}
+
+intrusive_ptr<DocumentSourceParallelScan> DocumentSourceParallelScan::create(
+    const string& ns,
+    const BSONObj& query,
+    const DepsTracker& deps,
+    const vector<intrusive_ptr<DocumentSource>>& workerStages,
+    int maxWorkers,
+    const intrusive_ptr<ExpressionContext>& pExpCtx) {
+    invariant(!workerStages.empty());
+    invariant(dynamic_cast<DocumentSourceGroup*>(workerStages.back().get()));
+    invariant(maxWorkers > 1);
+
+    vector<BSONObj> workerStageSpecs;
+    for (auto&& stage : workerStages) {
+        vector<Value> serialized;
+        stage->serializeToArray(serialized);
+        for (auto&& spec : serialized) {
+            workerStageSpecs.push_back(spec.getDocument().toBson());
+        }
+    }
+
+    return new DocumentSourceParallelScan(
+        ns, query, deps, std::move(workerStageSpecs), maxWorkers, pExpCtx);
+}
+
+const char* DocumentSourceParallelScan::getSourceName() const {
+    return "$parallelCursor";
+}
+
+void DocumentSourceParallelScan::setSource(DocumentSource* pSource) {
+    // This doesn't take a source.
+    verify(false);
+}
+
+boost::optional<Document> DocumentSourceParallelScan::getNext() {
+    pExpCtx->checkForInterrupt();
+
+    if (!_scanned) {
+        _scanned = true;
+        startScan();
+    }
+
+    if (!_state)
+        return boost::none;
+
+    OperationContext* txn = pExpCtx->opCtx;
+    {
+        stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+        while (_state->failure.isOK() && _state->workersRunning > 0 && _state->results.empty() &&
+               txn->checkForInterruptNoAssert().isOK()) {
+            _state->resultAdded.wait_for(lk, kInterruptCheckInterval);
+        }
+
+        if (!_state->results.empty()) {
+            Document out = std::move(_state->results.front());
+            _state->results.pop_front();
+            _state->resultsBytes -= out.getApproximateSize();
+            _state->resultTaken.notify_all();
+            return out;
+        }
+    }
+
+    finishScan();
+    return boost::none;
+}
+
+void DocumentSourceParallelScan::dispose() {
+    if (!_state)
+        return;
+
+    // The results were not all read, so the workers may still be running.
+    try {
+        waitForWorkers(/*kill*/ true);
+    } catch (const DBException&) {
+        // This operation was interrupted while waiting, which is no reason not to dispose.
+    }
+    _state.reset();
+}
+
+void DocumentSourceParallelScan::startScan() {
+    OperationContext* txn = pExpCtx->opCtx;
+
+    _state = stdx::make_unique<SharedState>();
+    ScopeGuard resetState = MakeGuard([this] { _state.reset(); });
+
+    // Queries containing $where are not parallelized, so the filter needs no JS context.
+    if (!_query.isEmpty()) {
+        _state->filter = uassertStatusOK(MatchExpressionParser::parse(_query));
+    }
+
+    {
+        AutoGetCollectionForRead autoColl(txn, _ns);
+        Collection* collection = autoColl.getCollection();
+        if (!collection) {
+            // Dropped since the pipeline was planned.
+            return;
+        }
+
+        // Deal the ranges out to the workers round robin. Each worker iterates its ranges with a
+        // MultiIteratorStage under a FetchStage, which only applies the filter as the documents
+        // are already fetched.
+        auto cursors = collection->getParallelCursors(txn);
+        const size_t numWorkers = std::min(cursors.size(), static_cast<size_t>(_maxWorkers));
+        _state->memoryShareBytes = internalDocumentSourceGroupMaxMemoryBytes / (numWorkers + 1);
+
+        vector<unique_ptr<WorkingSet>> workingSets;
+        vector<unique_ptr<MultiIteratorStage>> iterators;
+        for (size_t i = 0; i < numWorkers; i++) {
+            _state->workers.push_back(stdx::make_unique<Worker>());
+            workingSets.push_back(stdx::make_unique<WorkingSet>());
+            iterators.push_back(
+                stdx::make_unique<MultiIteratorStage>(txn, workingSets[i].get(), collection));
+        }
+        for (size_t i = 0; i < cursors.size(); i++) {
+            iterators[i % numWorkers]->addIterator(std::move(cursors[i]));
+            _state->workers[i % numWorkers]->stats.ranges++;
+        }
+
+        for (size_t i = 0; i < numWorkers; i++) {
+            unique_ptr<PlanStage> root = stdx::make_unique<FetchStage>(txn,
+                                                                       workingSets[i].get(),
+                                                                       iterators[i].release(),
+                                                                       _state->filter.get(),
+                                                                       collection);
+
+            // Registered with the collection's CursorManager, so that the executor is killed if
+            // the collection is dropped while the worker yields.
+            auto exec = uassertStatusOK(PlanExecutor::make(txn,
+                                                           std::move(workingSets[i]),
+                                                           std::move(root),
+                                                           collection,
+                                                           PlanExecutor::YIELD_AUTO));
+            exec->saveState();
+            exec->detachFromOperationContext();
+            _state->workers[i]->exec = std::move(exec);
+        }
+    }
+
+    parallelScans.increment();
+    parallelScanWorkers.increment(_state->workers.size());
+
+    try {
+        for (auto&& worker : _state->workers) {
+            Worker* w = worker.get();
+            {
+                stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+                _state->workersRunning++;
+            }
+            Status status = getParallelScanPool()->schedule([this, w] { runWorker(w); });
+            if (!status.isOK()) {
+                stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+                _state->workersRunning--;
+                uassertStatusOK(status);
+            }
+        }
+    } catch (...) {
+        waitForWorkers(/*kill*/ true);
+        throw;
+    }
+
+    resetState.Dismiss();
+}
+
+void DocumentSourceParallelScan::finishScan() {
+    ON_BLOCK_EXIT([this] { _state.reset(); });
+
+    bool failed;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        failed = !_state->failure.isOK();
+    }
+
+    waitForWorkers(/*kill*/ failed);
+    uassertStatusOK(_state->failure);
+
+    for (auto&& worker : _state->workers) {
+        _workerStats.push_back(worker->stats);
+    }
+}
+
+void DocumentSourceParallelScan::waitForWorkers(bool kill) {
+    OperationContext* txn = pExpCtx->opCtx;
+    Status interruptStatus = Status::OK();
+
+    {
+        stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+        while (_state->workersRunning > 0) {
+            if (!_state->killed && interruptStatus.isOK()) {
+                interruptStatus = txn->checkForInterruptNoAssert();
+            }
+
+            if ((kill || !interruptStatus.isOK()) && !_state->killed) {
+                _state->killed = true;
+                for (auto&& worker : _state->workers) {
+                    if (worker->txn) {
+                        stdx::lock_guard<Client> clientLock(*worker->txn->getClient());
+                        worker->txn->markKilled();
+                    }
+                }
+                _state->resultTaken.notify_all();
+            }
+
+            _state->resultAdded.wait_for(lk, kInterruptCheckInterval);
+        }
+    }
+
+    // Workers which never ran still hold registered executors, which must be destroyed under the
+    // collection lock.
+    bool haveUnusedExecutors = false;
+    for (auto&& worker : _state->workers) {
+        haveUnusedExecutors = haveUnusedExecutors || worker->exec;
+    }
+    if (haveUnusedExecutors) {
+        const NamespaceString nss(_ns);
+        Lock::DBLock dbLock(txn->lockState(), nss.db(), MODE_IS);
+        Lock::CollectionLock collLock(txn->lockState(), nss.ns(), MODE_IS);
+        for (auto&& worker : _state->workers) {
+            if (worker->exec) {
+                worker->exec->reattachToOperationContext(txn);
+                worker->exec.reset();
+            }
+        }
+    }
+
+    uassertStatusOK(interruptStatus);
+}
+
+void DocumentSourceParallelScan::runWorker(Worker* worker) const {
+    Client::initThreadIfNotAlready();
+    OperationContextImpl txn;
+    Timer timer;
+
+    {
+        stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+        if (_state->killed) {
+            txn.markKilled();
+        }
+        worker->txn = &txn;
+    }
+
+    intrusive_ptr<ExpressionContext> ctx = new ExpressionContext(&txn, pExpCtx->ns);
+    ctx->inShard = true;  // Have the $group produce partial groups for merging.
+    ctx->extSortAllowed = pExpCtx->extSortAllowed;
+    ctx->tempDir = pExpCtx->tempDir;
+
+    intrusive_ptr<DocumentSourceCursor> cursor;
+    vector<intrusive_ptr<DocumentSource>> stages;
+    try {
+        std::shared_ptr<PlanExecutor> exec = std::move(worker->exec);
+        exec->reattachToOperationContext(&txn);
+        cursor = DocumentSourceCursor::create(_ns, exec, ctx);
+        exec.reset();
+        cursor->setProjection(_projection, _dependencies);
+
+        DocumentSource* source = cursor.get();
+        for (auto&& spec : _workerStageSpecs) {
+            stages.push_back(DocumentSource::parse(ctx, spec));
+            stages.back()->setSource(source);
+            source = stages.back().get();
+        }
+
+        auto group = dynamic_cast<DocumentSourceGroup*>(source);
+        invariant(group);
+        group->setMaxMemoryUsageBytes(_state->memoryShareBytes);
+
+        while (auto next = source->getNext()) {
+            const long long size = next->getApproximateSize();
+
+            // Wait for getNext() to make room, though a result always fits in an empty buffer.
+            stdx::unique_lock<stdx::mutex> lk(_state->mutex);
+            while (!_state->killed && !_state->results.empty() &&
+                   _state->resultsBytes + size > _state->memoryShareBytes) {
+                _state->resultTaken.wait(lk);
+            }
+            if (_state->killed) {
+                lk.unlock();
+                txn.checkForInterrupt();
+            }
+
+            _state->results.push_back(std::move(*next));
+            _state->resultsBytes += size;
+            worker->stats.partialGroups++;
+            _state->resultAdded.notify_all();
+        }
+    } catch (const DBException& ex) {
+        worker->status = ex.toStatus();
+    }
+
+    // The cursor destroys its executor under the collection lock when it is exhausted. Otherwise
+    // take the lock here, so that the executor can deregister itself safely.
+    {
+        const NamespaceString nss(_ns);
+        Lock::DBLock dbLock(txn.lockState(), nss.db(), MODE_IS);
+        Lock::CollectionLock collLock(txn.lockState(), nss.ns(), MODE_IS);
+        for (auto it = stages.rbegin(); it != stages.rend(); ++it) {
+            (*it)->dispose();
+        }
+        if (cursor) {
+            cursor->dispose();
+        }
+    }
+
+    worker->stats.executionTimeMillis = timer.millis();
+
+    stdx::lock_guard<stdx::mutex> lk(_state->mutex);
+    if (_state->failure.isOK() && !worker->status.isOK() && !_state->killed) {
+        _state->failure = worker->status;
+    }
+    worker->txn = nullptr;
+    _state->workersRunning--;
+    _state->resultAdded.notify_all();
+}
+
+Value DocumentSourceParallelScan::serialize(bool explain) const {
+    // A DocumentSourceParallelScan is never serialized other than for explain, since it only
+    // exists in a pipeline that is already running on the mongod holding the collection.
+    if (!explain)
+        return Value();
+
+    vector<Value> workerPipeline;
+    for (auto&& spec : _workerStageSpecs) {
+        workerPipeline.push_back(Value(spec));
+    }
+
+    MutableDocument out;
+    out["query"] = Value(_query);
+    out["fields"] = Value(_projection);
+    out["maxWorkers"] = Value(_maxWorkers);
+    out["workerPipeline"] = Value(workerPipeline);
+
+    if (_scanned) {
+        vector<Value> workers;
+        for (auto&& stats : _workerStats) {
+            workers.push_back(Value(DOC("ranges" << stats.ranges << "partialGroups"
+                                                 << stats.partialGroups << "executionTimeMillis"
+                                                 << stats.executionTimeMillis)));
+        }
+        out["workers"] = Value(workers);
+    }
+
+    return Value(DOC(getSourceName() << out.freezeToValue()));
+}
+
+}  // namespace mongo
@@ -28,6 +28,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 
 #include "mongo/db/jsobj.h"
@@ -35,6 +36,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/pipeline/vectorized_expression.h"
 
 namespace mongo {
 
@@ -52,17 +54,62 @@ const char* DocumentSourceProject::getSourceName() const {
     return "$project";
 }
 
+bool DocumentSourceProject::loadBatch() {
+    _batch.clear();
+    _batchPosition = 0;
+    while (_batch.size() < _nextBatchSize) {
+        boost::optional<Document> next = pSource->getNext();
+        if (!next)
+            break;
+        _batch.push_back(std::move(*next));
+    }
+
+    if (_batch.empty())
+        return false;
+
+    for (auto&& vectorized : _vectorized) {
+        vectorized->evaluateBatch(_batch);
+    }
+
+    if (!_vectorized.empty()) {
+        const size_t maxBatchSize = std::max(internalDocumentSourceVectorizedBatchSize, 1);
+        _nextBatchSize = std::min(_nextBatchSize * 2, maxBatchSize);
+    }
+    return true;
+}
+
 boost::optional<Document> DocumentSourceProject::getNext() {
     pExpCtx->checkForInterrupt();
 
-    boost::optional<Document> input = pSource->getNext();
-    if (!input)
+    if (!_compiled) {
+        _compiled = true;
+        if (internalDocumentSourceVectorizedBatchSize > 0) {
+            pEO->replaceComputedFields([this](const intrusive_ptr<Expression>& expression) {
+                intrusive_ptr<ExpressionVectorized> vectorized =
+                    ExpressionVectorized::create(expression);
+                if (vectorized)
+                    _vectorized.push_back(vectorized);
+                return intrusive_ptr<Expression>(vectorized);
+            });
+        }
+        _nextBatchSize = _vectorized.empty() ? 1 : 16;
+    }
+
+    // Without anything to evaluate a batch at a time, this stage reads one document at a time.
+    if (_batchPosition == _batch.size() && !loadBatch())
         return boost::none;
 
+    const size_t row = _batchPosition++;
+    for (auto&& vectorized : _vectorized) {
+        vectorized->setRow(row);
+    }
+
+    Document input = std::move(_batch[row]);
+
     /* create the result document */
     const size_t sizeHint = pEO->getSizeHint();
     MutableDocument out(sizeHint);
-    out.copyMetaDataFrom(*input);
+    out.copyMetaDataFrom(input);
 
     /*
       Use the ExpressionObject to create the base result.
@@ -70,8 +117,8 @@ boost::optional<Document> DocumentSourceProject::getNext() {
       If we're excluding fields at the top level, leave out the _id if
       it is found, because we took care of it above.
     */
-    _variables->setRoot(*input);
-    pEO->addToDocument(out, *input, _variables.get());
+    _variables->setRoot(input);
+    pEO->addToDocument(out, input, _variables.get());
     _variables->clearRoot();
 
     return out.freeze();
@@ -37,6 +37,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/temp_dir.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 bool isMongos() {
@@ -291,13 +292,14 @@ public:
     Base() : _tempDir("DocumentSourceGroupTest") {}
 
 protected:
-    void createGroup(const BSONObj& spec, bool inShard = false) {
+    void createGroup(const BSONObj& spec, bool inShard = false, bool extSortAllowed = false) {
         BSONObj namedSpec = BSON("$group" << spec);
         BSONElement specElement = namedSpec.firstElement();
 
         intrusive_ptr<ExpressionContext> expressionContext =
             new ExpressionContext(_opCtx.get(), NamespaceString(ns));
         expressionContext->inShard = inShard;
+        expressionContext->extSortAllowed = extSortAllowed;
         // Won't spill to disk properly if it needs to.
         expressionContext->tempDir = _tempDir.path();
 
@@ -877,6 +879,82 @@ public:
     }
 };
 
+/**
+ * Runs a $group over more distinct keys than fit in a small memory limit, so that it must spill
+ * partitions to disk and re-aggregate them.
+ */
+class SpillBase : public Base {
+public:
+    void run() {
+        const int oldMaxMemoryBytes = internalDocumentSourceGroupMaxMemoryBytes;
+        const int oldNumPartitions = internalDocumentSourceGroupNumPartitions;
+        ON_BLOCK_EXIT([&] {
+            internalDocumentSourceGroupMaxMemoryBytes = oldMaxMemoryBytes;
+            internalDocumentSourceGroupNumPartitions = oldNumPartitions;
+        });
+        internalDocumentSourceGroupMaxMemoryBytes = maxMemoryBytes();
+        internalDocumentSourceGroupNumPartitions = numPartitions();
+
+        // Every key is seen five times, in separate passes over the key space.
+        std::deque<Document> inputData;
+        for (int i = 0; i < 5; ++i) {
+            for (int key = 0; key < kNumKeys; ++key) {
+                inputData.push_back(DOC("key" << key << "value" << i));
+            }
+        }
+
+        createGroup(fromjson("{_id:'$key',count:{$sum:1},values:{$push:'$value'}}"),
+                    false,
+                    true /* extSortAllowed */);
+        auto source = DocumentSourceMock::create(inputData);
+        group()->setSource(source.get());
+
+        std::set<int> keys;
+        while (boost::optional<Document> current = group()->getNext()) {
+            ASSERT_TRUE(keys.insert(current->getField("_id").getInt()).second);
+            ASSERT_EQUALS(5, current->getField("count").getInt());
+            ASSERT_EQUALS(5U, current->getField("values").getArrayLength());
+        }
+        assertExhausted(group());
+        ASSERT_EQUALS(static_cast<size_t>(kNumKeys), keys.size());
+
+        const auto& stats = static_cast<DocumentSourceGroup*>(group())->getSpillStats();
+        ASSERT_GREATER_THAN(stats.spills, 0);
+        ASSERT_GREATER_THAN(stats.partitionsReaggregated, 0);
+        checkSpillStats(stats);
+    }
+
+protected:
+    static const int kNumKeys = 2000;
+
+    virtual int maxMemoryBytes() = 0;
+    virtual int numPartitions() = 0;
+    virtual void checkSpillStats(const DocumentSourceGroup::SpillStats& stats) {}
+};
+
+/** Only some of the partitions are spilled and each fits in memory when re-aggregated. */
+class SpillSomePartitions : public SpillBase {
+    int maxMemoryBytes() {
+        return 300 * 1024;
+    }
+    int numPartitions() {
+        return 32;
+    }
+    void checkSpillStats(const DocumentSourceGroup::SpillStats& stats) {
+        ASSERT_LESS_THAN(stats.partitionsReaggregated, 32);
+    }
+};
+
+/** A spilled partition which does not fit in memory is re-aggregated by sorting it. */
+class SpillPartitionLargerThanMemory : public SpillBase {
+    int maxMemoryBytes() {
+        return 16 * 1024;
+    }
+    int numPartitions() {
+        return 1;
+    }
+};
+
 }  // namespace DocumentSourceGroup
 
 namespace DocumentSourceProject {
@@ -2106,6 +2184,8 @@ public:
         add<DocumentSourceGroup::Dependencies>();
         add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
         add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+        add<DocumentSourceGroup::SpillSomePartitions>();
+        add<DocumentSourceGroup::SpillPartitionLargerThanMemory>();
 
         add<DocumentSourceProject::Inclusion>();
         add<DocumentSourceProject::Optimize>();
@@ -1341,6 +1341,19 @@ void ExpressionObject::addToDocument(MutableDocument& out,
     }
 }
 
+void ExpressionObject::replaceComputedFields(
+    const stdx::function<intrusive_ptr<Expression>(const intrusive_ptr<Expression>&)>&
+        replacement) {
+    for (auto&& field : _expressions) {
+        // Null is an inclusion, and nested objects are handled field by field by addToDocument().
+        if (!field.second || dynamic_cast<ExpressionObject*>(field.second.get()))
+            continue;
+
+        if (intrusive_ptr<Expression> replaced = replacement(field.second))
+            field.second = replaced;
+    }
+}
+
 size_t ExpressionObject::getSizeHint() const {
     // Note: this can overestimate, but that is better than underestimating
     return _expressions.size() + (_excludeId ? 0 : 1);
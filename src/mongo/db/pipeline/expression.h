@@ -358,6 +358,10 @@ public:
 
     static ExpressionVector parseArguments(BSONElement bsonExpr, const VariablesParseState& vps);
 
+    const ExpressionVector& getOperandList() const {
+        return vpOperand;
+    }
+
 protected:
     ExpressionNary() {}
 
@@ -513,6 +517,10 @@ public:
 
     explicit ExpressionCompare(CmpOp cmpOp);
 
+    CmpOp getCmpOp() const {
+        return cmpOp;
+    }
+
 private:
     CmpOp cmpOp;
 };
@@ -669,6 +677,11 @@ public:
         return _fieldPath;
     }
 
+    /// The variable the path starts from. The first element of the path names this variable.
+    Variables::Id getVariableId() const {
+        return _variable;
+    }
+
 private:
     ExpressionFieldPath(const std::string& fieldPath, Variables::Id variable);
 
@@ -955,6 +968,14 @@ public:
         _excludeId = b;
     }
 
+    /**
+     * Replaces the expression computing each field at this level, other than nested objects, with
+     * what 'replacement' returns for it. A null return leaves the expression as it is.
+     */
+    void replaceComputedFields(
+        const stdx::function<boost::intrusive_ptr<Expression>(
+            const boost::intrusive_ptr<Expression>&)>& replacement);
+
 private:
     explicit ExpressionObject(bool atRoot);
 
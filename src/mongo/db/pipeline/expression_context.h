@@ -56,6 +56,10 @@ public:
     bool extSortAllowed = false;
     bool bypassDocumentValidation = false;
 
+    // Upper bound on the number of threads the pipeline may scan its collection with, as set by
+    // the 'maxParallelism' aggregate option. 0 if not set.
+    int maxParallelism = 0;
+
     NamespaceString ns;
     std::string tempDir;  // Defaults to empty to prevent external sorting in mongos.
 
@@ -32,6 +32,9 @@
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/pipeline_optimizations.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/catalog/document_validation.h"
@@ -56,6 +59,7 @@ const char Pipeline::commandName[] = "aggregate";
 const char Pipeline::pipelineName[] = "pipeline";
 const char Pipeline::explainName[] = "explain";
 const char Pipeline::fromRouterName[] = "fromRouter";
+const char Pipeline::maxParallelismName[] = "maxParallelism";
 const char Pipeline::serverPipelineName[] = "serverPipeline";
 const char Pipeline::mongosPipelineName[] = "mongosPipeline";
 
@@ -125,6 +129,16 @@ intrusive_ptr<Pipeline> Pipeline::parseCommand(string& errmsg,
             continue;
         }
 
+        if (str::equals(pFieldName, maxParallelismName)) {
+            uassert(28753,
+                    str::stream() << maxParallelismName << " must be a positive number, not "
+                                  << cmdElement.toString(false),
+                    cmdElement.isNumber() && cmdElement.numberLong() > 0);
+            pCtx->maxParallelism = std::min(cmdElement.numberLong(),
+                                            static_cast<long long>(std::numeric_limits<int>::max()));
+            continue;
+        }
+
         /* we didn't recognize a field in the command */
         ostringstream sb;
         sb << "unrecognized field '" << cmdElement.fieldName() << "'";
@@ -443,6 +457,34 @@ bool Pipeline::hasOutStage() const {
     return dynamic_cast<DocumentSourceOut*>(sources.back().get());
 }
 
+bool Pipeline::canMergeInRouter(long long maxResults) const {
+    // Bound on the number of results, or -1 if there is none.
+    long long resultsBound = -1;
+    auto applyBound = [&resultsBound](long long limit) {
+        if (limit >= 0 && (resultsBound < 0 || limit < resultsBound))
+            resultsBound = limit;
+    };
+
+    for (auto&& source : sources) {
+        if (auto sort = dynamic_cast<DocumentSourceSort*>(source.get())) {
+            // Only a merge of presorted shard output streams, any other sort buffers its input.
+            if (!sort->isMergingPresorted())
+                return false;
+            applyBound(sort->getLimit());
+        } else if (auto limit = dynamic_cast<DocumentSourceLimit*>(source.get())) {
+            applyBound(limit->getLimit());
+        } else if (!dynamic_cast<DocumentSourceSkip*>(source.get()) &&
+                   !dynamic_cast<DocumentSourceMatch*>(source.get()) &&
+                   !dynamic_cast<DocumentSourceProject*>(source.get()) &&
+                   !dynamic_cast<DocumentSourceRedact*>(source.get())) {
+            // $group, $unwind and $out either buffer or multiply their input, or write.
+            return false;
+        }
+    }
+
+    return maxResults < 0 || (resultsBound >= 0 && resultsBound <= maxResults);
+}
+
 Document Pipeline::serialize() const {
     MutableDocument serialized;
     // create an array out of the pipeline operations
@@ -470,6 +512,10 @@ Document Pipeline::serialize() const {
         serialized.setField(bypassDocumentValidationCommandOption(), Value(true));
     }
 
+    if (pCtx->maxParallelism) {
+        serialized.setField(maxParallelismName, Value(pCtx->maxParallelism));
+    }
+
     return serialized.freeze();
 }
 
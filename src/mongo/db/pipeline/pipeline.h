@@ -93,6 +93,16 @@ public:
      */
     bool hasOutStage() const;
 
+    /**
+     * Returns true if this merging pipeline only streams the output of the shards, buffering no
+     * more than one document per shard, and is bounded to return at most 'maxResults' documents.
+     * Such a pipeline may be merged by mongos itself. A negative 'maxResults' means the number of
+     * results does not need to be bounded.
+     *
+     * Must be called on the merging side returned by splitForSharded().
+     */
+    bool canMergeInRouter(long long maxResults) const;
+
     /**
       Write the Pipeline as a BSONObj command.  This should be the
       inverse of parseCommand().
@@ -177,6 +187,7 @@ private:
     static const char pipelineName[];
     static const char explainName[];
     static const char fromRouterName[];
+    static const char maxParallelismName[];
     static const char serverPipelineName[];
     static const char mongosPipelineName[];
 
@@ -30,12 +30,15 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <algorithm>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_executor.h"
@@ -90,6 +93,63 @@ private:
     intrusive_ptr<ExpressionContext> _ctx;
     DBDirectClient _client;
 };
+
+/**
+ * Returns the index of the $group whose input may be computed by a DocumentSourceParallelScan,
+ * or -1 if there is none. All stages before it must transform one document at a time. The workers
+ * see the documents out of order, so the $group may not use accumulators such as $first.
+ */
+int findParallelizableGroup(const std::deque<intrusive_ptr<DocumentSource>>& sources) {
+    for (size_t i = 0; i < sources.size(); i++) {
+        DocumentSource* source = sources[i].get();
+        if (auto group = dynamic_cast<DocumentSourceGroup*>(source))
+            return group->hasOrderSensitiveAccumulator() ? -1 : i;
+
+        if (!dynamic_cast<DocumentSourceMatch*>(source) &&
+            !dynamic_cast<DocumentSourceProject*>(source) &&
+            !dynamic_cast<DocumentSourceRedact*>(source) &&
+            !dynamic_cast<DocumentSourceUnwind*>(source)) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Returns how many threads may scan 'collection' with the plan of 'exec', or 1 if the scan should
+ * not be split.
+ */
+int getParallelScanWorkers(OperationContext* txn,
+                           Collection* collection,
+                           PlanExecutor* exec,
+                           const BSONObj& queryObj,
+                           const intrusive_ptr<ExpressionContext>& pExpCtx) {
+    int maxWorkers = std::min(internalDocumentSourceParallelScanMaxWorkers, 64);
+    if (pExpCtx->maxParallelism > 0)
+        maxWorkers = std::min(maxWorkers, pExpCtx->maxParallelism);
+    if (maxWorkers <= 1)
+        return 1;
+
+    // Only a plain collection scan can be split. In particular a sharded collection gets a
+    // SHARDING_FILTER stage above its scan, so its scans are never split.
+    if (!collection || collection->isCapped() ||
+        exec->getRootStage()->stageType() != STAGE_COLLSCAN) {
+        return 1;
+    }
+
+    // The workers read with their own recovery units, so they can't share a committed snapshot.
+    if (txn->recoveryUnit()->isReadingFromMajorityCommittedSnapshot())
+        return 1;
+
+    if (collection->numRecords(txn) < internalDocumentSourceParallelScanMinRecords)
+        return 1;
+
+    // The workers match documents without a JS scope, so $where must be evaluated normally.
+    if (!MatchExpressionParser::parse(queryObj).isOK())
+        return 1;
+
+    return maxWorkers;
+}
 }
 
 shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
@@ -221,6 +281,27 @@ shared_ptr<PlanExecutor> PipelineD::prepareCursorSource(
     }
 
 
+    // A collection scan feeding a $group may instead be done by several threads, each grouping
+    // its share of the collection. The partial groups they produce are then merged.
+    const int groupIndex = sortInRunner ? -1 : findParallelizableGroup(sources);
+    if (groupIndex >= 0) {
+        const int workers = getParallelScanWorkers(txn, collection, exec.get(), queryObj, pExpCtx);
+        if (workers > 1) {
+            auto group = static_cast<DocumentSourceGroup*>(sources[groupIndex].get());
+            const std::vector<intrusive_ptr<DocumentSource>> workerStages(
+                sources.begin(), sources.begin() + groupIndex + 1);
+            intrusive_ptr<DocumentSource> merger = group->getMergeSource();
+
+            sources.erase(sources.begin(), sources.begin() + groupIndex + 1);
+            sources.push_front(merger);
+            pPipeline->addInitialSource(DocumentSourceParallelScan::create(
+                fullName, queryObj, deps, workerStages, workers, pExpCtx));
+
+            // The scan builds its own executors once it runs.
+            return std::shared_ptr<PlanExecutor>();
+        }
+    }
+
     // DocumentSourceCursor expects a yielding PlanExecutor that has had its state saved. We
     // deregister the PlanExecutor so that it can be registered with ClientCursor.
     exec->deregisterExec();
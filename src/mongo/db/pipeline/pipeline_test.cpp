@@ -400,6 +400,101 @@ class ShardedSortMatchProjSkipLimBecomesMatchTopKSortSkipProj : public Base {
 };
 
 }  // namespace limitFieldsSentFromShardsToMerger
+
+namespace canMergeInRouter {
+
+class Base {
+public:
+    virtual string inputPipeJson() = 0;
+
+    bool canMergeInRouter(long long maxResults) {
+        const BSONObj inputBson = fromjson("{pipeline: " + inputPipeJson() + "}");
+        intrusive_ptr<ExpressionContext> ctx =
+            new ExpressionContext(&_opCtx, NamespaceString("a.collection"));
+        string errmsg;
+        intrusive_ptr<Pipeline> mergePipe = Pipeline::parseCommand(errmsg, inputBson, ctx);
+        ASSERT_EQUALS(errmsg, "");
+        ASSERT(mergePipe != NULL);
+        ASSERT(mergePipe->splitForSharded() != NULL);
+        return mergePipe->canMergeInRouter(maxResults);
+    }
+
+    virtual void run() = 0;
+
+    virtual ~Base() {}
+
+private:
+    OperationContextNoop _opCtx;
+};
+
+class TopKSortFitsInBatch : public Base {
+    string inputPipeJson() {
+        return "[{$match: {a: 1}}, {$sort: {a: 1}}, {$skip: 2}, {$limit: 5}, {$project: {a: 1}}]";
+    }
+public:
+    void run() {
+        ASSERT(canMergeInRouter(-1));
+        ASSERT(canMergeInRouter(101));
+        ASSERT(canMergeInRouter(7));
+        ASSERT(!canMergeInRouter(6));
+        ASSERT(!canMergeInRouter(0));
+    }
+};
+
+class UnboundedSortOnlyWithoutBatch : public Base {
+    string inputPipeJson() {
+        return "[{$sort: {a: 1}}, {$match: {b: 1}}]";
+    }
+public:
+    void run() {
+        ASSERT(canMergeInRouter(-1));
+        ASSERT(!canMergeInRouter(101));
+    }
+};
+
+class LimitWithoutSort : public Base {
+    string inputPipeJson() {
+        return "[{$limit: 10}]";
+    }
+public:
+    void run() {
+        ASSERT(canMergeInRouter(10));
+        ASSERT(!canMergeInRouter(9));
+    }
+};
+
+class GroupMergesOnShard : public Base {
+    string inputPipeJson() {
+        return "[{$group: {_id: '$a', n: {$sum: 1}}}, {$limit: 1}]";
+    }
+public:
+    void run() {
+        ASSERT(!canMergeInRouter(-1));
+        ASSERT(!canMergeInRouter(101));
+    }
+};
+
+class UnwindMergesOnShard : public Base {
+    string inputPipeJson() {
+        return "[{$sort: {a: 1}}, {$limit: 1}, {$unwind: '$b'}]";
+    }
+public:
+    void run() {
+        ASSERT(!canMergeInRouter(-1));
+    }
+};
+
+class OutMergesOnShard : public Base {
+    string inputPipeJson() {
+        return "[{$sort: {a: 1}}, {$limit: 1}, {$out: 'other'}]";
+    }
+public:
+    void run() {
+        ASSERT(!canMergeInRouter(-1));
+    }
+};
+
+}  // namespace canMergeInRouter
 }  // namespace Sharded
 }  // namespace Optimizations
 
@@ -429,6 +524,12 @@ public:
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::ShardAlreadyExhaustive>();
         add<Optimizations::Sharded::limitFieldsSentFromShardsToMerger::
                 ShardedSortMatchProjSkipLimBecomesMatchTopKSortSkipProj>();
+        add<Optimizations::Sharded::canMergeInRouter::TopKSortFitsInBatch>();
+        add<Optimizations::Sharded::canMergeInRouter::UnboundedSortOnlyWithoutBatch>();
+        add<Optimizations::Sharded::canMergeInRouter::LimitWithoutSort>();
+        add<Optimizations::Sharded::canMergeInRouter::GroupMergesOnShard>();
+        add<Optimizations::Sharded::canMergeInRouter::UnwindMergesOnShard>();
+        add<Optimizations::Sharded::canMergeInRouter::OutMergesOnShard>();
     }
 };
 
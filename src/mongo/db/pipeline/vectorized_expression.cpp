@@ -0,0 +1,951 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/vectorized_expression.h"
+
+#include <limits>
+
+#include "mongo/base/compare_numbers.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/stdx/memory.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+using boost::intrusive_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+// Integer arithmetic wraps on overflow, as the row-at-a-time implementations do in practice.
+long long wrappingAdd(long long lhs, long long rhs) {
+    return static_cast<long long>(static_cast<unsigned long long>(lhs) +
+                                  static_cast<unsigned long long>(rhs));
+}
+
+long long wrappingSubtract(long long lhs, long long rhs) {
+    return static_cast<long long>(static_cast<unsigned long long>(lhs) -
+                                  static_cast<unsigned long long>(rhs));
+}
+
+long long wrappingMultiply(long long lhs, long long rhs) {
+    return static_cast<long long>(static_cast<unsigned long long>(lhs) *
+                                  static_cast<unsigned long long>(rhs));
+}
+
+/**
+ * Stores an integral result the way Value::createIntOrLong() would.
+ */
+void setIntOrLong(ColumnVector* out, size_t row, long long value) {
+    const bool fitsInInt =
+        value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+    out->setIntegral(row, fitsInInt ? ColumnVector::kInt : ColumnVector::kLong, value);
+}
+
+ColumnVector::Kind widestNumeric(ColumnVector::Kind lhs, ColumnVector::Kind rhs) {
+    // kInt < kLong < kDouble, as for Value::getWidestNumeric().
+    return std::max(lhs, rhs);
+}
+
+BSONType bsonTypeOf(ColumnVector::Kind kind) {
+    switch (kind) {
+        case ColumnVector::kMissing:
+            return EOO;
+        case ColumnVector::kNull:
+            return jstNULL;
+        case ColumnVector::kBool:
+            return Bool;
+        case ColumnVector::kInt:
+            return NumberInt;
+        case ColumnVector::kLong:
+            return NumberLong;
+        case ColumnVector::kDouble:
+            return NumberDouble;
+        case ColumnVector::kDate:
+            return Date;
+        case ColumnVector::kString:
+            return String;
+        case ColumnVector::kFallback:
+            break;
+    }
+    MONGO_UNREACHABLE;
+}
+
+/**
+ * Compares two rows other than kFallback the way Value::compare() compares their values.
+ */
+int compareRows(const ColumnVector& lhs, size_t lRow, const ColumnVector& rhs, size_t rRow) {
+    const ColumnVector::Kind lKind = lhs.kind(lRow);
+    const ColumnVector::Kind rKind = rhs.kind(rRow);
+
+    const int lCanonical = canonicalizeBSONType(bsonTypeOf(lKind));
+    const int rCanonical = canonicalizeBSONType(bsonTypeOf(rKind));
+    if (lCanonical != rCanonical)
+        return lCanonical < rCanonical ? -1 : 1;
+
+    switch (lKind) {
+        case ColumnVector::kMissing:
+        case ColumnVector::kNull:
+            return 0;
+        case ColumnVector::kBool:
+        case ColumnVector::kDate:
+            return compareLongs(lhs.getInt(lRow), rhs.getInt(rRow));
+        case ColumnVector::kString:
+            return lhs.getString(lRow).compare(rhs.getString(rRow));
+        case ColumnVector::kInt:
+        case ColumnVector::kLong:
+            if (rKind == ColumnVector::kDouble)
+                return compareLongToDouble(lhs.getInt(lRow), rhs.getDouble(rRow));
+            return compareLongs(lhs.getInt(lRow), rhs.getInt(rRow));
+        case ColumnVector::kDouble:
+            if (rKind == ColumnVector::kDouble)
+                return compareDoubles(lhs.getDouble(lRow), rhs.getDouble(rRow));
+            return compareDoubleToLong(lhs.getDouble(lRow), rhs.getInt(rRow));
+        case ColumnVector::kFallback:
+            break;
+    }
+    MONGO_UNREACHABLE;
+}
+
+//
+// Kernels for VectorizedExpression
+//
+
+class ConstantKernel final : public VectorizedExpression {
+public:
+    explicit ConstantKernel(const Value& value) {
+        _value.reset(1);
+        _value.setValue(0, value);
+    }
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        out->reset(docs.size());
+        if (_value.kind(0) == ColumnVector::kFallback)
+            return;
+
+        const Value value = _value.getValue(0);
+        for (size_t row = 0; row < docs.size(); row++) {
+            out->setValue(row, value);
+        }
+    }
+
+private:
+    ColumnVector _value;
+};
+
+class FieldPathKernel final : public VectorizedExpression {
+public:
+    explicit FieldPathKernel(const FieldPath& path) {
+        // The first element names the variable, which is always $$ROOT.
+        for (size_t i = 1; i < path.getPathLength(); i++) {
+            _fields.push_back(path.getFieldName(i));
+        }
+    }
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        out->reset(docs.size());
+        for (size_t row = 0; row < docs.size(); row++) {
+            Value value = docs[row][_fields[0]];
+            bool throughArray = false;
+            for (size_t i = 1; i < _fields.size() && !value.missing(); i++) {
+                if (value.getType() == Object) {
+                    value = value.getDocument()[_fields[i]];
+                } else if (value.getType() == Array) {
+                    // Paths through arrays fan out over their elements; leave that to the
+                    // row-at-a-time path.
+                    throughArray = true;
+                    break;
+                } else {
+                    value = Value();
+                }
+            }
+
+            if (throughArray) {
+                out->setFallback(row);
+            } else {
+                out->setValue(row, value);
+            }
+        }
+    }
+
+private:
+    vector<string> _fields;
+};
+
+/**
+ * Base for kernels with vectorizable operands. Evaluates all operands for the batch.
+ */
+class NaryKernel : public VectorizedExpression {
+public:
+    explicit NaryKernel(vector<unique_ptr<VectorizedExpression>> operands)
+        : _operands(std::move(operands)) {}
+
+    vector<ColumnVector> evaluateOperands(const vector<Document>& docs) const {
+        vector<ColumnVector> columns(_operands.size());
+        for (size_t i = 0; i < _operands.size(); i++) {
+            _operands[i]->evaluate(docs, &columns[i]);
+        }
+        return columns;
+    }
+
+private:
+    const vector<unique_ptr<VectorizedExpression>> _operands;
+};
+
+/**
+ * $add and $multiply. Mirrors ExpressionAdd::evaluateInternal() and
+ * ExpressionMultiply::evaluateInternal().
+ */
+class AddOrMultiplyKernel final : public NaryKernel {
+public:
+    AddOrMultiplyKernel(vector<unique_ptr<VectorizedExpression>> operands, bool isAdd)
+        : NaryKernel(std::move(operands)), _isAdd(isAdd) {}
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        const size_t size = docs.size();
+        const vector<ColumnVector> columns = evaluateOperands(docs);
+        out->reset(size);
+
+        ColumnVector::Kind uniformKind = ColumnVector::kFallback;
+        for (size_t i = 0; i < columns.size(); i++) {
+            const ColumnVector::Kind kind = columns[i].uniformKind();
+            if (i > 0 && kind != uniformKind) {
+                uniformKind = ColumnVector::kFallback;
+                break;
+            }
+            uniformKind = kind;
+        }
+
+        switch (uniformKind) {
+            case ColumnVector::kDouble:
+                return evaluateDoubles(columns, out);
+            case ColumnVector::kInt:
+            case ColumnVector::kLong:
+                return evaluateIntegers(columns, uniformKind, out);
+            default:
+                for (size_t row = 0; row < size; row++) {
+                    evaluateRow(columns, row, out);
+                }
+        }
+    }
+
+private:
+    // Whole batches of a single numeric type take these loops, which have no per-row branches.
+    void evaluateDoubles(const vector<ColumnVector>& columns, ColumnVector* out) const {
+        const size_t size = out->size();
+        double* result = out->doubles();
+        for (size_t row = 0; row < size; row++) {
+            result[row] = _isAdd ? 0 : 1;
+        }
+        for (auto&& column : columns) {
+            const double* operand = column.doubles();
+            if (_isAdd) {
+                for (size_t row = 0; row < size; row++) {
+                    result[row] += operand[row];
+                }
+            } else {
+                for (size_t row = 0; row < size; row++) {
+                    result[row] *= operand[row];
+                }
+            }
+        }
+        for (size_t row = 0; row < size; row++) {
+            out->setDouble(row, result[row]);
+        }
+    }
+
+    void evaluateIntegers(const vector<ColumnVector>& columns,
+                          ColumnVector::Kind kind,
+                          ColumnVector* out) const {
+        const size_t size = out->size();
+        long long* result = out->ints();
+        for (size_t row = 0; row < size; row++) {
+            result[row] = _isAdd ? 0 : 1;
+        }
+        for (auto&& column : columns) {
+            const long long* operand = column.ints();
+            if (_isAdd) {
+                for (size_t row = 0; row < size; row++) {
+                    result[row] = wrappingAdd(result[row], operand[row]);
+                }
+            } else {
+                for (size_t row = 0; row < size; row++) {
+                    result[row] = wrappingMultiply(result[row], operand[row]);
+                }
+            }
+        }
+        for (size_t row = 0; row < size; row++) {
+            if (kind == ColumnVector::kInt) {
+                setIntOrLong(out, row, result[row]);
+            } else {
+                out->setIntegral(row, ColumnVector::kLong, result[row]);
+            }
+        }
+    }
+
+    void evaluateRow(const vector<ColumnVector>& columns, size_t row, ColumnVector* out) const {
+        ColumnVector::Kind totalKind = ColumnVector::kInt;
+        double doubleTotal = _isAdd ? 0 : 1;
+        long long longTotal = _isAdd ? 0 : 1;
+        bool nullish = false;
+        int dates = 0;
+
+        for (auto&& column : columns) {
+            const ColumnVector::Kind kind = column.kind(row);
+            if (column.isNumeric(row)) {
+                totalKind = widestNumeric(totalKind, kind);
+                if (_isAdd) {
+                    doubleTotal += column.coerceToDouble(row);
+                } else {
+                    doubleTotal *= column.coerceToDouble(row);
+                }
+                if (kind != ColumnVector::kDouble) {
+                    longTotal = _isAdd ? wrappingAdd(longTotal, column.getInt(row))
+                                       : wrappingMultiply(longTotal, column.getInt(row));
+                }
+            } else if (kind == ColumnVector::kDate && _isAdd) {
+                dates++;
+                longTotal = wrappingAdd(longTotal, column.getInt(row));
+            } else if (column.isNullish(row)) {
+                nullish = true;
+            } else {
+                // Either unknown, or an error for the row-at-a-time path to raise.
+                return;
+            }
+        }
+
+        if (dates > 1) {
+            return;
+        } else if (nullish) {
+            out->setNull(row);
+        } else if (dates == 1) {
+            // Adding a double to a date truncates through a conversion which is left to the
+            // row-at-a-time path.
+            if (totalKind != ColumnVector::kDouble)
+                out->setIntegral(row, ColumnVector::kDate, longTotal);
+        } else if (totalKind == ColumnVector::kDouble) {
+            out->setDouble(row, doubleTotal);
+        } else if (totalKind == ColumnVector::kLong) {
+            out->setIntegral(row, ColumnVector::kLong, longTotal);
+        } else {
+            setIntOrLong(out, row, longTotal);
+        }
+    }
+
+    const bool _isAdd;
+};
+
+/**
+ * $subtract. Mirrors ExpressionSubtract::evaluateInternal().
+ */
+class SubtractKernel final : public NaryKernel {
+public:
+    using NaryKernel::NaryKernel;
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        const vector<ColumnVector> columns = evaluateOperands(docs);
+        const ColumnVector& lhs = columns[0];
+        const ColumnVector& rhs = columns[1];
+        out->reset(docs.size());
+
+        const ColumnVector::Kind uniformKind = lhs.uniformKind();
+        if (uniformKind == ColumnVector::kDouble && rhs.uniformKind() == uniformKind) {
+            for (size_t row = 0; row < docs.size(); row++) {
+                out->doubles()[row] = lhs.getDouble(row) - rhs.getDouble(row);
+            }
+            for (size_t row = 0; row < docs.size(); row++) {
+                out->setDouble(row, out->doubles()[row]);
+            }
+            return;
+        }
+
+        for (size_t row = 0; row < docs.size(); row++) {
+            const ColumnVector::Kind lKind = lhs.kind(row);
+            const ColumnVector::Kind rKind = rhs.kind(row);
+            if (lKind == ColumnVector::kFallback || rKind == ColumnVector::kFallback)
+                continue;
+
+            if (lhs.isNumeric(row) && rhs.isNumeric(row)) {
+                const ColumnVector::Kind kind = widestNumeric(lKind, rKind);
+                if (kind == ColumnVector::kDouble) {
+                    out->setDouble(row, lhs.coerceToDouble(row) - rhs.coerceToDouble(row));
+                } else if (kind == ColumnVector::kLong) {
+                    out->setIntegral(row,
+                                     ColumnVector::kLong,
+                                     wrappingSubtract(lhs.getInt(row), rhs.getInt(row)));
+                } else {
+                    setIntOrLong(out, row, wrappingSubtract(lhs.getInt(row), rhs.getInt(row)));
+                }
+            } else if (lhs.isNullish(row) || rhs.isNullish(row)) {
+                out->setNull(row);
+            } else if (lKind == ColumnVector::kDate && rKind == ColumnVector::kDate) {
+                out->setIntegral(
+                    row, ColumnVector::kLong, wrappingSubtract(lhs.getInt(row), rhs.getInt(row)));
+            } else if (lKind == ColumnVector::kDate &&
+                       (rKind == ColumnVector::kInt || rKind == ColumnVector::kLong)) {
+                out->setIntegral(
+                    row, ColumnVector::kDate, wrappingSubtract(lhs.getInt(row), rhs.getInt(row)));
+            }
+        }
+    }
+};
+
+/**
+ * $divide. Mirrors ExpressionDivide::evaluateInternal().
+ */
+class DivideKernel final : public NaryKernel {
+public:
+    using NaryKernel::NaryKernel;
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        const vector<ColumnVector> columns = evaluateOperands(docs);
+        const ColumnVector& lhs = columns[0];
+        const ColumnVector& rhs = columns[1];
+        out->reset(docs.size());
+
+        for (size_t row = 0; row < docs.size(); row++) {
+            if (lhs.kind(row) == ColumnVector::kFallback || rhs.kind(row) == ColumnVector::kFallback)
+                continue;
+
+            if (lhs.isNumeric(row) && rhs.isNumeric(row)) {
+                // Division by zero is an error, raised by the row-at-a-time path.
+                const double denominator = rhs.coerceToDouble(row);
+                if (denominator != 0)
+                    out->setDouble(row, lhs.coerceToDouble(row) / denominator);
+            } else if (lhs.isNullish(row) || rhs.isNullish(row)) {
+                out->setNull(row);
+            }
+        }
+    }
+};
+
+/**
+ * $eq, $ne, $gt, $gte, $lt, $lte and $cmp. Mirrors ExpressionCompare::evaluateInternal().
+ */
+class CompareKernel final : public NaryKernel {
+public:
+    CompareKernel(vector<unique_ptr<VectorizedExpression>> operands,
+                  ExpressionCompare::CmpOp cmpOp)
+        : NaryKernel(std::move(operands)), _cmpOp(cmpOp) {}
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        const vector<ColumnVector> columns = evaluateOperands(docs);
+        const ColumnVector& lhs = columns[0];
+        const ColumnVector& rhs = columns[1];
+        const size_t size = docs.size();
+        out->reset(size);
+
+        // Compute -1, 0 or 1 for every row into the integer array first.
+        long long* cmp = out->ints();
+        const ColumnVector::Kind uniformKind = lhs.uniformKind();
+        if ((uniformKind == ColumnVector::kInt || uniformKind == ColumnVector::kLong) &&
+            rhs.uniformKind() == uniformKind) {
+            const long long* l = lhs.ints();
+            const long long* r = rhs.ints();
+            for (size_t row = 0; row < size; row++) {
+                cmp[row] = (l[row] > r[row]) - (l[row] < r[row]);
+            }
+        } else {
+            for (size_t row = 0; row < size; row++) {
+                if (lhs.kind(row) == ColumnVector::kFallback ||
+                    rhs.kind(row) == ColumnVector::kFallback) {
+                    cmp[row] = std::numeric_limits<long long>::min();
+                    continue;
+                }
+                const int result = compareRows(lhs, row, rhs, row);
+                cmp[row] = (result > 0) - (result < 0);
+            }
+        }
+
+        for (size_t row = 0; row < size; row++) {
+            const long long result = cmp[row];
+            if (result == std::numeric_limits<long long>::min())
+                continue;
+
+            switch (_cmpOp) {
+                case ExpressionCompare::EQ:
+                    out->setIntegral(row, ColumnVector::kBool, result == 0);
+                    break;
+                case ExpressionCompare::NE:
+                    out->setIntegral(row, ColumnVector::kBool, result != 0);
+                    break;
+                case ExpressionCompare::GT:
+                    out->setIntegral(row, ColumnVector::kBool, result > 0);
+                    break;
+                case ExpressionCompare::GTE:
+                    out->setIntegral(row, ColumnVector::kBool, result >= 0);
+                    break;
+                case ExpressionCompare::LT:
+                    out->setIntegral(row, ColumnVector::kBool, result < 0);
+                    break;
+                case ExpressionCompare::LTE:
+                    out->setIntegral(row, ColumnVector::kBool, result <= 0);
+                    break;
+                case ExpressionCompare::CMP:
+                    out->setIntegral(row, ColumnVector::kInt, result);
+                    break;
+            }
+        }
+    }
+
+private:
+    const ExpressionCompare::CmpOp _cmpOp;
+};
+
+/**
+ * $and, $or and $not. Operands are considered in order, so a row only depends on the operands the
+ * row-at-a-time path would have evaluated before short-circuiting.
+ */
+class LogicalKernel final : public NaryKernel {
+public:
+    enum Op { kAnd, kOr, kNot };
+
+    LogicalKernel(vector<unique_ptr<VectorizedExpression>> operands, Op op)
+        : NaryKernel(std::move(operands)), _op(op) {}
+
+    void evaluate(const vector<Document>& docs, ColumnVector* out) const final {
+        const vector<ColumnVector> columns = evaluateOperands(docs);
+        out->reset(docs.size());
+
+        for (size_t row = 0; row < docs.size(); row++) {
+            if (_op == kNot) {
+                if (columns[0].kind(row) != ColumnVector::kFallback)
+                    out->setIntegral(row, ColumnVector::kBool, !columns[0].coerceToBool(row));
+                continue;
+            }
+
+            // $and stops at the first false operand, $or at the first true one.
+            const bool stopValue = _op == kOr;
+            bool result = !stopValue;
+            bool known = true;
+            for (auto&& column : columns) {
+                if (column.kind(row) == ColumnVector::kFallback) {
+                    known = false;
+                    break;
+                }
+                if (column.coerceToBool(row) == stopValue) {
+                    result = stopValue;
+                    break;
+                }
+            }
+
+            if (known)
+                out->setIntegral(row, ColumnVector::kBool, result);
+        }
+    }
+
+private:
+    const Op _op;
+};
+
+//
+// Kernels for VectorizedPredicate
+//
+
+class AndOrPredicate final : public VectorizedPredicate {
+public:
+    AndOrPredicate(vector<unique_ptr<VectorizedPredicate>> children, bool isAnd)
+        : _children(std::move(children)), _isAnd(isAnd) {}
+
+    void evaluate(const vector<Document>& docs, vector<Result>* out) const final {
+        // The matcher has no side effects, so unlike for expressions the order in which children
+        // are considered doesn't matter.
+        const Result decisive = _isAnd ? kNoMatch : kMatch;
+        out->assign(docs.size(), _isAnd ? kMatch : kNoMatch);
+
+        vector<Result> childResults;
+        for (auto&& child : _children) {
+            child->evaluate(docs, &childResults);
+            for (size_t row = 0; row < docs.size(); row++) {
+                if ((*out)[row] == decisive)
+                    continue;
+                if (childResults[row] == decisive || childResults[row] == kUndecided)
+                    (*out)[row] = childResults[row];
+            }
+        }
+    }
+
+private:
+    const vector<unique_ptr<VectorizedPredicate>> _children;
+    const bool _isAnd;
+};
+
+class UndecidedPredicate final : public VectorizedPredicate {
+public:
+    void evaluate(const vector<Document>& docs, vector<Result>* out) const final {
+        out->assign(docs.size(), kUndecided);
+    }
+};
+
+/**
+ * $eq, $lt, $lte, $gt and $gte. Mirrors ComparisonMatchExpression::matchesSingleElement() for
+ * paths which don't reach an array.
+ */
+class ComparisonPredicate final : public VectorizedPredicate {
+public:
+    ComparisonPredicate(StringData path, MatchExpression::MatchType matchType, const Value& rhs)
+        : _matchType(matchType) {
+        size_t start = 0;
+        for (size_t dot; (dot = path.find('.', start)) != string::npos; start = dot + 1) {
+            _fields.push_back(path.substr(start, dot - start).toString());
+        }
+        _fields.push_back(path.substr(start).toString());
+
+        _rhs.reset(1);
+        _rhs.setValue(0, rhs);
+        invariant(_rhs.kind(0) != ColumnVector::kFallback);
+    }
+
+    void evaluate(const vector<Document>& docs, vector<Result>* out) const final {
+        out->assign(docs.size(), kUndecided);
+
+        ColumnVector lhs;
+        lhs.reset(docs.size());
+        for (size_t row = 0; row < docs.size(); row++) {
+            Value value = docs[row][_fields[0]];
+            size_t depth = 1;
+            for (; depth < _fields.size() && value.getType() == Object; depth++) {
+                value = value.getDocument()[_fields[depth]];
+            }
+            // A path stopping short at a scalar or an array is left to the matcher, as are leaves
+            // which are arrays, objects or missing.
+            if (depth < _fields.size())
+                continue;
+            lhs.setValue(row, value);
+        }
+
+        const int rhsCanonical = canonicalizeBSONType(bsonTypeOf(_rhs.kind(0)));
+        for (size_t row = 0; row < docs.size(); row++) {
+            const ColumnVector::Kind kind = lhs.kind(row);
+            if (kind == ColumnVector::kFallback || kind == ColumnVector::kMissing)
+                continue;
+
+            // Values of another canonical type, including null, never match.
+            if (canonicalizeBSONType(bsonTypeOf(kind)) != rhsCanonical) {
+                (*out)[row] = kNoMatch;
+                continue;
+            }
+
+            // NaN only equals NaN, and the right-hand side is never NaN.
+            if (kind == ColumnVector::kDouble && std::isnan(lhs.getDouble(row))) {
+                (*out)[row] = kNoMatch;
+                continue;
+            }
+
+            const int cmp = compareRows(lhs, row, _rhs, 0);
+            bool matches = false;
+            switch (_matchType) {
+                case MatchExpression::EQ:
+                    matches = cmp == 0;
+                    break;
+                case MatchExpression::LT:
+                    matches = cmp < 0;
+                    break;
+                case MatchExpression::LTE:
+                    matches = cmp <= 0;
+                    break;
+                case MatchExpression::GT:
+                    matches = cmp > 0;
+                    break;
+                case MatchExpression::GTE:
+                    matches = cmp >= 0;
+                    break;
+                default:
+                    MONGO_UNREACHABLE;
+            }
+            (*out)[row] = matches ? kMatch : kNoMatch;
+        }
+    }
+
+private:
+    vector<string> _fields;
+    const MatchExpression::MatchType _matchType;
+    ColumnVector _rhs;
+};
+
+unique_ptr<VectorizedPredicate> compilePredicate(const MatchExpression* expression) {
+    switch (expression->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR: {
+            vector<unique_ptr<VectorizedPredicate>> children;
+            for (size_t i = 0; i < expression->numChildren(); i++) {
+                children.push_back(compilePredicate(expression->getChild(i)));
+            }
+            return stdx::make_unique<AndOrPredicate>(std::move(children),
+                                                     expression->matchType() ==
+                                                         MatchExpression::AND);
+        }
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            auto comparison = static_cast<const ComparisonMatchExpression*>(expression);
+            const Value rhs(comparison->getData());
+
+            // Null, NaN, and types with special matching rules are left to the matcher.
+            ColumnVector rhsColumn;
+            rhsColumn.reset(1);
+            rhsColumn.setValue(0, rhs);
+            const ColumnVector::Kind kind = rhsColumn.kind(0);
+            if (kind == ColumnVector::kFallback || kind == ColumnVector::kMissing ||
+                kind == ColumnVector::kNull ||
+                (kind == ColumnVector::kDouble && std::isnan(rhsColumn.getDouble(0)))) {
+                return stdx::make_unique<UndecidedPredicate>();
+            }
+            return stdx::make_unique<ComparisonPredicate>(
+                comparison->path(), expression->matchType(), rhs);
+        }
+        default:
+            return stdx::make_unique<UndecidedPredicate>();
+    }
+}
+
+bool isUndecided(const VectorizedPredicate* predicate) {
+    return dynamic_cast<const UndecidedPredicate*>(predicate);
+}
+
+}  // namespace
+
+//
+// ColumnVector
+//
+
+void ColumnVector::reset(size_t size) {
+    _kinds.assign(size, kFallback);
+    _ints.resize(size);
+    _doubles.resize(size);
+    _strings.clear();
+}
+
+ColumnVector::Kind ColumnVector::uniformKind() const {
+    if (_kinds.empty())
+        return kFallback;
+
+    const Kind kind = _kinds[0];
+    for (size_t row = 1; row < _kinds.size(); row++) {
+        if (_kinds[row] != kind)
+            return kFallback;
+    }
+    return kind;
+}
+
+bool ColumnVector::coerceToBool(size_t row) const {
+    switch (_kinds[row]) {
+        case kMissing:
+        case kNull:
+            return false;
+        case kBool:
+        case kInt:
+        case kLong:
+            return _ints[row] != 0;
+        case kDouble:
+            return _doubles[row] != 0;
+        case kDate:
+        case kString:
+            return true;
+        case kFallback:
+            break;
+    }
+    MONGO_UNREACHABLE;
+}
+
+void ColumnVector::setValue(size_t row, const Value& value) {
+    switch (value.getType()) {
+        case EOO:
+            _kinds[row] = kMissing;
+            return;
+        case jstNULL:
+            _kinds[row] = kNull;
+            return;
+        case Bool:
+            setIntegral(row, kBool, value.getBool());
+            return;
+        case NumberInt:
+            setIntegral(row, kInt, value.getInt());
+            return;
+        case NumberLong:
+            setIntegral(row, kLong, value.getLong());
+            return;
+        case NumberDouble:
+            setDouble(row, value.getDouble());
+            return;
+        case Date:
+            setIntegral(row, kDate, value.getDate());
+            return;
+        case String:
+            if (_strings.size() < _kinds.size())
+                _strings.resize(_kinds.size());
+            _kinds[row] = kString;
+            _strings[row] = value.getString();
+            return;
+        default:
+            _kinds[row] = kFallback;
+            return;
+    }
+}
+
+Value ColumnVector::getValue(size_t row) const {
+    switch (_kinds[row]) {
+        case kMissing:
+            return Value();
+        case kNull:
+            return Value(BSONNULL);
+        case kBool:
+            return Value(_ints[row] != 0);
+        case kInt:
+            return Value(static_cast<int>(_ints[row]));
+        case kLong:
+            return Value(_ints[row]);
+        case kDouble:
+            return Value(_doubles[row]);
+        case kDate:
+            return Value(Date_t::fromMillisSinceEpoch(_ints[row]));
+        case kString:
+            return Value(_strings[row]);
+        case kFallback:
+            break;
+    }
+    MONGO_UNREACHABLE;
+}
+
+//
+// VectorizedExpression
+//
+
+unique_ptr<VectorizedExpression> VectorizedExpression::compile(
+    const intrusive_ptr<Expression>& expression) {
+    Expression* expr = expression.get();
+
+    if (auto constant = dynamic_cast<ExpressionConstant*>(expr))
+        return stdx::make_unique<ConstantKernel>(constant->getValue());
+
+    if (auto fieldPath = dynamic_cast<ExpressionFieldPath*>(expr)) {
+        if (fieldPath->getVariableId() != Variables::ROOT_ID ||
+            fieldPath->getFieldPath().getPathLength() < 2) {
+            return {};
+        }
+        return stdx::make_unique<FieldPathKernel>(fieldPath->getFieldPath());
+    }
+
+    auto nary = dynamic_cast<ExpressionNary*>(expr);
+    if (!nary)
+        return {};
+
+    vector<unique_ptr<VectorizedExpression>> operands;
+    for (auto&& operand : nary->getOperandList()) {
+        operands.push_back(compile(operand));
+        if (!operands.back())
+            return {};
+    }
+
+    if (dynamic_cast<ExpressionAdd*>(expr))
+        return stdx::make_unique<AddOrMultiplyKernel>(std::move(operands), /*isAdd*/ true);
+    if (dynamic_cast<ExpressionMultiply*>(expr))
+        return stdx::make_unique<AddOrMultiplyKernel>(std::move(operands), /*isAdd*/ false);
+    if (dynamic_cast<ExpressionSubtract*>(expr))
+        return stdx::make_unique<SubtractKernel>(std::move(operands));
+    if (dynamic_cast<ExpressionDivide*>(expr))
+        return stdx::make_unique<DivideKernel>(std::move(operands));
+    if (auto compare = dynamic_cast<ExpressionCompare*>(expr))
+        return stdx::make_unique<CompareKernel>(std::move(operands), compare->getCmpOp());
+    if (dynamic_cast<ExpressionAnd*>(expr))
+        return stdx::make_unique<LogicalKernel>(std::move(operands), LogicalKernel::kAnd);
+    if (dynamic_cast<ExpressionOr*>(expr))
+        return stdx::make_unique<LogicalKernel>(std::move(operands), LogicalKernel::kOr);
+    if (dynamic_cast<ExpressionNot*>(expr))
+        return stdx::make_unique<LogicalKernel>(std::move(operands), LogicalKernel::kNot);
+
+    return {};
+}
+
+//
+// ExpressionVectorized
+//
+
+ExpressionVectorized::ExpressionVectorized(const intrusive_ptr<Expression>& original,
+                                           unique_ptr<VectorizedExpression> vectorized)
+    : _original(original), _vectorized(std::move(vectorized)) {}
+
+intrusive_ptr<ExpressionVectorized> ExpressionVectorized::create(
+    const intrusive_ptr<Expression>& original) {
+    // Constants and plain field paths are cheaper to evaluate directly.
+    if (!dynamic_cast<ExpressionNary*>(original.get()))
+        return nullptr;
+
+    unique_ptr<VectorizedExpression> vectorized = VectorizedExpression::compile(original);
+    if (!vectorized)
+        return nullptr;
+
+    return new ExpressionVectorized(original, std::move(vectorized));
+}
+
+void ExpressionVectorized::addDependencies(DepsTracker* deps, vector<string>* path) const {
+    _original->addDependencies(deps, path);
+}
+
+Value ExpressionVectorized::serialize(bool explain) const {
+    return _original->serialize(explain);
+}
+
+Value ExpressionVectorized::evaluateInternal(Variables* vars) const {
+    if (_row >= _column.size() || _column.kind(_row) == ColumnVector::kFallback)
+        return _original->evaluateInternal(vars);
+    return _column.getValue(_row);
+}
+
+void ExpressionVectorized::evaluateBatch(const vector<Document>& docs) {
+    _vectorized->evaluate(docs, &_column);
+    _row = 0;
+}
+
+size_t ExpressionVectorized::getFallbackRows() const {
+    size_t fallbackRows = 0;
+    for (size_t row = 0; row < _column.size(); row++) {
+        fallbackRows += _column.kind(row) == ColumnVector::kFallback;
+    }
+    return fallbackRows;
+}
+
+//
+// VectorizedPredicate
+//
+
+unique_ptr<VectorizedPredicate> VectorizedPredicate::compile(const MatchExpression* expression) {
+    unique_ptr<VectorizedPredicate> predicate = compilePredicate(expression);
+    if (isUndecided(predicate.get()))
+        return {};
+    return predicate;
+}
+
+}  // namespace mongo
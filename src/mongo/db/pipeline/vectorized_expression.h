@@ -0,0 +1,248 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/value.h"
+
+namespace mongo {
+
+class MatchExpression;
+
+/**
+ * The values of an expression over a batch of documents, one row per document. Values of the
+ * types the vectorized kernels understand are stored unboxed in typed arrays. Rows holding
+ * anything else, or whose value the kernels could not compute exactly, are kFallback and must be
+ * evaluated one document at a time.
+ */
+class ColumnVector {
+public:
+    enum Kind : uint8_t {
+        kFallback,
+        kMissing,
+        kNull,
+        kBool,
+        kInt,
+        kLong,
+        kDouble,
+        kDate,
+        kString,
+    };
+
+    /**
+     * Resizes to 'size' rows, all of which are kFallback.
+     */
+    void reset(size_t size);
+
+    size_t size() const {
+        return _kinds.size();
+    }
+
+    Kind kind(size_t row) const {
+        return _kinds[row];
+    }
+
+    /**
+     * Returns the kind of all rows if they are of the same kind, or kFallback.
+     */
+    Kind uniformKind() const;
+
+    bool isNumeric(size_t row) const {
+        return _kinds[row] == kInt || _kinds[row] == kLong || _kinds[row] == kDouble;
+    }
+
+    bool isNullish(size_t row) const {
+        return _kinds[row] == kMissing || _kinds[row] == kNull;
+    }
+
+    // Integral kinds (kBool, kInt, kLong and kDate, in milliseconds) share one array, kDouble has
+    // its own. The arrays are exposed for kernels working on whole columns.
+    long long* ints() {
+        return _ints.data();
+    }
+    const long long* ints() const {
+        return _ints.data();
+    }
+    double* doubles() {
+        return _doubles.data();
+    }
+    const double* doubles() const {
+        return _doubles.data();
+    }
+
+    long long getInt(size_t row) const {
+        return _ints[row];
+    }
+    double getDouble(size_t row) const {
+        return _doubles[row];
+    }
+    StringData getString(size_t row) const {
+        return _strings[row];
+    }
+
+    /** Same as Value::coerceToDouble() for numeric rows. */
+    double coerceToDouble(size_t row) const {
+        return _kinds[row] == kDouble ? _doubles[row] : static_cast<double>(_ints[row]);
+    }
+
+    /** Same as Value::coerceToBool() for any row other than kFallback. */
+    bool coerceToBool(size_t row) const;
+
+    void setFallback(size_t row) {
+        _kinds[row] = kFallback;
+    }
+    void setMissing(size_t row) {
+        _kinds[row] = kMissing;
+    }
+    void setNull(size_t row) {
+        _kinds[row] = kNull;
+    }
+    void setIntegral(size_t row, Kind kind, long long value) {
+        _kinds[row] = kind;
+        _ints[row] = value;
+    }
+    void setDouble(size_t row, double value) {
+        _kinds[row] = kDouble;
+        _doubles[row] = value;
+    }
+
+    /**
+     * Stores 'value', or marks the row kFallback if it isn't of a kind this understands.
+     */
+    void setValue(size_t row, const Value& value);
+
+    /**
+     * Returns the value of a row other than kFallback.
+     */
+    Value getValue(size_t row) const;
+
+private:
+    std::vector<Kind> _kinds;
+    std::vector<long long> _ints;
+    std::vector<double> _doubles;
+
+    // Only sized once a string is stored.
+    std::vector<std::string> _strings;
+};
+
+/**
+ * An aggregation expression compiled to kernels which evaluate it over a batch of documents at a
+ * time. Only field paths, constants, $add, $subtract, $multiply, $divide, the comparisons, $and,
+ * $or and $not are supported, and the kernels only handle numbers, dates, booleans, strings, null
+ * and missing values. Any row they can't compute exactly as Expression::evaluate() would, including
+ * every row on which it would throw, is left as kFallback.
+ *
+ * Kernels never throw and evaluate all of their operands, so a row's fallback must evaluate the
+ * original expression rather than parts of it.
+ */
+class VectorizedExpression {
+public:
+    virtual ~VectorizedExpression() = default;
+
+    /**
+     * Returns null if 'expression' uses anything the kernels don't support. Field paths must be
+     * relative to $$ROOT; the documents passed to evaluate() are used as $$ROOT.
+     */
+    static std::unique_ptr<VectorizedExpression> compile(
+        const boost::intrusive_ptr<Expression>& expression);
+
+    /**
+     * Computes the value of the expression for each of 'docs' into 'out'.
+     */
+    virtual void evaluate(const std::vector<Document>& docs, ColumnVector* out) const = 0;
+};
+
+/**
+ * Stands in for a computed field of a $project whose expression can be vectorized. The $project
+ * calls evaluateBatch() with each batch of input documents, then setRow() before projecting each
+ * of them. evaluateInternal() returns the precomputed value for that row, or evaluates the
+ * original expression if the kernels could not.
+ */
+class ExpressionVectorized final : public Expression {
+public:
+    /**
+     * Returns null if 'original' is not worth vectorizing or can't be vectorized.
+     */
+    static boost::intrusive_ptr<ExpressionVectorized> create(
+        const boost::intrusive_ptr<Expression>& original);
+
+    void addDependencies(DepsTracker* deps, std::vector<std::string>* path = NULL) const final;
+    Value serialize(bool explain) const final;
+    Value evaluateInternal(Variables* vars) const final;
+
+    void evaluateBatch(const std::vector<Document>& docs);
+
+    void setRow(size_t row) {
+        _row = row;
+    }
+
+    /** Number of rows of the last batch which had to be evaluated one at a time. */
+    size_t getFallbackRows() const;
+
+private:
+    ExpressionVectorized(const boost::intrusive_ptr<Expression>& original,
+                         std::unique_ptr<VectorizedExpression> vectorized);
+
+    const boost::intrusive_ptr<Expression> _original;
+    const std::unique_ptr<VectorizedExpression> _vectorized;
+    ColumnVector _column;
+    size_t _row = 0;
+};
+
+/**
+ * A MatchExpression compiled to kernels which decide it for a batch of Documents without
+ * converting them to BSON. Supports $and, $or and $eq, $lt, $lte, $gt and $gte against numbers,
+ * strings, dates and booleans. Rows it can't decide exactly, for instance because the path
+ * reaches an array, are kUndecided and must be given to the Matcher.
+ */
+class VectorizedPredicate {
+public:
+    enum Result : uint8_t { kNoMatch, kMatch, kUndecided };
+
+    virtual ~VectorizedPredicate() = default;
+
+    /**
+     * Returns null if no row of any document could be decided without the Matcher.
+     */
+    static std::unique_ptr<VectorizedPredicate> compile(const MatchExpression* expression);
+
+    /**
+     * Decides 'expression' for each of 'docs' into 'out'.
+     */
+    virtual void evaluate(const std::vector<Document>& docs, std::vector<Result>* out) const = 0;
+};
+
+}  // namespace mongo
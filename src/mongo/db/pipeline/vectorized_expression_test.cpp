@@ -0,0 +1,256 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/vectorized_expression.h"
+
+#include <limits>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/matcher.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using boost::intrusive_ptr;
+using std::numeric_limits;
+using std::vector;
+
+/**
+ * Documents covering the types, and mixes of types, the kernels distinguish between.
+ */
+vector<Document> makeDocuments() {
+    const vector<BSONObj> objs = {
+        BSON("a" << 1 << "b" << 2),
+        BSON("a" << 1 << "b" << 2LL),
+        BSON("a" << 1.5 << "b" << 2),
+        BSON("a" << numeric_limits<int>::max() << "b" << 1),
+        BSON("a" << numeric_limits<long long>::max() << "b" << 1LL),
+        BSON("a" << numeric_limits<double>::quiet_NaN() << "b" << 1.0),
+        BSON("a" << -0.0 << "b" << 0),
+        BSON("a" << 0 << "b" << 0.0),
+        BSON("a" << Date_t::fromMillisSinceEpoch(1000) << "b" << 10),
+        BSON("a" << Date_t::fromMillisSinceEpoch(1000) << "b" << 2.5),
+        BSON("a" << Date_t::fromMillisSinceEpoch(1000) << "b"
+                 << Date_t::fromMillisSinceEpoch(10)),
+        BSON("a"
+             << "abc"
+             << "b"
+             << "abd"),
+        BSON("a"
+             << "abc"
+             << "b" << 1),
+        BSON("a" << true << "b" << false),
+        BSON("a" << BSONNULL << "b" << 1),
+        BSON("b" << 1),
+        BSON("a" << BSON_ARRAY(1 << 2) << "b" << 1),
+        BSON("a" << BSON("c" << 1) << "b" << 1),
+        BSON("a" << OID() << "b" << 1),
+        BSON("a" << BSONUndefined << "b" << 1),
+        BSON("a" << 3 << "b" << BSONNULL),
+        BSON("a" << 3 << "b"
+                 << "x"),
+        BSON("n" << BSON("x" << 1 << "y" << 2)),
+        BSON("n" << BSON("x" << 1.5)),
+        BSON("n" << 5),
+        BSON("n" << BSON_ARRAY(BSON("x" << 1))),
+        BSON("n" << BSON("x" << BSON_ARRAY(1))),
+    };
+
+    vector<Document> docs;
+    for (auto&& obj : objs) {
+        docs.push_back(Document(obj));
+    }
+    return docs;
+}
+
+/**
+ * Evaluates 'spec' over each document a batch at a time and one at a time, and checks that the
+ * results, including any error, are the same.
+ */
+void assertBatchMatchesRows(const BSONObj& spec, size_t expectedMinDecidedRows = 1) {
+    VariablesIdGenerator idGenerator;
+    VariablesParseState vps(&idGenerator);
+    const BSONObj wrapped = BSON("" << spec);
+    intrusive_ptr<Expression> original = Expression::parseOperand(wrapped.firstElement(), vps);
+    intrusive_ptr<ExpressionVectorized> vectorized = ExpressionVectorized::create(original);
+    ASSERT(vectorized);
+
+    const vector<Document> docs = makeDocuments();
+    vectorized->evaluateBatch(docs);
+    ASSERT_LESS_THAN_OR_EQUALS(expectedMinDecidedRows + vectorized->getFallbackRows(),
+                               docs.size());
+
+    for (size_t row = 0; row < docs.size(); row++) {
+        vectorized->setRow(row);
+
+        Value expected;
+        bool expectedThrows = false;
+        try {
+            expected = original->evaluate(docs[row]);
+        } catch (const UserException&) {
+            expectedThrows = true;
+        }
+
+        if (expectedThrows) {
+            ASSERT_THROWS(vectorized->evaluate(docs[row]), UserException);
+            continue;
+        }
+
+        const Value actual = vectorized->evaluate(docs[row]);
+        ASSERT_EQUALS(expected.getType(), actual.getType()) << spec << " on " << docs[row];
+        ASSERT_EQUALS(expected, actual) << spec << " on " << docs[row];
+    }
+}
+
+/**
+ * Decides 'query' for each document and checks every decided row against the Matcher.
+ */
+void assertPredicateMatchesMatcher(const BSONObj& query) {
+    Matcher matcher(query);
+    std::unique_ptr<VectorizedPredicate> predicate =
+        VectorizedPredicate::compile(matcher.getMatchExpression());
+    ASSERT(predicate);
+
+    const vector<Document> docs = makeDocuments();
+    vector<VectorizedPredicate::Result> results;
+    predicate->evaluate(docs, &results);
+    ASSERT_EQUALS(docs.size(), results.size());
+
+    size_t decided = 0;
+    for (size_t row = 0; row < docs.size(); row++) {
+        if (results[row] == VectorizedPredicate::kUndecided)
+            continue;
+        decided++;
+        const bool matches = results[row] == VectorizedPredicate::kMatch;
+        ASSERT_EQUALS(matcher.matches(docs[row].toBson()), matches) << query << " on "
+                                                                    << docs[row];
+    }
+    ASSERT_GREATER_THAN(decided, 0U);
+}
+
+TEST(VectorizedExpressionTest, Arithmetic) {
+    assertBatchMatchesRows(BSON("$add" << BSON_ARRAY("$a"
+                                                     << "$b")));
+    assertBatchMatchesRows(BSON("$add" << BSON_ARRAY("$a"
+                                                     << "$b" << 1.5 << 2LL)));
+    assertBatchMatchesRows(BSON("$multiply" << BSON_ARRAY("$a"
+                                                          << "$b")));
+    assertBatchMatchesRows(BSON("$multiply" << BSON_ARRAY("$a" << 3)));
+    assertBatchMatchesRows(BSON("$subtract" << BSON_ARRAY("$a"
+                                                          << "$b")));
+    assertBatchMatchesRows(BSON("$divide" << BSON_ARRAY("$a"
+                                                        << "$b")));
+    assertBatchMatchesRows(BSON("$add" << BSON_ARRAY("$n.x"
+                                                     << "$n.y")));
+}
+
+TEST(VectorizedExpressionTest, Comparisons) {
+    for (auto op : {"$eq", "$ne", "$gt", "$gte", "$lt", "$lte", "$cmp"}) {
+        assertBatchMatchesRows(BSON(op << BSON_ARRAY("$a"
+                                                     << "$b")));
+        assertBatchMatchesRows(BSON(op << BSON_ARRAY("$a" << 1)));
+        assertBatchMatchesRows(BSON(op << BSON_ARRAY("$n.x" << 1)));
+    }
+}
+
+TEST(VectorizedExpressionTest, Logical) {
+    assertBatchMatchesRows(
+        BSON("$and" << BSON_ARRAY("$a" << BSON("$gt" << BSON_ARRAY("$b" << 1)))));
+    assertBatchMatchesRows(
+        BSON("$or" << BSON_ARRAY("$a" << BSON("$gt" << BSON_ARRAY("$b" << 1)))));
+    assertBatchMatchesRows(BSON("$not" << BSON_ARRAY("$a")));
+
+    // A fallback operand must stop the row from being decided only if it is reached.
+    assertBatchMatchesRows(BSON("$and" << BSON_ARRAY(false << BSON("$divide" << BSON_ARRAY(
+                                                                       "$a"
+                                                                       << "$b")))),
+                           10);
+}
+
+TEST(VectorizedExpressionTest, UnsupportedExpressionsAreNotWrapped) {
+    VariablesIdGenerator idGenerator;
+    VariablesParseState vps(&idGenerator);
+    auto parse = [&](const BSONObj& operand) {
+        return Expression::parseOperand(operand.firstElement(), vps);
+    };
+
+    ASSERT_FALSE(ExpressionVectorized::create(parse(BSON(""
+                                                         << "$a"))));
+    ASSERT_FALSE(ExpressionVectorized::create(parse(BSON("" << 1))));
+    ASSERT_FALSE(ExpressionVectorized::create(parse(BSON("" << BSON("$concat" << BSON_ARRAY(
+                                                                        "$a"
+                                                                        << "$b"))))));
+    ASSERT_FALSE(ExpressionVectorized::create(parse(BSON(
+        "" << BSON("$add" << BSON_ARRAY(BSON("$size"
+                                             << "$a") << 1))))));
+    ASSERT_FALSE(ExpressionVectorized::create(parse(BSON(
+        "" << BSON("$add" << BSON_ARRAY("$$CURRENT" << 1))))));
+}
+
+TEST(VectorizedPredicateTest, Comparisons) {
+    assertPredicateMatchesMatcher(BSON("a" << 1));
+    assertPredicateMatchesMatcher(BSON("a" << 1.5));
+    assertPredicateMatchesMatcher(BSON("a" << BSON("$gt" << 0)));
+    assertPredicateMatchesMatcher(BSON("a" << BSON("$lte" << numeric_limits<long long>::max())));
+    assertPredicateMatchesMatcher(BSON("a" << BSON("$gte"
+                                                   << "abc")));
+    assertPredicateMatchesMatcher(BSON("a" << BSON("$lt" << Date_t::fromMillisSinceEpoch(2000))));
+    assertPredicateMatchesMatcher(BSON("a" << true));
+    assertPredicateMatchesMatcher(BSON("n.x" << 1));
+    assertPredicateMatchesMatcher(BSON("n.x" << BSON("$gt" << 1)));
+}
+
+TEST(VectorizedPredicateTest, AndOr) {
+    assertPredicateMatchesMatcher(BSON("a" << BSON("$gt" << 0) << "b" << BSON("$lt" << 2)));
+    assertPredicateMatchesMatcher(BSON("$or" << BSON_ARRAY(BSON("a" << 1) << BSON("b" << 1))));
+
+    // Unsupported children leave rows undecided unless another child decides them.
+    assertPredicateMatchesMatcher(BSON("a" << 1 << "b" << BSON("$exists" << true)));
+    assertPredicateMatchesMatcher(
+        BSON("$or" << BSON_ARRAY(BSON("a" << 1) << BSON("b" << BSON("$type" << 2)))));
+}
+
+TEST(VectorizedPredicateTest, UnsupportedQueriesAreNotCompiled) {
+    for (auto&& query : {BSON("a" << BSONNULL),
+                         BSON("a" << numeric_limits<double>::quiet_NaN()),
+                         BSON("a" << BSON("$in" << BSON_ARRAY(1 << 2))),
+                         BSON("a" << BSON("c" << 1)),
+                         BSON("a" << BSON("$exists" << false))}) {
+        Matcher matcher(query);
+        ASSERT_FALSE(VectorizedPredicate::compile(matcher.getMatchExpression())) << query;
+    }
+}
+
+}  // namespace
+}  // namespace mongo
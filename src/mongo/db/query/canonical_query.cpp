@@ -34,6 +34,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/util/log.h"
 
@@ -343,6 +344,8 @@ Status CanonicalQuery::init(LiteParsedQuery* lpq,
         _proj.reset(pp);
     }
 
+    _shapeHash = PlanCache::computeShapeHash(*this);
+
     return Status::OK();
 }
 
@@ -29,6 +29,9 @@
 #pragma once
 
 
+#include <memory>
+#include <string>
+
 #include "mongo/base/status.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/jsobj.h"
@@ -38,6 +41,8 @@
 
 namespace mongo {
 
+struct PlanCacheShapeStats;
+
 class CanonicalQuery {
 public:
     /**
@@ -175,6 +180,14 @@ public:
         return _proj.get();
     }
 
+    /**
+     * A hash of the shape of the normalized query: its predicate without values, sort and
+     * projection. See PlanCache::computeShapeHash().
+     */
+    uint64_t getShapeHash() const {
+        return _shapeHash;
+    }
+
     // Debugging
     std::string toString() const;
     std::string toStringShort() const;
@@ -209,6 +222,22 @@ public:
     static size_t countNodes(const MatchExpression* root, MatchExpression::MatchType type);
 
 private:
+    friend class PlanCache;
+
+    /**
+     * What the PlanCache remembers about this query, so that its cache key is built once and its
+     * executions are recorded without looking its entry up again.
+     */
+    struct PlanCacheState {
+        // The PlanCache::_indexabilityVersion 'keyHash' and 'key' were computed for, or 0.
+        unsigned long long indexabilityVersion = 0;
+        uint64_t keyHash = 0;
+        std::string key;
+
+        // Statistics of the entry this query was last planned from or added as, if any.
+        std::shared_ptr<PlanCacheShapeStats> entryStats;
+    };
+
     // You must go through canonicalize to create a CanonicalQuery.
     CanonicalQuery() {}
 
@@ -225,6 +254,10 @@ private:
     std::unique_ptr<MatchExpression> _root;
 
     std::unique_ptr<ParsedProjection> _proj;
+
+    uint64_t _shapeHash = 0;
+
+    mutable PlanCacheState _planCacheState;
 };
 
 }  // namespace mongo
@@ -40,6 +40,7 @@ const char kQueryField[] = "query";
 const char kLimitField[] = "limit";
 const char kSkipField[] = "skip";
 const char kHintField[] = "hint";
+const char kEstimateField[] = "estimate";
 
 }  // namespace
 
@@ -68,6 +69,10 @@ BSONObj CountRequest::toBSON() const {
         builder.append(kHintField, _hint.get());
     }
 
+    if (_estimate) {
+        builder.append(kEstimateField, _estimate.get());
+    }
+
     return builder.obj();
 }
 
@@ -118,6 +123,13 @@ StatusWith<CountRequest> CountRequest::parseFromBSON(const std::string& dbname,
         request.setHint(BSON("$hint" << hint));
     }
 
+    // Estimate
+    if (cmdObj[kEstimateField].isBoolean()) {
+        request.setEstimate(cmdObj[kEstimateField].boolean());
+    } else if (cmdObj[kEstimateField].ok()) {
+        return Status(ErrorCodes::BadValue, "estimate value is not a boolean");
+    }
+
     return request;
 }
 
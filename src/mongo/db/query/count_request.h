@@ -80,6 +80,14 @@ public:
 
     void setHint(BSONObj hint);
 
+    bool isEstimate() const {
+        return _estimate.value_or(false);
+    }
+
+    void setEstimate(bool estimate) {
+        _estimate = estimate;
+    }
+
     /**
      * Constructs a BSON representation of this request, which can be used for sending it in
      * commands.
@@ -107,6 +115,10 @@ private:
     // Optional. Indicates to the query planner that it should generate a count plan using a
     // particular index.
     boost::optional<BSONObj> _hint;
+
+    // Optional. Whether an estimate computed from index statistics, without running the query,
+    // is acceptable.
+    boost::optional<bool> _estimate;
 };
 
 }  // namespace mongo
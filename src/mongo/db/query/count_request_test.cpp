@@ -54,6 +54,7 @@ TEST(CountRequest, ParseDefaults) {
     ASSERT_EQUALS(countRequest.getLimit(), 0);
     ASSERT_EQUALS(countRequest.getSkip(), 0);
     ASSERT(countRequest.getHint().isEmpty());
+    ASSERT_FALSE(countRequest.isEstimate());
 }
 
 TEST(CountRequest, ParseComplete) {
@@ -112,11 +113,35 @@ TEST(CountRequest, FailParseBadSkipValue) {
     ASSERT_EQUALS(countRequestStatus.getStatus(), ErrorCodes::BadValue);
 }
 
+TEST(CountRequest, ParseEstimate) {
+    const auto countRequestStatus =
+        CountRequest::parseFromBSON("TestDB",
+                                    BSON("count"
+                                         << "TestColl"
+                                         << "query" << BSON("a" << BSON("$gte" << 11))
+                                         << "estimate" << true));
+
+    ASSERT_OK(countRequestStatus.getStatus());
+    ASSERT_TRUE(countRequestStatus.getValue().isEstimate());
+}
+
+TEST(CountRequest, FailParseBadEstimateValue) {
+    const auto countRequestStatus =
+        CountRequest::parseFromBSON("TestDB",
+                                    BSON("count"
+                                         << "TestColl"
+                                         << "query" << BSON("a" << BSON("$gte" << 11))
+                                         << "estimate" << 1));
+
+    ASSERT_EQUALS(countRequestStatus.getStatus(), ErrorCodes::BadValue);
+}
+
 TEST(CountRequest, ToBSON) {
     CountRequest countRequest("TestDB.TestColl", BSON("a" << BSON("$gte" << 11)));
     countRequest.setLimit(100);
     countRequest.setSkip(1000);
     countRequest.setHint(BSON("b" << 5));
+    countRequest.setEstimate(true);
 
     BSONObj actualObj = countRequest.toBSON();
     BSONObj expectedObj(fromjson(
@@ -124,7 +149,8 @@ TEST(CountRequest, ToBSON) {
         "  query : { a : { '$gte' : 11 } },"
         "  limit : 100,"
         "  skip : 1000,"
-        "  hint : { b : 5 } }"));
+        "  hint : { b : 5 },"
+        "  estimate : true }"));
 
     ASSERT_EQUALS(actualObj, expectedObj);
 }
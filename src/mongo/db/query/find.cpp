@@ -48,6 +48,7 @@
 #include "mongo/db/query/find_constants.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
 #include "mongo/db/s/sharding_state.h"
@@ -180,6 +181,17 @@ void endQueryOp(OperationContext* txn,
     curop->debug().nscannedObjects = summaryStats.totalDocsExamined;
     curop->debug().idhack = summaryStats.isIdhack;
 
+    // Add this execution to the statistics of the cache entry the query was planned from or added
+    // as, if any.
+    const CanonicalQuery* cq = exec.getCanonicalQuery();
+    const Collection* collection = exec.collection();
+    if (cq && collection && PlanCache::shouldCacheQuery(*cq)) {
+        collection->infoCache()->getPlanCache()->recordExecution(*cq,
+                                                                 summaryStats.totalDocsExamined,
+                                                                 summaryStats.totalKeysExamined,
+                                                                 curop->elapsedMicros());
+    }
+
     const logger::LogComponent queryLogComponent = logger::LogComponent::kQuery;
     const logger::LogSeverity logLevelOne = logger::LogSeverity::Debug(1);
 
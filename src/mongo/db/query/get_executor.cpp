@@ -32,10 +32,12 @@
 
 #include "mongo/db/query/get_executor.h"
 
+#include <cmath>
 #include <limits>
 #include <memory>
 
 #include "mongo/base/error_codes.h"
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/exec/cached_plan.h"
@@ -58,6 +60,7 @@
 #include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_cost_model.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
@@ -126,6 +129,7 @@ void fillOutPlannerParams(OperationContext* txn,
                           CanonicalQuery* canonicalQuery,
                           QueryPlannerParams* plannerParams) {
     // If it's not NULL, we may have indices.  Access the catalog and fill out IndexEntry(s)
+    CollectionInfoCache* infoCache = collection->infoCache();
     IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(txn, false);
     while (ii.more()) {
         const IndexDescriptor* desc = ii.next();
@@ -138,6 +142,14 @@ void fillOutPlannerParams(OperationContext* txn,
                                                     desc->indexName(),
                                                     ice->getFilterExpression(),
                                                     desc->infoObj()));
+
+        // Without the background sampler, the cost model samples indexes as it needs them, but
+        // reads only a few keys as the query waits for it.
+        if (internalQueryPlannerEnableCostModel && !internalQueryIndexStatisticsSamplerEnabled) {
+            infoCache->refreshIndexStatistics(
+                txn, desc, internalQueryCostModelMaxKeysScannedInline, PlanExecutor::YIELD_MANUAL);
+        }
+        plannerParams->indices.back().statistics = infoCache->getIndexStatistics(desc->indexName());
     }
 
     // If query supports index filters, filter params.indices by indices in query settings.
@@ -370,6 +382,30 @@ Status prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // If the cost model can tell the candidates apart, run the cheapest one without a trial.
+    if (solutions.size() > 1 && internalQueryPlannerEnableCostModel &&
+        !internalQueryForceIntersectionPlans) {
+        PlanCostModel costModel(collection->numRecords(opCtx),
+                                PlanCostModel::lookupIn(plannerParams.indices));
+        auto best = costModel.pickBest(solutions, internalQueryPlannerCostModelMargin);
+        if (best) {
+            for (size_t i = 0; i < solutions.size(); ++i) {
+                if (i != *best) {
+                    delete solutions[i];
+                }
+            }
+
+            verify(StageBuilder::build(opCtx, collection, *solutions[*best], ws, rootOut));
+
+            LOG(2) << "Cost model chose a plan without a trial run; it will not be cached. "
+                   << canonicalQuery->toStringShort()
+                   << ", planSummary: " << Explain::getPlanSummary(*rootOut);
+
+            *querySolutionOut = solutions[*best];
+            return Status::OK();
+        }
+    }
+
     if (1 == solutions.size()) {
         // Only one possible plan.  Run it.  Build the stages from the solution.
         verify(StageBuilder::build(opCtx, collection, *solutions[0], ws, rootOut));
@@ -1241,6 +1277,115 @@ StatusWith<unique_ptr<PlanExecutor>> getExecutorCount(OperationContext* txn,
                               yieldPolicy);
 }
 
+namespace {
+
+/**
+ * Returns true if 'oil' is the single interval [MinKey, MaxKey], in either direction.
+ */
+bool isAllValues(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() != 1) {
+        return false;
+    }
+    const Interval& interval = oil.intervals[0];
+    if (!interval.startInclusive || !interval.endInclusive) {
+        return false;
+    }
+    return (MinKey == interval.start.type() && MaxKey == interval.end.type()) ||
+        (MaxKey == interval.start.type() && MinKey == interval.end.type());
+}
+
+/**
+ * Returns true if the number of results of the plan rooted at 'node' can be read off the
+ * statistics of the index it scans. The cost model estimates an index scan from the bounds on the
+ * leading field alone, and does not count the results of OR or AND plans, so the plan must be a
+ * single scan of an index with one key per document, possibly under a FETCH or PROJECTION, with
+ * no residual filter and with every field after the first unbounded.
+ */
+bool resultsFollowFromIndexBounds(const QuerySolutionNode* node) {
+    while (STAGE_FETCH == node->getType() || STAGE_PROJECTION == node->getType()) {
+        if (node->filter || node->children.size() != 1) {
+            return false;
+        }
+        node = node->children[0];
+    }
+    if (STAGE_IXSCAN != node->getType() || node->filter) {
+        return false;
+    }
+
+    const IndexScanNode* ixscan = static_cast<const IndexScanNode*>(node);
+    if (ixscan->indexIsMultiKey) {
+        return false;
+    }
+    if (ixscan->bounds.isSimpleRange) {
+        return ixscan->indexKeyPattern.nFields() == 1;
+    }
+    for (size_t i = 1; i < ixscan->bounds.fields.size(); ++i) {
+        if (!isAllValues(ixscan->bounds.fields[i])) {
+            return false;
+        }
+    }
+    return !ixscan->bounds.fields.empty();
+}
+
+}  // namespace
+
+boost::optional<long long> estimateCount(OperationContext* txn,
+                                         Collection* collection,
+                                         const CountRequest& request) {
+    if (!collection || request.getQuery().isEmpty()) {
+        return boost::none;
+    }
+
+    auto statusWithCQ = CanonicalQuery::canonicalize(request.getNs().ns(),
+                                                     request.getQuery(),
+                                                     BSONObj(),  // sort
+                                                     BSONObj(),  // projection
+                                                     0,          // skip
+                                                     0,          // limit
+                                                     request.getHint(),
+                                                     BSONObj(),  // min
+                                                     BSONObj(),  // max
+                                                     false,      // snapshot
+                                                     false,      // explain
+                                                     WhereCallbackReal(txn, collection->ns().db()));
+    if (!statusWithCQ.isOK()) {
+        return boost::none;
+    }
+    unique_ptr<CanonicalQuery> cq = std::move(statusWithCQ.getValue());
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(txn, collection, cq.get(), &plannerParams);
+
+    vector<QuerySolution*> rawSolutions;
+    if (!QueryPlanner::plan(*cq, plannerParams, &rawSolutions).isOK()) {
+        return boost::none;
+    }
+    OwnedPointerVector<QuerySolution> solutions(rawSolutions);
+
+    PlanCostModel costModel(collection->numRecords(txn),
+                            PlanCostModel::lookupIn(plannerParams.indices));
+    boost::optional<PlanCostEstimate> best;
+    for (const QuerySolution* solution : solutions.vector()) {
+        if (!resultsFollowFromIndexBounds(solution->root.get())) {
+            continue;
+        }
+        auto est = costModel.estimate(*solution);
+        if (est && (!best || est->cost < best->cost)) {
+            best = est;
+        }
+    }
+    if (!best) {
+        return boost::none;
+    }
+
+    // As in CountStage, a negative limit counts the same as its absolute value.
+    double n = std::max(0.0, best->numResults - request.getSkip());
+    if (request.getLimit()) {
+        n = std::min(n, std::abs(static_cast<double>(request.getLimit())));
+    }
+    return std::llround(n);
+}
+
 //
 // Distinct hack
 //
@@ -26,6 +26,8 @@
  *    it in the license file.
  */
 
+#include <boost/optional.hpp>
+
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/query_planner_params.h"
@@ -147,6 +149,17 @@ StatusWith<std::unique_ptr<PlanExecutor>> getExecutorCount(OperationContext* txn
                                                            bool explain,
                                                            PlanExecutor::YieldPolicy yieldPolicy);
 
+/**
+ * Estimates the result of a count command from index statistics, without running the query.
+ * Returns boost::none if there is no plan whose result size follows from the distribution of a
+ * single-key index alone, or if the index has not been sampled yet, in which case the caller
+ * should count exactly. Indexes are not sampled here; their statistics come from the background
+ * sampler or from planning earlier queries.
+ */
+boost::optional<long long> estimateCount(OperationContext* txn,
+                                         Collection* collection,
+                                         const CountRequest& request);
+
 /**
  * Get a PlanExecutor for a delete operation. 'parsedDelete' describes the query predicate
  * and delete flags like 'isMulti'. The caller must hold the appropriate MODE_X or MODE_IX
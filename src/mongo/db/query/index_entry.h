@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "mongo/db/index_names.h"
@@ -36,6 +37,7 @@
 
 namespace mongo {
 
+class IndexStatistics;
 class MatchExpression;
 
 /**
@@ -116,6 +118,10 @@ struct IndexEntry {
     // by the keyPattern?)
     IndexType type;
 
+    // Sampled distribution of the index's leading field, if any. Used for cost-based plan
+    // selection and count estimates.
+    std::shared_ptr<const IndexStatistics> statistics;
+
     std::string toString() const;
 };
 
@@ -0,0 +1,355 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/base/status_with.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+namespace {
+
+const char kNumKeysField[] = "numKeys";
+const char kDistinctField[] = "distinct";
+const char kSampleSizeField[] = "sampleSize";
+const char kUnsampledKeysField[] = "unsampledKeys";
+const char kMinField[] = "min";
+const char kBucketsField[] = "buckets";
+const char kUpperBoundField[] = "upperBound";
+const char kCountField[] = "count";
+const char kUpperBoundCountField[] = "upperBoundCount";
+
+int compareValues(const BSONElement& lhs, const BSONElement& rhs) {
+    return lhs.woCompare(rhs, false);
+}
+
+BSONObj wrapValue(const BSONElement& value) {
+    BSONObjBuilder bob;
+    bob.appendAs(value, "");
+    return bob.obj();
+}
+
+Status extractNumber(const BSONObj& obj, StringData fieldName, double* out) {
+    BSONElement elt = obj[fieldName];
+    if (!elt.isNumber()) {
+        return Status(ErrorCodes::TypeMismatch,
+                      str::stream() << "'" << fieldName << "' must be a number");
+    }
+    *out = elt.numberDouble();
+    return Status::OK();
+}
+
+}  // namespace
+
+IndexStatistics::IndexStatistics(std::vector<BSONObj> sample,
+                                 double sampleWeight,
+                                 double unsampledKeys,
+                                 size_t maxBuckets)
+    : _numKeys(sample.size() * sampleWeight + unsampledKeys),
+      _unsampledKeys(std::max(0.0, unsampledKeys)),
+      _sampleSize(sample.size()) {
+    std::sort(sample.begin(),
+              sample.end(),
+              [](const BSONObj& lhs, const BSONObj& rhs) {
+                  return compareValues(lhs.firstElement(), rhs.firstElement()) < 0;
+              });
+
+    // Collapse the sample into runs of equal values.
+    std::vector<std::pair<BSONElement, size_t>> runs;
+    for (const BSONObj& obj : sample) {
+        BSONElement value = obj.firstElement();
+        if (runs.empty() || compareValues(runs.back().first, value) != 0) {
+            runs.emplace_back(value, 0);
+        }
+        ++runs.back().second;
+    }
+
+    // GEE scales the values seen exactly once by the square root of the inverse sampling rate
+    // and counts the others as is.
+    size_t singletons = 0;
+    for (const auto& run : runs) {
+        if (run.second == 1) {
+            ++singletons;
+        }
+    }
+    _distinctEstimate = std::sqrt(std::max(sampleWeight, 1.0)) * singletons +
+        (runs.size() - singletons);
+    const double distinctScale = runs.empty() ? 1.0 : _distinctEstimate / runs.size();
+
+    if (!runs.empty()) {
+        _min = wrapValue(runs.front().first);
+
+        const size_t depth = (sample.size() + maxBuckets - 1) / std::max<size_t>(maxBuckets, 1);
+        Bucket bucket;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            bucket.count += runs[i].second * sampleWeight;
+            bucket.distinct += distinctScale;
+
+            // A value never straddles two buckets, so a bucket may exceed its target depth.
+            if (bucket.count >= depth * sampleWeight || i + 1 == runs.size()) {
+                bucket.upperBound = wrapValue(runs[i].first);
+                bucket.upperBoundCount = runs[i].second * sampleWeight;
+                _buckets.push_back(bucket);
+                bucket = Bucket();
+            }
+        }
+    }
+
+    if (unsampledKeys > 0) {
+        Bucket tail;
+        tail.upperBound = BSON("" << MAXKEY);
+        tail.count = unsampledKeys;
+        tail.distinct = std::max(1.0, unsampledKeys * _distinctEstimate / std::max(_numKeys, 1.0));
+        _buckets.push_back(tail);
+
+        if (_min.isEmpty()) {
+            _min = BSON("" << MINKEY);
+        }
+    }
+
+    double cumulative = 0;
+    for (Bucket& b : _buckets) {
+        cumulative += b.count;
+        b.cumulativeCount = cumulative;
+    }
+}
+
+StatusWith<IndexStatistics> IndexStatistics::fromBSON(const BSONObj& obj) {
+    IndexStatistics stats;
+
+    double sampleSize;
+    Status status = extractNumber(obj, kNumKeysField, &stats._numKeys);
+    if (status.isOK()) {
+        status = extractNumber(obj, kDistinctField, &stats._distinctEstimate);
+    }
+    if (status.isOK()) {
+        status = extractNumber(obj, kSampleSizeField, &sampleSize);
+    }
+    if (status.isOK() && obj.hasField(kUnsampledKeysField)) {
+        // Absent from statistics saved before the field was added, which were never incomplete.
+        status = extractNumber(obj, kUnsampledKeysField, &stats._unsampledKeys);
+    }
+    if (!status.isOK()) {
+        return status;
+    }
+    stats._sampleSize = static_cast<size_t>(sampleSize);
+
+    BSONElement minElt = obj[kMinField];
+    BSONElement bucketsElt = obj[kBucketsField];
+    if (bucketsElt.type() != Array) {
+        return Status(ErrorCodes::TypeMismatch,
+                      str::stream() << "'" << kBucketsField << "' must be an array");
+    }
+
+    double cumulative = 0;
+    for (const BSONElement& bucketElt : bucketsElt.Obj()) {
+        if (bucketElt.type() != Object) {
+            return Status(ErrorCodes::TypeMismatch, "each bucket must be an object");
+        }
+        BSONObj bucketObj = bucketElt.Obj();
+        BSONElement upperBoundElt = bucketObj[kUpperBoundField];
+        if (upperBoundElt.eoo()) {
+            return Status(ErrorCodes::NoSuchKey,
+                          str::stream() << "bucket is missing '" << kUpperBoundField << "'");
+        }
+
+        Bucket bucket;
+        bucket.upperBound = wrapValue(upperBoundElt);
+        status = extractNumber(bucketObj, kCountField, &bucket.count);
+        if (status.isOK()) {
+            status = extractNumber(bucketObj, kUpperBoundCountField, &bucket.upperBoundCount);
+        }
+        if (status.isOK()) {
+            status = extractNumber(bucketObj, kDistinctField, &bucket.distinct);
+        }
+        if (!status.isOK()) {
+            return status;
+        }
+
+        if (!stats._buckets.empty() &&
+            compareValues(stats._buckets.back().upperBound.firstElement(), upperBoundElt) >= 0) {
+            return Status(ErrorCodes::BadValue, "bucket upper bounds must be increasing");
+        }
+
+        cumulative += bucket.count;
+        bucket.cumulativeCount = cumulative;
+        stats._buckets.push_back(bucket);
+    }
+
+    if (stats._unsampledKeys > 0 && stats._buckets.empty()) {
+        return Status(ErrorCodes::BadValue, "unsampled keys must have a bucket");
+    }
+
+    if (!stats._buckets.empty()) {
+        if (minElt.eoo()) {
+            return Status(ErrorCodes::NoSuchKey,
+                          str::stream() << "missing '" << kMinField << "' field");
+        }
+        stats._min = wrapValue(minElt);
+    }
+
+    return stats;
+}
+
+BSONObj IndexStatistics::toBSON() const {
+    BSONObjBuilder bob;
+    bob.append(kNumKeysField, _numKeys);
+    bob.append(kDistinctField, _distinctEstimate);
+    bob.appendNumber(kSampleSizeField, static_cast<long long>(_sampleSize));
+    if (_unsampledKeys > 0) {
+        bob.append(kUnsampledKeysField, _unsampledKeys);
+    }
+    if (!_min.isEmpty()) {
+        bob.appendAs(_min.firstElement(), kMinField);
+    }
+
+    BSONArrayBuilder buckets(bob.subarrayStart(kBucketsField));
+    for (const Bucket& bucket : _buckets) {
+        BSONObjBuilder bucketBob(buckets.subobjStart());
+        bucketBob.appendAs(bucket.upperBound.firstElement(), kUpperBoundField);
+        bucketBob.append(kCountField, bucket.count);
+        bucketBob.append(kUpperBoundCountField, bucket.upperBoundCount);
+        bucketBob.append(kDistinctField, bucket.distinct);
+    }
+    buckets.doneFast();
+
+    return bob.obj();
+}
+
+double IndexStatistics::keysBelow(const BSONElement& value, bool inclusive) const {
+    if (_buckets.empty()) {
+        return 0;
+    }
+
+    // Find the first bucket whose upper bound is at or above 'value'.
+    auto it = std::lower_bound(_buckets.begin(),
+                               _buckets.end(),
+                               value,
+                               [](const Bucket& bucket, const BSONElement& v) {
+                                   return compareValues(bucket.upperBound.firstElement(), v) < 0;
+                               });
+    if (it == _buckets.end()) {
+        return _numKeys;
+    }
+
+    const double before = (it == _buckets.begin()) ? 0 : (it - 1)->cumulativeCount;
+    const BSONElement upper = it->upperBound.firstElement();
+    if (compareValues(upper, value) == 0) {
+        return inclusive ? it->cumulativeCount : it->cumulativeCount - it->upperBoundCount;
+    }
+
+    const BSONElement lower =
+        (it == _buckets.begin()) ? _min.firstElement() : (it - 1)->upperBound.firstElement();
+    const int lowerCmp = compareValues(value, lower);
+    if (it == _buckets.begin() && lowerCmp < 0) {
+        return 0;
+    }
+
+    // 'value' lies strictly inside the bucket (or on the sampled minimum of the first bucket).
+    const double interior = it->count - it->upperBoundCount;
+    const double perValue = interior / std::max(1.0, it->distinct - 1);
+
+    double fraction = 0.5;
+    if (lowerCmp == 0) {
+        fraction = 0;
+    } else if (lower.isNumber() && upper.isNumber() && value.isNumber()) {
+        const double width = upper.numberDouble() - lower.numberDouble();
+        if (width > 0) {
+            fraction = (value.numberDouble() - lower.numberDouble()) / width;
+        }
+    }
+    fraction = std::max(0.0, std::min(1.0, fraction));
+
+    return before + std::min(interior, interior * fraction + (inclusive ? perValue : 0));
+}
+
+double IndexStatistics::estimateSelectivity(const Interval& interval) const {
+    if (_numKeys <= 0) {
+        return 0;
+    }
+
+    BSONElement low = interval.start;
+    BSONElement high = interval.end;
+    bool lowInclusive = interval.startInclusive;
+    bool highInclusive = interval.endInclusive;
+    if (compareValues(low, high) > 0) {
+        std::swap(low, high);
+        std::swap(lowInclusive, highInclusive);
+    }
+
+    const double keys = keysBelow(high, highInclusive) - keysBelow(low, !lowInclusive);
+    return std::max(0.0, std::min(1.0, keys / _numKeys));
+}
+
+bool IndexStatistics::isWithinSample(const Interval& interval) const {
+    if (_unsampledKeys <= 0) {
+        return true;
+    }
+
+    // The last bucket holds the unsampled keys. Those may be equal to the largest sampled value,
+    // so an interval including that value is not within the sample either.
+    if (_buckets.size() < 2) {
+        return false;
+    }
+    const BSONElement maxSampled = _buckets[_buckets.size() - 2].upperBound.firstElement();
+
+    BSONElement high = interval.end;
+    bool highInclusive = interval.endInclusive;
+    if (compareValues(interval.start, high) > 0) {
+        high = interval.start;
+        highInclusive = interval.startInclusive;
+    }
+    const int cmp = compareValues(high, maxSampled);
+    return cmp < 0 || (cmp == 0 && !highInclusive);
+}
+
+bool IndexStatistics::isWithinSample(const OrderedIntervalList& oil) const {
+    for (const Interval& interval : oil.intervals) {
+        if (!isWithinSample(interval)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double IndexStatistics::estimateSelectivity(const OrderedIntervalList& oil) const {
+    double selectivity = 0;
+    for (const Interval& interval : oil.intervals) {
+        selectivity += estimateSelectivity(interval);
+    }
+    return std::min(1.0, selectivity);
+}
+
+}  // namespace mongo
@@ -0,0 +1,155 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/query/index_bounds.h"
+
+namespace mongo {
+
+template <typename T>
+class StatusWith;
+
+/**
+ * A summary of the distribution of the leading field of an index, built from a sample of its
+ * keys. The cost model uses it to estimate how many keys an index scan over a given set of
+ * bounds examines, without running the scan.
+ *
+ * The summary is an equi-depth histogram: each bucket covers roughly the same number of keys and
+ * records its inclusive upper bound, how many keys fall in it, how many of those are equal to the
+ * upper bound and how many distinct values it holds. Values inside a bucket are assumed to be
+ * spread uniformly, which is interpolated for numbers and approximated by the bucket's average
+ * frequency for everything else.
+ */
+class IndexStatistics {
+public:
+    struct Bucket {
+        // Single-element object with an empty field name holding the inclusive upper bound.
+        BSONObj upperBound;
+
+        // Number of keys in the bucket, including those equal to the upper bound.
+        double count = 0;
+
+        // Number of keys equal to the upper bound.
+        double upperBoundCount = 0;
+
+        // Number of distinct values in the bucket, including the upper bound.
+        double distinct = 0;
+
+        // Number of keys in this and all preceding buckets.
+        double cumulativeCount = 0;
+    };
+
+    /**
+     * Builds statistics from 'sample', the leading field values of keys read from the index, each
+     * standing for 'sampleWeight' keys. 'unsampledKeys' keys are known to sort after every sampled
+     * value but were not read; they are accounted for in a trailing bucket bounded by MaxKey, and
+     * intervals reaching into that bucket are not isWithinSample().
+     * 'sample' need not be sorted.
+     */
+    IndexStatistics(std::vector<BSONObj> sample,
+                    double sampleWeight,
+                    double unsampledKeys,
+                    size_t maxBuckets);
+
+    /**
+     * Parses statistics serialized by toBSON().
+     */
+    static StatusWith<IndexStatistics> fromBSON(const BSONObj& obj);
+
+    /**
+     * Serializes the statistics, for instance to persist them in a collection.
+     */
+    BSONObj toBSON() const;
+
+    /**
+     * Returns the estimated fraction of index keys whose leading field falls inside 'oil'. The
+     * intervals may be oriented in either direction.
+     */
+    double estimateSelectivity(const OrderedIntervalList& oil) const;
+
+    /**
+     * Returns the estimated fraction of index keys inside 'interval'.
+     */
+    double estimateSelectivity(const Interval& interval) const;
+
+    /**
+     * Returns false if some interval of 'oil' reaches past the largest sampled value into the
+     * unsampled keys, whose distribution is unknown, so that its selectivity is a guess.
+     */
+    bool isWithinSample(const OrderedIntervalList& oil) const;
+
+    bool isWithinSample(const Interval& interval) const;
+
+    /**
+     * Returns the estimated number of distinct values of the leading field, computed from the
+     * sample with the GEE estimator.
+     */
+    double getDistinctEstimate() const {
+        return _distinctEstimate;
+    }
+
+    /**
+     * Returns the estimated number of keys in the index.
+     */
+    double getNumKeys() const {
+        return _numKeys;
+    }
+
+    size_t getSampleSize() const {
+        return _sampleSize;
+    }
+
+    const std::vector<Bucket>& getBuckets() const {
+        return _buckets;
+    }
+
+private:
+    IndexStatistics() = default;
+
+    /**
+     * Returns the estimated number of keys whose leading field is less than 'value', or less than
+     * or equal to it if 'inclusive' is set.
+     */
+    double keysBelow(const BSONElement& value, bool inclusive) const;
+
+    std::vector<Bucket> _buckets;
+
+    // The smallest sampled value, which is the lower bound of the first bucket.
+    BSONObj _min;
+
+    double _numKeys = 0;
+    double _unsampledKeys = 0;
+    double _distinctEstimate = 0;
+    size_t _sampleSize = 0;
+};
+
+}  // namespace mongo
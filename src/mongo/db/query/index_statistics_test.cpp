@@ -0,0 +1,181 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/index_statistics.h"
+
+#include "mongo/base/status_with.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::vector<BSONObj> numbers(int from, int to) {
+    std::vector<BSONObj> sample;
+    for (int i = from; i < to; ++i) {
+        sample.push_back(BSON("" << i));
+    }
+    return sample;
+}
+
+Interval interval(const BSONObj& bounds, bool startInclusive = true, bool endInclusive = true) {
+    return Interval(bounds, startInclusive, endInclusive);
+}
+
+TEST(IndexStatisticsTest, Empty) {
+    IndexStatistics stats({}, 1.0, 0, 10);
+    ASSERT_EQUALS(0, stats.getNumKeys());
+    ASSERT_EQUALS(0U, stats.getBuckets().size());
+    ASSERT_EQUALS(0, stats.estimateSelectivity(interval(BSON("" << MINKEY << "" << MAXKEY))));
+}
+
+TEST(IndexStatisticsTest, UniformNumbers) {
+    // Reverse the sample to check that it need not be sorted.
+    std::vector<BSONObj> sample = numbers(0, 1000);
+    std::reverse(sample.begin(), sample.end());
+    IndexStatistics stats(sample, 1.0, 0, 10);
+
+    ASSERT_EQUALS(1000, stats.getNumKeys());
+    ASSERT_EQUALS(1000, stats.getDistinctEstimate());
+    ASSERT_EQUALS(10U, stats.getBuckets().size());
+    ASSERT_APPROX_EQUAL(0.1, stats.estimateSelectivity(interval(BSON("" << 0 << "" << 99))), 1e-9);
+    ASSERT_APPROX_EQUAL(
+        0.001, stats.estimateSelectivity(interval(BSON("" << 500 << "" << 500))), 1e-9);
+    ASSERT_APPROX_EQUAL(
+        0.25, stats.estimateSelectivity(interval(BSON("" << 250 << "" << 500))), 0.01);
+    ASSERT_APPROX_EQUAL(
+        1.0, stats.estimateSelectivity(interval(BSON("" << MINKEY << "" << MAXKEY))), 1e-9);
+    ASSERT_EQUALS(0, stats.estimateSelectivity(interval(BSON("" << 2000 << "" << 3000))));
+    ASSERT_EQUALS(0, stats.estimateSelectivity(interval(BSON("" << "a" << "" << "z"))));
+}
+
+TEST(IndexStatisticsTest, ExclusiveAndDescendingIntervals) {
+    IndexStatistics stats(numbers(0, 1000), 1.0, 0, 10);
+
+    double inclusive = stats.estimateSelectivity(interval(BSON("" << 99 << "" << 199)));
+    double exclusive =
+        stats.estimateSelectivity(interval(BSON("" << 99 << "" << 199), false, false));
+    ASSERT_APPROX_EQUAL(0.101, inclusive, 1e-9);
+    ASSERT_APPROX_EQUAL(0.099, exclusive, 1e-9);
+
+    // An interval from a descending scan covers the same keys.
+    ASSERT_APPROX_EQUAL(
+        inclusive, stats.estimateSelectivity(interval(BSON("" << 199 << "" << 99))), 1e-9);
+}
+
+TEST(IndexStatisticsTest, SkewedValues) {
+    std::vector<BSONObj> sample = numbers(2, 102);
+    for (int i = 0; i < 900; ++i) {
+        sample.push_back(BSON("" << 1));
+    }
+    IndexStatistics stats(sample, 1.0, 0, 10);
+
+    ASSERT_EQUALS(101, stats.getDistinctEstimate());
+    ASSERT_APPROX_EQUAL(0.9, stats.estimateSelectivity(interval(BSON("" << 1 << "" << 1))), 1e-9);
+    ASSERT_APPROX_EQUAL(
+        0.1, stats.estimateSelectivity(interval(BSON("" << 2 << "" << 101))), 0.01);
+
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(interval(BSON("" << 1 << "" << 1)));
+    oil.intervals.push_back(interval(BSON("" << 50 << "" << 50)));
+    ASSERT_APPROX_EQUAL(0.901, stats.estimateSelectivity(oil), 1e-9);
+}
+
+TEST(IndexStatisticsTest, NonNumericValues) {
+    std::vector<BSONObj> sample;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        for (int i = 0; i < 10; ++i) {
+            sample.push_back(BSON("" << std::string(1, c)));
+        }
+    }
+    IndexStatistics stats(sample, 1.0, 0, 10);
+
+    ASSERT_APPROX_EQUAL(
+        10.0 / 260, stats.estimateSelectivity(interval(BSON("" << "m" << "" << "m"))), 1e-9);
+    ASSERT_APPROX_EQUAL(
+        0.5, stats.estimateSelectivity(interval(BSON("" << "a" << "" << "m"))), 0.05);
+}
+
+TEST(IndexStatisticsTest, WeightedSampleWithUnsampledTail) {
+    // Every sampled key stands for two keys, and 800 keys sort after the sample.
+    IndexStatistics stats(numbers(0, 100), 2.0, 800, 10);
+
+    ASSERT_EQUALS(1000, stats.getNumKeys());
+    ASSERT_APPROX_EQUAL(std::sqrt(2.0) * 100, stats.getDistinctEstimate(), 1e-9);
+    ASSERT_EQUALS(11U, stats.getBuckets().size());
+    ASSERT_APPROX_EQUAL(0.2, stats.estimateSelectivity(interval(BSON("" << 0 << "" << 99))), 1e-9);
+    ASSERT_APPROX_EQUAL(
+        1.0, stats.estimateSelectivity(interval(BSON("" << MINKEY << "" << MAXKEY))), 1e-9);
+
+    // Unsampled keys may equal the largest sampled value, 99, so only intervals below it are
+    // within the sample.
+    ASSERT_TRUE(stats.isWithinSample(interval(BSON("" << 0 << "" << 98))));
+    ASSERT_TRUE(stats.isWithinSample(interval(BSON("" << 0 << "" << 99), true, false)));
+    ASSERT_FALSE(stats.isWithinSample(interval(BSON("" << 0 << "" << 99))));
+    ASSERT_FALSE(stats.isWithinSample(interval(BSON("" << 200 << "" << 100))));
+    ASSERT_TRUE(IndexStatistics(numbers(0, 100), 1.0, 0, 10)
+                    .isWithinSample(interval(BSON("" << MINKEY << "" << MAXKEY))));
+}
+
+TEST(IndexStatisticsTest, RoundTripsThroughBSON) {
+    IndexStatistics stats(numbers(0, 100), 2.0, 800, 10);
+
+    auto parsed = IndexStatistics::fromBSON(stats.toBSON());
+    ASSERT_OK(parsed.getStatus());
+    ASSERT_EQUALS(stats.toBSON(), parsed.getValue().toBSON());
+    ASSERT_EQUALS(stats.getNumKeys(), parsed.getValue().getNumKeys());
+    ASSERT_EQUALS(stats.getSampleSize(), parsed.getValue().getSampleSize());
+    ASSERT_EQUALS(stats.estimateSelectivity(interval(BSON("" << 10 << "" << 60))),
+                  parsed.getValue().estimateSelectivity(interval(BSON("" << 10 << "" << 60))));
+}
+
+TEST(IndexStatisticsTest, FromBSONRejectsMalformedInput) {
+    BSONObj good = IndexStatistics(numbers(0, 100), 1.0, 0, 10).toBSON();
+    ASSERT_OK(IndexStatistics::fromBSON(good).getStatus());
+
+    ASSERT_NOT_OK(IndexStatistics::fromBSON(good.removeField("numKeys")).getStatus());
+    ASSERT_NOT_OK(IndexStatistics::fromBSON(good.removeField("min")).getStatus());
+    ASSERT_NOT_OK(IndexStatistics::fromBSON(
+                      BSON("numKeys" << 2 << "distinct" << 2 << "sampleSize" << 2 << "min" << 0
+                                     << "buckets" << 3)).getStatus());
+
+    // Upper bounds out of order.
+    BSONObj unordered =
+        BSON("numKeys" << 2 << "distinct" << 2 << "sampleSize" << 2 << "min" << 0 << "buckets"
+                       << BSON_ARRAY(BSON("upperBound" << 5 << "count" << 1 << "upperBoundCount"
+                                                       << 1 << "distinct" << 1)
+                                     << BSON("upperBound" << 1 << "count" << 1
+                                                          << "upperBoundCount" << 1 << "distinct"
+                                                          << 1)));
+    ASSERT_NOT_OK(IndexStatistics::fromBSON(unordered).getStatus());
+}
+
+}  // namespace
+}  // namespace mongo
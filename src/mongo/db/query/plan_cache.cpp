@@ -42,7 +42,9 @@
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/query_knobs.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/hex.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 
@@ -58,11 +60,63 @@ const char kEncodeChildrenSeparator = ',';
 const char kEncodeSortSection = '~';
 const char kEncodeProjectionSection = '|';
 
+// Number of stripes the cache is partitioned into.
+const size_t kNumStripes = 16;
+
+// Source of PlanCache::_indexabilityVersion.
+AtomicUInt64 nextIndexabilityVersion(1);
+
+/**
+ * Computes a PlanCacheKeyHash from the same sequence of operands a PlanCacheKey is built from,
+ * using 64-bit FNV-1a with a final mix so that the low bits can select a stripe.
+ */
+class KeyHasher {
+public:
+    explicit KeyHasher(uint64_t seed = kOffsetBasis) : _hash(seed) {}
+
+    KeyHasher& operator<<(char c) {
+        _hash = (_hash ^ static_cast<unsigned char>(c)) * kPrime;
+        return *this;
+    }
+
+    KeyHasher& operator<<(StringData str) {
+        for (size_t i = 0; i < str.size(); ++i) {
+            *this << str[i];
+        }
+        return *this;
+    }
+
+    KeyHasher& operator<<(const char* str) {
+        return *this << StringData(str);
+    }
+
+    KeyHasher& operator<<(bool b) {
+        return *this << (b ? '1' : '0');
+    }
+
+    uint64_t hash() const {
+        uint64_t h = _hash;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+private:
+    static const uint64_t kOffsetBasis = 0xcbf29ce484222325ULL;
+    static const uint64_t kPrime = 0x100000001b3ULL;
+
+    uint64_t _hash;
+};
+
 /**
  * Encode user-provided string. Cache key delimiters seen in the
  * user string are escaped with a backslash.
  */
-void encodeUserString(StringData s, StringBuilder* keyBuilder) {
+template <typename KeyBuilder>
+void encodeUserString(StringData s, KeyBuilder* keyBuilder) {
     for (size_t i = 0; i < s.size(); ++i) {
         char c = s[i];
         switch (c) {
@@ -181,7 +235,8 @@ const char* encodeMatchType(MatchExpression::MatchType mt) {
  * - geometry type
  * - CRS (flat or spherical)
  */
-void encodeGeoMatchExpression(const GeoMatchExpression* tree, StringBuilder* keyBuilder) {
+template <typename KeyBuilder>
+void encodeGeoMatchExpression(const GeoMatchExpression* tree, KeyBuilder* keyBuilder) {
     const GeoExpression& geoQuery = tree->getGeoExpression();
 
     // Type of geo query.
@@ -221,7 +276,8 @@ void encodeGeoMatchExpression(const GeoMatchExpression* tree, StringBuilder* key
  * - isNearSphere
  * - CRS (flat or spherical)
  */
-void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree, StringBuilder* keyBuilder) {
+template <typename KeyBuilder>
+void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree, KeyBuilder* keyBuilder) {
     const GeoNearExpression& nearQuery = tree->getData();
 
     // isNearSphere
@@ -246,6 +302,164 @@ void encodeGeoNearMatchExpression(const GeoNearMatchExpression* tree, StringBuil
     }
 }
 
+/**
+ * Appends the indexability discriminators of the path of 'tree', if it has any.
+ */
+template <typename KeyBuilder>
+void encodeIndexability(const MatchExpression* tree,
+                        const PlanCacheIndexabilityState& indexabilityState,
+                        KeyBuilder* keyBuilder) {
+    const IndexabilityDiscriminators& discriminators =
+        indexabilityState.getDiscriminators(tree->path());
+    if (!discriminators.empty()) {
+        *keyBuilder << kEncodeDiscriminatorsBegin;
+        // For each discriminator on this path, append the character '0' or '1'.
+        for (const IndexabilityDiscriminator& discriminator : discriminators) {
+            *keyBuilder << discriminator(tree);
+        }
+        *keyBuilder << kEncodeDiscriminatorsEnd;
+    }
+}
+
+/**
+ * Appends the indexability of every node of 'tree', in the order encodeKeyForMatch() would. Two
+ * queries of the same shape have the same key exactly when this encodes the same for both.
+ */
+template <typename KeyBuilder>
+void encodeIndexabilityForMatch(const MatchExpression* tree,
+                                const PlanCacheIndexabilityState& indexabilityState,
+                                KeyBuilder* keyBuilder) {
+    encodeIndexability(tree, indexabilityState, keyBuilder);
+    for (size_t i = 0; i < tree->numChildren(); ++i) {
+        encodeIndexabilityForMatch(tree->getChild(i), indexabilityState, keyBuilder);
+    }
+}
+
+/**
+ * Traverses expression tree pre-order.
+ * Appends an encoding of each node's match type and path name
+ * to the output stream. Indexability is only encoded if 'indexabilityState' is given.
+ */
+template <typename KeyBuilder>
+void encodeKeyForMatch(const MatchExpression* tree,
+                       const PlanCacheIndexabilityState* indexabilityState,
+                       KeyBuilder* keyBuilder) {
+    // Encode match type and path.
+    *keyBuilder << encodeMatchType(tree->matchType());
+
+    encodeUserString(tree->path(), keyBuilder);
+
+    // GEO and GEO_NEAR require additional encoding.
+    if (MatchExpression::GEO == tree->matchType()) {
+        encodeGeoMatchExpression(static_cast<const GeoMatchExpression*>(tree), keyBuilder);
+    } else if (MatchExpression::GEO_NEAR == tree->matchType()) {
+        encodeGeoNearMatchExpression(static_cast<const GeoNearMatchExpression*>(tree), keyBuilder);
+    }
+
+    // Encode indexability.
+    if (indexabilityState) {
+        encodeIndexability(tree, *indexabilityState, keyBuilder);
+    }
+
+    // Traverse child nodes.
+    // Enclose children in [].
+    if (tree->numChildren() > 0) {
+        *keyBuilder << kEncodeChildrenBegin;
+    }
+    // Use comma to separate children encoding.
+    for (size_t i = 0; i < tree->numChildren(); ++i) {
+        if (i > 0) {
+            *keyBuilder << kEncodeChildrenSeparator;
+        }
+        encodeKeyForMatch(tree->getChild(i), indexabilityState, keyBuilder);
+    }
+    if (tree->numChildren() > 0) {
+        *keyBuilder << kEncodeChildrenEnd;
+    }
+}
+
+/**
+ * Encodes sort order into cache key.
+ * Sort order is normalized because it provided by
+ * LiteParsedQuery.
+ */
+template <typename KeyBuilder>
+void encodeKeyForSort(const BSONObj& sortObj, KeyBuilder* keyBuilder) {
+    if (sortObj.isEmpty()) {
+        return;
+    }
+
+    *keyBuilder << kEncodeSortSection;
+
+    BSONObjIterator it(sortObj);
+    while (it.more()) {
+        BSONElement elt = it.next();
+        // $meta text score
+        if (LiteParsedQuery::isTextScoreMeta(elt)) {
+            *keyBuilder << "t";
+        }
+        // Ascending
+        else if (elt.numberInt() == 1) {
+            *keyBuilder << "a";
+        }
+        // Descending
+        else {
+            *keyBuilder << "d";
+        }
+        encodeUserString(elt.fieldName(), keyBuilder);
+
+        // Sort argument separator
+        if (it.more()) {
+            *keyBuilder << ",";
+        }
+    }
+}
+
+/**
+ * Encodes parsed projection into cache key.
+ * Does a simple toString() on each projected field
+ * in the BSON object.
+ * Orders the encoded elements in the projection by field name.
+ * This handles all the special projection types ($meta, $elemMatch, etc.)
+ */
+template <typename KeyBuilder>
+void encodeKeyForProj(const BSONObj& projObj, KeyBuilder* keyBuilder) {
+    if (projObj.isEmpty()) {
+        return;
+    }
+
+    *keyBuilder << kEncodeProjectionSection;
+
+    // Sorts the BSON elements by field name using a map.
+    std::map<StringData, BSONElement> elements;
+
+    BSONObjIterator it(projObj);
+    while (it.more()) {
+        BSONElement elt = it.next();
+        StringData fieldName = elt.fieldNameStringData();
+        elements[fieldName] = elt;
+    }
+
+    // Read elements in order of field name
+    for (std::map<StringData, BSONElement>::const_iterator i = elements.begin();
+         i != elements.end();
+         ++i) {
+        const BSONElement& elt = (*i).second;
+
+        if (elt.isSimpleType()) {
+            // For inclusion/exclusion projections, we encode as "i" or "e".
+            *keyBuilder << (elt.trueValue() ? "i" : "e");
+        } else {
+            // For projection operators, we use the verbatim string encoding of the element.
+            encodeUserString(elt.toString(false,   // includeFieldName
+                                          false),  // full
+                             keyBuilder);
+        }
+
+        encodeUserString(elt.fieldName(), keyBuilder);
+    }
+}
+
 }  // namespace
 
 //
@@ -306,7 +520,7 @@ bool PlanCache::shouldCacheQuery(const CanonicalQuery& query) {
 // CachedSolution
 //
 
-CachedSolution::CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& entry)
+CachedSolution::CachedSolution(PlanCacheKeyHash key, const PlanCacheEntry& entry)
     : plannerData(entry.plannerData.size()),
       key(key),
       query(entry.query.getOwned()),
@@ -380,6 +594,10 @@ PlanCacheEntry* PlanCacheEntry::clone() const {
         fb->score = feedback[i]->score;
         entry->feedback.push_back(fb);
     }
+
+    entry->keyHash = keyHash;
+    entry->key = key;
+    entry->stats = stats;
     return entry;
 }
 
@@ -390,7 +608,56 @@ std::string PlanCacheEntry::toString() const {
 }
 
 std::string CachedSolution::toString() const {
-    return str::stream() << "key: " << key << '\n';
+    return str::stream() << "key: " << integerToHex(key) << '\n';
+}
+
+//
+// PlanCacheShapeStats
+//
+
+void PlanCacheShapeStats::record(size_t docsExamined,
+                                 size_t keysExamined,
+                                 long long latencyMicros) {
+    executions.fetchAndAdd(1);
+    totalDocsExamined.fetchAndAdd(docsExamined);
+    totalKeysExamined.fetchAndAdd(keysExamined);
+    totalLatencyMicros.fetchAndAdd(latencyMicros);
+
+    size_t bucket = 0;
+    for (long long micros = latencyMicros; micros > 0 && bucket < kLatencyBuckets - 1;
+         micros >>= 1) {
+        bucket++;
+    }
+    latencyHistogram[bucket].fetchAndAdd(1);
+}
+
+void PlanCacheShapeStats::appendTo(BSONObjBuilder* bob) const {
+    // Executions recorded while this runs may be counted by some of the totals and not others.
+    const long long numExecutions = executions.load();
+    const long long docsExamined = totalDocsExamined.load();
+    const long long keysExamined = totalKeysExamined.load();
+    const long long latencyMicros = totalLatencyMicros.load();
+    bob->appendNumber("executions", numExecutions);
+    bob->appendNumber("totalDocsExamined", docsExamined);
+    bob->appendNumber("totalKeysExamined", keysExamined);
+    bob->appendNumber("totalLatencyMicros", latencyMicros);
+    if (numExecutions > 0) {
+        bob->append("avgDocsExamined", static_cast<double>(docsExamined) / numExecutions);
+        bob->append("avgKeysExamined", static_cast<double>(keysExamined) / numExecutions);
+        bob->append("avgLatencyMicros", static_cast<double>(latencyMicros) / numExecutions);
+    }
+
+    // Only the buckets which counted something, each labelled by the least latency it counts.
+    BSONArrayBuilder histogramBuilder(bob->subarrayStart("latencyHistogram"));
+    for (size_t bucket = 0; bucket < kLatencyBuckets; ++bucket) {
+        const long long count = latencyHistogram[bucket].load();
+        if (count == 0) {
+            continue;
+        }
+        const long long lowerBoundMicros = bucket == 0 ? 0 : 1LL << (bucket - 1);
+        histogramBuilder.append(BSON("micros" << lowerBoundMicros << "count" << count));
+    }
+    histogramBuilder.doneFast();
 }
 
 //
@@ -476,137 +743,47 @@ std::string SolutionCacheData::toString() const {
 // PlanCache
 //
 
-PlanCache::PlanCache() : _cache(internalQueryCacheSize) {}
-
-PlanCache::PlanCache(const std::string& ns) : _cache(internalQueryCacheSize), _ns(ns) {}
-
-PlanCache::~PlanCache() {}
-
-/**
- * Traverses expression tree pre-order.
- * Appends an encoding of each node's match type and path name
- * to the output stream.
- */
-void PlanCache::encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const {
-    // Encode match type and path.
-    *keyBuilder << encodeMatchType(tree->matchType());
-
-    encodeUserString(tree->path(), keyBuilder);
+PlanCache::PlanCache() : PlanCache("") {}
 
-    // GEO and GEO_NEAR require additional encoding.
-    if (MatchExpression::GEO == tree->matchType()) {
-        encodeGeoMatchExpression(static_cast<const GeoMatchExpression*>(tree), keyBuilder);
-    } else if (MatchExpression::GEO_NEAR == tree->matchType()) {
-        encodeGeoNearMatchExpression(static_cast<const GeoNearMatchExpression*>(tree), keyBuilder);
-    }
-
-    // Encode indexability.
-    const IndexabilityDiscriminators& discriminators =
-        _indexabilityState.getDiscriminators(tree->path());
-    if (!discriminators.empty()) {
-        *keyBuilder << kEncodeDiscriminatorsBegin;
-        // For each discriminator on this path, append the character '0' or '1'.
-        for (const IndexabilityDiscriminator& discriminator : discriminators) {
-            *keyBuilder << discriminator(tree);
-        }
-        *keyBuilder << kEncodeDiscriminatorsEnd;
-    }
-
-    // Traverse child nodes.
-    // Enclose children in [].
-    if (tree->numChildren() > 0) {
-        *keyBuilder << kEncodeChildrenBegin;
-    }
-    // Use comma to separate children encoding.
-    for (size_t i = 0; i < tree->numChildren(); ++i) {
-        if (i > 0) {
-            *keyBuilder << kEncodeChildrenSeparator;
-        }
-        encodeKeyForMatch(tree->getChild(i), keyBuilder);
-    }
-    if (tree->numChildren() > 0) {
-        *keyBuilder << kEncodeChildrenEnd;
+PlanCache::PlanCache(const std::string& ns)
+    : _ns(ns), _indexabilityVersion(nextIndexabilityVersion.fetchAndAdd(1)) {
+    // Each stripe holds an equal share of the entries, and at least one.
+    const size_t maxSize = std::max(internalQueryCacheSize, 1);
+    const size_t numStripes = std::min(kNumStripes, maxSize);
+    for (size_t i = 0; i < numStripes; ++i) {
+        _stripes.push_back(stdx::make_unique<Stripe>((maxSize + numStripes - 1) / numStripes));
     }
 }
 
-/**
- * Encodes sort order into cache key.
- * Sort order is normalized because it provided by
- * LiteParsedQuery.
- */
-void PlanCache::encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const {
-    if (sortObj.isEmpty()) {
-        return;
-    }
-
-    *keyBuilder << kEncodeSortSection;
-
-    BSONObjIterator it(sortObj);
-    while (it.more()) {
-        BSONElement elt = it.next();
-        // $meta text score
-        if (LiteParsedQuery::isTextScoreMeta(elt)) {
-            *keyBuilder << "t";
-        }
-        // Ascending
-        else if (elt.numberInt() == 1) {
-            *keyBuilder << "a";
-        }
-        // Descending
-        else {
-            *keyBuilder << "d";
-        }
-        encodeUserString(elt.fieldName(), keyBuilder);
+PlanCache::~PlanCache() {}
 
-        // Sort argument separator
-        if (it.more()) {
-            *keyBuilder << ",";
-        }
-    }
+PlanCache::Stripe& PlanCache::getStripe(PlanCacheKeyHash key) const {
+    return *_stripes[key % _stripes.size()];
 }
 
-/**
- * Encodes parsed projection into cache key.
- * Does a simple toString() on each projected field
- * in the BSON object.
- * Orders the encoded elements in the projection by field name.
- * This handles all the special projection types ($meta, $elemMatch, etc.)
- */
-void PlanCache::encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const {
-    if (projObj.isEmpty()) {
-        return;
+CanonicalQuery::PlanCacheState& PlanCache::getKeyedState(const CanonicalQuery& cq) const {
+    CanonicalQuery::PlanCacheState& state = cq._planCacheState;
+    if (state.indexabilityVersion != _indexabilityVersion) {
+        state.keyHash = computeKeyHash(cq);
+        state.key = computeKey(cq);
+        state.indexabilityVersion = _indexabilityVersion;
     }
+    return state;
+}
 
-    *keyBuilder << kEncodeProjectionSection;
-
-    // Sorts the BSON elements by field name using a map.
-    std::map<StringData, BSONElement> elements;
-
-    BSONObjIterator it(projObj);
-    while (it.more()) {
-        BSONElement elt = it.next();
-        StringData fieldName = elt.fieldNameStringData();
-        elements[fieldName] = elt;
+// static
+Status PlanCache::getFromStripe_inlock(const Stripe& stripe,
+                                       PlanCacheKeyHash keyHash,
+                                       const PlanCacheKey& key,
+                                       PlanCacheEntry** entryOut) {
+    Status cacheStatus = stripe.cache.get(keyHash, entryOut);
+    if (!cacheStatus.isOK()) {
+        return cacheStatus;
     }
-
-    // Read elements in order of field name
-    for (std::map<StringData, BSONElement>::const_iterator i = elements.begin();
-         i != elements.end();
-         ++i) {
-        const BSONElement& elt = (*i).second;
-
-        if (elt.isSimpleType()) {
-            // For inclusion/exclusion projections, we encode as "i" or "e".
-            *keyBuilder << (elt.trueValue() ? "i" : "e");
-        } else {
-            // For projection operators, we use the verbatim string encoding of the element.
-            encodeUserString(elt.toString(false,   // includeFieldName
-                                          false),  // full
-                             keyBuilder);
-        }
-
-        encodeUserString(elt.fieldName(), keyBuilder);
+    if ((*entryOut)->key != key) {
+        return Status(ErrorCodes::NoSuchKey, "plan cache entry is for another query shape");
     }
+    return Status::OK();
 }
 
 Status PlanCache::add(const CanonicalQuery& query,
@@ -637,8 +814,25 @@ Status PlanCache::add(const CanonicalQuery& query,
     entry->sort = pq.getSort().getOwned();
     entry->projection = pq.getProj().getOwned();
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(computeKey(query), entry);
+    CanonicalQuery::PlanCacheState& state = getKeyedState(query);
+    const PlanCacheKeyHash key = state.keyHash;
+    entry->keyHash = key;
+    entry->key = state.key;
+
+    Stripe& stripe = getStripe(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(stripe.mutex);
+
+    // A replanned shape keeps the statistics of the entry it replaces. An entry for another shape
+    // with the same hash is replaced without handing over its statistics.
+    PlanCacheEntry* oldEntry;
+    if (getFromStripe_inlock(stripe, key, entry->key, &oldEntry).isOK()) {
+        entry->stats = oldEntry->stats;
+    } else {
+        entry->stats = std::make_shared<PlanCacheShapeStats>();
+    }
+    state.entryStats = entry->stats;
+
+    std::unique_ptr<PlanCacheEntry> evictedEntry = stripe.cache.add(key, entry);
 
     if (NULL != evictedEntry.get()) {
         LOG(1) << _ns << ": plan cache maximum size exceeded - "
@@ -649,18 +843,22 @@ Status PlanCache::add(const CanonicalQuery& query,
 }
 
 Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const {
-    PlanCacheKey key = computeKey(query);
+    CanonicalQuery::PlanCacheState& state = getKeyedState(query);
+    const PlanCacheKeyHash key = state.keyHash;
     verify(crOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    Stripe& stripe = getStripe(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(stripe.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = getFromStripe_inlock(stripe, key, state.key, &entry);
     if (!cacheStatus.isOK()) {
+        state.entryStats.reset();
         return cacheStatus;
     }
     invariant(entry);
 
     *crOut = new CachedSolution(key, *entry);
+    state.entryStats = entry->stats;
 
     return Status::OK();
 }
@@ -670,11 +868,13 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
         return Status(ErrorCodes::BadValue, "feedback is NULL");
     }
     std::unique_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
-    PlanCacheKey ck = computeKey(cq);
+    const auto& state = getKeyedState(cq);
+    const PlanCacheKeyHash ck = state.keyHash;
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    Stripe& stripe = getStripe(ck);
+    stdx::lock_guard<stdx::mutex> cacheLock(stripe.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = getFromStripe_inlock(stripe, ck, state.key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -689,31 +889,67 @@ Status PlanCache::feedback(const CanonicalQuery& cq, PlanCacheEntryFeedback* fee
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    const auto& state = getKeyedState(canonicalQuery);
+    const PlanCacheKeyHash key = state.keyHash;
+    Stripe& stripe = getStripe(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(stripe.mutex);
+    PlanCacheEntry* entry;
+    Status cacheStatus = getFromStripe_inlock(stripe, key, state.key, &entry);
+    if (!cacheStatus.isOK()) {
+        return cacheStatus;
+    }
+    return stripe.cache.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& stripe : _stripes) {
+        stdx::lock_guard<stdx::mutex> cacheLock(stripe->mutex);
+        stripe->cache.clear();
+    }
     _writeOperations.store(0);
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
     StringBuilder keyBuilder;
-    encodeKeyForMatch(cq.root(), &keyBuilder);
+    encodeKeyForMatch(cq.root(), &_indexabilityState, &keyBuilder);
     encodeKeyForSort(cq.getParsed().getSort(), &keyBuilder);
     encodeKeyForProj(cq.getParsed().getProj(), &keyBuilder);
     return keyBuilder.str();
 }
 
+PlanCacheKeyHash PlanCache::computeKeyHash(const CanonicalQuery& cq) const {
+    KeyHasher hasher(cq.getShapeHash());
+    encodeIndexabilityForMatch(cq.root(), _indexabilityState, &hasher);
+    return hasher.hash();
+}
+
+// static
+uint64_t PlanCache::computeShapeHash(const CanonicalQuery& cq) {
+    KeyHasher hasher;
+    encodeKeyForMatch(cq.root(), nullptr, &hasher);
+    encodeKeyForSort(cq.getParsed().getSort(), &hasher);
+    encodeKeyForProj(cq.getParsed().getProj(), &hasher);
+    return hasher.hash();
+}
+
+void PlanCache::recordExecution(const CanonicalQuery& cq,
+                                size_t docsExamined,
+                                size_t keysExamined,
+                                long long latencyMicros) {
+    if (const auto& stats = cq._planCacheState.entryStats) {
+        stats->record(docsExamined, keysExamined, latencyMicros);
+    }
+}
+
 Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOut) const {
-    PlanCacheKey key = computeKey(query);
+    const auto& state = getKeyedState(query);
+    const PlanCacheKeyHash key = state.keyHash;
     verify(entryOut);
 
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
+    Stripe& stripe = getStripe(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(stripe.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = getFromStripe_inlock(stripe, key, state.key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -725,29 +961,39 @@ Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOu
 }
 
 std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
     std::vector<PlanCacheEntry*> entries;
-    typedef std::list<std::pair<PlanCacheKey, PlanCacheEntry*>>::const_iterator ConstIterator;
-    for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-        PlanCacheEntry* entry = i->second;
-        entries.push_back(entry->clone());
+    for (auto&& stripe : _stripes) {
+        stdx::lock_guard<stdx::mutex> cacheLock(stripe->mutex);
+        for (auto i = stripe->cache.begin(); i != stripe->cache.end(); i++) {
+            PlanCacheEntry* entry = i->second;
+            entries.push_back(entry->clone());
+        }
     }
 
     return entries;
 }
 
 bool PlanCache::contains(const CanonicalQuery& cq) const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.hasKey(computeKey(cq));
+    const auto& state = getKeyedState(cq);
+    const PlanCacheKeyHash key = state.keyHash;
+    Stripe& stripe = getStripe(key);
+    stdx::lock_guard<stdx::mutex> cacheLock(stripe.mutex);
+    PlanCacheEntry* entry;
+    return getFromStripe_inlock(stripe, key, state.key, &entry).isOK();
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<stdx::mutex> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& stripe : _stripes) {
+        stdx::lock_guard<stdx::mutex> cacheLock(stripe->mutex);
+        size += stripe->cache.size();
+    }
+    return size;
 }
 
 void PlanCache::notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries) {
     _indexabilityState.updateDiscriminators(indexEntries);
+    _indexabilityVersion = nextIndexabilityVersion.fetchAndAdd(1);
 }
 
 }  // namespace mongo
@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <set>
 #include <boost/optional/optional.hpp>
 
@@ -45,6 +48,10 @@ namespace mongo {
 // A PlanCacheKey is a string-ified version of a query's predicate/projection/sort.
 typedef std::string PlanCacheKey;
 
+// A 64-bit hash of what a PlanCacheKey encodes, computed without building the string. The plan
+// cache is keyed by these.
+typedef uint64_t PlanCacheKeyHash;
+
 struct PlanRankingDecision;
 struct QuerySolution;
 struct QuerySolutionNode;
@@ -178,14 +185,14 @@ private:
     MONGO_DISALLOW_COPYING(CachedSolution);
 
 public:
-    CachedSolution(const PlanCacheKey& key, const PlanCacheEntry& entry);
+    CachedSolution(PlanCacheKeyHash key, const PlanCacheEntry& entry);
     ~CachedSolution();
 
     // Owned here.
     std::vector<SolutionCacheData*> plannerData;
 
     // Key used to provide feedback on the entry.
-    PlanCacheKey key;
+    PlanCacheKeyHash key;
 
     // For debugging.
     std::string toString() const;
@@ -202,6 +209,27 @@ public:
     size_t decisionWorks;
 };
 
+/**
+ * Statistics about the executions of queries of one shape, recorded by
+ * PlanCache::recordExecution() and reported by planCacheListQueryShapes. Updated without the lock
+ * of the entry's stripe, so each counter is atomic.
+ */
+struct PlanCacheShapeStats {
+    // Latencies are counted in buckets of powers of two microseconds. Bucket 0 counts executions
+    // which took under a microsecond, and bucket i > 0 those which took [2^(i-1), 2^i).
+    static const size_t kLatencyBuckets = 32;
+
+    void record(size_t docsExamined, size_t keysExamined, long long latencyMicros);
+
+    void appendTo(BSONObjBuilder* bob) const;
+
+    AtomicInt64 executions;
+    AtomicInt64 totalDocsExamined;
+    AtomicInt64 totalKeysExamined;
+    AtomicInt64 totalLatencyMicros;
+    std::array<AtomicInt64, kLatencyBuckets> latencyHistogram;
+};
+
 /**
  * Used by the cache to track entries and their performance over time.
  * Also used by the plan cache commands to display plan cache state.
@@ -257,6 +285,14 @@ public:
     // Annotations from cached runs.  The CachedPlanStage provides these stats about its
     // runs when they complete.
     std::vector<PlanCacheEntryFeedback*> feedback;
+
+    // The key of the entry, and statistics about every execution of a query with that key since
+    // the shape was first cached. Replacing the entry for a key keeps its statistics, which are
+    // shared with the queries planned from the entry.
+    PlanCacheKeyHash keyHash = 0;
+    // The full key, which lookups compare, as different shapes may have the same hash.
+    PlanCacheKey key;
+    std::shared_ptr<PlanCacheShapeStats> stats;
 };
 
 /**
@@ -264,6 +300,9 @@ public:
  * mapping, the cache contains information on why that mapping was made and statistics on the
  * cache entry's actual performance on subsequent runs.
  *
+ * Entries are keyed by PlanCacheKeyHash and partitioned by it into stripes, each an LRU cache
+ * with its own mutex, so that queries of different shapes rarely contend. Eviction is least
+ * recently used within a stripe.
  */
 class PlanCache {
 private:
@@ -349,6 +388,29 @@ public:
      */
     PlanCacheKey computeKey(const CanonicalQuery&) const;
 
+    /**
+     * Get the hash of the key computeKey() would return, which is what the cache is keyed by.
+     * Starts from the shape hash computed when 'cq' was canonicalized.
+     *
+     * Callers must hold the collection lock when calling this method.
+     */
+    PlanCacheKeyHash computeKeyHash(const CanonicalQuery& cq) const;
+
+    /**
+     * Hashes the predicate, sort and projection of 'cq' the way computeKey() encodes them, but
+     * without the parts which depend on the collection's indexes. Called by CanonicalQuery.
+     */
+    static uint64_t computeShapeHash(const CanonicalQuery& cq);
+
+    /**
+     * Adds an execution of 'cq' to the statistics of the entry it was last planned from by get()
+     * or added as by add(). Does nothing if neither happened. Takes no lock.
+     */
+    void recordExecution(const CanonicalQuery& cq,
+                         size_t docsExamined,
+                         size_t keysExamined,
+                         long long latencyMicros);
+
     /**
      * Returns a copy of a cache entry.
      * Used by planCacheListPlans to display plan details.
@@ -389,14 +451,34 @@ public:
     void notifyOfIndexEntries(const std::vector<IndexEntry>& indexEntries);
 
 private:
-    void encodeKeyForMatch(const MatchExpression* tree, StringBuilder* keyBuilder) const;
-    void encodeKeyForSort(const BSONObj& sortObj, StringBuilder* keyBuilder) const;
-    void encodeKeyForProj(const BSONObj& projObj, StringBuilder* keyBuilder) const;
+    struct Stripe {
+        explicit Stripe(size_t maxSize) : cache(maxSize) {}
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        // Protects cache.
+        stdx::mutex mutex;
+        LRUKeyValue<PlanCacheKeyHash, PlanCacheEntry> cache;
+    };
 
-    // Protects _cache.
-    mutable stdx::mutex _cacheMutex;
+    Stripe& getStripe(PlanCacheKeyHash key) const;
+
+    /**
+     * Returns the state 'cq' keeps for this cache, whose key and key hash are computed the first
+     * time 'cq' is used with the current indexes.
+     */
+    CanonicalQuery::PlanCacheState& getKeyedState(const CanonicalQuery& cq) const;
+
+    /**
+     * Finds the entry for 'key', whose hash is 'keyHash', in 'stripe'. Entries are keyed by the
+     * hash alone, so an entry for a different shape with the same hash is reported as a miss.
+     *
+     * Must be called with the stripe's mutex held.
+     */
+    static Status getFromStripe_inlock(const Stripe& stripe,
+                                       PlanCacheKeyHash keyHash,
+                                       const PlanCacheKey& key,
+                                       PlanCacheEntry** entryOut);
+
+    std::vector<std::unique_ptr<Stripe>> _stripes;
 
     // Counter for write notifications since initialization or last clear() invocation.  Starts
     // at 0.
@@ -411,6 +493,10 @@ private:
     // Concurrent access is synchronized by the collection lock.  Multiple concurrent readers
     // are allowed.
     PlanCacheIndexabilityState _indexabilityState;
+
+    // Identifies _indexabilityState among all the states of all plan caches, so that a query's
+    // cached key can be reused until the collection's indexes change. Never 0.
+    unsigned long long _indexabilityVersion;
 };
 
 }  // namespace mongo
@@ -388,6 +388,85 @@ TEST(PlanCacheTest, AddValidSolution) {
     ASSERT_EQUALS(planCache.size(), 1U);
 }
 
+TEST(PlanCacheTest, AddManyShapes) {
+    PlanCache planCache;
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+
+    // Enough shapes to land in every stripe.
+    std::vector<unique_ptr<CanonicalQuery>> cqs;
+    for (int i = 0; i < 100; ++i) {
+        const std::string field = str::stream() << "f" << i;
+        cqs.push_back(canonicalize(BSON("a" << 1 << field << 1)));
+        ASSERT_OK(planCache.add(*cqs.back(), solns, createDecision(1U)));
+    }
+
+    ASSERT_EQUALS(planCache.size(), 100U);
+    for (auto&& cq : cqs) {
+        ASSERT_TRUE(planCache.contains(*cq));
+    }
+
+    std::vector<PlanCacheEntry*> entries = planCache.getAllEntries();
+    ASSERT_EQUALS(entries.size(), 100U);
+    for (auto entry : entries) {
+        delete entry;
+    }
+
+    planCache.clear();
+    ASSERT_EQUALS(planCache.size(), 0U);
+}
+
+TEST(PlanCacheTest, RecordExecution) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    unique_ptr<CanonicalQuery> sameShape(canonicalize("{a: 5}"));
+    QuerySolution qs;
+    qs.cacheData.reset(new SolutionCacheData());
+    qs.cacheData->tree.reset(new PlanCacheIndexTree());
+    std::vector<QuerySolution*> solns;
+    solns.push_back(&qs);
+
+    // Executions of queries which were neither planned from nor added to the cache aren't
+    // recorded.
+    planCache.recordExecution(*cq, 10, 10, 100);
+
+    ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+    planCache.recordExecution(*cq, 10, 20, 0);
+    planCache.recordExecution(*sameShape, 30, 40, 1000);
+    CachedSolution* rawCS;
+    ASSERT_OK(planCache.get(*sameShape, &rawCS));
+    unique_ptr<CachedSolution> cs(rawCS);
+    planCache.recordExecution(*sameShape, 30, 40, 1000);
+
+    // Replanning keeps the statistics.
+    ASSERT_OK(planCache.add(*sameShape, solns, createDecision(1U)));
+
+    PlanCacheEntry* rawEntry;
+    ASSERT_OK(planCache.getEntry(*cq, &rawEntry));
+    unique_ptr<PlanCacheEntry> entry(rawEntry);
+    ASSERT_EQUALS(entry->keyHash, planCache.computeKeyHash(*cq));
+    ASSERT_EQUALS(entry->key, planCache.computeKey(*cq));
+    ASSERT_EQUALS(entry->stats->executions.load(), 2);
+    ASSERT_EQUALS(entry->stats->totalDocsExamined.load(), 40);
+    ASSERT_EQUALS(entry->stats->totalKeysExamined.load(), 60);
+    ASSERT_EQUALS(entry->stats->totalLatencyMicros.load(), 1000);
+
+    // 0 micros is counted in bucket 0, and 1000 in [512, 1024).
+    ASSERT_EQUALS(entry->stats->latencyHistogram[0].load(), 1);
+    ASSERT_EQUALS(entry->stats->latencyHistogram[10].load(), 1);
+
+    BSONObjBuilder bob;
+    entry->stats->appendTo(&bob);
+    BSONObj statsObj = bob.obj();
+    ASSERT_EQUALS(statsObj["avgDocsExamined"].numberDouble(), 20.0);
+    ASSERT_EQUALS(statsObj["latencyHistogram"].Obj(),
+                  BSON_ARRAY(BSON("micros" << 0LL << "count" << 1LL)
+                             << BSON("micros" << 512LL << "count" << 1LL)));
+}
+
 /**
  * Each test in the CachePlanSelectionTest suite goes through
  * the following flow:
@@ -688,14 +767,14 @@ protected:
         ASSERT(NULL == bestSoln->cacheData.get());
     }
 
-    static const PlanCacheKey ck;
+    static const PlanCacheKeyHash ck;
 
     BSONObj queryObj;
     QueryPlannerParams params;
     vector<QuerySolution*> solns;
 };
 
-const PlanCacheKey CachePlanSelectionTest::ck = "mock_cache_key";
+const PlanCacheKeyHash CachePlanSelectionTest::ck = 0x1234;
 
 //
 // Equality
@@ -1147,6 +1226,24 @@ TEST(PlanCacheTest, ComputeKeyGeoNear) {
         "gnanrsp");
 }
 
+// Queries of the same shape have the same shape hash, and queries of different shapes don't.
+TEST(PlanCacheTest, ShapeHash) {
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1, b: {$gt: 2}}", "{c: 1}", "{}"));
+    unique_ptr<CanonicalQuery> sameShape(canonicalize("{b: {$gt: 5}, a: 'x'}", "{c: 1}", "{}"));
+    unique_ptr<CanonicalQuery> otherPredicate(canonicalize("{a: 1, b: {$lt: 2}}", "{c: 1}", "{}"));
+    unique_ptr<CanonicalQuery> otherSort(canonicalize("{a: 1, b: {$gt: 2}}", "{c: -1}", "{}"));
+    unique_ptr<CanonicalQuery> otherProj(canonicalize("{a: 1, b: {$gt: 2}}", "{c: 1}", "{a: 1}"));
+
+    ASSERT_EQUALS(cq->getShapeHash(), sameShape->getShapeHash());
+    ASSERT_NOT_EQUALS(cq->getShapeHash(), otherPredicate->getShapeHash());
+    ASSERT_NOT_EQUALS(cq->getShapeHash(), otherSort->getShapeHash());
+    ASSERT_NOT_EQUALS(cq->getShapeHash(), otherProj->getShapeHash());
+
+    PlanCache planCache;
+    ASSERT_EQUALS(planCache.computeKeyHash(*cq), planCache.computeKeyHash(*sameShape));
+    ASSERT_NOT_EQUALS(planCache.computeKeyHash(*cq), planCache.computeKeyHash(*otherSort));
+}
+
 // When a sparse index is present, computeKey() should generate different keys depending on
 // whether or not the predicates in the given query can use the index.
 TEST(PlanCacheTest, ComputeKeySparseIndex) {
@@ -1169,6 +1266,11 @@ TEST(PlanCacheTest, ComputeKeySparseIndex) {
 
     // 'cqEqNull' gets a different key, since it is not compatible with this index.
     ASSERT_NOT_EQUALS(planCache.computeKey(*cqEqNull), planCache.computeKey(*cqEqNumber));
+
+    // The hashes the cache is keyed by agree with the keys.
+    ASSERT_EQ(planCache.computeKeyHash(*cqEqNumber), planCache.computeKeyHash(*cqEqString));
+    ASSERT_NOT_EQUALS(planCache.computeKeyHash(*cqEqNull),
+                      planCache.computeKeyHash(*cqEqNumber));
 }
 
 // When a partial index is present, computeKey() should generate different keys depending on
@@ -1196,6 +1298,11 @@ TEST(PlanCacheTest, ComputeKeyPartialIndex) {
 
     // 'cqGtNegativeFive' gets a different key, since it is not compatible with this index.
     ASSERT_NOT_EQUALS(planCache.computeKey(*cqGtNegativeFive), planCache.computeKey(*cqGtZero));
+
+    // The hashes the cache is keyed by agree with the keys.
+    ASSERT_EQ(planCache.computeKeyHash(*cqGtZero), planCache.computeKeyHash(*cqGtFive));
+    ASSERT_NOT_EQUALS(planCache.computeKeyHash(*cqGtNegativeFive),
+                      planCache.computeKeyHash(*cqGtZero));
 }
 
 }  // namespace
@@ -0,0 +1,216 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_model.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+const double PlanCostModel::kKeyCost = 1.0;
+const double PlanCostModel::kFetchCost = 4.0;
+const double PlanCostModel::kScanCost = 2.0;
+const double PlanCostModel::kSortCost = 0.5;
+const double PlanCostModel::kHashCost = 1.0;
+const double PlanCostModel::kFilterSelectivity = 0.5;
+
+PlanCostModel::PlanCostModel(double numRecords, IndexStatisticsLookup lookup)
+    : _numRecords(numRecords), _lookup(std::move(lookup)) {}
+
+PlanCostModel::IndexStatisticsLookup PlanCostModel::lookupIn(
+    const std::vector<IndexEntry>& indices) {
+    return [&indices](const BSONObj& keyPattern) -> std::shared_ptr<const IndexStatistics> {
+        for (const IndexEntry& entry : indices) {
+            if (entry.keyPattern == keyPattern) {
+                return entry.statistics;
+            }
+        }
+        return nullptr;
+    };
+}
+
+boost::optional<PlanCostEstimate> PlanCostModel::estimate(const QuerySolution& solution) const {
+    if (!solution.root) {
+        return boost::none;
+    }
+    return estimateNode(solution.root.get());
+}
+
+boost::optional<size_t> PlanCostModel::pickBest(const std::vector<QuerySolution*>& solutions,
+                                                double margin) const {
+    if (solutions.size() < 2) {
+        return boost::none;
+    }
+
+    std::vector<double> costs;
+    for (const QuerySolution* solution : solutions) {
+        auto est = estimate(*solution);
+        if (!est) {
+            return boost::none;
+        }
+        costs.push_back(est->cost);
+    }
+
+    const size_t best = std::min_element(costs.begin(), costs.end()) - costs.begin();
+    for (size_t i = 0; i < costs.size(); ++i) {
+        if (i != best && costs[i] < costs[best] * (1 + margin)) {
+            return boost::none;
+        }
+    }
+    return best;
+}
+
+boost::optional<PlanCostEstimate> PlanCostModel::estimateIndexScan(
+    const IndexScanNode* node) const {
+    std::shared_ptr<const IndexStatistics> stats = _lookup(node->indexKeyPattern);
+    if (!stats) {
+        return boost::none;
+    }
+
+    // Scans reaching keys the statistics did not sample are left to the trial run.
+    double selectivity;
+    size_t numIntervals = 1;
+    if (node->bounds.isSimpleRange) {
+        BSONObjBuilder bob;
+        bob.appendAs(node->bounds.startKey.firstElement(), "");
+        bob.appendAs(node->bounds.endKey.firstElement(), "");
+        const Interval range(bob.obj(), true, true);
+        if (!stats->isWithinSample(range)) {
+            return boost::none;
+        }
+        selectivity = stats->estimateSelectivity(range);
+    } else if (node->bounds.fields.empty()) {
+        return boost::none;
+    } else {
+        if (!stats->isWithinSample(node->bounds.fields[0])) {
+            return boost::none;
+        }
+        selectivity = stats->estimateSelectivity(node->bounds.fields[0]);
+        numIntervals = node->bounds.fields[0].intervals.size();
+    }
+
+    // Bounds on trailing fields are ignored, so compound indexes are costed by their leading
+    // field alone. Every interval costs at least a seek.
+    PlanCostEstimate est;
+    const double keys = std::max(1.0, selectivity * stats->getNumKeys());
+    est.cost = (keys + numIntervals) * kKeyCost;
+    est.numResults = node->filter ? keys * kFilterSelectivity : keys;
+    return est;
+}
+
+boost::optional<PlanCostEstimate> PlanCostModel::estimateNode(const QuerySolutionNode* node) const {
+    std::vector<PlanCostEstimate> children;
+    for (const QuerySolutionNode* child : node->children) {
+        auto est = estimateNode(child);
+        if (!est) {
+            return boost::none;
+        }
+        children.push_back(*est);
+    }
+
+    PlanCostEstimate est;
+    for (const PlanCostEstimate& child : children) {
+        est.cost += child.cost;
+        est.blocking = est.blocking || child.blocking;
+    }
+
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+            est.cost = _numRecords * kScanCost;
+            est.numResults = node->filter ? _numRecords * kFilterSelectivity : _numRecords;
+            return est;
+        case STAGE_IXSCAN:
+            return estimateIndexScan(static_cast<const IndexScanNode*>(node));
+        case STAGE_FETCH:
+            est.cost += children[0].numResults * kFetchCost;
+            est.numResults = children[0].numResults;
+            break;
+        case STAGE_AND_HASH:
+            est.blocking = true;
+        // Fall through.
+        case STAGE_AND_SORTED:
+            est.numResults = children[0].numResults;
+            for (const PlanCostEstimate& child : children) {
+                if (STAGE_AND_HASH == node->getType()) {
+                    est.cost += child.numResults * kHashCost;
+                }
+                est.numResults = std::min(est.numResults, child.numResults);
+            }
+            break;
+        case STAGE_OR:
+        case STAGE_SORT_MERGE:
+            for (const PlanCostEstimate& child : children) {
+                est.numResults += child.numResults;
+            }
+            break;
+        case STAGE_SORT: {
+            const SortNode* sort = static_cast<const SortNode*>(node);
+            const double n = children[0].numResults;
+            est.cost += n * std::log2(n + 1) * kSortCost;
+            est.numResults = sort->limit ? std::min(n, static_cast<double>(sort->limit)) : n;
+            est.blocking = true;
+            break;
+        }
+        case STAGE_LIMIT: {
+            const LimitNode* limit = static_cast<const LimitNode*>(node);
+            const double n = children[0].numResults;
+            est.numResults = std::min(n, static_cast<double>(limit->limit));
+
+            // A streaming plan stops once it has produced enough results.
+            if (!est.blocking && n > 0) {
+                est.cost *= est.numResults / n;
+            }
+            break;
+        }
+        case STAGE_SKIP: {
+            const SkipNode* skip = static_cast<const SkipNode*>(node);
+            est.numResults =
+                std::max(0.0, children[0].numResults - static_cast<double>(skip->skip));
+            break;
+        }
+        case STAGE_PROJECTION:
+        case STAGE_SHARDING_FILTER:
+        case STAGE_KEEP_MUTATIONS:
+            est.numResults = children[0].numResults;
+            break;
+        default:
+            return boost::none;
+    }
+
+    if (node->filter) {
+        est.numResults *= kFilterSelectivity;
+    }
+    return est;
+}
+
+}  // namespace mongo
@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/query/index_entry.h"
+#include "mongo/db/query/index_statistics.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/stdx/functional.h"
+
+namespace mongo {
+
+/**
+ * The estimated cost of running a plan to completion, in abstract units where examining one index
+ * key costs 1, along with the estimated number of results it produces.
+ */
+struct PlanCostEstimate {
+    double cost = 0;
+    double numResults = 0;
+
+    // Whether the plan buffers its whole input before producing a result, so that a limit
+    // above it does not cut its cost short.
+    bool blocking = false;
+};
+
+/**
+ * Estimates the cost of QuerySolutions from index statistics so that the planner can pick a
+ * plan without trial-running every candidate in a MultiPlanStage.
+ *
+ * The model only knows about the distribution of the leading field of each index and assumes a
+ * fixed selectivity for residual filters, so it is deliberately conservative: it names a winner
+ * only when every other candidate is estimated to cost more by a configurable margin, and
+ * otherwise defers to the trial run.
+ */
+class PlanCostModel {
+public:
+    /**
+     * Returns the statistics for the index with the given key pattern, or null if there are none.
+     */
+    using IndexStatisticsLookup =
+        stdx::function<std::shared_ptr<const IndexStatistics>(const BSONObj& keyPattern)>;
+
+    /**
+     * Cost of examining an index key, fetching a document by RecordId, reading a document
+     * during a collection scan, comparing two results in a blocking sort and hashing a result in
+     * a hashed intersection, respectively.
+     */
+    static const double kKeyCost;
+    static const double kFetchCost;
+    static const double kScanCost;
+    static const double kSortCost;
+    static const double kHashCost;
+
+    // Assumed fraction of documents or keys that pass a residual filter.
+    static const double kFilterSelectivity;
+
+    PlanCostModel(double numRecords, IndexStatisticsLookup lookup);
+
+    /**
+     * Returns a lookup that finds statistics in the IndexEntry with a matching key pattern.
+     * 'indices' must outlive the lookup.
+     */
+    static IndexStatisticsLookup lookupIn(const std::vector<IndexEntry>& indices);
+
+    /**
+     * Returns the estimated cost of 'solution', or boost::none if it contains a stage the model
+     * cannot cost or scans an index that has no statistics.
+     */
+    boost::optional<PlanCostEstimate> estimate(const QuerySolution& solution) const;
+
+    /**
+     * Returns the position of the cheapest of 'solutions' if every other solution is estimated to
+     * cost at least (1 + 'margin') times as much. Returns boost::none if there are fewer than two
+     * solutions, if any of them cannot be costed, or if the cheapest ones are too close to call.
+     */
+    boost::optional<size_t> pickBest(const std::vector<QuerySolution*>& solutions,
+                                     double margin) const;
+
+private:
+    boost::optional<PlanCostEstimate> estimateNode(const QuerySolutionNode* node) const;
+
+    boost::optional<PlanCostEstimate> estimateIndexScan(const IndexScanNode* node) const;
+
+    const double _numRecords;
+    const IndexStatisticsLookup _lookup;
+};
+
+}  // namespace mongo
@@ -0,0 +1,193 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cost_model.h"
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const double kNumRecords = 1000;
+
+/**
+ * Returns statistics over 'a' and 'b' that hold the values 0 to 999 once each, and over 'd' for
+ * which only the first 100 of those were sampled.
+ */
+std::shared_ptr<const IndexStatistics> uniformStats(const BSONObj& keyPattern) {
+    const bool partial = keyPattern == BSON("d" << 1);
+    if (keyPattern != BSON("a" << 1) && keyPattern != BSON("b" << 1) && !partial) {
+        return nullptr;
+    }
+    const int numSampled = partial ? 100 : kNumRecords;
+    std::vector<BSONObj> sample;
+    for (int i = 0; i < numSampled; ++i) {
+        sample.push_back(BSON("" << i));
+    }
+    return std::make_shared<const IndexStatistics>(
+        std::move(sample), 1.0, kNumRecords - numSampled, 10);
+}
+
+QuerySolutionNode* indexScan(const BSONObj& keyPattern, const BSONObj& bounds) {
+    IndexScanNode* ixscan = new IndexScanNode();
+    ixscan->indexKeyPattern = keyPattern;
+    OrderedIntervalList oil(keyPattern.firstElementFieldName());
+    oil.intervals.push_back(Interval(bounds, true, true));
+    ixscan->bounds.fields.push_back(oil);
+    return ixscan;
+}
+
+QuerySolutionNode* fetch(QuerySolutionNode* child) {
+    FetchNode* node = new FetchNode();
+    node->children.push_back(child);
+    return node;
+}
+
+QuerySolutionNode* limit(QuerySolutionNode* child, long long n) {
+    LimitNode* node = new LimitNode();
+    node->limit = n;
+    node->children.push_back(child);
+    return node;
+}
+
+QuerySolutionNode* sort(QuerySolutionNode* child) {
+    SortNode* node = new SortNode();
+    node->pattern = BSON("a" << 1);
+    node->children.push_back(child);
+    return node;
+}
+
+class PlanCostModelTest : public unittest::Test {
+protected:
+    PlanCostModelTest() : _model(kNumRecords, uniformStats) {}
+
+    QuerySolution* addSolution(QuerySolutionNode* root) {
+        QuerySolution* solution = new QuerySolution();
+        solution->root.reset(root);
+        _solutions.mutableVector().push_back(solution);
+        return solution;
+    }
+
+    const std::vector<QuerySolution*>& solutions() const {
+        return _solutions.vector();
+    }
+
+    PlanCostModel _model;
+    OwnedPointerVector<QuerySolution> _solutions;
+};
+
+TEST_F(PlanCostModelTest, SelectiveIndexScanBeatsCollectionScan) {
+    addSolution(new CollectionScanNode());
+    addSolution(fetch(indexScan(BSON("a" << 1), BSON("" << 5 << "" << 5))));
+
+    auto collScan = _model.estimate(*solutions()[0]);
+    auto ixScan = _model.estimate(*solutions()[1]);
+    ASSERT(collScan);
+    ASSERT(ixScan);
+    ASSERT_EQUALS(kNumRecords * PlanCostModel::kScanCost, collScan->cost);
+    ASSERT_EQUALS(1, ixScan->numResults);
+    ASSERT_LT(ixScan->cost, collScan->cost);
+
+    auto best = _model.pickBest(solutions(), 1.0);
+    ASSERT(best);
+    ASSERT_EQUALS(1U, *best);
+}
+
+TEST_F(PlanCostModelTest, PicksMoreSelectiveIndex) {
+    addSolution(fetch(indexScan(BSON("a" << 1), BSON("" << 0 << "" << 499))));
+    addSolution(fetch(indexScan(BSON("b" << 1), BSON("" << 0 << "" << 9))));
+
+    auto best = _model.pickBest(solutions(), 1.0);
+    ASSERT(best);
+    ASSERT_EQUALS(1U, *best);
+}
+
+TEST_F(PlanCostModelTest, CloseCostsDeferToTrial) {
+    addSolution(fetch(indexScan(BSON("a" << 1), BSON("" << 0 << "" << 99))));
+    addSolution(fetch(indexScan(BSON("b" << 1), BSON("" << 0 << "" << 149))));
+
+    ASSERT_FALSE(_model.pickBest(solutions(), 1.0));
+
+    // With no margin the cheaper plan always wins.
+    auto best = _model.pickBest(solutions(), 0.0);
+    ASSERT(best);
+    ASSERT_EQUALS(0U, *best);
+}
+
+TEST_F(PlanCostModelTest, IndexWithoutStatisticsDefersToTrial) {
+    addSolution(new CollectionScanNode());
+    addSolution(fetch(indexScan(BSON("c" << 1), BSON("" << 5 << "" << 5))));
+
+    ASSERT_FALSE(_model.estimate(*solutions()[1]));
+    ASSERT_FALSE(_model.pickBest(solutions(), 1.0));
+}
+
+TEST_F(PlanCostModelTest, ScanPastSampleDefersToTrial) {
+    addSolution(new CollectionScanNode());
+    addSolution(fetch(indexScan(BSON("d" << 1), BSON("" << 5 << "" << 5))));
+    addSolution(fetch(indexScan(BSON("d" << 1), BSON("" << 500 << "" << 500))));
+
+    ASSERT(_model.estimate(*solutions()[1]));
+    ASSERT_FALSE(_model.estimate(*solutions()[2]));
+    ASSERT_FALSE(_model.pickBest(solutions(), 1.0));
+}
+
+TEST_F(PlanCostModelTest, SingleSolutionIsNotRanked) {
+    addSolution(new CollectionScanNode());
+    ASSERT_FALSE(_model.pickBest(solutions(), 1.0));
+}
+
+TEST_F(PlanCostModelTest, LimitShortensStreamingPlansOnly) {
+    // Scanning all of 'a' in order stops after ten results, whereas sorting the results of a
+    // scan over 'b' has to read all of its input first.
+    QuerySolution* streaming = addSolution(
+        limit(fetch(indexScan(BSON("a" << 1), BSON("" << MINKEY << "" << MAXKEY))), 10));
+    QuerySolution* blocking = addSolution(
+        limit(sort(fetch(indexScan(BSON("b" << 1), BSON("" << 0 << "" << 499)))), 10));
+
+    auto streamingCost = _model.estimate(*streaming);
+    auto blockingCost = _model.estimate(*blocking);
+    ASSERT(streamingCost);
+    ASSERT(blockingCost);
+    ASSERT_FALSE(streamingCost->blocking);
+    ASSERT_TRUE(blockingCost->blocking);
+    ASSERT_EQUALS(10, streamingCost->numResults);
+    ASSERT_LT(streamingCost->cost, 100);
+    ASSERT_GT(blockingCost->cost, 500 * PlanCostModel::kFetchCost);
+
+    auto best = _model.pickBest(solutions(), 1.0);
+    ASSERT(best);
+    ASSERT_EQUALS(0U, *best);
+}
+
+}  // namespace
+}  // namespace mongo
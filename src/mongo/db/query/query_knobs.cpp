@@ -56,6 +56,22 @@ MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableIndexIntersection, bool,
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableHashIntersection, bool, false);
 
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerEnableCostModel, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerCostModelMargin, double, 1.0);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCostModelSampleSize, int, 10000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCostModelMaxKeysScanned, int, 1000000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCostModelMaxKeysScannedInline, int, 1000);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryCostModelHistogramBuckets, int, 64);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryIndexStatisticsSamplerEnabled, bool, false);
+
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryIndexStatisticsSamplerSleepSecs, int, 60);
+
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlanOrChildrenIndependently, bool, true);
 
 MONGO_EXPORT_SERVER_PARAMETER(internalQueryMaxScansToExplode, int, 200);
@@ -54,6 +54,36 @@ extern bool internalQueryPlannerEnableIndexIntersection;
 // Do we use hash-based intersection for rooted $and queries?
 extern bool internalQueryPlannerEnableHashIntersection;
 
+//
+// cost-based plan selection
+//
+
+// Do we rank candidate plans by estimated cost before resorting to a trial run?
+extern bool internalQueryPlannerEnableCostModel;
+
+// The cheapest plan is chosen without a trial run only if every other plan is estimated to cost
+// at least (1 + this margin) times as much.
+extern double internalQueryPlannerCostModelMargin;
+
+// How many index keys are kept as the sample from which index statistics are built?
+extern int internalQueryCostModelSampleSize;
+
+// How many index keys are we willing to read while sampling an index?
+extern int internalQueryCostModelMaxKeysScanned;
+
+// How many index keys may planning a query read to sample an index when the background sampler is
+// off?
+extern int internalQueryCostModelMaxKeysScannedInline;
+
+// How many buckets does an index statistics histogram have?
+extern int internalQueryCostModelHistogramBuckets;
+
+// Do we sample index statistics in a background job rather than when planning queries?
+extern bool internalQueryIndexStatisticsSamplerEnabled;
+
+// How many seconds does the background index statistics sampler sleep between passes?
+extern int internalQueryIndexStatisticsSamplerSleepSecs;
+
 //
 // plan cache
 //
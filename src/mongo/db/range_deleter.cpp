@@ -32,7 +32,9 @@
 
 #include "mongo/db/range_deleter.h"
 
+#include <algorithm>
 #include <boost/date_time/posix_time/posix_time_duration.hpp>
+#include <cmath>
 #include <memory>
 
 #include "mongo/db/client.h"
@@ -154,10 +156,13 @@ bool RangeDeleter::NSMinMaxCmp::operator()(const NSMinMax* lhs, const NSMinMax*
     return compareRanges(lhs->min, lhs->max, rhs->min, rhs->max) < 0;
 }
 
-RangeDeleter::RangeDeleter(RangeDeleterEnv* env)
+RangeDeleter::RangeDeleter(RangeDeleterEnv* env, size_t numWorkers)
     : _env(env),  // ownership xfer
+      _numWorkers(numWorkers),
       _stopRequested(false),
-      _deletesInProgress(0) {}
+      _deletesInProgress(0) {
+    invariant(_numWorkers > 0);
+}
 
 RangeDeleter::~RangeDeleter() {
     for (TaskList::iterator it = _notReadyQueue.begin(); it != _notReadyQueue.end(); ++it) {
@@ -180,8 +185,10 @@ RangeDeleter::~RangeDeleter() {
 }
 
 void RangeDeleter::startWorkers() {
-    if (!_worker) {
-        _worker.reset(new stdx::thread(stdx::bind(&RangeDeleter::doWork, this)));
+    if (_workers.empty()) {
+        for (size_t i = 0; i < _numWorkers; i++) {
+            _workers.emplace_back(new stdx::thread(stdx::bind(&RangeDeleter::doWork, this)));
+        }
     }
 }
 
@@ -191,8 +198,8 @@ void RangeDeleter::stopWorkers() {
         _stopRequested = true;
     }
 
-    if (_worker) {
-        _worker->join();
+    for (auto&& worker : _workers) {
+        worker->join();
     }
 
     stdx::unique_lock<stdx::mutex> sl(_queueMutex);
@@ -365,6 +372,7 @@ bool RangeDeleter::deleteNow(OperationContext* txn,
     }
     taskDetails.stats.queueEndTS = jsTime();
 
+    taskDetails.throttle = &_throttle;
     taskDetails.stats.deleteStartTS = jsTime();
     bool result = _env->deleteRange(txn, taskDetails, &taskDetails.stats.deletedDocCount, errMsg);
 
@@ -435,7 +443,8 @@ void RangeDeleter::doWork() {
 
         {
             stdx::unique_lock<stdx::mutex> sl(_queueMutex);
-            while (_taskQueue.empty()) {
+            TaskList::iterator nextTaskIter;
+            while ((nextTaskIter = findReadyTask_inlock()) == _taskQueue.end()) {
                 _taskQueueNotEmptyCV.wait_for(sl,
                                               stdx::chrono::milliseconds(kNotEmptyTimeoutMillis));
 
@@ -444,7 +453,7 @@ void RangeDeleter::doWork() {
                     return;
                 }
 
-                if (_taskQueue.empty()) {
+                if (findReadyTask_inlock() == _taskQueue.end()) {
                     // Try to check if some deletes are ready and move them to the
                     // ready queue.
 
@@ -485,14 +494,16 @@ void RangeDeleter::doWork() {
                 return;
             }
 
-            nextTask = _taskQueue.front();
-            _taskQueue.pop_front();
+            nextTask = *nextTaskIter;
+            _taskQueue.erase(nextTaskIter);
 
+            _nsInProgress.insert(nextTask->options.range.ns);
             _deletesInProgress++;
         }
 
         {
             auto txn = client->makeOperationContext();
+            nextTask->throttle = &_throttle;
             nextTask->stats.deleteStartTS = jsTime();
             bool delResult =
                 _env->deleteRange(txn.get(), *nextTask, &nextTask->stats.deletedDocCount, &errMsg);
@@ -518,8 +529,12 @@ void RangeDeleter::doWork() {
                               nextTask->options.range.minKey,
                               nextTask->options.range.maxKey);
             deletePtrElement(&_deleteSet, &setEntry);
+            _nsInProgress.erase(nextTask->options.range.ns);
             _deletesInProgress--;
 
+            // Another worker may be waiting for a task of this namespace.
+            _taskQueueNotEmptyCV.notify_all();
+
             if (nextTask->notifyDone) {
                 nextTask->notifyDone->notifyOne();
             }
@@ -531,6 +546,14 @@ void RangeDeleter::doWork() {
     }
 }
 
+RangeDeleter::TaskList::iterator RangeDeleter::findReadyTask_inlock() {
+    return std::find_if(_taskQueue.begin(),
+                        _taskQueue.end(),
+                        [this](const RangeDeleteEntry* entry) {
+                            return _nsInProgress.count(entry->options.range.ns) == 0;
+                        });
+}
+
 bool RangeDeleter::canEnqueue_inlock(StringData ns,
                                      const BSONObj& min,
                                      const BSONObj& max,
@@ -576,7 +599,7 @@ void RangeDeleter::recordDelStats(DeleteJobStats* newStat) {
 }
 
 RangeDeleteEntry::RangeDeleteEntry(const RangeDeleterOptions& options)
-    : options(options), notifyDone(NULL) {}
+    : options(options), notifyDone(NULL), throttle(NULL) {}
 
 BSONObj RangeDeleteEntry::toBSON() const {
     BSONObjBuilder builder;
@@ -594,6 +617,64 @@ BSONObj RangeDeleteEntry::toBSON() const {
     return builder.done().copy();
 }
 
+Milliseconds RangeDeleterThrottle::TokenBucket::consume(Milliseconds elapsed,
+                                                       long long amount,
+                                                       long long ratePerSecond) {
+    if (ratePerSecond <= 0) {
+        tokens = 0;
+        rate = 0;
+        return Milliseconds(0);
+    }
+
+    if (ratePerSecond != rate) {
+        // Start with a full bucket whenever the limit changes.
+        rate = ratePerSecond;
+        tokens = rate;
+    } else {
+        tokens = std::min(static_cast<double>(rate),
+                          tokens + rate * durationCount<Milliseconds>(elapsed) / 1000.0);
+    }
+
+    tokens -= amount;
+    if (tokens >= 0) {
+        return Milliseconds(0);
+    }
+
+    return Milliseconds(static_cast<long long>(std::ceil(-tokens * 1000 / rate)));
+}
+
+Milliseconds RangeDeleterThrottle::recordDeletes(Date_t now,
+                                                 long long docs,
+                                                 long long bytes,
+                                                 long long maxDocsPerSecond,
+                                                 long long maxBytesPerSecond) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    Milliseconds elapsed(0);
+    if (_lastDeleteTS != Date_t() && now > _lastDeleteTS) {
+        elapsed = now - _lastDeleteTS;
+    }
+    _lastDeleteTS = std::max(now, _lastDeleteTS);
+
+    const Milliseconds wait = std::max(_docsBucket.consume(elapsed, docs, maxDocsPerSecond),
+                                       _bytesBucket.consume(elapsed, bytes, maxBytesPerSecond));
+
+    _deletedDocs += docs;
+    _deletedBytes += bytes;
+    _deletedBatches++;
+    _throttled += wait;
+
+    return wait;
+}
+
+void RangeDeleterThrottle::append(BSONObjBuilder* builder) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    builder->append("deletedDocs", _deletedDocs);
+    builder->append("deletedBytes", _deletedBytes);
+    builder->append("deletedBatches", _deletedBatches);
+    builder->append("throttledMillis", durationCount<Milliseconds>(_throttled));
+}
+
 RangeDeleterOptions::RangeDeleterOptions(const KeyRange& range)
     : range(range), fromMigrate(false), onlyRemoveOrphanedDocs(false), waitForOpenCursors(false) {}
 }
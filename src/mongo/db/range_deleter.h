@@ -53,6 +53,58 @@ struct RangeDeleteEntry;
 struct RangeDeleterEnv;
 struct RangeDeleterOptions;
 
+/**
+ * Token bucket shared by all the deletes of a RangeDeleter, which limits how fast documents are
+ * deleted and counts the documents and bytes deleted so far.
+ */
+class RangeDeleterThrottle {
+    MONGO_DISALLOW_COPYING(RangeDeleterThrottle);
+
+public:
+    RangeDeleterThrottle() = default;
+
+    /**
+     * Records that a batch of 'docs' documents totalling 'bytes' was deleted at 'now'. Returns how
+     * long the caller must wait before deleting more documents to stay within 'maxDocsPerSecond'
+     * and 'maxBytesPerSecond'. Each limit allows bursts of up to a second's worth of deletes and a
+     * limit <= 0 means unlimited.
+     */
+    Milliseconds recordDeletes(Date_t now,
+                               long long docs,
+                               long long bytes,
+                               long long maxDocsPerSecond,
+                               long long maxBytesPerSecond);
+
+    /**
+     * Appends the number of documents, bytes and batches deleted and the total time deletes were
+     * asked to wait.
+     */
+    void append(BSONObjBuilder* builder) const;
+
+private:
+    /**
+     * Bucket refilled at 'rate' tokens per second. Deleting more than the bucket holds leaves it
+     * negative, which the caller pays back by waiting.
+     */
+    struct TokenBucket {
+        Milliseconds consume(Milliseconds elapsed, long long amount, long long ratePerSecond);
+
+        double tokens{0};
+        long long rate{0};
+    };
+
+    mutable stdx::mutex _mutex;
+
+    Date_t _lastDeleteTS;
+    TokenBucket _docsBucket;
+    TokenBucket _bytesBucket;
+
+    long long _deletedDocs{0};
+    long long _deletedBytes{0};
+    long long _deletedBatches{0};
+    Milliseconds _throttled{0};
+};
+
 /**
  * Class for deleting documents for a given namespace and range.  It contains a queue of
  * jobs to be deleted. Deletions can be "immediate", in which case they are going to be put
@@ -61,8 +113,9 @@ struct RangeDeleterOptions;
  *
  * Threading assumptions:
  *
- *   This class has (currently) one worker thread attacking the queue, one
- *   job at a time. If we want an immediate deletion, that job is going to
+ *   This class has a fixed number of worker threads attacking the queue, each
+ *   one job at a time. Two workers never delete ranges of the same namespace
+ *   at the same time. If we want an immediate deletion, that job is going to
  *   be performed on the thread that is requesting it.
  *
  *   All calls regarding deletion are synchronized.
@@ -81,9 +134,10 @@ class RangeDeleter {
 public:
     /**
      * Creates a new deleter and uses an environment object to delegate external logic like
-     * data deletion. Takes ownership of the environment.
+     * data deletion. Takes ownership of the environment. Queued deletes are processed by
+     * 'numWorkers' threads.
      */
-    explicit RangeDeleter(RangeDeleterEnv* env);
+    explicit RangeDeleter(RangeDeleterEnv* env, size_t numWorkers = 1);
 
     /**
      * Destroys this deleter. Must make sure that no threads are working on this queue. Use
@@ -96,15 +150,15 @@ public:
     //
 
     /**
-     * Starts the background thread to work on this queue. Does nothing if the worker
-     * thread is already active.
+     * Starts the background threads to work on this queue. Does nothing if the worker
+     * threads are already active.
      *
      * This call is _not_ thread safe and must be issued before any other call.
      */
     void startWorkers();
 
     /**
-     * Stops the background thread working on this queue. This will block if there are
+     * Stops the background threads working on this queue. This will block if there are
      * tasks that are being deleted, but will leave the pending tasks in the queue.
      *
      * Steps:
@@ -161,6 +215,13 @@ public:
     size_t getPendingDeletes() const;
     size_t getDeletesInProgress() const;
 
+    /**
+     * Returns the throttle shared by all deletes of this deleter.
+     */
+    const RangeDeleterThrottle& getThrottle() const {
+        return _throttle;
+    }
+
     //
     // Methods meant to be only used for testing. Should be treated like private
     // methods.
@@ -184,9 +245,15 @@ private:
 
     typedef std::set<NSMinMax*, NSMinMaxCmp> NSMinMaxSet;  // owned here
 
-    /** Body of the worker thread */
+    /** Body of the worker threads */
     void doWork();
 
+    /**
+     * Returns the first task of _taskQueue whose namespace no worker is deleting from, or
+     * _taskQueue.end() if there is none.
+     */
+    TaskList::iterator findReadyTask_inlock();
+
     /** Returns true if the range doesn't intersect with one other range */
     bool canEnqueue_inlock(StringData ns,
                            const BSONObj& min,
@@ -198,8 +265,12 @@ private:
 
     std::unique_ptr<RangeDeleterEnv> _env;
 
+    const size_t _numWorkers;
+
     // Initially not active. Must be started explicitly.
-    std::unique_ptr<stdx::thread> _worker;
+    std::vector<std::unique_ptr<stdx::thread>> _workers;
+
+    RangeDeleterThrottle _throttle;
 
     // Protects _stopRequested.
     mutable stdx::mutex _stopMutex;
@@ -238,6 +309,9 @@ private:
     // Keeps track of number of tasks that are in progress, including the inline deletes.
     size_t _deletesInProgress;
 
+    // Namespaces of the queued deletes that the workers are currently working on.
+    std::set<std::string> _nsInProgress;
+
     // Protects _statsHistory
     mutable stdx::mutex _statsHistoryMutex;
     std::deque<DeleteJobStats*> _statsHistory;
@@ -291,6 +365,9 @@ struct RangeDeleteEntry {
     // Time since the last time we reported this object.
     Date_t lastLoggedTS;
 
+    // Not owned here. Throttle which the deletes of this entry must respect, if not NULL.
+    RangeDeleterThrottle* throttle;
+
     DeleteJobStats stats;
 
     // For debugging only
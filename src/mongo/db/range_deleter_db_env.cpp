@@ -32,6 +32,8 @@
 
 #include "mongo/db/range_deleter_db_env.h"
 
+#include <algorithm>
+
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
@@ -39,16 +41,34 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/operation_context.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/write_concern_options.h"
 #include "mongo/s/d_state.h"
 #include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
 using std::endl;
 using std::string;
 
+namespace {
+
+// Number of documents the range deleter deletes under one collection lock and unit of work.
+MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchSize, int, 128);
+
+// Limits on how fast the range deleter deletes documents, over all the ranges it is deleting. A
+// limit <= 0 means unlimited.
+MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxDocsPerSecond, long long, 0);
+MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxBytesPerSecond, long long, 0);
+
+// Longest that a throttled delete sleeps between checks for interruption.
+const Milliseconds kMaxThrottleSleep(100);
+
+}  // namespace
+
 /**
  * Outline of the delete process:
  * 1. Initialize the client for this thread if there is no client. This is for the worker
@@ -56,7 +76,8 @@ using std::string;
  * 2. Grant this thread authorization to perform deletes.
  * 3. Temporarily enable mode to bypass shard version checks. TODO: Replace this hack.
  * 4. Setup callback to save deletes to moveChunk directory (only if moveParanoia is true).
- * 5. Delete range.
+ * 5. Delete range, in batches of rangeDeleterBatchSize documents. After each batch, wait
+ *    as long as the throttle asks to.
  * 6. Wait until the majority of the secondaries catch up.
  */
 bool RangeDeleterDBEnv::deleteRange(OperationContext* txn,
@@ -87,6 +108,25 @@ bool RangeDeleterDBEnv::deleteRange(OperationContext* txn,
         log() << "Deleter starting delete for: " << ns << " from " << inclusiveLower << " -> "
               << exclusiveUpper << ", with opId: " << opId << endl;
 
+        const auto onBatchDeleted = [&taskDetails, txn](long long docs, long long bytes) {
+            if (!taskDetails.throttle) {
+                return;
+            }
+
+            Milliseconds wait = taskDetails.throttle->recordDeletes(jsTime(),
+                                                                    docs,
+                                                                    bytes,
+                                                                    rangeDeleterMaxDocsPerSecond,
+                                                                    rangeDeleterMaxBytesPerSecond);
+            while (wait > Milliseconds(0)) {
+                txn->checkForInterrupt();
+
+                const Milliseconds sleep = std::min(wait, kMaxThrottleSleep);
+                sleepmillis(durationCount<Milliseconds>(sleep));
+                wait -= sleep;
+            }
+        };
+
         try {
             *deletedDocs =
                 Helpers::removeRange(txn,
@@ -95,7 +135,9 @@ bool RangeDeleterDBEnv::deleteRange(OperationContext* txn,
                                      writeConcern,
                                      removeSaverPtr,
                                      fromMigrate,
-                                     onlyRemoveOrphans);
+                                     onlyRemoveOrphans,
+                                     std::max(1, rangeDeleterBatchSize),
+                                     onBatchDeleted);
 
             if (*deletedDocs < 0) {
                 *errMsg = "collection or index dropped before data could be cleaned";
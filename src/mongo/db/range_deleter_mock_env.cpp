@@ -52,7 +52,7 @@ bool DeletedRangeCmp::operator()(const DeletedRange& lhs, const DeletedRange& rh
 }
 
 RangeDeleterMockEnv::RangeDeleterMockEnv()
-    : _pauseDelete(false), _pausedCount(0), _getCursorsCallCount(0) {
+    : _pauseDelete(false), _resumeAll(false), _pausedCount(0), _getCursorsCallCount(0) {
     setGlobalServiceContext(stdx::make_unique<ServiceContextNoop>());
 }
 
@@ -69,6 +69,7 @@ void RangeDeleterMockEnv::removeCursorId(StringData ns, CursorId id) {
 void RangeDeleterMockEnv::pauseDeletes() {
     stdx::lock_guard<stdx::mutex> sl(_pauseDeleteMutex);
     _pauseDelete = true;
+    _resumeAll = false;
 }
 
 void RangeDeleterMockEnv::resumeOneDelete() {
@@ -77,6 +78,13 @@ void RangeDeleterMockEnv::resumeOneDelete() {
     _pausedCV.notify_one();
 }
 
+void RangeDeleterMockEnv::resumeAllDeletes() {
+    stdx::lock_guard<stdx::mutex> sl(_pauseDeleteMutex);
+    _pauseDelete = false;
+    _resumeAll = true;
+    _pausedCV.notify_all();
+}
+
 void RangeDeleterMockEnv::waitForNthGetCursor(uint64_t nthCall) {
     stdx::unique_lock<stdx::mutex> sl(_envStatMutex);
     while (_getCursorsCallCount < nthCall) {
@@ -118,7 +126,7 @@ bool RangeDeleterMockEnv::deleteRange(OperationContext* txn,
             _pausedCV.wait(sl);
         }
 
-        _pauseDelete = wasInitiallyPaused;
+        _pauseDelete = wasInitiallyPaused && !_resumeAll;
     }
 
     {
@@ -88,6 +88,11 @@ public:
      */
     void resumeOneDelete();
 
+    /**
+     * Unblocks all paused deletes and stops blocking new deletes.
+     */
+    void resumeAllDeletes();
+
     /**
      * Blocks until the getCursor method was called and terminated at least the
      * specified number of times for the entire lifetime of this deleter.
@@ -146,10 +151,11 @@ private:
     stdx::mutex _cursorMapMutex;
     std::map<std::string, std::set<CursorId>> _cursorMap;
 
-    // Protects _pauseDelete & _pausedCount
+    // Protects _pauseDelete, _resumeAll & _pausedCount
     stdx::mutex _pauseDeleteMutex;
     stdx::condition_variable _pausedCV;
     bool _pauseDelete;
+    bool _resumeAll;
 
     // Number of times a delete gets paused.
     uint64_t _pausedCount;
@@ -30,6 +30,7 @@
 
 #include "mongo/base/init.h"
 #include "mongo/db/range_deleter_db_env.h"
+#include "mongo/db/server_parameters.h"
 
 namespace {
 
@@ -38,8 +39,17 @@ mongo::RangeDeleter* _deleter = NULL;
 
 namespace mongo {
 
-MONGO_INITIALIZER(RangeDeleterInit)(InitializerContext* context) {
-    _deleter = new RangeDeleter(new RangeDeleterDBEnv);
+// Number of ranges deleted at the same time. Ranges of the same collection are always deleted one
+// after the other.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(rangeDeleterMaxConcurrentDeletes, int, 2);
+
+MONGO_INITIALIZER_WITH_PREREQUISITES(RangeDeleterInit,
+                                     ("EndStartupOptionStorage"))(InitializerContext* context) {
+    if (rangeDeleterMaxConcurrentDeletes < 1) {
+        return Status(ErrorCodes::BadValue, "rangeDeleterMaxConcurrentDeletes must be > 0");
+    }
+
+    _deleter = new RangeDeleter(new RangeDeleterDBEnv, rangeDeleterMaxConcurrentDeletes);
     return Status::OK();
 }
 
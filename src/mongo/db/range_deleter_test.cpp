@@ -40,6 +40,7 @@
 #include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 namespace {
@@ -362,5 +363,111 @@ TEST(MixedDeletes, MultipleDeletes) {
     deleter.stopWorkers();
 }
 
+// Ranges of different collections are deleted at the same time, while ranges of the same
+// collection wait for each other.
+TEST(QueuedDelete, ConcurrentDeletesOfDifferentCollections) {
+    const string ns1("test.user");
+    const string ns2("test.other");
+
+    RangeDeleterMockEnv* env = new RangeDeleterMockEnv();
+    RangeDeleter deleter(env, 3);
+
+    std::unique_ptr<mongo::repl::ReplicationCoordinatorMock> mock(
+        new mongo::repl::ReplicationCoordinatorMock(replSettings));
+
+    mongo::repl::ReplicationCoordinator::set(mongo::getGlobalServiceContext(), std::move(mock));
+
+    deleter.startWorkers();
+    env->pauseDeletes();
+
+    Notification notifyDone1;
+    ASSERT_TRUE(deleter.queueDelete(
+        noTxn,
+        RangeDeleterOptions(KeyRange(ns1, BSON("x" << 0), BSON("x" << 10), BSON("x" << 1))),
+        &notifyDone1,
+        NULL /* errMsg not needed */));
+
+    Notification notifyDone2;
+    ASSERT_TRUE(deleter.queueDelete(
+        noTxn,
+        RangeDeleterOptions(KeyRange(ns2, BSON("x" << 0), BSON("x" << 10), BSON("x" << 1))),
+        &notifyDone2,
+        NULL /* errMsg not needed */));
+
+    env->waitForNthPausedDelete(2u);
+    ASSERT_EQUALS(2U, deleter.getDeletesInProgress());
+
+    Notification notifyDone3;
+    ASSERT_TRUE(deleter.queueDelete(
+        noTxn,
+        RangeDeleterOptions(KeyRange(ns1, BSON("x" << 10), BSON("x" << 20), BSON("x" << 1))),
+        &notifyDone3,
+        NULL /* errMsg not needed */));
+
+    // The idle worker must leave the second range of ns1 alone.
+    sleepmillis(300);
+    ASSERT_EQUALS(1U, deleter.getPendingDeletes());
+    ASSERT_EQUALS(2U, deleter.getDeletesInProgress());
+
+    env->resumeAllDeletes();
+    notifyDone1.waitToBeNotified();
+    notifyDone2.waitToBeNotified();
+    notifyDone3.waitToBeNotified();
+
+    ASSERT_EQUALS(0U, deleter.getTotalDeletes());
+
+    deleter.stopWorkers();
+}
+
+TEST(RangeDeleterThrottle, UnlimitedNeverWaits) {
+    RangeDeleterThrottle throttle;
+    const Date_t now = Date_t::fromMillisSinceEpoch(1000);
+
+    ASSERT_EQUALS(Milliseconds(0), throttle.recordDeletes(now, 1000, 1000 * 1000, 0, 0));
+    ASSERT_EQUALS(Milliseconds(0), throttle.recordDeletes(now, 1000, 1000 * 1000, -1, 0));
+
+    BSONObjBuilder builder;
+    throttle.append(&builder);
+    const BSONObj stats = builder.obj();
+    ASSERT_EQUALS(2000, stats["deletedDocs"].numberLong());
+    ASSERT_EQUALS(2 * 1000 * 1000, stats["deletedBytes"].numberLong());
+    ASSERT_EQUALS(2, stats["deletedBatches"].numberLong());
+    ASSERT_EQUALS(0, stats["throttledMillis"].numberLong());
+}
+
+TEST(RangeDeleterThrottle, LimitsDocsPerSecond) {
+    RangeDeleterThrottle throttle;
+    const Date_t now = Date_t::fromMillisSinceEpoch(1000);
+
+    // A full second's worth of deletes may be done at once.
+    ASSERT_EQUALS(Milliseconds(0), throttle.recordDeletes(now, 100, 0, 100, 0));
+
+    // Anything more must be paid back by waiting.
+    ASSERT_EQUALS(Milliseconds(500), throttle.recordDeletes(now, 50, 0, 100, 0));
+    ASSERT_EQUALS(Milliseconds(500),
+                  throttle.recordDeletes(now + Milliseconds(500), 50, 0, 100, 0));
+
+    // The bucket refills over time, but never beyond a second's worth of deletes.
+    ASSERT_EQUALS(Milliseconds(0),
+                  throttle.recordDeletes(now + Milliseconds(10 * 1000), 100, 0, 100, 0));
+    ASSERT_EQUALS(Milliseconds(10),
+                  throttle.recordDeletes(now + Milliseconds(10 * 1000), 1, 0, 100, 0));
+
+    BSONObjBuilder builder;
+    throttle.append(&builder);
+    ASSERT_EQUALS(1010, builder.obj()["throttledMillis"].numberLong());
+}
+
+TEST(RangeDeleterThrottle, WaitsForTheMostLimitingRate) {
+    RangeDeleterThrottle throttle;
+    const Date_t now = Date_t::fromMillisSinceEpoch(1000);
+
+    ASSERT_EQUALS(Milliseconds(0), throttle.recordDeletes(now, 10, 1000, 1000, 1000));
+    ASSERT_EQUALS(Milliseconds(2000), throttle.recordDeletes(now, 10, 2000, 1000, 1000));
+
+    // Changing a limit starts over with a full bucket.
+    ASSERT_EQUALS(Milliseconds(0), throttle.recordDeletes(now, 10, 2000, 1000, 4000));
+}
+
 }  // unnamed namespace
 }  // namespace mongo
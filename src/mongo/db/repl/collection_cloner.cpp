@@ -32,6 +32,8 @@
 
 #include "mongo/db/repl/collection_cloner.h"
 
+#include "mongo/executor/remote_command_request.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -39,6 +41,22 @@
 namespace mongo {
 namespace repl {
 
+void CollectionCloner::Stats::append(Date_t now, BSONObjBuilder* builder) const {
+    const Date_t until = end == Date_t() ? now : end;
+    const long long elapsedMillis = durationCount<Milliseconds>(until - start);
+    builder->appendNumber("documentsCopied", static_cast<long long>(documentsCopied));
+    builder->appendNumber("batchesInserted", static_cast<long long>(batchesInserted));
+    builder->appendNumber("batchesQueued", static_cast<long long>(batchesQueued));
+    builder->appendDate("start", start);
+    if (end != Date_t()) {
+        builder->appendDate("end", end);
+    }
+    builder->append("elapsedMillis", elapsedMillis);
+    if (elapsedMillis > 0) {
+        builder->append("documentsPerSecond", documentsCopied * 1000.0 / elapsedMillis);
+    }
+}
+
 CollectionCloner::CollectionCloner(ReplicationExecutor* executor,
                                    const HostAndPort& source,
                                    const NamespaceString& sourceNss,
@@ -72,7 +90,12 @@ CollectionCloner::CollectionCloner(ReplicationExecutor* executor,
                               stdx::placeholders::_2,
                               stdx::placeholders::_3)),
       _indexSpecs(),
-      _documents(),
+      _maxQueuedBatches(kDefaultMaxQueuedBatches),
+      _lastBatchQueued(false),
+      _inserting(false),
+      _pausedCursorId(0),
+      _finished(false),
+      _canceled(false),
       _dbWorkCallbackHandle(),
       _scheduleDbWorkFn([this](const ReplicationExecutor::CallbackFn& work) {
           return _executor->scheduleDBWork(work);
@@ -106,6 +129,8 @@ std::string CollectionCloner::getDiagnosticString() const {
     output << " active: " << _active;
     output << " listIndexes fetcher: " << _listIndexesFetcher.getDiagnosticString();
     output << " find fetcher: " << _findFetcher.getDiagnosticString();
+    output << " queued batches: " << _batches.size();
+    output << " paused cursor: " << _pausedCursorId;
     output << " database worked callback handle: " << (_dbWorkCallbackHandle.isValid() ? "valid"
                                                                                        : "invalid");
     return output;
@@ -129,6 +154,7 @@ Status CollectionCloner::start() {
     }
 
     _active = true;
+    _stats.start = _executor->now();
 
     return Status::OK();
 }
@@ -143,6 +169,11 @@ void CollectionCloner::cancel() {
         }
 
         dbWorkCallbackHandle = _dbWorkCallbackHandle;
+
+        _canceled = true;
+        if (_getMoreFetcher) {
+            _getMoreFetcher->cancel();
+        }
     }
 
     _listIndexesFetcher.cancel();
@@ -175,6 +206,19 @@ void CollectionCloner::waitForDbWorker() {
     }
 }
 
+CollectionCloner::Stats CollectionCloner::getStats() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    Stats stats = _stats;
+    stats.batchesQueued = _batches.size();
+    return stats;
+}
+
+void CollectionCloner::setMaxQueuedBatches(size_t maxQueuedBatches) {
+    invariant(maxQueuedBatches > 0);
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _maxQueuedBatches = maxQueuedBatches;
+}
+
 void CollectionCloner::setScheduleDbWorkFn(const ScheduleDbWorkFn& scheduleDbWorkFn) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
 
@@ -229,25 +273,83 @@ void CollectionCloner::_findCallback(const StatusWith<Fetcher::QueryResponse>& f
     }
 
     auto batchData(fetchResult.getValue());
-    _documents = batchData.documents;
-
     bool lastBatch = *nextAction == Fetcher::NextAction::kNoAction;
-    auto&& scheduleResult = _scheduleDbWorkFn(stdx::bind(
-        &CollectionCloner::_insertDocumentsCallback, this, stdx::placeholders::_1, lastBatch));
-    if (!scheduleResult.isOK()) {
-        _finishCallback(nullptr, scheduleResult.getStatus());
+
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+
+    if (_finished) {
+        // Inserting an earlier batch failed. Stop reading and kill the cursor.
+        *nextAction = Fetcher::NextAction::kNoAction;
         return;
     }
 
+    _batches.push_back(std::move(batchData.documents));
+    _lastBatchQueued = lastBatch;
+
     if (*nextAction == Fetcher::NextAction::kGetMore) {
-        invariant(getMoreBob);
-        getMoreBob->append("getMore", batchData.cursorId);
-        getMoreBob->append("collection", batchData.nss.coll());
+        if (_batches.size() >= _maxQueuedBatches) {
+            // Keep the cursor open and let the database worker resume reading from it once it
+            // has inserted enough of the queued batches.
+            *nextAction = Fetcher::NextAction::kExitAndKeepCursorAlive;
+            _pausedCursorId = batchData.cursorId;
+            _pausedCursorNss = batchData.nss;
+        } else {
+            invariant(getMoreBob);
+            getMoreBob->append("getMore", batchData.cursorId);
+            getMoreBob->append("collection", batchData.nss.coll());
+        }
+    }
+
+    // The database worker inserts all queued batches before it returns.
+    if (_inserting) {
+        return;
+    }
+
+    auto&& scheduleResult = _scheduleDbWorkFn(
+        stdx::bind(&CollectionCloner::_insertDocumentsCallback, this, stdx::placeholders::_1));
+    if (!scheduleResult.isOK()) {
+        lk.unlock();
+        _finishCallback(nullptr, scheduleResult.getStatus());
+        return;
     }
 
+    _inserting = true;
     _dbWorkCallbackHandle = scheduleResult.getValue();
 }
 
+Status CollectionCloner::_resumeFind(CursorId cursorId, const NamespaceString& cursorNss) {
+    auto getMoreFetcher = stdx::make_unique<Fetcher>(
+        _executor,
+        _source,
+        _sourceNss.db().toString(),
+        BSON("getMore" << cursorId << "collection" << cursorNss.coll()),
+        stdx::bind(&CollectionCloner::_findCallback,
+                   this,
+                   stdx::placeholders::_1,
+                   stdx::placeholders::_2,
+                   stdx::placeholders::_3));
+
+    // The fetcher is scheduled under the mutex so that a concurrent cancel() either sees it or
+    // stops it from being scheduled.
+    Status scheduleStatus = Status::OK();
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        if (_finished || _canceled) {
+            return Status(ErrorCodes::CallbackCanceled,
+                          str::stream() << "collection cloner for '" << _sourceNss.ns()
+                                        << "' was stopped before resuming its cursor");
+        }
+        _getMoreFetcher.swap(getMoreFetcher);
+        scheduleStatus = _getMoreFetcher->schedule();
+    }
+
+    // The previous getMore fetcher, if any, stopped reading when the queue filled up. It is
+    // destroyed outside of the mutex because it may still be finishing its callback.
+    getMoreFetcher.reset();
+
+    return scheduleStatus;
+}
+
 void CollectionCloner::_beginCollectionCallback(const ReplicationExecutor::CallbackArgs& cbd) {
     OperationContext* txn = cbd.txn;
     if (!cbd.status.isOK()) {
@@ -268,28 +370,86 @@ void CollectionCloner::_beginCollectionCallback(const ReplicationExecutor::Callb
     }
 }
 
-void CollectionCloner::_insertDocumentsCallback(const ReplicationExecutor::CallbackArgs& cbd,
-                                                bool lastBatch) {
+void CollectionCloner::_insertDocumentsCallback(const ReplicationExecutor::CallbackArgs& cbd) {
     OperationContext* txn = cbd.txn;
     if (!cbd.status.isOK()) {
         _finishCallback(txn, cbd.status);
         return;
     }
 
-    Status status = _storageInterface->insertDocuments(txn, _destNss, _documents);
-    if (!status.isOK()) {
-        _finishCallback(txn, status);
-        return;
-    }
+    while (true) {
+        Fetcher::Documents documents;
+        CursorId resumeCursorId = 0;
+        NamespaceString resumeCursorNss;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (_batches.empty()) {
+                _inserting = false;
+                if (!_lastBatchQueued) {
+                    // The fetcher schedules the worker again when it queues the next batch.
+                    return;
+                }
+                break;
+            }
+
+            documents = std::move(_batches.front());
+            _batches.pop_front();
+
+            if (_pausedCursorId && _batches.size() < _maxQueuedBatches) {
+                resumeCursorId = _pausedCursorId;
+                resumeCursorNss = _pausedCursorNss;
+                _pausedCursorId = 0;
+            }
+        }
 
-    if (!lastBatch) {
-        return;
+        // Read the next batch from the sync source while this one is inserted.
+        if (resumeCursorId) {
+            Status resumeStatus = _resumeFind(resumeCursorId, resumeCursorNss);
+            if (!resumeStatus.isOK()) {
+                _finishCallback(txn, resumeStatus);
+                return;
+            }
+        }
+
+        Status status = _storageInterface->insertDocuments(txn, _destNss, documents);
+        if (!status.isOK()) {
+            _finishCallback(txn, status);
+            return;
+        }
+
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _stats.documentsCopied += documents.size();
+        ++_stats.batchesInserted;
     }
 
     _finishCallback(txn, Status::OK());
 }
 
 void CollectionCloner::_finishCallback(OperationContext* txn, const Status& status) {
+    CursorId pausedCursorId = 0;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        // Both the fetchers and the database worker may fail. Only the first result is
+        // reported.
+        if (_finished) {
+            return;
+        }
+        _finished = true;
+        _stats.end = _executor->now();
+        std::swap(pausedCursorId, _pausedCursorId);
+        _batches.clear();
+    }
+
+    // Nothing else will read from a cursor that was left open while the queue was full.
+    if (pausedCursorId) {
+        _executor->scheduleRemoteCommand(
+            executor::RemoteCommandRequest(_source,
+                                           _sourceNss.db().toString(),
+                                           BSON("killCursors" << _sourceNss.coll() << "cursors"
+                                                              << BSON_ARRAY(pausedCursorId))),
+            [](const ReplicationExecutor::RemoteCommandCallbackArgs& args) {});
+    }
+
     if (status.isOK()) {
         auto commitStatus = _storageInterface->commitCollection(txn, _destNss);
         if (!commitStatus.isOK()) {
@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
@@ -44,6 +45,7 @@
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
 #include "mongo/util/net/hostandport.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 namespace repl {
@@ -69,6 +71,29 @@ public:
     using ScheduleDbWorkFn = stdx::function<StatusWith<ReplicationExecutor::CallbackHandle>(
         const ReplicationExecutor::CallbackFn&)>;
 
+    /**
+     * Progress of a collection cloner.
+     */
+    struct Stats {
+        Date_t start;
+        Date_t end;
+        size_t documentsCopied = 0;
+        size_t batchesInserted = 0;
+        size_t batchesQueued = 0;
+
+        /**
+         * Appends the progress to 'builder', with the copy rate up to 'now' (or to the end of the
+         * clone, if it has completed).
+         */
+        void append(Date_t now, BSONObjBuilder* builder) const;
+    };
+
+    /**
+     * Default number of batches read from the sync source that may wait to be inserted before
+     * the cloner stops reading.
+     */
+    static const size_t kDefaultMaxQueuedBatches = 4;
+
     /**
      * Creates CollectionCloner task in inactive state. Use start() to activate cloner.
      *
@@ -99,6 +124,18 @@ public:
 
     void wait() override;
 
+    /**
+     * Returns the progress of the cloner.
+     */
+    Stats getStats() const;
+
+    /**
+     * Sets the number of batches that may wait to be inserted. Batches are read from the sync
+     * source while earlier batches are inserted; when this many are waiting, the cloner stops
+     * reading until the inserts catch up. Must be called before start().
+     */
+    void setMaxQueuedBatches(size_t maxQueuedBatches);
+
     //
     // Testing only functions below.
     //
@@ -127,12 +164,20 @@ private:
                               BSONObjBuilder* getMoreBob);
 
     /**
-     * Read collection documents from find result.
+     * Queues collection documents from find and getMore results to be inserted, and schedules
+     * the database worker to insert them if it is not already running.
+     *
+     * Stops reading from the cursor, without killing it, while the queue is full.
      */
     void _findCallback(const StatusWith<Fetcher::QueryResponse>& fetchResult,
                        Fetcher::NextAction* nextAction,
                        BSONObjBuilder* getMoreBob);
 
+    /**
+     * Resumes reading from the find cursor after the queue of batches was full.
+     */
+    Status _resumeFind(CursorId cursorId, const NamespaceString& cursorNss);
+
     /**
      * Request storage interface to create collection.
      *
@@ -145,14 +190,10 @@ private:
     void _beginCollectionCallback(const ReplicationExecutor::CallbackArgs& callbackData);
 
     /**
-     * Called multiple times if there are more than one batch of documents from the fetcher.
-     * On the last batch, 'lastBatch' will be true.
-     *
-     * Each document returned will be inserted via the storage interfaceRequest storage
-     * interface.
+     * Inserts the queued batches of documents via the storage interface until the queue is
+     * empty. Completes the clone after inserting the last batch.
      */
-    void _insertDocumentsCallback(const ReplicationExecutor::CallbackArgs& callbackData,
-                                  bool lastBatch);
+    void _insertDocumentsCallback(const ReplicationExecutor::CallbackArgs& callbackData);
 
     /**
      * Reports completion status.
@@ -189,8 +230,30 @@ private:
 
     std::vector<BSONObj> _indexSpecs;
 
-    // Current batch of documents read from fetcher to insert into collection.
-    std::vector<BSONObj> _documents;
+    // Fetches getMore batches after reading from the find cursor was stopped by a full queue.
+    std::unique_ptr<Fetcher> _getMoreFetcher;
+
+    // Batches of documents read from the fetchers, waiting to be inserted into collection.
+    std::deque<Fetcher::Documents> _batches;
+    size_t _maxQueuedBatches;
+
+    // True when the last batch of the cursor has been queued.
+    bool _lastBatchQueued;
+
+    // True while the database worker is scheduled to insert the queued batches.
+    bool _inserting;
+
+    // Set when reading from the cursor was stopped because the queue was full.
+    CursorId _pausedCursorId;
+    NamespaceString _pausedCursorNss;
+
+    // True once the clone has completed or failed.
+    bool _finished;
+
+    // True once cancel() has been called. No getMore fetcher is scheduled after that.
+    bool _canceled;
+
+    Stats _stats;
 
     // Callback handle for database worker.
     ReplicationExecutor::CallbackHandle _dbWorkCallbackHandle;
@@ -205,7 +268,7 @@ private:
  * Operation context is provided by the replication executor via the cloner.
  *
  * The storage interface is expected to acquire locks on any resources it needs
- * to perform any of its functions.
+ * to perform any of its functions. Cloners of different collections may call it concurrently.
  *
  * TODO: Consider having commit/abort/cancel functions.
  */
@@ -216,6 +279,10 @@ public:
     /**
      * Creates a collection with the provided indexes.
      *
+     * The keys of the indexes are expected to be generated from the documents as they are
+     * passed to insertDocuments(), with bulk index builders that are committed by
+     * commitCollection(), rather than in a separate pass over the collection.
+     *
      * Assume that no database locks have been acquired prior to calling this
      * function.
      */
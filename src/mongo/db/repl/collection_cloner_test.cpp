@@ -489,4 +489,47 @@ TEST_F(CollectionClonerTest, InsertDocumentsMultipleBatches) {
     ASSERT_FALSE(collectionCloner->isActive());
 }
 
+TEST_F(CollectionClonerTest, ResumeReadingAfterQueueIsFull) {
+    collectionCloner->setMaxQueuedBatches(1);
+    ASSERT_OK(collectionCloner->start());
+
+    std::vector<BSONObj> collDocuments;
+    storageInterface->insertDocumentsFn = [&](OperationContext* txn,
+                                              const NamespaceString& theNss,
+                                              const std::vector<BSONObj>& theDocuments) {
+        ASSERT(txn);
+        collDocuments.insert(collDocuments.end(), theDocuments.begin(), theDocuments.end());
+        return Status::OK();
+    };
+
+    processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+
+    collectionCloner->waitForDbWorker();
+
+    // The queue is full after the first batch, so the cloner stops reading from the cursor. The
+    // database worker resumes reading once it takes the batch off the queue.
+    const BSONObj doc = BSON("_id" << 1);
+    processNetworkResponse(createCursorResponse(1, BSON_ARRAY(doc)));
+
+    collectionCloner->waitForDbWorker();
+    ASSERT_EQUALS(1U, collDocuments.size());
+    ASSERT_EQUALS(doc, collDocuments[0]);
+    ASSERT_TRUE(collectionCloner->isActive());
+
+    const BSONObj doc2 = BSON("_id" << 2);
+    processNetworkResponse(createCursorResponse(0, BSON_ARRAY(doc2), "nextBatch"));
+
+    collectionCloner->waitForDbWorker();
+    ASSERT_EQUALS(2U, collDocuments.size());
+    ASSERT_EQUALS(doc2, collDocuments[1]);
+
+    ASSERT_OK(getStatus());
+    ASSERT_FALSE(collectionCloner->isActive());
+
+    CollectionCloner::Stats stats = collectionCloner->getStats();
+    ASSERT_EQUALS(2U, stats.documentsCopied);
+    ASSERT_EQUALS(2U, stats.batchesInserted);
+    ASSERT_EQUALS(0U, stats.batchesQueued);
+}
+
 }  // namespace
@@ -208,6 +208,7 @@ public:
     Status start();
 
     bool isActive() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
         return _active;
     }
 
@@ -216,9 +217,12 @@ public:
     }
 
     void cancel() {
-        if (!_active)
-            return;
-        _active = false;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            if (!_active)
+                return;
+            _active = false;
+        }
         // TODO: cancel all cloners
         _setStatus(Status(ErrorCodes::CallbackCanceled, "Initial Sync Cancelled."));
     }
@@ -228,6 +232,7 @@ public:
     }
 
     std::string toString() {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
         return str::stream() << "initial sync --"
                              << " active:" << _active << " status:" << _status.toString()
                              << " source:" << _source.toString()
@@ -241,6 +246,38 @@ public:
         _storage = si;
     }
 
+    /**
+     * Sets how many collections of each database are cloned at the same time, and how many
+     * fetched batches of each collection may wait to be inserted.
+     */
+    void setCollectionCloneLimits(size_t maxConcurrentCollectionClones,
+                                  size_t maxQueuedBatchesPerCollection) {
+        _maxConcurrentCollectionClones = maxConcurrentCollectionClones;
+        _maxQueuedBatchesPerCollection = maxQueuedBatchesPerCollection;
+    }
+
+    /**
+     * Appends the progress of each database cloner to 'builder'. May be called from any thread.
+     */
+    void appendStats(BSONObjBuilder* builder) {
+        std::vector<std::shared_ptr<DatabaseCloner>> databaseCloners;
+        int clonersActive;
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            databaseCloners = _databaseCloners;
+            clonersActive = _clonersActive;
+        }
+
+        // The database cloners synchronize their own statistics.
+        builder->append("databases", static_cast<int>(databaseCloners.size()));
+        builder->append("activeDatabases", clonersActive);
+        BSONObjBuilder databasesBuilder(builder->subobjStart("databaseProgress"));
+        for (auto&& dbCloner : databaseCloners) {
+            BSONObjBuilder dbBuilder(databasesBuilder.subobjStart(dbCloner->getDatabaseName()));
+            dbCloner->appendStats(&dbBuilder);
+        }
+    }
+
 private:
     /**
      * Does the next action necessary for the initial sync process.
@@ -287,19 +324,31 @@ private:
     Status _status;              // If it is not OK, we stop everything.
     ReplicationExecutor* _exec;  // executor to schedule things with
     HostAndPort _source;         // The source to use, until we get an error
-    bool _active;                // false until we start
+
+    // Protects _active, _databaseCloners and _clonersActive, which are read by appendStats()
+    // outside of the executor.
+    stdx::mutex _mutex;
+    bool _active;  // false until we start
     std::vector<std::shared_ptr<DatabaseCloner>> _databaseCloners;  // database cloners by name
     int _clonersActive;
 
     const stdx::function<void(const Status&)> _finishFn;
 
     CollectionCloner::StorageInterface* _storage;
+
+    size_t _maxConcurrentCollectionClones = 1;
+    size_t _maxQueuedBatchesPerCollection = CollectionCloner::kDefaultMaxQueuedBatches;
 };
 
 /** State held during Initial Sync */
 struct InitialSyncState {
-    InitialSyncState(DatabasesCloner cloner, Event event)
-        : dbsCloner(cloner), finishEvent(event), status(ErrorCodes::IllegalOperation, ""){};
+    InitialSyncState(ReplicationExecutor* exec,
+                     HostAndPort source,
+                     stdx::function<void(const Status&)> finishFn,
+                     Event event)
+        : dbsCloner(exec, source, finishFn),
+          finishEvent(event),
+          status(ErrorCodes::IllegalOperation, ""){};
 
     DatabasesCloner dbsCloner;  // Cloner for all databases included in initial sync.
     Timestamp beginTimestamp;   // Timestamp from the latest entry in oplog when started.
@@ -375,7 +424,10 @@ void InitialSyncState::setStatus(const CBHStatus& s) {
 
 // Initial Sync
 Status DatabasesCloner::start() {
-    _active = true;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        _active = true;
+    }
 
     if (!_status.isOK() && _status.code() != ErrorCodes::NotYetInitialized) {
         return _status;
@@ -419,7 +471,10 @@ void DatabasesCloner::_onListDatabaseFinish(const CommandCallbackArgs& cbd) {
         BSONForEach(arrayElement, dbsElem) {
             const BSONObj dbBSON = arrayElement.Obj();
             const std::string name = dbBSON["name"].str();
-            ++_clonersActive;
+            {
+                stdx::lock_guard<stdx::mutex> lk(_mutex);
+                ++_clonersActive;
+            }
             std::shared_ptr<DatabaseCloner> dbCloner{nullptr};
             try {
                 dbCloner.reset(new DatabaseCloner(
@@ -442,6 +497,11 @@ void DatabasesCloner::_onListDatabaseFinish(const CommandCallbackArgs& cbd) {
                 // error creating, fails below.
             }
 
+            if (dbCloner) {
+                dbCloner->setMaxConcurrentCollectionCloners(_maxConcurrentCollectionClones);
+                dbCloner->setMaxQueuedBatchesPerCollection(_maxQueuedBatchesPerCollection);
+            }
+
             Status s = dbCloner ? dbCloner->start() : Status(ErrorCodes::UnknownError, "Bad!");
 
             if (!s.isOK()) {
@@ -453,6 +513,7 @@ void DatabasesCloner::_onListDatabaseFinish(const CommandCallbackArgs& cbd) {
             }
 
             // add cloner to list.
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
             _databaseCloners.push_back(dbCloner);
         }
     } else {
@@ -465,7 +526,14 @@ void DatabasesCloner::_onListDatabaseFinish(const CommandCallbackArgs& cbd) {
 }
 
 void DatabasesCloner::_onEachDBCloneFinish(const Status& status, const std::string name) {
-    auto clonersLeft = --_clonersActive;
+    int clonersLeft;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        clonersLeft = --_clonersActive;
+        if (clonersLeft == 0) {
+            _active = false;
+        }
+    }
 
     if (status.isOK()) {
         log() << "database clone finished: " << name;
@@ -475,7 +543,6 @@ void DatabasesCloner::_onEachDBCloneFinish(const Status& status, const std::stri
     }
 
     if (clonersLeft == 0) {
-        _active = false;
         // All cloners are done, trigger event.
         log() << "all database clones finished, calling _finishFn";
         _finishFn(_status);
@@ -486,7 +553,7 @@ void DatabasesCloner::_onEachDBCloneFinish(const Status& status, const std::stri
 
 void DatabasesCloner::_doNextActions() {
     // If we are no longer active or we had an error, stop doing more
-    if (!(_active && _status.isOK())) {
+    if (!(isActive() && _status.isOK())) {
         if (!_status.isOK()) {
             // trigger failed state
             _failed();
@@ -606,6 +673,17 @@ std::string DataReplicator::getDiagnosticString() const {
     return out;
 }
 
+void DataReplicator::appendInitialSyncStats(BSONObjBuilder* builder) {
+    // Initial sync holds _mutex while it waits on the executor, so only the lock over
+    // _initialSyncState is taken here.
+    LockGuard lk(_initialSyncStateMutex);
+    if (!_initialSyncState || !_initialSyncState->dbsCloner.isActive()) {
+        return;
+    }
+    BSONObjBuilder initialSyncBuilder(builder->subobjStart("initialSyncStatus"));
+    _initialSyncState->dbsCloner.appendStats(&initialSyncBuilder);
+}
+
 Status DataReplicator::resume(bool wait) {
     CBHStatus handle = _exec->scheduleWork(
         stdx::bind(&DataReplicator::_resumeFinish, this, stdx::placeholders::_1));
@@ -743,14 +821,23 @@ TimestampStatus DataReplicator::initialSync() {
 
         if (attemptErrorStatus.isOK()) {
             invariant(initialSyncFinishEvent.isValid());
-            _initialSyncState.reset(new InitialSyncState(
-                DatabasesCloner(
-                    _exec,
-                    _syncSource,
-                    stdx::bind(&DataReplicator::_onDataClonerFinish, this, stdx::placeholders::_1)),
+            std::unique_ptr<InitialSyncState> initialSyncState(new InitialSyncState(
+                _exec,
+                _syncSource,
+                stdx::bind(&DataReplicator::_onDataClonerFinish, this, stdx::placeholders::_1),
                 initialSyncFinishEvent));
+            {
+                LockGuard statsLock(_initialSyncStateMutex);
+                _initialSyncState.swap(initialSyncState);
+            }
+            // The state of the previous attempt, if any, is destroyed outside of
+            // _initialSyncStateMutex.
+            initialSyncState.reset();
 
             _initialSyncState->dbsCloner.setStorageInterface(_storage);
+            _initialSyncState->dbsCloner.setCollectionCloneLimits(
+                _opts.initialSyncMaxConcurrentCollectionClones,
+                _opts.initialSyncMaxQueuedBatchesPerCollection);
             const NamespaceString ns(_opts.remoteOplogNS);
             TimestampStatus tsStatus =
                 _initialSyncState->getLatestOplogTimestamp(_exec, _syncSource, ns);
@@ -116,6 +116,10 @@ struct DataReplicatorOptions {
     Seconds blacklistSyncSourcePenaltyForNetworkConnectionError{10};
     Minutes blacklistSyncSourcePenaltyForOplogStartMissing{10};
 
+    // Initial sync cloning
+    size_t initialSyncMaxConcurrentCollectionClones = 1;
+    size_t initialSyncMaxQueuedBatchesPerCollection = CollectionCloner::kDefaultMaxQueuedBatches;
+
     // Replication settings
     NamespaceString localOplogNS = NamespaceString("local.oplog.rs");
     NamespaceString remoteOplogNS = NamespaceString("local.oplog.rs");
@@ -203,6 +207,12 @@ public:
 
     std::string getDiagnosticString() const;
 
+    /**
+     * Appends the progress of the databases cloned by initial sync to 'builder' as
+     * 'initialSyncStatus'. Appends nothing unless initial sync is cloning databases.
+     */
+    void appendInitialSyncStats(BSONObjBuilder* builder);
+
     // For testing only
 
     void _resetState_inlock(Timestamp lastAppliedOptime);
@@ -286,8 +296,12 @@ private:
     stdx::condition_variable _stateCondition;
     DataReplicatorState _state;  // (MX)
 
+    // Protects the _initialSyncState pointer, which is replaced holding both it and _mutex, so
+    // that appendInitialSyncStats() can read it without waiting for _mutex.
+    mutable stdx::mutex _initialSyncStateMutex;  // (S)
+
     // initial sync state
-    std::unique_ptr<InitialSyncState> _initialSyncState;  // (M)
+    std::unique_ptr<InitialSyncState> _initialSyncState;  // (I)
     CollectionCloner::StorageInterface* _storage;         // (M)
 
     // set during scheduling and onFinish
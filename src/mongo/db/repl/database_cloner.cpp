@@ -100,7 +100,13 @@ DatabaseCloner::DatabaseCloner(ReplicationExecutor* executor,
       _scheduleDbWorkFn([this](const ReplicationExecutor::CallbackFn& work) {
           return _executor->scheduleDBWork(work);
       }),
-      _startCollectionCloner([](CollectionCloner& cloner) { return cloner.start(); }) {
+      _startCollectionCloner([](CollectionCloner& cloner) { return cloner.start(); }),
+      _maxConcurrentCollectionCloners(1),
+      _maxQueuedBatchesPerCollection(CollectionCloner::kDefaultMaxQueuedBatches),
+      _activeCollectionCloners(0),
+      _finishedCollectionCloners(0),
+      _startStatus(Status::OK()),
+      _collectionClonersDone(false) {
     uassert(ErrorCodes::BadValue, "null replication executor", executor);
     uassert(ErrorCodes::BadValue, "empty database name", !dbname.empty());
     uassert(ErrorCodes::BadValue, "storage interface cannot be null", si);
@@ -117,6 +123,10 @@ const std::vector<BSONObj>& DatabaseCloner::getCollectionInfos() const {
     return _collectionInfos;
 }
 
+const std::string& DatabaseCloner::getDatabaseName() const {
+    return _dbname;
+}
+
 std::string DatabaseCloner::getDiagnosticString() const {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     str::stream output;
@@ -170,6 +180,39 @@ void DatabaseCloner::wait() {
     _condition.wait(lk, [this]() { return !_active; });
 }
 
+void DatabaseCloner::setMaxConcurrentCollectionCloners(size_t maxConcurrentCollectionCloners) {
+    invariant(maxConcurrentCollectionCloners > 0);
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _maxConcurrentCollectionCloners = maxConcurrentCollectionCloners;
+}
+
+void DatabaseCloner::setMaxQueuedBatchesPerCollection(size_t maxQueuedBatchesPerCollection) {
+    invariant(maxQueuedBatchesPerCollection > 0);
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _maxQueuedBatchesPerCollection = maxQueuedBatchesPerCollection;
+}
+
+void DatabaseCloner::appendStats(BSONObjBuilder* builder) const {
+    const Date_t now = _executor->now();
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    builder->appendNumber("collections", static_cast<long long>(_collectionCloners.size()));
+    builder->appendNumber("clonedCollections", static_cast<long long>(_finishedCollectionCloners));
+
+    long long documentsCopied = 0;
+    BSONObjBuilder activeBuilder;
+    for (auto&& collectionCloner : _collectionCloners) {
+        const CollectionCloner::Stats stats = collectionCloner.getStats();
+        documentsCopied += stats.documentsCopied;
+        if (stats.start != Date_t() && stats.end == Date_t()) {
+            BSONObjBuilder collectionBuilder(
+                activeBuilder.subobjStart(collectionCloner.getSourceNamespace().coll()));
+            stats.append(now, &collectionBuilder);
+        }
+    }
+    builder->appendNumber("documentsCopied", documentsCopied);
+    builder->append("activeCollections", activeBuilder.obj());
+}
+
 void DatabaseCloner::setScheduleDbWorkFn(const CollectionCloner::ScheduleDbWorkFn& work) {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
 
@@ -266,6 +309,7 @@ void DatabaseCloner::_listCollectionsCallback(const StatusWith<Fetcher::QueryRes
         auto&& nss = *_collectionNamespaces.crbegin();
 
         try {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
             _collectionCloners.emplace_back(
                 _executor,
                 _source,
@@ -280,22 +324,16 @@ void DatabaseCloner::_listCollectionsCallback(const StatusWith<Fetcher::QueryRes
         }
     }
 
-    for (auto&& collectionCloner : _collectionCloners) {
-        collectionCloner.setScheduleDbWorkFn(_scheduleDbWorkFn);
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        for (auto&& collectionCloner : _collectionCloners) {
+            collectionCloner.setScheduleDbWorkFn(_scheduleDbWorkFn);
+            collectionCloner.setMaxQueuedBatches(_maxQueuedBatchesPerCollection);
+        }
+        _nextCollectionClonerIter = _collectionCloners.begin();
     }
 
-    // Start first collection cloner.
-    _currentCollectionClonerIter = _collectionCloners.begin();
-
-    LOG(1) << "    cloning collection " << _currentCollectionClonerIter->getSourceNamespace();
-
-    Status startStatus = _startCollectionCloner(*_currentCollectionClonerIter);
-    if (!startStatus.isOK()) {
-        LOG(1) << "    failed to start collection cloning on "
-               << _currentCollectionClonerIter->getSourceNamespace() << ": " << startStatus;
-        _finishCallback(startStatus);
-        return;
-    }
+    _startCollectionCloners();
 }
 
 void DatabaseCloner::_collectionClonerCallback(const Status& status, const NamespaceString& nss) {
@@ -304,22 +342,53 @@ void DatabaseCloner::_collectionClonerCallback(const Status& status, const Names
     // from cloning the rest of the collections in the listCollections result.
     _collectionWork(status, nss);
 
-    _currentCollectionClonerIter++;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_mutex);
+        invariant(_activeCollectionCloners > 0);
+        --_activeCollectionCloners;
+        ++_finishedCollectionCloners;
+    }
+
+    _startCollectionCloners();
+}
+
+void DatabaseCloner::_startCollectionCloners() {
+    while (true) {
+        CollectionCloner* collectionCloner = nullptr;
+        Status finishStatus = Status::OK();
+        {
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            const bool startMore =
+                _startStatus.isOK() && _nextCollectionClonerIter != _collectionCloners.end();
+            if (startMore && _activeCollectionCloners < _maxConcurrentCollectionCloners) {
+                collectionCloner = &*_nextCollectionClonerIter++;
+                ++_activeCollectionCloners;
+            } else if (!startMore && _activeCollectionCloners == 0 && !_collectionClonersDone) {
+                _collectionClonersDone = true;
+                finishStatus = _startStatus;
+            } else {
+                return;
+            }
+        }
 
-    LOG(1) << "    cloning collection " << _currentCollectionClonerIter->getSourceNamespace();
+        if (!collectionCloner) {
+            _finishCallback(finishStatus);
+            return;
+        }
 
-    if (_currentCollectionClonerIter != _collectionCloners.end()) {
-        Status startStatus = _startCollectionCloner(*_currentCollectionClonerIter);
+        LOG(1) << "    cloning collection " << collectionCloner->getSourceNamespace();
+
+        Status startStatus = _startCollectionCloner(*collectionCloner);
         if (!startStatus.isOK()) {
             LOG(1) << "    failed to start collection cloning on "
-                   << _currentCollectionClonerIter->getSourceNamespace() << ": " << startStatus;
-            _finishCallback(startStatus);
-            return;
+                   << collectionCloner->getSourceNamespace() << ": " << startStatus;
+            stdx::lock_guard<stdx::mutex> lk(_mutex);
+            --_activeCollectionCloners;
+            if (_startStatus.isOK()) {
+                _startStatus = startStatus;
+            }
         }
-        return;
     }
-
-    _finishCallback(Status::OK());
 }
 
 void DatabaseCloner::_finishCallback(const Status& status) {
@@ -70,6 +70,8 @@ public:
      *     - source namespace of the collection cloner that completed (or failed).
      *
      * Called exactly once for every collection cloner started by the the database cloner.
+     * Collection cloners run concurrently if setMaxConcurrentCollectionCloners() allows it, in
+     * which case this may be called from different threads at the same time.
      */
     using CollectionCallbackFn = stdx::function<void(const Status&, const NamespaceString&)>;
 
@@ -105,6 +107,8 @@ public:
      */
     const std::vector<BSONObj>& getCollectionInfos() const;
 
+    const std::string& getDatabaseName() const;
+
     std::string getDiagnosticString() const override;
 
     bool isActive() const override;
@@ -115,6 +119,32 @@ public:
 
     void wait() override;
 
+    /**
+     * Sets how many collections are cloned at the same time. Defaults to 1. Must be called
+     * before start().
+     */
+    void setMaxConcurrentCollectionCloners(size_t maxConcurrentCollectionCloners);
+
+    /**
+     * Sets the number of batches each collection cloner may queue for insertion. Must be called
+     * before start().
+     */
+    void setMaxQueuedBatchesPerCollection(size_t maxQueuedBatchesPerCollection);
+
+    /**
+     * Appends the progress of the collection cloners to 'builder', in the format:
+     * {
+     *     collections: <number of collections to clone>,
+     *     clonedCollections: <number of completed collection cloners>,
+     *     documentsCopied: <total over all collections>,
+     *     activeCollections: {
+     *         <collection name>: <CollectionCloner::Stats>,
+     *         ...
+     *     }
+     * }
+     */
+    void appendStats(BSONObjBuilder* builder) const;
+
     //
     // Testing only functions below.
     //
@@ -147,6 +177,12 @@ private:
      */
     void _collectionClonerCallback(const Status& status, const NamespaceString& nss);
 
+    /**
+     * Starts collection cloners until the maximum number of them are active or all of them
+     * have been started. Reports completion once every started collection cloner has finished.
+     */
+    void _startCollectionCloners();
+
     /**
      * Reports completion status.
      * Sets cloner to inactive.
@@ -191,7 +227,20 @@ private:
     std::vector<NamespaceString> _collectionNamespaces;
 
     std::list<CollectionCloner> _collectionCloners;
-    std::list<CollectionCloner>::iterator _currentCollectionClonerIter;
+
+    // Next collection cloner to start.
+    std::list<CollectionCloner>::iterator _nextCollectionClonerIter;
+
+    size_t _maxConcurrentCollectionCloners;
+    size_t _maxQueuedBatchesPerCollection;
+    size_t _activeCollectionCloners;
+    size_t _finishedCollectionCloners;
+
+    // First failure to start a collection cloner. No more cloners are started after it.
+    Status _startStatus;
+
+    // Set once completion has been reported.
+    bool _collectionClonersDone;
 
     // Function for scheduling database work using the executor.
     CollectionCloner::ScheduleDbWorkFn _scheduleDbWorkFn;
@@ -529,4 +529,54 @@ TEST_F(DatabaseClonerTest, CreateCollections) {
     }
 }
 
+TEST_F(DatabaseClonerTest, CloneCollectionsConcurrently) {
+    databaseCloner->setMaxConcurrentCollectionCloners(2);
+    ASSERT_OK(databaseCloner->start());
+
+    // Replace scheduleDbWork function so that all callbacks (including exclusive tasks)
+    // will run through network interface.
+    auto&& executor = getReplExecutor();
+    databaseCloner->setScheduleDbWorkFn([&](const ReplicationExecutor::CallbackFn& workFn) {
+        return executor.scheduleWork(workFn);
+    });
+
+    const std::vector<BSONObj> sourceInfos = {BSON("name"
+                                                   << "a"
+                                                   << "options" << BSONObj()),
+                                              BSON("name"
+                                                   << "b"
+                                                   << "options" << BSONObj())};
+    processNetworkResponse(
+        createListCollectionsResponse(0, BSON_ARRAY(sourceInfos[0] << sourceInfos[1])));
+
+    // Both collection cloners are started, so the listIndexes commands of both collections are
+    // sent before the find command of the first collection.
+    processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+    processNetworkResponse(createListIndexesResponse(0, BSON_ARRAY(idIndexSpec)));
+
+    BSONObjBuilder statsBuilder;
+    databaseCloner->appendStats(&statsBuilder);
+    const BSONObj stats = statsBuilder.obj();
+    ASSERT_EQUALS(2, stats["collections"].numberInt());
+    ASSERT_EQUALS(0, stats["clonedCollections"].numberInt());
+    ASSERT_TRUE(stats["activeCollections"].Obj().hasField("a"));
+    ASSERT_TRUE(stats["activeCollections"].Obj().hasField("b"));
+
+    processNetworkResponse(createCursorResponse(0, BSONArray()));
+    processNetworkResponse(createCursorResponse(0, BSONArray()));
+
+    ASSERT_OK(getStatus());
+    ASSERT_FALSE(databaseCloner->isActive());
+
+    ASSERT_EQUALS(2U, collectionWorkResults.size());
+    {
+        auto i = collectionWorkResults.cbegin();
+        ASSERT_OK(i->first);
+        ASSERT_EQUALS(i->second.ns(), NamespaceString(dbname, "a").ns());
+        i++;
+        ASSERT_OK(i->first);
+        ASSERT_EQUALS(i->second.ns(), NamespaceString(dbname, "b").ns());
+    }
+}
+
 }  // namespace
@@ -69,6 +69,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/old_thread_pool.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
 
@@ -42,5 +42,24 @@ MONGO_INITIALIZER(maxSyncSourceLagSecsCheck)(InitializerContext*) {
     }
     return Status::OK();
 }
+
+// Number of collections of each database that initial sync clones at the same time.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(initialSyncMaxConcurrentCollectionClones, int, 4);
+MONGO_INITIALIZER(initialSyncMaxConcurrentCollectionClonesCheck)(InitializerContext*) {
+    if (initialSyncMaxConcurrentCollectionClones < 1) {
+        return Status(ErrorCodes::BadValue, "initialSyncMaxConcurrentCollectionClones must be > 0");
+    }
+    return Status::OK();
+}
+
+// Number of fetched batches of each collection that may wait to be inserted during initial sync.
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(initialSyncMaxQueuedBatchesPerCollection, int, 4);
+MONGO_INITIALIZER(initialSyncMaxQueuedBatchesPerCollectionCheck)(InitializerContext*) {
+    if (initialSyncMaxQueuedBatchesPerCollection < 1) {
+        return Status(ErrorCodes::BadValue,
+                      "initialSyncMaxQueuedBatchesPerCollection must be > 0");
+    }
+    return Status::OK();
+}
 }
 }
@@ -169,6 +169,10 @@ DataReplicatorOptions createDataReplicatorOptions(ReplicationCoordinator* replCo
     options.setFollowerMode =
         [replCoord](const MemberState& newState) { return replCoord->setFollowerMode(newState); };
     options.syncSourceSelector = replCoord;
+    options.initialSyncMaxConcurrentCollectionClones =
+        static_cast<size_t>(initialSyncMaxConcurrentCollectionClones);
+    options.initialSyncMaxQueuedBatchesPerCollection =
+        static_cast<size_t>(initialSyncMaxQueuedBatchesPerCollection);
     return options;
 }
 }  // namespace
@@ -1498,6 +1502,10 @@ Status ReplicationCoordinatorImpl::processReplSetGetStatus(BSONObjBuilder* respo
     fassert(18640, cbh.getStatus());
     _replExecutor.wait(cbh.getValue());
 
+    if (result.isOK()) {
+        _dr.appendInitialSyncStats(response);
+    }
+
     return result;
 }
 
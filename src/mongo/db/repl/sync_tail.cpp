@@ -38,16 +38,19 @@
 #include "third_party/murmurhash3/MurmurHash3.h"
 
 #include "mongo/base/counter.h"
+#include "mongo/base/parse_number.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/prefetch.h"
@@ -58,27 +61,139 @@
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/replica_set_config.h"
 #include "mongo/db/repl/replication_coordinator_global.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
 using std::endl;
 
 namespace repl {
+namespace {
+
 #if defined(MONGO_PLATFORM_64)
-const int replWriterThreadCount = 16;
-const int replPrefetcherThreadCount = 16;
+const int kDefaultReplThreadCount = 16;
+const int kMaxAutoReplWriterThreadCount = 256;
 #elif defined(MONGO_PLATFORM_32)
-const int replWriterThreadCount = 2;
-const int replPrefetcherThreadCount = 2;
+const int kDefaultReplThreadCount = 2;
+const int kMaxAutoReplWriterThreadCount = 2;
 #else
 #error need to include something that defines MONGO_PLATFORM_XX
 #endif
 
+// Upper bound on the size of the writer and prefetcher pools.
+const int kMaxReplThreadCount = 256;
+
+/**
+ * Server parameter holding the configured size of one of the replication thread pools, where 0
+ * means the size is chosen automatically. Changes made at runtime take effect from the next batch.
+ */
+class ReplThreadCountParameter : public ServerParameter {
+    MONGO_DISALLOW_COPYING(ReplThreadCountParameter);
+
+public:
+    explicit ReplThreadCountParameter(const std::string& name)
+        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true) {}
+
+    virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+        b.append(name, _value.load());
+    }
+
+    virtual Status set(const BSONElement& newValueElement) {
+        if (!newValueElement.isNumber())
+            return Status(ErrorCodes::BadValue, str::stream() << name() << " has to be a number");
+        return _set(newValueElement.numberInt());
+    }
+
+    virtual Status setFromString(const std::string& str) {
+        int num = 0;
+        Status status = parseNumberFromString(str, &num);
+        if (!status.isOK())
+            return status;
+        return _set(num);
+    }
+
+    int get() const {
+        return _value.load();
+    }
+
+private:
+    Status _set(int newNum) {
+        if (newNum < 0 || newNum > kMaxReplThreadCount) {
+            return Status(ErrorCodes::BadValue,
+                          str::stream() << name() << " must be between 0 (automatic) and "
+                                        << kMaxReplThreadCount);
+        }
+        _value.store(newNum);
+        return Status::OK();
+    }
+
+    AtomicInt32 _value{0};
+};
+
+ReplThreadCountParameter replWriterThreadCountParam("replWriterThreadCount");
+ReplThreadCountParameter replPrefetcherThreadCountParam("replPrefetcherThreadCount");
+
+/**
+ * Returns the number of threads the writer pool should have. Automatic sizing only goes beyond
+ * the default with document level locking, as otherwise writers to the same collection contend
+ * on its lock.
+ */
+int getReplWriterThreadCount() {
+    const int configured = replWriterThreadCountParam.get();
+    if (configured > 0) {
+        return configured;
+    }
+
+    if (!getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking()) {
+        return kDefaultReplThreadCount;
+    }
+
+    const int numCores = ProcessInfo().getNumCores();
+    return std::min(kMaxAutoReplWriterThreadCount,
+                    std::max(kDefaultReplThreadCount, 2 * numCores));
+}
+
+int getReplPrefetcherThreadCount() {
+    const int configured = replPrefetcherThreadCountParam.get();
+    return configured > 0 ? configured : kDefaultReplThreadCount;
+}
+
+/**
+ * Returns "pool" if it has "numThreads" threads, otherwise replaces it with a new pool of that
+ * size, after waiting for the tasks on the old pool to complete.
+ */
+ThreadPool* resizeReplThreadPool(std::unique_ptr<ThreadPool>* pool,
+                                 int numThreads,
+                                 const std::string& threadNamePrefix) {
+    if (*pool && (*pool)->getStats().options.maxThreads == static_cast<size_t>(numThreads)) {
+        return pool->get();
+    }
+
+    if (*pool) {
+        log() << "resizing " << threadNamePrefix << "pool to " << numThreads << " threads";
+        (*pool)->shutdown();
+        (*pool)->join();
+    }
+
+    ThreadPool::Options options;
+    options.threadNamePrefix = threadNamePrefix;
+    options.poolName = str::stream() << threadNamePrefix << "Pool";
+    options.minThreads = options.maxThreads = static_cast<size_t>(numThreads);
+    pool->reset(new ThreadPool(options));
+    (*pool)->startup();
+    return pool->get();
+}
+
+}  // namespace
+
 static Counter64 opsAppliedStats;
 
 // The oplog entries applied
@@ -90,6 +205,55 @@ MONGO_FP_DECLARE(rsSyncApplyStop);
 static TimerStats applyBatchStats;
 static ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches",
                                                                    &applyBatchStats);
+
+namespace {
+
+/**
+ * Statistics for the operations applied by one of the writer threads.
+ */
+struct ReplWriterStats {
+    // Number of operations in the most recent batch assigned to this writer.
+    AtomicInt64 lastBatchOps;
+    // Time this writer spent applying its most recent batch.
+    AtomicInt64 lastBatchMicros;
+    AtomicInt64 totalOps;
+    AtomicInt64 totalMicros;
+};
+
+ReplWriterStats replWriterStats[kMaxReplThreadCount];
+
+// Number of writer threads used for the most recent batch.
+AtomicInt32 replWriterStatsCount;
+
+/**
+ * Reports per-writer queue depths and apply latencies under metrics.repl.apply.writers.
+ */
+class ReplWriterStatsMetric : public ServerStatusMetric {
+public:
+    ReplWriterStatsMetric() : ServerStatusMetric("repl.apply.writers") {}
+
+    virtual void appendAtLeaf(BSONObjBuilder& b) const {
+        BSONArrayBuilder writers(b.subarrayStart(_leafName));
+        const int count = replWriterStatsCount.load();
+        for (int i = 0; i < count; ++i) {
+            const ReplWriterStats& stats = replWriterStats[i];
+            BSONObjBuilder writer(writers.subobjStart());
+            writer.appendNumber("lastBatchOps", stats.lastBatchOps.load());
+            writer.appendNumber("lastBatchMicros", stats.lastBatchMicros.load());
+            writer.appendNumber("totalOps", stats.totalOps.load());
+            writer.appendNumber("totalMicros", stats.totalMicros.load());
+        }
+    }
+} replWriterStatsMetric;
+
+// Number of CRUD operations which had to be serialized by namespace rather than partitioned
+// across writers by _id.
+Counter64 opsSerializedByNamespace;
+ServerStatusMetricField<Counter64> displayOpsSerializedByNamespace(
+    "repl.apply.opsSerializedByNamespace", &opsSerializedByNamespace);
+
+}  // namespace
+
 void initializePrefetchThread() {
     if (!ClientBasic::getCurrent()) {
         Client::initThreadIfNotAlready();
@@ -109,13 +273,19 @@ bool isCrudOpType(const char* field) {
 }
 
 SyncTail::SyncTail(BackgroundSyncInterface* q, MultiSyncApplyFunc func)
-    : _networkQueue(q),
-      _applyFunc(func),
-      _writerPool(replWriterThreadCount, "repl writer worker "),
-      _prefetcherPool(replPrefetcherThreadCount, "repl prefetch worker ") {}
+    : _networkQueue(q), _applyFunc(func) {}
 
 SyncTail::~SyncTail() {}
 
+ThreadPool* SyncTail::_getWriterPool() {
+    return resizeReplThreadPool(&_writerPool, getReplWriterThreadCount(), "repl writer worker ");
+}
+
+ThreadPool* SyncTail::_getPrefetcherPool() {
+    return resizeReplThreadPool(
+        &_prefetcherPool, getReplPrefetcherThreadCount(), "repl prefetch worker ");
+}
+
 bool SyncTail::peek(BSONObj* op) {
     return _networkQueue->peek(op);
 }
@@ -270,32 +440,82 @@ void prefetchOp(const BSONObj& op) {
 }
 
 // Doles out all the work to the reader pool threads and waits for them to complete
-void prefetchOps(const std::deque<BSONObj>& ops, OldThreadPool* prefetcherPool) {
+void prefetchOps(const std::deque<BSONObj>& ops, ThreadPool* prefetcherPool) {
     invariant(prefetcherPool);
     for (std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
-        prefetcherPool->schedule(&prefetchOp, *it);
+        const BSONObj& op = *it;
+        fassert(28751, prefetcherPool->schedule([op] { prefetchOp(op); }));
     }
-    prefetcherPool->join();
+    prefetcherPool->waitForIdle();
 }
 
 // Doles out all the work to the writer pool threads and waits for them to complete
 void applyOps(const std::vector<std::vector<BSONObj>>& writerVectors,
-              OldThreadPool* writerPool,
+              ThreadPool* writerPool,
               SyncTail::MultiSyncApplyFunc func,
               SyncTail* sync) {
     TimerHolder timer(&applyBatchStats);
-    for (std::vector<std::vector<BSONObj>>::const_iterator it = writerVectors.begin();
-         it != writerVectors.end();
-         ++it) {
-        if (!it->empty()) {
-            writerPool->schedule(func, stdx::cref(*it), sync);
+    invariant(writerVectors.size() <= static_cast<size_t>(kMaxReplThreadCount));
+    replWriterStatsCount.store(writerVectors.size());
+    for (size_t i = 0; i < writerVectors.size(); ++i) {
+        const std::vector<BSONObj>& ops = writerVectors[i];
+        ReplWriterStats* stats = &replWriterStats[i];
+        stats->lastBatchOps.store(ops.size());
+        if (ops.empty()) {
+            stats->lastBatchMicros.store(0);
+            continue;
+        }
+
+        fassert(28752,
+                writerPool->schedule([&ops, stats, func, sync] {
+                    Timer applyTimer;
+                    func(ops, sync);
+                    const long long micros = applyTimer.micros();
+                    stats->lastBatchMicros.store(micros);
+                    stats->totalMicros.fetchAndAdd(micros);
+                    stats->totalOps.fetchAndAdd(ops.size());
+                }));
+    }
+    writerPool->waitForIdle();
+}
+
+}  // namespace
+
+bool SyncTail::canPartitionById(OperationContext* txn, StringData ns) {
+    AutoGetDb autoDb(txn, ns, MODE_IS);
+    Lock::CollectionLock collLock(txn->lockState(), ns, MODE_IS);
+    Database* db = autoDb.getDb();
+    Collection* collection = db ? db->getCollection(ns) : nullptr;
+    if (!collection) {
+        // Ops on a collection which does not exist yet can only be inserts which implicitly create
+        // it, and the first of those must not race with the others.
+        return false;
+    }
+
+    if (collection->isCapped()) {
+        return false;
+    }
+
+    IndexCatalog::IndexIterator it =
+        collection->getIndexCatalog()->getIndexIterator(txn, true /* includeUnfinishedIndexes */);
+    while (it.more()) {
+        const IndexDescriptor* desc = it.next();
+        if (desc->unique() && !desc->isIdIndex()) {
+            return false;
         }
     }
-    writerPool->join();
+    return true;
 }
 
-void fillWriterVectors(const std::deque<BSONObj>& ops,
-                       std::vector<std::vector<BSONObj>>* writerVectors) {
+void SyncTail::fillWriterVectors(OperationContext* txn,
+                                 const std::deque<BSONObj>& ops,
+                                 std::vector<std::vector<BSONObj>>* writerVectors) {
+    const bool supportsDocLocking =
+        getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking();
+
+    // Whether each namespace in the batch can be partitioned by _id, determined once per batch.
+    StringMap<bool> partitionableNamespaces;
+
     for (std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
         const BSONElement e = it->getField("ns");
         verify(e.type() == String);
@@ -306,35 +526,45 @@ void fillWriterVectors(const std::deque<BSONObj>& ops,
 
         const char* opType = it->getField("op").valuestrsafe();
 
-        if (getGlobalServiceContext()->getGlobalStorageEngine()->supportsDocLocking() &&
-            isCrudOpType(opType)) {
-            BSONElement id;
-            switch (opType[0]) {
-                case 'u':
-                    id = it->getField("o2").Obj()["_id"];
-                    break;
-                case 'd':
-                case 'i':
-                    id = it->getField("o").Obj()["_id"];
-                    break;
+        if (supportsDocLocking && isCrudOpType(opType)) {
+            bool partitionable;
+            auto cached = partitionableNamespaces.find(ns);
+            if (cached == partitionableNamespaces.end()) {
+                partitionable = canPartitionById(txn, ns);
+                partitionableNamespaces[ns] = partitionable;
+            } else {
+                partitionable = cached->second;
             }
 
-            const size_t idHash = BSONElement::Hasher()(id);
-            MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+            if (partitionable) {
+                BSONElement id;
+                switch (opType[0]) {
+                    case 'u':
+                        id = it->getField("o2").Obj()["_id"];
+                        break;
+                    case 'd':
+                    case 'i':
+                        id = it->getField("o").Obj()["_id"];
+                        break;
+                }
+
+                const size_t idHash = BSONElement::Hasher()(id);
+                MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+            } else {
+                opsSerializedByNamespace.increment();
+            }
         }
 
         (*writerVectors)[hash % writerVectors->size()].push_back(*it);
     }
 }
 
-}  // namespace
-
 // Doles out all the work to the writer pool threads and waits for them to complete
 // static
 OpTime SyncTail::multiApply(OperationContext* txn,
                             const OpQueue& ops,
-                            OldThreadPool* prefetcherPool,
-                            OldThreadPool* writerPool,
+                            ThreadPool* prefetcherPool,
+                            ThreadPool* writerPool,
                             MultiSyncApplyFunc func,
                             SyncTail* sync,
                             bool supportsWaitingUntilDurable) {
@@ -348,9 +578,10 @@ OpTime SyncTail::multiApply(OperationContext* txn,
         prefetchOps(ops.getDeque(), prefetcherPool);
     }
 
-    std::vector<std::vector<BSONObj>> writerVectors(replWriterThreadCount);
+    // One writer vector per thread in the pool.
+    std::vector<std::vector<BSONObj>> writerVectors(writerPool->getStats().options.maxThreads);
 
-    fillWriterVectors(ops.getDeque(), &writerVectors);
+    fillWriterVectors(txn, ops.getDeque(), &writerVectors);
     LOG(2) << "replication batch size is " << ops.getDeque().size() << endl;
     // We must grab this because we're going to grab write locks later.
     // We hold this mutex the entire time we're writing; it doesn't matter
@@ -441,8 +672,8 @@ void SyncTail::_applyOplogUntil(OperationContext* txn, const OpTime& endOpTime)
 
         const OpTime lastOpTime = multiApply(txn,
                                              ops,
-                                             &_prefetcherPool,
-                                             &_writerPool,
+                                             _getPrefetcherPool(),
+                                             _getWriterPool(),
                                              _applyFunc,
                                              this,
                                              supportsWaitingUntilDurable());
@@ -573,8 +804,8 @@ void SyncTail::oplogApplication() {
         setMinValid(&txn, extractOpTime(lastOp));
         multiApply(&txn,
                    ops,
-                   &_prefetcherPool,
-                   &_writerPool,
+                   _getPrefetcherPool(),
+                   _getWriterPool(),
                    _applyFunc,
                    this,
                    supportsWaitingUntilDurable());
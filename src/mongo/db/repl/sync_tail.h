@@ -29,12 +29,15 @@
 #pragma once
 
 #include <deque>
+#include <memory>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/db/storage/mmap_v1/dur.h"
 #include "mongo/stdx/functional.h"
-#include "mongo/util/concurrency/old_thread_pool.h"
+#include "mongo/util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -144,6 +147,26 @@ public:
     virtual bool shouldRetry(OperationContext* txn, const BSONObj& o);
     void setHostname(const std::string& hostname);
 
+    /**
+     * Partitions a batch of operations across the writer vectors.
+     *
+     * Operations on the same namespace are kept in order by assigning them to the same writer.
+     * When the storage engine supports document level locking, CRUD operations on a collection
+     * are instead partitioned by document _id if canPartitionById() allows it, so that a write
+     * heavy collection does not serialize onto a single writer.
+     */
+    static void fillWriterVectors(OperationContext* txn,
+                                  const std::deque<BSONObj>& ops,
+                                  std::vector<std::vector<BSONObj>>* writerVectors);
+
+    /**
+     * Returns whether operations on different documents of the collection "ns" may be applied
+     * out of order with respect to each other. This is not the case for capped collections, whose
+     * natural order is their insertion order, or for collections with unique secondary indexes,
+     * where reordering can produce spurious duplicate key errors.
+     */
+    static bool canPartitionById(OperationContext* txn, StringData ns);
+
 protected:
     // Cap the batches using the limit on journal commits.
     // This works out to be 100 MB (64 bit) or 50 MB (32 bit)
@@ -162,8 +185,8 @@ protected:
     // Returns the last OpTime applied.
     static OpTime multiApply(OperationContext* txn,
                              const OpQueue& ops,
-                             OldThreadPool* prefetcherPool,
-                             OldThreadPool* writerPool,
+                             ThreadPool* prefetcherPool,
+                             ThreadPool* writerPool,
                              MultiSyncApplyFunc func,
                              SyncTail* sync,
                              bool supportsAwaitingCommit);
@@ -185,10 +208,17 @@ private:
 
     void handleSlaveDelay(const BSONObj& op);
 
+    /**
+     * Return the writer and prefetcher pools, creating them or replacing them with pools of the
+     * currently configured size as needed. Must only be called between batches.
+     */
+    ThreadPool* _getWriterPool();
+    ThreadPool* _getPrefetcherPool();
+
     // persistent pool of worker threads for writing ops to the databases
-    OldThreadPool _writerPool;
+    std::unique_ptr<ThreadPool> _writerPool;
     // persistent pool of worker threads for prefetching
-    OldThreadPool _prefetcherPool;
+    std::unique_ptr<ThreadPool> _prefetcherPool;
 };
 
 // These free functions are used by the thread pool workers to write ops to the db.
@@ -30,9 +30,12 @@
 
 #include <memory>
 
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/document_validation.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/client.h"
@@ -357,4 +360,95 @@ TEST_F(SyncTailTest, SyncApplyCommandThrowsException) {
     ASSERT_EQUALS(1U, _opsApplied);
 }
 
+/**
+ * Creates the collection "ns" with the given options and, if 'indexSpec' is not empty, an
+ * additional index.
+ */
+void createCollection(OperationContext* txn,
+                      StringData ns,
+                      const CollectionOptions& options,
+                      const BSONObj& indexSpec) {
+    Lock::GlobalWrite globalLock(txn->lockState());
+    bool justCreated = false;
+    Database* db = dbHolder().openDb(txn, nsToDatabaseSubstring(ns), &justCreated);
+    ASSERT_TRUE(db);
+    Collection* collection = db->createCollection(txn, ns, options);
+    ASSERT_TRUE(collection);
+    if (!indexSpec.isEmpty()) {
+        ASSERT_OK(collection->getIndexCatalog()->createIndexOnEmptyCollection(txn, indexSpec));
+    }
+}
+
+/**
+ * Returns the number of writer vectors which were assigned at least one of 100 inserts into
+ * "ns" with distinct _ids.
+ */
+size_t countWritersUsedForInserts(OperationContext* txn, StringData ns) {
+    std::deque<BSONObj> ops;
+    for (int i = 0; i < 100; ++i) {
+        ops.push_back(BSON("op"
+                           << "i"
+                           << "ns" << ns << "o" << BSON("_id" << i << "x" << i)));
+    }
+
+    std::vector<std::vector<BSONObj>> writerVectors(8);
+    SyncTail::fillWriterVectors(txn, ops, &writerVectors);
+
+    size_t writersUsed = 0;
+    size_t opsAssigned = 0;
+    for (const auto& writerVector : writerVectors) {
+        if (!writerVector.empty()) {
+            ++writersUsed;
+        }
+        opsAssigned += writerVector.size();
+    }
+    ASSERT_EQUALS(ops.size(), opsAssigned);
+    return writersUsed;
+}
+
+// The catalog persists across tests, so each of these tests uses a collection of its own.
+const std::string kNonUniqueNs = "test.fillWriterVectorsNonUnique";
+const std::string kUniqueNs = "test.fillWriterVectorsUnique";
+const std::string kCappedNs = "test.fillWriterVectorsCapped";
+const std::string kMissingNs = "test.fillWriterVectorsMissing";
+
+TEST_F(SyncTailTest, FillWriterVectorsPartitionsByIdWithoutUniqueSecondaryIndexes) {
+    createCollection(_txn.get(),
+                     kNonUniqueNs,
+                     CollectionOptions(),
+                     BSON("v" << 1 << "key" << BSON("x" << 1) << "name"
+                              << "x_1"
+                              << "ns"
+                              << kNonUniqueNs));
+    ASSERT_TRUE(SyncTail::canPartitionById(_txn.get(), kNonUniqueNs));
+    ASSERT_GREATER_THAN(countWritersUsedForInserts(_txn.get(), kNonUniqueNs), 1U);
+}
+
+TEST_F(SyncTailTest, FillWriterVectorsSerializesCollectionWithUniqueSecondaryIndex) {
+    createCollection(_txn.get(),
+                     kUniqueNs,
+                     CollectionOptions(),
+                     BSON("v" << 1 << "key" << BSON("x" << 1) << "name"
+                              << "x_1"
+                              << "ns"
+                              << kUniqueNs
+                              << "unique" << true));
+    ASSERT_FALSE(SyncTail::canPartitionById(_txn.get(), kUniqueNs));
+    ASSERT_EQUALS(1U, countWritersUsedForInserts(_txn.get(), kUniqueNs));
+}
+
+TEST_F(SyncTailTest, FillWriterVectorsSerializesCappedCollection) {
+    CollectionOptions options;
+    options.capped = true;
+    options.cappedSize = 1024 * 1024;
+    createCollection(_txn.get(), kCappedNs, options, BSONObj());
+    ASSERT_FALSE(SyncTail::canPartitionById(_txn.get(), kCappedNs));
+    ASSERT_EQUALS(1U, countWritersUsedForInserts(_txn.get(), kCappedNs));
+}
+
+TEST_F(SyncTailTest, FillWriterVectorsSerializesMissingCollection) {
+    ASSERT_FALSE(SyncTail::canPartitionById(_txn.get(), kMissingNs));
+    ASSERT_EQUALS(1U, countWritersUsedForInserts(_txn.get(), kMissingNs));
+}
+
 }  // namespace
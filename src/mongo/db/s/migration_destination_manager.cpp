@@ -43,6 +43,7 @@
 #include "mongo/db/catalog/document_validation.h"
 #include "mongo/db/catalog/index_create.h"
 #include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbhelpers.h"
@@ -75,6 +76,10 @@ namespace {
 
 Tee* migrateLog = RamLog::get("migrate");
 
+// Bounds on the number of cloned documents inserted under one collection lock and unit of work.
+const size_t kMaxClonedDocumentsPerInsertBatch = 100;
+const long long kMaxClonedBytesPerInsertBatch = 1024 * 1024;
+
 /**
  * Returns a human-readabale name of the migration manager's state.
  */
@@ -574,11 +579,17 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
                 return;
             }
 
-            BSONObj arr = res["objects"].Obj();
-            int thisTime = 0;
-
-            BSONObjIterator i(arr);
+            std::vector<BSONObj> docs;
+            BSONObjIterator i(res["objects"].Obj());
             while (i.more()) {
+                docs.push_back(i.next().Obj());
+            }
+
+            if (docs.empty())
+                break;
+
+            std::vector<BSONObj>::const_iterator docsIter = docs.begin();
+            while (docsIter != docs.end()) {
                 txn->checkForInterrupt();
 
                 if (getState() == ABORT) {
@@ -588,32 +599,8 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
                     return;
                 }
 
-                BSONObj docToClone = i.next().Obj();
-                {
-                    OldClientWriteContext cx(txn, ns);
-
-                    BSONObj localDoc;
-                    if (willOverrideLocalId(
-                            txn, ns, min, max, shardKeyPattern, cx.db(), docToClone, &localDoc)) {
-                        string errMsg = str::stream() << "cannot migrate chunk, local document "
-                                                      << localDoc << " has same _id as cloned "
-                                                      << "remote document " << docToClone;
-
-                        warning() << errMsg;
-
-                        // Exception will abort migration cleanly
-                        uasserted(16976, errMsg);
-                    }
-
-                    Helpers::upsert(txn, ns, docToClone, true);
-                }
-                thisTime++;
-
-                {
-                    stdx::lock_guard<stdx::mutex> statsLock(_mutex);
-                    _numCloned++;
-                    _clonedBytes += docToClone.objsize();
-                }
+                docsIter = _insertClonedDocuments(
+                    txn, ns, min, max, shardKeyPattern, docsIter, docs.end());
 
                 if (writeConcern.shouldWaitForOtherNodes()) {
                     repl::ReplicationCoordinator::StatusAndDuration replStatus =
@@ -629,9 +616,6 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
                     }
                 }
             }
-
-            if (thisTime == 0)
-                break;
         }
 
         timing.done(3);
@@ -795,6 +779,79 @@ void MigrationDestinationManager::_migrateDriver(OperationContext* txn,
     conn.done();
 }
 
+std::vector<BSONObj>::const_iterator MigrationDestinationManager::_insertClonedDocuments(
+    OperationContext* txn,
+    const string& ns,
+    const BSONObj& min,
+    const BSONObj& max,
+    const BSONObj& shardKeyPattern,
+    std::vector<BSONObj>::const_iterator begin,
+    std::vector<BSONObj>::const_iterator end) {
+    OldClientWriteContext cx(txn, ns);
+
+    Collection* const collection = cx.getCollection();
+    uassert(28769, str::stream() << "collection dropped during migration: " << ns, collection);
+
+    std::vector<BSONObj> toInsert;
+    BSONObjSet toInsertIds;
+    long long batchBytes = 0;
+
+    std::vector<BSONObj>::const_iterator docsIter = begin;
+    for (; docsIter != end && toInsert.size() < kMaxClonedDocumentsPerInsertBatch &&
+         batchBytes < kMaxClonedBytesPerInsertBatch;
+         ++docsIter) {
+        const BSONObj& docToClone = *docsIter;
+        const BSONObj idObj = docToClone["_id"].wrap();
+
+        // The donor may return a document more than once if it moved while the donor scanned the
+        // chunk, so insert the documents inserted so far before looking for it.
+        if (toInsertIds.count(idObj)) {
+            break;
+        }
+
+        BSONObj localDoc;
+        if (willOverrideLocalId(
+                txn, ns, min, max, shardKeyPattern, cx.db(), docToClone, &localDoc)) {
+            string errMsg = str::stream() << "cannot migrate chunk, local document " << localDoc
+                                          << " has same _id as cloned "
+                                          << "remote document " << docToClone;
+
+            warning() << errMsg;
+
+            // Exception will abort migration cleanly
+            uasserted(16976, errMsg);
+        }
+
+        if (!localDoc.isEmpty()) {
+            Helpers::upsert(txn, ns, docToClone, true);
+        } else {
+            toInsert.push_back(docToClone);
+            toInsertIds.insert(idObj);
+        }
+
+        batchBytes += docToClone.objsize();
+    }
+
+    // New documents are inserted in a single unit of work, so that their index keys are written
+    // with one commit rather than one per document.
+    MONGO_WRITE_CONFLICT_RETRY_LOOP_BEGIN {
+        WriteUnitOfWork wunit(txn);
+        for (const BSONObj& doc : toInsert) {
+            uassertStatusOK(collection->insertDocument(txn, doc, true, true));
+        }
+        wunit.commit();
+    }
+    MONGO_WRITE_CONFLICT_RETRY_LOOP_END(txn, "migrate clone insert", ns);
+
+    {
+        stdx::lock_guard<stdx::mutex> statsLock(_mutex);
+        _numCloned += docsIter - begin;
+        _clonedBytes += batchBytes;
+    }
+
+    return docsIter;
+}
+
 bool MigrationDestinationManager::_applyMigrateOp(OperationContext* txn,
                                                   const string& ns,
                                                   const BSONObj& min,
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/bsonobj.h"
@@ -107,6 +108,20 @@ private:
                         const OID& epoch,
                         const WriteConcernOptions& writeConcern);
 
+    /**
+     * Inserts a batch of the cloned documents starting at 'begin' under a single collection lock
+     * and returns the position after the last document of the batch. Documents whose _id already
+     * exists in the chunk's range are upserted instead.
+     */
+    std::vector<BSONObj>::const_iterator _insertClonedDocuments(
+        OperationContext* txn,
+        const std::string& ns,
+        const BSONObj& min,
+        const BSONObj& max,
+        const BSONObj& shardKeyPattern,
+        std::vector<BSONObj>::const_iterator begin,
+        std::vector<BSONObj>::const_iterator end);
+
     bool _applyMigrateOp(OperationContext* txn,
                          const std::string& ns,
                          const BSONObj& min,
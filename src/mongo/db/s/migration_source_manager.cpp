@@ -32,6 +32,7 @@
 
 #include "mongo/db/s/migration_source_manager.h"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -40,10 +41,12 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/record_id.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/logger/ramlog.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/d_state.h"
@@ -61,6 +64,11 @@ namespace {
 
 Tee* migrateLog = RamLog::get("migrate");
 
+// Whether a migration clones its chunk by streaming the documents in the order of the shard key
+// index, rather than by first collecting the record ids of all documents in the chunk. Read once
+// at the start of every migration.
+MONGO_EXPORT_SERVER_PARAMETER(internalMigrationCloneByRange, bool, true);
+
 /**
  * Used to receive invalidation notifications.
  *
@@ -193,6 +201,7 @@ bool MigrationSourceManager::start(OperationContext* txn,
 
     stdx::lock_guard<stdx::mutex> tLock(_cloneLocsMutex);
     invariant(_cloneLocs.size() == 0);
+    invariant(!_cloneExec);
 
     return true;
 }
@@ -217,6 +226,9 @@ void MigrationSourceManager::done(OperationContext* txn) {
 
     stdx::lock_guard<stdx::mutex> cloneLock(_cloneLocsMutex);
     _cloneLocs.clear();
+    _cloneByRange = false;
+    _cloneExec.reset();
+    _cloneRangeRemaining = 0;
 }
 
 void MigrationSourceManager::logOp(OperationContext* txn,
@@ -388,6 +400,8 @@ bool MigrationSourceManager::storeCurrentLocs(OperationContext* txn,
         maxRecsWhenFull = Chunk::MaxObjectPerChunk + 1;
     }
 
+    const bool cloneByRange = internalMigrationCloneByRange;
+
     // Do a full traversal of the chunk and don't stop even if we think it is a large chunk we want
     // the number of records to better report, in that case
     bool isLargeChunk = false;
@@ -395,7 +409,7 @@ bool MigrationSourceManager::storeCurrentLocs(OperationContext* txn,
 
     RecordId recordId;
     while (PlanExecutor::ADVANCED == exec->getNext(NULL, &recordId)) {
-        if (!isLargeChunk) {
+        if (!isLargeChunk && !cloneByRange) {
             stdx::lock_guard<stdx::mutex> lk(_cloneLocsMutex);
             _cloneLocs.insert(recordId);
         }
@@ -423,6 +437,31 @@ bool MigrationSourceManager::storeCurrentLocs(OperationContext* txn,
         return false;
     }
 
+    if (cloneByRange) {
+        // The documents are fetched in the order of the shard key index as they are cloned. The
+        // scan yields between clone() calls, but any document changed in the meantime is also
+        // queued for the 'transferMods' stage.
+        unique_ptr<PlanExecutor> cloneExec(
+            InternalPlanner::indexScan(txn,
+                                       collection,
+                                       idx,
+                                       min,
+                                       max,
+                                       false,
+                                       InternalPlanner::FORWARD,
+                                       InternalPlanner::IXSCAN_FETCH));
+
+        // Registering the executor delivers invalidations to it while it is saved.
+        cloneExec->registerExec();
+        cloneExec->saveState();
+        cloneExec->detachFromOperationContext();
+
+        stdx::lock_guard<stdx::mutex> lk(_cloneLocsMutex);
+        _cloneByRange = true;
+        _cloneExec = std::move(cloneExec);
+        _cloneRangeRemaining = recCount;
+    }
+
     log() << "moveChunk number of documents: " << cloneLocsRemaining() << migrateLog;
 
     txn->recoveryUnit()->abandonSnapshot();
@@ -474,6 +513,21 @@ bool MigrationSourceManager::clone(OperationContext* txn, string& errmsg, BSONOb
 
         stdx::lock_guard<stdx::mutex> lk(_cloneLocsMutex);
 
+        if (_cloneByRange) {
+            Status status =
+                _cloneRangeBatch(txn, &tracker, &clonedDocsArrayBuilder, &isBufferFilled);
+            if (!status.isOK()) {
+                errmsg = status.reason();
+                return false;
+            }
+
+            if (!_cloneExec) {
+                break;
+            }
+
+            continue;
+        }
+
         std::set<RecordId>::iterator cloneLocsIter = _cloneLocs.begin();
         for (; cloneLocsIter != _cloneLocs.end(); ++cloneLocsIter) {
             if (tracker.intervalHasElapsed())  // should I yield?
@@ -520,6 +574,12 @@ void MigrationSourceManager::aboutToDelete(const RecordId& dl) {
 
 std::size_t MigrationSourceManager::cloneLocsRemaining() const {
     stdx::lock_guard<stdx::mutex> lk(_cloneLocsMutex);
+    if (_cloneByRange) {
+        // Documents may have been inserted into the range after it was counted, so the scan must
+        // be exhausted before reporting that nothing is left to clone.
+        return _cloneExec ? std::max(_cloneRangeRemaining, 1LL) : 0;
+    }
+
     return _cloneLocs.size();
 }
 
@@ -592,6 +652,59 @@ void MigrationSourceManager::_xfer(OperationContext* txn,
     arr.done();
 }
 
+Status MigrationSourceManager::_cloneRangeBatch(OperationContext* txn,
+                                                ElapsedTracker* tracker,
+                                                BSONArrayBuilder* arrBuilder,
+                                                bool* isBufferFilled) {
+    if (!_cloneExec) {
+        return Status::OK();
+    }
+
+    _cloneExec->reattachToOperationContext(txn);
+    if (!_cloneExec->restoreState()) {
+        _cloneExec.reset();
+        return Status(ErrorCodes::OperationFailed,
+                      str::stream() << "collection " << _ns << " was dropped while cloning");
+    }
+
+    BSONObj doc;
+    PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
+    while (!tracker->intervalHasElapsed()) {
+        state = _cloneExec->getNext(&doc, NULL);
+        if (state != PlanExecutor::ADVANCED) {
+            break;
+        }
+
+        // Same as for _cloneLocs, always append at least one document. A document which doesn't
+        // fit is returned again by the next call.
+        if (arrBuilder->arrSize() != 0 &&
+            (arrBuilder->len() + doc.objsize() + 1024) > BSONObjMaxUserSize) {
+            _cloneExec->enqueue(doc.getOwned());
+            *isBufferFilled = true;
+            break;
+        }
+
+        arrBuilder->append(doc);
+        _cloneRangeRemaining--;
+    }
+
+    if (state == PlanExecutor::IS_EOF) {
+        _cloneExec.reset();
+        return Status::OK();
+    }
+
+    if (state != PlanExecutor::ADVANCED) {
+        _cloneExec.reset();
+        return Status(ErrorCodes::OperationFailed,
+                      str::stream() << "executor error while cloning " << _ns << ": "
+                                    << WorkingSetCommon::toStatusString(doc));
+    }
+
+    _cloneExec->saveState();
+    _cloneExec->detachFromOperationContext();
+    return Status::OK();
+}
+
 std::string MigrationSourceManager::_getNS() const {
     stdx::lock_guard<stdx::mutex> lk(_mutex);
     return _ns;
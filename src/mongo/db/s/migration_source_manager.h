@@ -29,6 +29,7 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 
@@ -38,11 +39,14 @@
 
 namespace mongo {
 
+class BSONArrayBuilder;
 class BSONObj;
 class Database;
+class ElapsedTracker;
 class OperationContext;
 class PlanExecutor;
 class RecordId;
+class Status;
 
 class MigrationSourceManager {
     MONGO_DISALLOW_COPYING(MigrationSourceManager);
@@ -78,7 +82,9 @@ public:
 
     /**
      * Get the disklocs that belong to the chunk migrated and sort them in _cloneLocs (to avoid
-     * seeking disk later).
+     * seeking disk later). If internalMigrationCloneByRange is set, the record ids are only
+     * counted and a saved scan over the chunk's range of the shard key index is prepared instead,
+     * which clone() resumes on every call.
      *
      * @param maxChunkSize number of bytes beyond which a chunk's base data (no indices) is
      *      considered too large to move
@@ -91,10 +97,18 @@ public:
                           std::string& errmsg,
                           BSONObjBuilder& result);
 
+    /**
+     * Appends to 'result' the next batch of documents of the chunk, up to the maximum user object
+     * size, as the array "objects". An empty array means that the whole chunk has been cloned.
+     */
     bool clone(OperationContext* txn, std::string& errmsg, BSONObjBuilder& result);
 
     void aboutToDelete(const RecordId& dl);
 
+    /**
+     * Returns the number of documents which have not been cloned yet. When cloning by range this is
+     * an estimate, which is only zero once the scan of the range is exhausted.
+     */
     std::size_t cloneLocsRemaining() const;
 
     long long mbUsed() const;
@@ -131,6 +145,18 @@ private:
                long long& size,
                bool explode);
 
+    /**
+     * Appends the documents returned by the saved scan of the chunk's range to 'arrBuilder' until
+     * either it is full, the scan is exhausted or it is time to yield. Sets 'isBufferFilled' if no
+     * more documents fit in the batch.
+     *
+     * Must be holding the collection lock for ns, _mutex and _cloneLocsMutex.
+     */
+    Status _cloneRangeBatch(OperationContext* txn,
+                            ElapsedTracker* tracker,
+                            BSONArrayBuilder* arrBuilder,
+                            bool* isBufferFilled);
+
     std::string _getNS() const;
 
     // All member variables are labeled with one of the following codes indicating the
@@ -175,6 +201,18 @@ private:
 
     // List of record id that needs to be transferred from here to the other side.
     std::set<RecordId> _cloneLocs;  // (C)
+
+    // Whether this migration clones the chunk by scanning its range of the shard key index in
+    // order instead of fetching the documents in _cloneLocs. Concurrent changes to the chunk are
+    // transferred by _reload and _deleted either way.
+    bool _cloneByRange{false};  // (C)
+
+    // Scan of the chunk's range which is resumed by every clone() call. It is saved and detached
+    // from the operation context in between calls and is reset once the range is exhausted.
+    std::unique_ptr<PlanExecutor> _cloneExec;  // (C)
+
+    // Number of documents counted in the chunk's range which have not been cloned yet.
+    long long _cloneRangeRemaining{0};  // (C)
 };
 
 }  // namespace mongo
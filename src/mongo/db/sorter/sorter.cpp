@@ -48,18 +48,21 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
-#include <snappy.h>
 
 #include "mongo/base/string_data.h"
 #include "mongo/config.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/sorter/sorter_spill.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/s/mongos_options.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/print.h"
+#include "mongo/util/timer.h"
 #include "mongo/util/unowned_ptr.h"
 
 namespace mongo {
@@ -68,6 +71,33 @@ namespace sorter {
 using std::shared_ptr;
 using namespace mongoutils;
 
+// Write and read keys, passing the previous key in the block to types that use it.
+template <typename Key>
+void serializeKey(const Key& key, const Key* previous, BufBuilder& buf, std::false_type) {
+    key.serializeForSorter(buf);
+}
+
+template <typename Key>
+void serializeKey(const Key& key, const Key* previous, BufBuilder& buf, std::true_type) {
+    key.serializeForSorter(buf, previous);
+}
+
+template <typename Key>
+Key deserializeKey(BufReader& buf,
+                   const typename Key::SorterDeserializeSettings& settings,
+                   const Key* previous,
+                   std::false_type) {
+    return Key::deserializeForSorter(buf, settings);
+}
+
+template <typename Key>
+Key deserializeKey(BufReader& buf,
+                   const typename Key::SorterDeserializeSettings& settings,
+                   const Key* previous,
+                   std::true_type) {
+    return Key::deserializeForSorter(buf, settings, previous);
+}
+
 // We need to use the "real" errno everywhere, not GetLastError() on Windows
 inline std::string myErrnoWithDescription() {
     int errnoCopy = errno;
@@ -158,7 +188,12 @@ private:
     std::deque<Data> _data;
 };
 
-/** Returns results in order from a single file */
+/**
+ * Returns results in order from a single file.
+ *
+ * While the results of one block of the file are returned, the next block may be read and
+ * uncompressed on a background thread. See sorterSpillReadAhead.
+ */
 template <typename Key, typename Value>
 class FileIterator : public SortIteratorInterface<Key, Value> {
 public:
@@ -184,6 +219,14 @@ public:
                 boost::filesystem::file_size(_fileName) != 0);
     }
 
+    ~FileIterator() {
+        // The background read uses _file, so it must finish first.
+        if (_readAhead) {
+            stdx::unique_lock<stdx::mutex> lk(_readAhead->mutex);
+            _readAhead->condition.wait(lk, [this] { return !_readAhead->inProgress; });
+        }
+    }
+
     bool more() {
         if (!_done)
             fillIfNeeded();  // may change _done
@@ -196,12 +239,35 @@ public:
 
         Data out;
         // Note: key must be read before value so can't pass directly to Data constructor
-        out.first = Key::deserializeForSorter(*_reader, _settings.first);
+        const bool havePreviousKey = _reader->offset() > 0;
+        out.first = deserializeKey(*_reader,
+                                   _settings.first,
+                                   havePreviousKey ? &_previousKey : nullptr,
+                                   SorterKeyUsesPreviousKey<Key>());
         out.second = Value::deserializeForSorter(*_reader, _settings.second);
+        if (SorterKeyUsesPreviousKey<Key>::value) {
+            _previousKey = out.first;
+        }
         return out;
     }
 
 private:
+    /** A block of the file, uncompressed. */
+    struct Block {
+        bool eof = false;
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    /** The state of a block being read on a background thread. */
+    struct ReadAhead {
+        stdx::mutex mutex;
+        stdx::condition_variable condition;
+        bool inProgress = true;
+        Status status = Status::OK();
+        Block block;
+    };
+
     void fillIfNeeded() {
         verify(!_done);
 
@@ -210,48 +276,118 @@ private:
     }
 
     void fill() {
-        int32_t rawSize;
-        read(&rawSize, sizeof(rawSize));
-        if (_done)
+        Block block;
+        if (_readAhead) {
+            Status status = Status::OK();
+            {
+                stdx::unique_lock<stdx::mutex> lk(_readAhead->mutex);
+                _readAhead->condition.wait(lk, [this] { return !_readAhead->inProgress; });
+                status = _readAhead->status;
+                block = std::move(_readAhead->block);
+            }
+            _readAhead.reset();
+            if (!status.isOK())
+                msgasserted(status.location(), status.reason());
+        } else {
+            readBlock(&block);
+        }
+
+        if (block.eof) {
+            _done = true;
             return;
+        }
 
-        // negative size means compressed
-        const bool compressed = rawSize < 0;
-        const int32_t blockSize = std::abs(rawSize);
+        _buffer = std::move(block.data);
+        _reader.reset(new BufReader(_buffer.get(), block.size));
 
-        _buffer.reset(new char[blockSize]);
-        read(_buffer.get(), blockSize);
-        massert(16816, "file too short?", !_done);
+        if (isSpillReadAheadEnabled())
+            startReadAhead();
+    }
 
-        if (!compressed) {
-            _reader.reset(new BufReader(_buffer.get(), blockSize));
-            return;
-        }
+    /**
+     * Reads the next block of the file on a background thread. Nothing else may use _file until
+     * it is done.
+     */
+    void startReadAhead() {
+        invariant(!_readAhead);
+        _readAhead.reset(new ReadAhead());
+
+        ReadAhead* readAhead = _readAhead.get();
+        const Status status = scheduleSpillReadAhead([this, readAhead] {
+            Block block;
+            Status status = Status::OK();
+            try {
+                readBlock(&block);
+                spillStats.blocksReadAhead.increment();
+            } catch (const DBException& ex) {
+                status = Status(ErrorCodes::InternalError, ex.what(), ex.getCode());
+            }
+
+            stdx::lock_guard<stdx::mutex> lk(readAhead->mutex);
+            readAhead->block = std::move(block);
+            readAhead->status = status;
+            readAhead->inProgress = false;
+            readAhead->condition.notify_one();
+        });
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
+        // If the block can't be read in the background, it is read when it is needed instead.
+        if (!status.isOK())
+            _readAhead.reset();
+    }
 
-        size_t uncompressedSize;
-        massert(17061,
-                "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
+    /**
+     * Reads, checks and uncompresses the next block, or sets 'out->eof' at the end of the file.
+     * See SortedFileWriter::spill() for the format.
+     */
+    void readBlock(Block* out) {
+        Timer timer;
+
+        int32_t storedSize;
+        if (!read(&storedSize, sizeof(storedSize))) {
+            out->eof = true;
+            return;
+        }
 
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-        massert(17062,
-                "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
+        int32_t rawSize;
+        uint8_t compressor;
+        uint32_t checksum;
+        massert(16816,
+                "file too short?",
+                read(&rawSize, sizeof(rawSize)) && read(&compressor, sizeof(compressor)) &&
+                    read(&checksum, sizeof(checksum)));
+        massert(28760,
+                str::stream() << "corrupt block header in file \"" << _fileName << "\"",
+                storedSize >= 0 && rawSize >= 0);
+
+        std::unique_ptr<char[]> stored(new char[storedSize]);
+        massert(28770, "file too short?", read(stored.get(), storedSize));
+        massert(28761,
+                str::stream() << "checksum mismatch in file \"" << _fileName << "\"",
+                spillBlockChecksum(stored.get(), storedSize) == checksum);
+
+        const auto blockCompressor = static_cast<SpillCompressor>(compressor);
+        if (blockCompressor == SpillCompressor::kNone) {
+            massert(28762, "spill block has the wrong size", storedSize == rawSize);
+            out->data = std::move(stored);
+        } else {
+            out->data.reset(new char[rawSize]);
+            uncompressSpillBlock(
+                blockCompressor, stored.get(), storedSize, out->data.get(), rawSize);
+        }
+        out->size = rawSize;
 
-        // hold on to decompressed data and throw out compressed data at block exit
-        _buffer.swap(decompressionBuffer);
-        _reader.reset(new BufReader(_buffer.get(), uncompressedSize));
+        spillStats.blocksRead.increment();
+        spillStats.bytesRead.increment(sizeof(storedSize) + sizeof(rawSize) + sizeof(compressor) +
+                                       sizeof(checksum) + storedSize);
+        spillStats.readMicros.increment(timer.micros());
     }
 
-    // sets _done to true on EOF - asserts on any other error
-    void read(void* out, size_t size) {
+    // Returns false on EOF - asserts on any other error
+    bool read(void* out, size_t size) {
         _file.read(reinterpret_cast<char*>(out), size);
         if (!_file.good()) {
             if (_file.eof()) {
-                _done = true;
-                return;
+                return false;
             }
 
             msgasserted(16817,
@@ -259,15 +395,18 @@ private:
                                       << "\": " << myErrnoWithDescription());
         }
         verify(_file.gcount() == static_cast<std::streamsize>(size));
+        return true;
     }
 
     const Settings _settings;
     bool _done;
     std::unique_ptr<char[]> _buffer;
     std::unique_ptr<BufReader> _reader;
+    Key _previousKey;  // The last key read from _reader. See SorterKeyUsesPreviousKey.
     std::string _fileName;
     std::shared_ptr<FileDeleter> _fileDeleter;  // Must outlive _file
     std::ifstream _file;
+    std::unique_ptr<ReadAhead> _readAhead;  // Set while the next block is read ahead.
 };
 
 /** Merge-sorts results from 0 or more FileIterators */
@@ -830,8 +969,14 @@ SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts, const Se
 
 template <typename Key, typename Value>
 void SortedFileWriter<Key, Value>::addAlreadySorted(const Key& key, const Value& val) {
-    key.serializeForSorter(_buffer);
+    sorter::serializeKey(key,
+                         _buffer.len() > 0 ? &_previousKey : nullptr,
+                         _buffer,
+                         SorterKeyUsesPreviousKey<Key>());
     val.serializeForSorter(_buffer);
+    if (SorterKeyUsesPreviousKey<Key>::value) {
+        _previousKey = key;
+    }
 
     if (_buffer.len() > 64 * 1024)
         spill();
@@ -844,26 +989,44 @@ void SortedFileWriter<Key, Value>::spill() {
     if (_buffer.len() == 0)
         return;
 
+    Timer timer;
+
+    // Each block is written as a header followed by its data:
+    //   int32 storedSize   - the size of the data as written
+    //   int32 rawSize      - the size of the data once uncompressed
+    //   uint8 compressor   - a sorter::SpillCompressor
+    //   uint32 checksum    - sorter::spillBlockChecksum() of the data as written
     std::string compressed;
-    snappy::Compress(_buffer.buf(), _buffer.len(), &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+    const auto compressor = sorter::compressSpillBlock(
+        sorter::getSpillCompressor(), _buffer.buf(), _buffer.len(), &compressed);
+    const bool isCompressed = compressor != sorter::SpillCompressor::kNone;
+    const char* data = isCompressed ? compressed.data() : _buffer.buf();
+    const size_t size = isCompressed ? compressed.size() : _buffer.len();
+    verify(size <= size_t(std::numeric_limits<int32_t>::max()));
+
+    const int32_t storedSize = size;
+    const int32_t rawSize = _buffer.len();
+    const uint8_t compressorByte = static_cast<uint8_t>(compressor);
+    const uint32_t checksum = sorter::spillBlockChecksum(data, size);
 
     try {
-        if (compressed.size() < size_t(_buffer.len() / 10 * 9)) {
-            const int32_t size = -int32_t(compressed.size());  // negative means compressed
-            _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-            _file.write(compressed.data(), compressed.size());
-        } else {
-            const int32_t size = _buffer.len();
-            _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-            _file.write(_buffer.buf(), _buffer.len());
-        }
+        _file.write(reinterpret_cast<const char*>(&storedSize), sizeof(storedSize));
+        _file.write(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+        _file.write(reinterpret_cast<const char*>(&compressorByte), sizeof(compressorByte));
+        _file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        _file.write(data, size);
     } catch (const std::exception&) {
         msgasserted(16821,
                     str::stream() << "error writing to file \"" << _fileName
                                   << "\": " << sorter::myErrnoWithDescription());
     }
 
+    sorter::spillStats.blocksWritten.increment();
+    sorter::spillStats.bytesWritten.increment(sizeof(storedSize) + sizeof(rawSize) +
+                                              sizeof(compressorByte) + sizeof(checksum) + size);
+    sorter::spillStats.rawBytesWritten.increment(rawSize);
+    sorter::spillStats.writeMicros.increment(timer.micros());
+
     _buffer.reset();
 }
 
@@ -31,11 +31,13 @@
 #include <deque>
 #include <fstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/bson/util/builder.h"
+#include "mongo/util/bufreader.h"
 
 /**
  * This is the public API for the Sorter (both in-memory and external)
@@ -61,6 +63,15 @@
  * // Return *this if your type doesn't have an unowned state
  * Type getOwned() const;
  *
+ * Key types for which SorterKeyUsesPreviousKey is specialized to true instead serialize and
+ * deserialize with an extra argument pointing to the key before them in the same block of a
+ * spill file, or nullptr for the first key of a block:
+ *
+ * void serializeForSorter(BufBuilder& buf, const Type* previous) const;
+ * static Type deserializeForSorter(BufReader& buf,
+ *                                  const Type::SorterDeserializeSettings&,
+ *                                  const Type* previous);
+ *
  * Comparators are functors that that compare std::pair<Key, Value> and return an
  * int less than, equal to, or greater than 0 depending on how the two pairs
  * compare with the same semantics as memcmp.
@@ -88,6 +99,31 @@ namespace sorter {
 class FileDeleter;
 }
 
+/**
+ * Whether spill files store each key relative to the key before it, which suits keys that sort
+ * by their bytes, as adjacent keys then often share a prefix. See the top of this file.
+ */
+template <typename Key>
+struct SorterKeyUsesPreviousKey : std::false_type {};
+
+/**
+ * A Value type for Sorters whose keys hold all of the data being sorted.
+ */
+struct NullValue {
+    struct SorterDeserializeSettings {};
+
+    void serializeForSorter(BufBuilder& buf) const {}
+    static NullValue deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+        return NullValue();
+    }
+    int memUsageForSorter() const {
+        return 0;
+    }
+    NullValue getOwned() const {
+        return *this;
+    }
+};
+
 /**
  * Runtime options that control the Sorter's behavior
  */
@@ -201,6 +237,9 @@ private:
     std::shared_ptr<sorter::FileDeleter> _fileDeleter;  // Must outlive _file
     std::ofstream _file;
     BufBuilder _buffer;
+
+    // The last key added to _buffer, if SorterKeyUsesPreviousKey<Key> and _buffer is not empty.
+    Key _previousKey;
 };
 }
 
@@ -0,0 +1,234 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter_spill.h"
+
+#include <snappy.h>
+#include <zlib.h>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+namespace sorter {
+
+SpillStats spillStats;
+
+namespace {
+
+AtomicWord<int> spillCompressor(static_cast<int>(SpillCompressor::kSnappy));
+
+MONGO_EXPORT_SERVER_PARAMETER(sorterSpillReadAhead, bool, true);
+
+// Reading ahead only overlaps disk reads with merging, so a few threads serve all Sorters.
+const int kMaxReadAheadThreads = 4;
+
+stdx::mutex readAheadPoolMutex;
+ThreadPool* readAheadPool = nullptr;
+
+ThreadPool* getReadAheadPool() {
+    stdx::lock_guard<stdx::mutex> lk(readAheadPoolMutex);
+    if (!readAheadPool) {
+        ThreadPool::Options options;
+        options.poolName = "SorterReadAhead";
+        options.threadNamePrefix = "sorterReadAhead-";
+        options.minThreads = 0;
+        options.maxThreads = kMaxReadAheadThreads;
+
+        // Intentionally leaked, so that it never has to be shut down.
+        readAheadPool = new ThreadPool(options);
+        readAheadPool->startup();
+    }
+    return readAheadPool;
+}
+
+class SpillCompressorParameter : public ServerParameter {
+    MONGO_DISALLOW_COPYING(SpillCompressorParameter);
+
+public:
+    SpillCompressorParameter()
+        : ServerParameter(ServerParameterSet::getGlobal(), "sorterSpillCompressor", true, true) {}
+
+    virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+        b.append(name, spillCompressorName(getSpillCompressor()));
+    }
+
+    virtual Status set(const BSONElement& newValueElement) {
+        if (newValueElement.type() != String) {
+            return Status(ErrorCodes::TypeMismatch,
+                          str::stream() << "Expected server parameter " << name()
+                                        << " to be a string, but found "
+                                        << typeName(newValueElement.type()));
+        }
+        return setFromString(newValueElement.String());
+    }
+
+    virtual Status setFromString(const std::string& str) {
+        return setSpillCompressor(str);
+    }
+} spillCompressorParameter;
+
+ServerStatusMetricField<Counter64> displayBlocksWritten("sorter.spill.blocksWritten",
+                                                        &spillStats.blocksWritten);
+ServerStatusMetricField<Counter64> displayBytesWritten("sorter.spill.bytesWritten",
+                                                       &spillStats.bytesWritten);
+ServerStatusMetricField<Counter64> displayRawBytesWritten("sorter.spill.rawBytesWritten",
+                                                          &spillStats.rawBytesWritten);
+ServerStatusMetricField<Counter64> displayWriteMicros("sorter.spill.writeMicros",
+                                                      &spillStats.writeMicros);
+ServerStatusMetricField<Counter64> displayBlocksRead("sorter.spill.blocksRead",
+                                                     &spillStats.blocksRead);
+ServerStatusMetricField<Counter64> displayBytesRead("sorter.spill.bytesRead",
+                                                    &spillStats.bytesRead);
+ServerStatusMetricField<Counter64> displayReadMicros("sorter.spill.readMicros",
+                                                     &spillStats.readMicros);
+ServerStatusMetricField<Counter64> displayBlocksReadAhead("sorter.spill.blocksReadAhead",
+                                                          &spillStats.blocksReadAhead);
+
+}  // namespace
+
+SpillCompressor getSpillCompressor() {
+    return static_cast<SpillCompressor>(spillCompressor.load());
+}
+
+Status setSpillCompressor(StringData name) {
+    for (auto compressor :
+         {SpillCompressor::kNone, SpillCompressor::kSnappy, SpillCompressor::kZlib}) {
+        if (name == spillCompressorName(compressor)) {
+            spillCompressor.store(static_cast<int>(compressor));
+            return Status::OK();
+        }
+    }
+    return Status(ErrorCodes::BadValue,
+                  str::stream() << "sorterSpillCompressor must be one of \"none\", \"snappy\" "
+                                   "or \"zlib\", not \"" << name << "\"");
+}
+
+StringData spillCompressorName(SpillCompressor compressor) {
+    switch (compressor) {
+        case SpillCompressor::kNone:
+            return "none";
+        case SpillCompressor::kSnappy:
+            return "snappy";
+        case SpillCompressor::kZlib:
+            return "zlib";
+    }
+    MONGO_UNREACHABLE;
+}
+
+SpillCompressor compressSpillBlock(SpillCompressor compressor,
+                                   const char* data,
+                                   size_t size,
+                                   std::string* out) {
+    out->clear();
+    switch (compressor) {
+        case SpillCompressor::kNone:
+            return SpillCompressor::kNone;
+        case SpillCompressor::kSnappy:
+            snappy::Compress(data, size, out);
+            break;
+        case SpillCompressor::kZlib: {
+            uLongf compressedSize = compressBound(size);
+            out->resize(compressedSize);
+            // Spill files are short lived, so favor speed over size.
+            const int ret = compress2(reinterpret_cast<Bytef*>(&(*out)[0]),
+                                      &compressedSize,
+                                      reinterpret_cast<const Bytef*>(data),
+                                      size,
+                                      Z_BEST_SPEED);
+            massert(28755, str::stream() << "zlib compression failed: " << ret, ret == Z_OK);
+            out->resize(compressedSize);
+            break;
+        }
+    }
+
+    // Only keep compressed blocks that are meaningfully smaller, as they cost time to read.
+    if (out->size() >= size / 10 * 9) {
+        out->clear();
+        return SpillCompressor::kNone;
+    }
+    return compressor;
+}
+
+void uncompressSpillBlock(
+    SpillCompressor compressor, const char* data, size_t size, char* out, size_t rawSize) {
+    switch (compressor) {
+        case SpillCompressor::kNone:
+            massert(28756, "spill block has the wrong size", size == rawSize);
+            memcpy(out, data, size);
+            return;
+        case SpillCompressor::kSnappy: {
+            size_t uncompressedSize;
+            massert(17061,
+                    "couldn't get uncompressed length",
+                    snappy::GetUncompressedLength(data, size, &uncompressedSize));
+            massert(28757,
+                    "spill block has the wrong uncompressed size",
+                    uncompressedSize == rawSize);
+            massert(17062, "decompression failed", snappy::RawUncompress(data, size, out));
+            return;
+        }
+        case SpillCompressor::kZlib: {
+            uLongf uncompressedSize = rawSize;
+            const int ret = uncompress(reinterpret_cast<Bytef*>(out),
+                                       &uncompressedSize,
+                                       reinterpret_cast<const Bytef*>(data),
+                                       size);
+            massert(28758,
+                    str::stream() << "zlib decompression failed: " << ret,
+                    ret == Z_OK && uncompressedSize == rawSize);
+            return;
+        }
+    }
+    msgasserted(28759,
+                str::stream() << "unknown spill block compressor: "
+                              << static_cast<int>(compressor));
+}
+
+uint32_t spillBlockChecksum(const char* data, size_t size) {
+    return crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), size);
+}
+
+bool isSpillReadAheadEnabled() {
+    return sorterSpillReadAhead;
+}
+
+Status scheduleSpillReadAhead(stdx::function<void()> task) {
+    return getReadAheadPool()->schedule(std::move(task));
+}
+
+}  // namespace sorter
+}  // namespace mongo
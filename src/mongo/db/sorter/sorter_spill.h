@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "mongo/base/counter.h"
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/stdx/functional.h"
+
+/**
+ * Settings, statistics and background reads for the files that Sorters spill sorted data to.
+ * These are shared by every instantiation of the templates in sorter.cpp.
+ */
+
+namespace mongo {
+namespace sorter {
+
+/**
+ * How a block of a spill file is compressed. Stored in each block's header, so the values must
+ * not change while a file is being read.
+ */
+enum class SpillCompressor : uint8_t {
+    kNone = 0,
+    kSnappy = 1,
+    kZlib = 2,
+};
+
+/**
+ * Returns the compressor that newly written spill blocks should use, as chosen with the
+ * sorterSpillCompressor server parameter. Blocks that do not compress well are stored as is.
+ */
+SpillCompressor getSpillCompressor();
+
+/**
+ * Sets the compressor from its name, which is one of "none", "snappy" or "zlib".
+ */
+Status setSpillCompressor(StringData name);
+
+StringData spillCompressorName(SpillCompressor compressor);
+
+/**
+ * Compresses the 'size' bytes at 'data' into 'out' with 'compressor'. Returns the compressor that
+ * was used, which is kNone, leaving 'out' empty, if compression would not save enough space.
+ */
+SpillCompressor compressSpillBlock(SpillCompressor compressor,
+                                   const char* data,
+                                   size_t size,
+                                   std::string* out);
+
+/**
+ * Uncompresses the 'size' bytes at 'data', which were compressed with 'compressor', into the
+ * 'rawSize' bytes at 'out'. Throws if the data is corrupt.
+ */
+void uncompressSpillBlock(
+    SpillCompressor compressor, const char* data, size_t size, char* out, size_t rawSize);
+
+/**
+ * Returns the checksum stored with a block of 'size' bytes at 'data'.
+ */
+uint32_t spillBlockChecksum(const char* data, size_t size);
+
+/**
+ * Whether file iterators read the next block of their file on a background thread while the
+ * current block is consumed. Set with the sorterSpillReadAhead server parameter.
+ */
+bool isSpillReadAheadEnabled();
+
+/**
+ * Runs 'task' on the threads that read spill files ahead. Returns an error if it could not be
+ * scheduled, in which case the caller should do the work itself.
+ */
+Status scheduleSpillReadAhead(stdx::function<void()> task);
+
+/**
+ * Spill file counters for all Sorters in this process, reported in serverStatus under
+ * metrics.sorter.spill.
+ */
+struct SpillStats {
+    Counter64 blocksWritten;
+    Counter64 bytesWritten;     // As stored, after compression.
+    Counter64 rawBytesWritten;  // Before compression.
+    Counter64 writeMicros;
+
+    Counter64 blocksRead;
+    Counter64 bytesRead;
+    Counter64 readMicros;
+    Counter64 blocksReadAhead;  // Blocks that were read in the background.
+};
+
+extern SpillStats spillStats;
+
+}  // namespace sorter
+}  // namespace mongo
@@ -33,6 +33,9 @@
 #include <boost/filesystem.hpp>
 
 #include "mongo/config.h"
+#include "mongo/db/sorter/sorter_spill.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/platform/random.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
@@ -540,6 +543,143 @@ class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
 };
 }
 
+// Sorts KeyStrings, which are written to spill files relative to the key written before them.
+class KeyStringKeys {
+public:
+    typedef Sorter<KeyString::Value, NullValue> KSSorter;
+
+    class KSComparator {
+    public:
+        int operator()(const KSSorter::Data& lhs, const KSSorter::Data& rhs) const {
+            return lhs.first.compare(rhs.first);
+        }
+    };
+
+    void run() {
+        unittest::TempDir tempDir("sorterKeyStringTests");
+        const SortOptions opts =
+            SortOptions().TempDir(tempDir.path()).MaxMemoryUsageBytes(64 * 1024).ExtSortAllowed();
+        const Ordering ordering = Ordering::make(BSON("a" << 1 << "b" << -1));
+
+        std::vector<int> order;
+        for (int i = 0; i < NUM_ITEMS; i++)
+            order.push_back(i);
+        std::random_shuffle(order.begin(), order.end());
+
+        std::unique_ptr<KSSorter> sorter(KSSorter::make(opts, KSComparator()));
+        for (int i : order)
+            sorter->add(makeKey(i, ordering), NullValue());
+        ASSERT_GREATER_THAN(sorter->numFiles(), 1);
+
+        std::unique_ptr<KSSorter::Iterator> it(sorter->done());
+        for (int i = 0; i < NUM_ITEMS; i++) {
+            ASSERT(it->more());
+            const KeyString::Value expected = makeKey(i, ordering);
+            const KeyString::Value value = it->next().first;
+            ASSERT_EQ(expected.getSize(), value.getSize());
+            ASSERT_EQ(0, memcmp(expected.getBuffer(), value.getBuffer(), value.getSize()));
+            ASSERT_EQ(expected.getTypeBits().getSize(), value.getTypeBits().getSize());
+        }
+        ASSERT(!it->more());
+    }
+
+private:
+    // Keys that sort in the order of 'i', with long shared prefixes and some non-empty TypeBits.
+    static KeyString::Value makeKey(int i, const Ordering& ordering) {
+        const std::string prefix = str::stream() << "shared prefix " << (1000 + i / 100);
+        const BSONObj key = BSON("" << prefix << "" << (i % 2 ? static_cast<double>(-i) : -i));
+        return KeyString(key, ordering, RecordId(i + 1)).getValue();
+    }
+
+    enum Constants { NUM_ITEMS = 100 * 1000 };
+};
+
+// Spills blocks with each compressor and reads them back.
+class SpillCompressors {
+public:
+    void run() {
+        const SpillCompressor original = getSpillCompressor();
+        for (auto name : {"none", "snappy", "zlib"}) {
+            ASSERT_OK(setSpillCompressor(name));
+
+            const long long rawBytesBefore = spillStats.rawBytesWritten.get();
+            const long long bytesBefore = spillStats.bytesWritten.get();
+            const long long blocksReadBefore = spillStats.blocksRead.get();
+
+            unittest::TempDir tempDir("sorterSpillCompressorTests");
+            SortedFileWriter<IntWrapper, IntWrapper> writer(SortOptions().TempDir(tempDir.path()));
+            for (int i = 0; i < NUM_ITEMS; i++)
+                writer.addAlreadySorted(i, -i);
+            ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(writer.done()),
+                                        make_shared<IntIterator>(0, NUM_ITEMS));
+
+            const long long rawBytes = spillStats.rawBytesWritten.get() - rawBytesBefore;
+            const long long bytes = spillStats.bytesWritten.get() - bytesBefore;
+            ASSERT_GREATER_THAN_OR_EQUALS(rawBytes, NUM_ITEMS * 2 * int(sizeof(int)));
+            ASSERT_GREATER_THAN(bytes, 0);
+            ASSERT_GREATER_THAN(spillStats.blocksRead.get(), blocksReadBefore);
+
+            // Blocks that compress well are stored compressed, and others are stored as is.
+            const std::string compressible(64 * 1024, 'x');
+            std::string compressed;
+            ASSERT(compressSpillBlock(getSpillCompressor(),
+                                      compressible.data(),
+                                      compressible.size(),
+                                      &compressed) == getSpillCompressor());
+            if (getSpillCompressor() != SpillCompressor::kNone) {
+                ASSERT_LESS_THAN(compressed.size(), compressible.size());
+                std::string uncompressed(compressible.size(), '\0');
+                uncompressSpillBlock(getSpillCompressor(),
+                                     compressed.data(),
+                                     compressed.size(),
+                                     &uncompressed[0],
+                                     uncompressed.size());
+                ASSERT_EQUALS(compressible, uncompressed);
+            }
+
+            std::string incompressible;
+            PseudoRandom random(1);
+            for (int i = 0; i < 64 * 1024; i++)
+                incompressible.push_back(static_cast<char>(random.nextInt32()));
+            ASSERT(compressSpillBlock(getSpillCompressor(),
+                                      incompressible.data(),
+                                      incompressible.size(),
+                                      &compressed) == SpillCompressor::kNone);
+            ASSERT(compressed.empty());
+        }
+        ASSERT_NOT_OK(setSpillCompressor("lz4"));
+        ASSERT_OK(setSpillCompressor(spillCompressorName(original)));
+    }
+
+    enum Constants { NUM_ITEMS = 100 * 1000 };
+};
+
+// A spill file that is changed after it is written fails its checksum when it is read.
+class SpillChecksum {
+public:
+    void run() {
+        unittest::TempDir tempDir("sorterSpillChecksumTests");
+        SortedFileWriter<IntWrapper, IntWrapper> writer(SortOptions().TempDir(tempDir.path()));
+        for (int i = 0; i < 1000; i++)
+            writer.addAlreadySorted(i, -i);
+
+        boost::filesystem::directory_iterator file(tempDir.path());
+        ASSERT(file != boost::filesystem::directory_iterator());
+        const std::string fileName = file->path().string();
+
+        std::unique_ptr<IWIterator> it(writer.done());
+        {
+            // Flip a bit in the last byte of the file, which is in the data of the only block.
+            std::fstream stream(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+            stream.seekg(-1, std::ios::end);
+            char c = stream.get() ^ 1;
+            stream.seekp(-1, std::ios::end);
+            stream.put(c);
+        }
+        ASSERT_THROWS_CODE(it->more(), MsgAssertionException, 28761);
+    }
+};
+
 class SorterSuite : public mongo::unittest::Suite {
 public:
     SorterSuite() : Suite("sorter") {}
@@ -559,6 +699,9 @@ public:
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/true>>();    // fits in mem
         add<SorterTests::LotsOfDataWithLimit<5000, /*random=*/false>>();  // spills
         add<SorterTests::LotsOfDataWithLimit<5000, /*random=*/true>>();   // spills
+        add<KeyStringKeys>();
+        add<SpillCompressors>();
+        add<SpillChecksum>();
     }
 };
 
@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/stats/latency_histogram.h"
+
+#include <algorithm>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+void LatencyHistogram::record(unsigned long long micros) {
+    _count.fetchAndAdd(1);
+    _totalMicros.fetchAndAdd(micros);
+    _buckets[getBucket(micros)].fetchAndAdd(1);
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    _count.fetchAndAdd(other._count.load());
+    _totalMicros.fetchAndAdd(other._totalMicros.load());
+    for (int i = 0; i < kNumBuckets; i++) {
+        _buckets[i].fetchAndAdd(other._buckets[i].load());
+    }
+}
+
+unsigned long long LatencyHistogram::getPercentileMicros(double fraction) const {
+    unsigned long long total = 0;
+    std::array<unsigned long long, kNumBuckets> counts;
+    for (int i = 0; i < kNumBuckets; i++) {
+        counts[i] = _buckets[i].load();
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const double target = std::max(1.0, fraction * total);
+    unsigned long long seen = 0;
+    for (int i = 0; i < kNumBuckets - 1; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            return getBucketLowerBound(i + 1);
+        }
+    }
+    return getBucketLowerBound(kNumBuckets - 1);
+}
+
+void LatencyHistogram::append(BSONObjBuilder* builder) const {
+    builder->append("count", static_cast<long long>(getCount()));
+    builder->append("totalMicros", static_cast<long long>(getTotalMicros()));
+
+    BSONArrayBuilder histogram(builder->subarrayStart("histogram"));
+    for (int i = 0; i < kNumBuckets; i++) {
+        const unsigned long long count = _buckets[i].load();
+        if (count == 0) {
+            continue;
+        }
+        histogram.append(BSON("micros" << static_cast<long long>(getBucketLowerBound(i))
+                                       << "count" << static_cast<long long>(count)));
+    }
+    histogram.doneFast();
+}
+
+int LatencyHistogram::getBucket(unsigned long long micros) {
+    // The number of significant bits is the index of the bucket whose bounds hold 'micros'.
+    return std::min(64 - countLeadingZeros64(micros), kNumBuckets - 1);
+}
+
+unsigned long long LatencyHistogram::getBucketLowerBound(int bucket) {
+    return bucket == 0 ? 0 : 1ULL << (bucket - 1);
+}
+
+}  // namespace mongo
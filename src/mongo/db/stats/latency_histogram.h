@@ -0,0 +1,94 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Counts latencies in buckets whose bounds grow by powers of two, so that their distribution can
+ * be reported along with their count and sum. Bucket 0 holds latencies under 1 microsecond, and
+ * bucket i > 0 those from 2^(i-1) up to 2^i microseconds. The last bucket is open ended.
+ *
+ * Recording is lock free and may race with reporting, so a report is not an exact snapshot.
+ */
+class LatencyHistogram {
+public:
+    static const int kNumBuckets = 28;  // The last bucket starts at 2^26 micros, about 67s.
+
+    void record(unsigned long long micros);
+
+    /**
+     * Adds the latencies recorded by 'other' to this.
+     */
+    void add(const LatencyHistogram& other);
+
+    unsigned long long getCount() const {
+        return _count.load();
+    }
+
+    unsigned long long getTotalMicros() const {
+        return _totalMicros.load();
+    }
+
+    /**
+     * Returns the upper bound in microseconds of the bucket holding the latency that 'fraction'
+     * of the recorded latencies are at or below, or 0 if nothing was recorded. The last, open
+     * ended bucket reports its lower bound.
+     */
+    unsigned long long getPercentileMicros(double fraction) const;
+
+    /**
+     * Appends {count, totalMicros, histogram: [{micros, count}, ...]} to 'builder', where each
+     * histogram entry gives the lower bound of a nonempty bucket and how many latencies it holds.
+     */
+    void append(BSONObjBuilder* builder) const;
+
+    /**
+     * Returns the index of the bucket that holds 'micros'.
+     */
+    static int getBucket(unsigned long long micros);
+
+    /**
+     * Returns the lowest latency in microseconds that falls into 'bucket'.
+     */
+    static unsigned long long getBucketLowerBound(int bucket);
+
+private:
+    AtomicUInt64 _count;
+    AtomicUInt64 _totalMicros;
+    std::array<AtomicUInt64, kNumBuckets> _buckets;
+};
+
+}  // namespace mongo
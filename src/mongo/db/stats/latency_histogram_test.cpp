@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+using namespace mongo;
+
+TEST(LatencyHistogramTest, Buckets) {
+    ASSERT_EQUALS(0, LatencyHistogram::getBucket(0));
+    ASSERT_EQUALS(1, LatencyHistogram::getBucket(1));
+    ASSERT_EQUALS(2, LatencyHistogram::getBucket(2));
+    ASSERT_EQUALS(2, LatencyHistogram::getBucket(3));
+    ASSERT_EQUALS(11, LatencyHistogram::getBucket(1024));
+    ASSERT_EQUALS(11, LatencyHistogram::getBucket(2047));
+    ASSERT_EQUALS(LatencyHistogram::kNumBuckets - 1, LatencyHistogram::getBucket(~0ULL));
+
+    for (int i = 0; i < LatencyHistogram::kNumBuckets; i++) {
+        const unsigned long long lowerBound = LatencyHistogram::getBucketLowerBound(i);
+        ASSERT_EQUALS(i, LatencyHistogram::getBucket(lowerBound));
+        if (lowerBound > 0) {
+            ASSERT_EQUALS(i - 1, LatencyHistogram::getBucket(lowerBound - 1));
+        }
+    }
+}
+
+TEST(LatencyHistogramTest, AppendEmpty) {
+    LatencyHistogram histogram;
+    BSONObjBuilder builder;
+    histogram.append(&builder);
+    ASSERT_EQUALS(BSON("count" << 0 << "totalMicros" << 0 << "histogram" << BSONArray()),
+                  builder.obj());
+    ASSERT_EQUALS(0ULL, histogram.getPercentileMicros(0.5));
+}
+
+TEST(LatencyHistogramTest, AppendOnlyNonEmptyBuckets) {
+    LatencyHistogram histogram;
+    histogram.record(0);
+    histogram.record(5);
+    histogram.record(6);
+    histogram.record(1000);
+
+    BSONObjBuilder builder;
+    histogram.append(&builder);
+    ASSERT_EQUALS(BSON("count" << 4 << "totalMicros" << 1011 << "histogram"
+                               << BSON_ARRAY(BSON("micros" << 0 << "count" << 1)
+                                             << BSON("micros" << 4 << "count" << 2)
+                                             << BSON("micros" << 512 << "count" << 1))),
+                  builder.obj());
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 90; i++) {
+        histogram.record(10);
+    }
+    for (int i = 0; i < 9; i++) {
+        histogram.record(100);
+    }
+    histogram.record(100 * 1000 * 1000);
+
+    ASSERT_EQUALS(16ULL, histogram.getPercentileMicros(0));
+    ASSERT_EQUALS(16ULL, histogram.getPercentileMicros(0.5));
+    ASSERT_EQUALS(16ULL, histogram.getPercentileMicros(0.9));
+    ASSERT_EQUALS(128ULL, histogram.getPercentileMicros(0.99));
+    ASSERT_EQUALS(LatencyHistogram::getBucketLowerBound(LatencyHistogram::kNumBuckets - 1),
+                  histogram.getPercentileMicros(1));
+}
+
+}  // namespace
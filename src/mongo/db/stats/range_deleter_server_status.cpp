@@ -38,6 +38,12 @@ namespace mongo {
  * Sample format:
  *
  * rangeDeleter: {
+ *   pendingDeletes: 2,
+ *   deletesInProgress: 1,
+ *   deletedDocs: NumberLong(1000),
+ *   deletedBytes: NumberLong(64000),
+ *   deletedBatches: NumberLong(8),
+ *   throttledMillis: NumberLong(500),
  *   lastDeleteStats: [
  *     {
  *       deleteDocs: NumberLong(5);
@@ -65,6 +71,10 @@ public:
         }
 
         BSONObjBuilder result;
+        result.appendNumber("pendingDeletes", static_cast<long long>(deleter->getPendingDeletes()));
+        result.appendNumber("deletesInProgress",
+                            static_cast<long long>(deleter->getDeletesInProgress()));
+        deleter->getThrottle().append(&result);
 
         OwnedPointerVector<DeleteJobStats> statsList;
         deleter->getStatsHistory(&statsList.mutableVector());
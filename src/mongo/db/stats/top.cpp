@@ -35,6 +35,8 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/service_context.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/log.h"
 #include "mongo/util/net/message.h"
 
@@ -49,6 +51,11 @@ namespace {
 
 const auto getTop = ServiceContext::declareDecoration<Top>();
 
+// Threads are assigned stripes round robin, on their first use of Top. The thread local holds the
+// stripe index plus one, so that zero means not assigned yet.
+AtomicUInt32 nextStripe;
+MONGO_TRIVIALLY_CONSTRUCTIBLE_THREAD_LOCAL unsigned threadStripe;
+
 }  // namespace
 
 Top::UsageData::UsageData(const UsageData& older, const UsageData& newer) {
@@ -68,6 +75,44 @@ Top::CollectionData::CollectionData(const CollectionData& older, const Collectio
       remove(older.remove, newer.remove),
       commands(older.commands, newer.commands) {}
 
+void Top::CollectionData::add(const CollectionData& other) {
+    total.add(other.total);
+    readLock.add(other.readLock);
+    writeLock.add(other.writeLock);
+    queries.add(other.queries);
+    getmore.add(other.getmore);
+    insert.add(other.insert);
+    update.add(other.update);
+    remove.add(other.remove);
+    commands.add(other.commands);
+    if (other.latency) {
+        if (!latency) {
+            latency = std::make_shared<OperationLatencyHistograms>();
+        }
+        latency->add(*other.latency);
+    }
+}
+
+void Top::OperationLatencyHistograms::add(const OperationLatencyHistograms& other) {
+    reads.add(other.reads);
+    writes.add(other.writes);
+    commands.add(other.commands);
+}
+
+void Top::OperationLatencyHistograms::append(BSONObjBuilder* builder) const {
+    BSONObjBuilder readsBuilder(builder->subobjStart("reads"));
+    reads.append(&readsBuilder);
+    readsBuilder.doneFast();
+
+    BSONObjBuilder writesBuilder(builder->subobjStart("writes"));
+    writes.append(&writesBuilder);
+    writesBuilder.doneFast();
+
+    BSONObjBuilder commandsBuilder(builder->subobjStart("commands"));
+    commands.append(&commandsBuilder);
+    commandsBuilder.doneFast();
+}
+
 // static
 Top& Top::get(ServiceContext* service) {
     return getTop(service);
@@ -78,14 +123,18 @@ void Top::record(StringData ns, int op, int lockType, long long micros, bool com
         return;
 
     // cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-    stdx::lock_guard<SimpleMutex> lk(_lock);
+    Stripe& stripe = _getStripe();
+    stdx::lock_guard<SimpleMutex> lk(stripe.lock);
 
-    if ((command || op == dbQuery) && ns == _lastDropped) {
-        _lastDropped = "";
+    if ((command || op == dbQuery) && ns == stripe.lastDropped) {
+        stripe.lastDropped = "";
         return;
     }
 
-    CollectionData& coll = _usage[ns];
+    CollectionData& coll = stripe.usage[ns];
+    if (!coll.latency) {
+        coll.latency = std::make_shared<OperationLatencyHistograms>();
+    }
     _record(coll, op, lockType, micros, command);
 }
 
@@ -103,21 +152,28 @@ void Top::_record(CollectionData& c, int op, int lockType, long long micros, boo
             break;
         case dbUpdate:
             c.update.inc(micros);
+            c.latency->writes.record(micros);
             break;
         case dbInsert:
             c.insert.inc(micros);
+            c.latency->writes.record(micros);
             break;
         case dbQuery:
-            if (command)
+            if (command) {
                 c.commands.inc(micros);
-            else
+                c.latency->commands.record(micros);
+            } else {
                 c.queries.inc(micros);
+                c.latency->reads.record(micros);
+            }
             break;
         case dbGetMore:
             c.getmore.inc(micros);
+            c.latency->reads.record(micros);
             break;
         case dbDelete:
             c.remove.inc(micros);
+            c.latency->writes.record(micros);
             break;
         case dbKillCursors:
             break;
@@ -128,6 +184,7 @@ void Top::_record(CollectionData& c, int op, int lockType, long long micros, boo
             break;
         case dbCommand:
             c.commands.inc(micros);
+            c.latency->commands.record(micros);
             break;
         default:
             log() << "unknown op in Top::record: " << op << endl;
@@ -135,19 +192,54 @@ void Top::_record(CollectionData& c, int op, int lockType, long long micros, boo
 }
 
 void Top::collectionDropped(StringData ns) {
-    stdx::lock_guard<SimpleMutex> lk(_lock);
-    _usage.erase(ns);
-    _lastDropped = ns.toString();
+    Stripe& ownStripe = _getStripe();
+    for (Stripe& stripe : _stripes) {
+        stdx::lock_guard<SimpleMutex> lk(stripe.lock);
+        stripe.usage.erase(ns);
+        if (&stripe == &ownStripe) {
+            stripe.lastDropped = ns.toString();
+        }
+    }
 }
 
 void Top::cloneMap(Top::UsageMap& out) const {
-    stdx::lock_guard<SimpleMutex> lk(_lock);
-    out = _usage;
+    UsageMap usage;
+    _mergeStripes(&usage);
+    out = usage;
 }
 
 void Top::append(BSONObjBuilder& b) {
-    stdx::lock_guard<SimpleMutex> lk(_lock);
-    _appendToUsageMap(b, _usage);
+    UsageMap usage;
+    _mergeStripes(&usage);
+    _appendToUsageMap(b, usage);
+}
+
+void Top::appendLatencyStats(StringData ns, BSONObjBuilder* builder) const {
+    OperationLatencyHistograms latency;
+    for (Stripe& stripe : _stripes) {
+        stdx::lock_guard<SimpleMutex> lk(stripe.lock);
+        auto it = stripe.usage.find(ns);
+        if (it != stripe.usage.end() && it->second.latency) {
+            latency.add(*it->second.latency);
+        }
+    }
+    latency.append(builder);
+}
+
+Top::Stripe& Top::_getStripe() {
+    if (!threadStripe) {
+        threadStripe = nextStripe.fetchAndAdd(1) % kNumStripes + 1;
+    }
+    return _stripes[threadStripe - 1];
+}
+
+void Top::_mergeStripes(UsageMap* out) const {
+    for (Stripe& stripe : _stripes) {
+        stdx::lock_guard<SimpleMutex> lk(stripe.lock);
+        for (UsageMap::const_iterator i = stripe.usage.begin(); i != stripe.usage.end(); ++i) {
+            (*out)[i->first].add(i->second);
+        }
+    }
 }
 
 void Top::_appendToUsageMap(BSONObjBuilder& b, const UsageMap& map) const {
@@ -177,6 +269,12 @@ void Top::_appendToUsageMap(BSONObjBuilder& b, const UsageMap& map) const {
         _appendStatsEntry(b, "remove", coll.remove);
         _appendStatsEntry(b, "commands", coll.commands);
 
+        if (coll.latency) {
+            BSONObjBuilder latencyBuilder(bb.subobjStart("latencyStats"));
+            coll.latency->append(&latencyBuilder);
+            latencyBuilder.doneFast();
+        }
+
         bb.done();
     }
 }
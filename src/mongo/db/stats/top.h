@@ -29,17 +29,24 @@
 
 #pragma once
 
+#include <array>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <memory>
 
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
 class ServiceContext;
 
 /**
  * tracks usage by collection
+ *
+ * Operations record their usage into one of several stripes, chosen by their thread, so that
+ * concurrent operations rarely contend on the same mutex. Readers merge the stripes.
  */
 class Top {
 public:
@@ -57,6 +64,28 @@ public:
             count++;
             time += micros;
         }
+
+        void add(const UsageData& other) {
+            count += other.count;
+            time += other.time;
+        }
+    };
+
+    /**
+     * Latency distributions of the operations on a collection by kind of operation. Each stripe
+     * records into its own, and readers add those of all stripes together.
+     */
+    struct OperationLatencyHistograms {
+        LatencyHistogram reads;
+        LatencyHistogram writes;
+        LatencyHistogram commands;
+
+        void add(const OperationLatencyHistograms& other);
+
+        /**
+         * Appends {reads: {...}, writes: {...}, commands: {...}} to 'builder'.
+         */
+        void append(BSONObjBuilder* builder) const;
     };
 
     struct CollectionData {
@@ -77,6 +106,16 @@ public:
         UsageData update;
         UsageData remove;
         UsageData commands;
+
+        // Not part of a diff, which only covers the usage counts. Held by pointer as histograms
+        // cannot be copied.
+        std::shared_ptr<OperationLatencyHistograms> latency;
+
+        /**
+         * Adds the usage counts and latencies of 'other' to this. The latencies are added into
+         * histograms of this entry's own.
+         */
+        void add(const CollectionData& other);
     };
 
     typedef StringMap<CollectionData> UsageMap;
@@ -87,14 +126,41 @@ public:
     void cloneMap(UsageMap& out) const;
     void collectionDropped(StringData ns);
 
+    /**
+     * Appends the latency histograms of the operations on 'ns' to 'builder', as described in
+     * OperationLatencyHistograms::append. The histograms are empty if 'ns' has not been used.
+     */
+    void appendLatencyStats(StringData ns, BSONObjBuilder* builder) const;
+
 private:
+    static const int kNumStripes = 16;
+
+    // Stripes are padded to a multiple of this, so that neighbouring stripes do not share a cache
+    // line. Top lives in a ServiceContext decoration, which is not allocated with more than the
+    // default alignment, so over-aligning the stripes would not be honoured.
+    static const size_t kStripePadding = 128;
+
+    struct Stripe {
+        SimpleMutex lock;
+        UsageMap usage;
+
+        // The collection dropped last by a thread of this stripe. The command that dropped it
+        // records its usage on the same thread afterwards, which must not bring the entry back.
+        std::string lastDropped;
+
+        char padding[kStripePadding -
+                     (sizeof(SimpleMutex) + sizeof(UsageMap) + sizeof(std::string)) %
+                         kStripePadding];
+    };
+
+    Stripe& _getStripe();
+    void _mergeStripes(UsageMap* out) const;
+
     void _appendToUsageMap(BSONObjBuilder& b, const UsageMap& map) const;
     void _appendStatsEntry(BSONObjBuilder& b, const char* statsName, const UsageData& map) const;
     void _record(CollectionData& c, int op, int lockType, long long micros, bool command);
 
-    mutable SimpleMutex _lock;
-    UsageMap _usage;
-    std::string _lastDropped;
+    mutable std::array<Stripe, kNumStripes> _stripes;
 };
 
 }  // namespace mongo
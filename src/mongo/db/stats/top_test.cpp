@@ -29,7 +29,13 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/stats/top.h"
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/net/message.h"
 
 namespace {
 
@@ -39,4 +45,83 @@ TEST(TopTest, CollectionDropped) {
     Top().collectionDropped("coll");
 }
 
+TEST(TopTest, MergesUsageRecordedByManyThreads) {
+    Top top;
+    std::vector<stdx::thread> threads;
+    for (int i = 0; i < 20; i++) {
+        threads.emplace_back([&top] {
+            for (int j = 0; j < 100; j++) {
+                top.record("test.coll", dbInsert, 1, 10, false);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Top::UsageMap usage;
+    top.cloneMap(usage);
+    ASSERT_EQUALS(1U, usage.size());
+    ASSERT_EQUALS(2000, usage["test.coll"].insert.count);
+    ASSERT_EQUALS(20000, usage["test.coll"].total.time);
+    ASSERT_EQUALS(2000, usage["test.coll"].writeLock.count);
+
+    // Each stripe has its own histograms, which are added together.
+    BSONObjBuilder builder;
+    top.appendLatencyStats("test.coll", &builder);
+    BSONObj stats = builder.obj();
+    ASSERT_EQUALS(2000, stats["writes"]["count"].numberLong());
+    ASSERT_EQUALS(20000, stats["writes"]["totalMicros"].numberLong());
+    ASSERT_EQUALS(2000, usage["test.coll"].latency->writes.getCount());
+}
+
+TEST(TopTest, LatencyStatsByOperationType) {
+    Top top;
+    top.record("test.coll", dbQuery, -1, 5, false);
+    top.record("test.coll", dbGetMore, -1, 100, false);
+    top.record("test.coll", dbUpdate, 1, 1000, false);
+    top.record("test.coll", dbQuery, -1, 7, true);
+    top.record("test.other", dbDelete, 1, 3, false);
+
+    BSONObjBuilder builder;
+    top.appendLatencyStats("test.coll", &builder);
+    BSONObj stats = builder.obj();
+    ASSERT_EQUALS(2, stats["reads"]["count"].numberLong());
+    ASSERT_EQUALS(105, stats["reads"]["totalMicros"].numberLong());
+    ASSERT_EQUALS(2U, stats["reads"]["histogram"].Array().size());
+    ASSERT_EQUALS(1, stats["writes"]["count"].numberLong());
+    ASSERT_EQUALS(1000, stats["writes"]["totalMicros"].numberLong());
+    ASSERT_EQUALS(1, stats["commands"]["count"].numberLong());
+
+    // Dropping the collection resets its histograms
+    top.collectionDropped("test.coll");
+    BSONObjBuilder droppedBuilder;
+    top.appendLatencyStats("test.coll", &droppedBuilder);
+    BSONObj dropped = droppedBuilder.obj();
+    ASSERT_EQUALS(0, dropped["reads"]["count"].numberLong());
+    ASSERT_EQUALS(0, dropped["writes"]["count"].numberLong());
+    ASSERT_EQUALS(0, dropped["commands"]["count"].numberLong());
+
+    Top::UsageMap usage;
+    top.cloneMap(usage);
+    ASSERT_EQUALS(1U, usage.size());
+    ASSERT_EQUALS(1, usage["test.other"].remove.count);
+}
+
+TEST(TopTest, DropCommandDoesNotRecreateUsage) {
+    Top top;
+    top.record("test.coll", dbInsert, 1, 10, false);
+    top.collectionDropped("test.coll");
+
+    // The drop command itself is recorded on the thread that dropped the collection
+    top.record("test.coll", dbCommand, 1, 10, true);
+    Top::UsageMap usage;
+    top.cloneMap(usage);
+    ASSERT_EQUALS(0U, usage.size());
+
+    top.record("test.coll", dbInsert, 1, 10, false);
+    top.cloneMap(usage);
+    ASSERT_EQUALS(1U, usage.size());
+}
+
 }  // namespace
@@ -1107,6 +1107,15 @@ RecordId KeyString::decodeRecordIdAtEnd(const void* bufferRaw, size_t bufSize) {
     return decodeRecordId(&reader);
 }
 
+size_t KeyString::sizeWithoutRecordIdAtEnd(const void* bufferRaw, size_t bufSize) {
+    invariant(bufSize >= 2);  // smallest possible encoding of a RecordId.
+    const unsigned char* buffer = static_cast<const unsigned char*>(bufferRaw);
+    const unsigned char lastByte = *(buffer + bufSize - 1);
+    const size_t ridSize = 2 + (lastByte & 0x7);  // stored in low 3 bits.
+    invariant(bufSize >= ridSize);
+    return bufSize - ridSize;
+}
+
 RecordId KeyString::decodeRecordId(BufReader* reader) {
     const uint8_t firstByte = readType<uint8_t>(reader, false);
     const uint8_t numExtraBytes = firstByte >> 5;  // high 3 bits in firstByte
@@ -1151,6 +1160,71 @@ int KeyString::compare(const KeyString& other) const {
     return a < b ? -1 : 1;
 }
 
+KeyString::Value KeyString::getValue() const {
+    const int32_t keySize = getSize();
+    const int32_t size = keySize + _typeBits.getSize();
+    SharedBuffer buffer = SharedBuffer::allocate(size);
+    memcpy(buffer.get(), getBuffer(), keySize);
+    memcpy(buffer.get() + keySize, _typeBits.getBuffer(), _typeBits.getSize());
+    return Value(std::move(buffer), keySize, size);
+}
+
+KeyString::TypeBits KeyString::Value::getTypeBits() const {
+    BufReader reader(_buffer.get() + _keySize, _size - _keySize);
+    return TypeBits::fromBuffer(&reader);
+}
+
+int KeyString::Value::compare(const Value& other) const {
+    const int cmp = memcmp(getBuffer(), other.getBuffer(), std::min(_keySize, other._keySize));
+    if (cmp)
+        return cmp < 0 ? -1 : 1;
+
+    if (_keySize == other._keySize)
+        return 0;
+    return _keySize < other._keySize ? -1 : 1;
+}
+
+void KeyString::Value::serializeForSorter(BufBuilder& buf, const Value* previous) const {
+    // The Sorter writes keys in order, so each key often shares a long prefix with the one
+    // before it.
+    int32_t prefixSize = 0;
+    if (previous) {
+        const int32_t maxPrefixSize = std::min(_keySize, previous->_keySize);
+        const char* data = getBuffer();
+        const char* previousData = previous->getBuffer();
+        while (prefixSize < maxPrefixSize && data[prefixSize] == previousData[prefixSize]) {
+            prefixSize++;
+        }
+    }
+
+    const uint8_t typeBitsSize = _size - _keySize;
+    buf.appendNum(prefixSize);
+    buf.appendNum(_keySize - prefixSize);
+    buf.appendNum(static_cast<char>(typeBitsSize));
+    buf.appendBuf(getBuffer() + prefixSize, _size - prefixSize);
+}
+
+KeyString::Value KeyString::Value::deserializeForSorter(BufReader& buf,
+                                                        const SorterDeserializeSettings&,
+                                                        const Value* previous) {
+    const int32_t prefixSize = buf.read<int32_t>();
+    const int32_t suffixSize = buf.read<int32_t>();
+    const uint8_t typeBitsSize = buf.read<uint8_t>();
+    massert(28754,
+            "corrupt KeyString in sort file",
+            prefixSize >= 0 && suffixSize >= 0 &&
+                (prefixSize == 0 || (previous && prefixSize <= previous->_keySize)));
+
+    const int32_t keySize = prefixSize + suffixSize;
+    const int32_t size = keySize + typeBitsSize;
+    SharedBuffer buffer = SharedBuffer::allocate(size);
+    if (prefixSize) {
+        memcpy(buffer.get(), previous->getBuffer(), prefixSize);
+    }
+    memcpy(buffer.get() + prefixSize, buf.skip(size - prefixSize), size - prefixSize);
+    return Value(std::move(buffer), keySize, size);
+}
+
 void KeyString::TypeBits::resetFromBuffer(BufReader* reader) {
     if (!reader->remaining()) {
         // This means AllZeros state was encoded as an empty buffer.
@@ -30,12 +30,15 @@
 
 #pragma once
 
+#include <type_traits>
+
 #include "mongo/bson/bsonobj.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/bson/timestamp.h"
 #include "mongo/bson/ordering.h"
 #include "mongo/db/record_id.h"
+#include "mongo/util/shared_buffer.h"
 
 namespace mongo {
 
@@ -205,6 +208,56 @@ public:
         uint8_t _buf[1 /*size*/ + kMaxBytesNeeded];
     };
 
+    /**
+     * An immutable copy of a KeyString's bytes and TypeBits, held in one reference counted
+     * buffer. Unlike a KeyString it is small and cheap to copy, so many of them can be held in
+     * memory, as the external Sorter does when it sorts encoded keys by comparing their bytes.
+     */
+    class Value {
+    public:
+        Value() = default;
+
+        const char* getBuffer() const {
+            return _buffer.get();
+        }
+        size_t getSize() const {
+            return _keySize;
+        }
+
+        TypeBits getTypeBits() const;
+
+        int compare(const Value& other) const;
+
+        //
+        // Sorter support. Sorted keys are written to spill files as the part of each key that
+        // follows the prefix it shares with the key written before it, if any.
+        //
+
+        struct SorterDeserializeSettings {};
+
+        void serializeForSorter(BufBuilder& buf, const Value* previous = nullptr) const;
+        static Value deserializeForSorter(BufReader& buf,
+                                          const SorterDeserializeSettings&,
+                                          const Value* previous = nullptr);
+        int memUsageForSorter() const {
+            return sizeof(Value) + sizeof(SharedBuffer::Holder) + _size;
+        }
+        Value getOwned() const {
+            return *this;
+        }
+
+    private:
+        friend class KeyString;
+
+        Value(SharedBuffer buffer, int32_t keySize, int32_t size)
+            : _buffer(std::move(buffer)), _keySize(keySize), _size(size) {}
+
+        // The key's bytes followed by its encoded TypeBits.
+        SharedBuffer _buffer;
+        int32_t _keySize = 0;
+        int32_t _size = 0;
+    };
+
     enum Discriminator {
         kInclusive,  // Anything to be stored in an index must use this.
         kExclusiveBefore,
@@ -233,6 +286,11 @@ public:
      */
     static RecordId decodeRecordIdAtEnd(const void* buf, size_t size);
 
+    /**
+     * Returns the size of a buffer holding a key followed by a RecordId, without the RecordId.
+     */
+    static size_t sizeWithoutRecordIdAtEnd(const void* buf, size_t size);
+
     /**
      * Decodes a RecordId, consuming all bytes needed from reader.
      */
@@ -271,6 +329,11 @@ public:
         return _typeBits;
     }
 
+    /**
+     * Returns a copy of this KeyString's bytes and TypeBits.
+     */
+    Value getValue() const;
+
     int compare(const KeyString& other) const;
 
     /**
@@ -350,4 +413,11 @@ inline std::ostream& operator<<(std::ostream& stream, const KeyString& value) {
     return stream << value.toString();
 }
 
+// Defined in sorter.h.
+template <typename Key>
+struct SorterKeyUsesPreviousKey;
+
+template <>
+struct SorterKeyUsesPreviousKey<KeyString::Value> : std::true_type {};
+
 }  // namespace mongo
@@ -38,6 +38,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/hex.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/base/owned_pointer_vector.h"
 
 using std::string;
@@ -839,3 +840,52 @@ TEST(KeyStringTest, RecordIds) {
         }
     }
 }
+
+TEST(KeyStringTest, ValueKeepsBytesAndTypeBits) {
+    const BSONObj key = BSON("" << 1.0 << ""
+                                << "abc");
+    const KeyString ks(key, ALL_ASCENDING, RecordId(7));
+    const KeyString::Value value = ks.getValue();
+
+    ASSERT_EQ(ks.getSize(), value.getSize());
+    ASSERT_EQ(0, memcmp(ks.getBuffer(), value.getBuffer(), ks.getSize()));
+    ASSERT_EQ(RecordId(7), KeyString::decodeRecordIdAtEnd(value.getBuffer(), value.getSize()));
+
+    const size_t keySize = KeyString::sizeWithoutRecordIdAtEnd(value.getBuffer(), value.getSize());
+    ASSERT_EQ(KeyString(key, ALL_ASCENDING).getSize(), keySize);
+    const BSONObj decoded =
+        KeyString::toBson(value.getBuffer(), keySize, ALL_ASCENDING, value.getTypeBits());
+    ASSERT(decoded.binaryEqual(key));
+}
+
+TEST(KeyStringTest, ValueSerializesForSorterRelativeToPreviousKey) {
+    std::vector<KeyString::Value> values;
+    for (int i = 0; i < 100; i++) {
+        const std::string prefix = str::stream() << "a long common prefix " << i / 10;
+        const BSONObj key = BSON("" << prefix << "" << (i % 3 ? static_cast<double>(i) : i));
+        values.push_back(KeyString(key, ONE_DESCENDING, RecordId(i + 1)).getValue());
+    }
+
+    BufBuilder whole;
+    BufBuilder relative;
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i].serializeForSorter(whole);
+        values[i].serializeForSorter(relative, i ? &values[i - 1] : nullptr);
+    }
+    ASSERT_LESS_THAN(relative.len(), whole.len());
+
+    BufReader reader(relative.buf(), relative.len());
+    KeyString::Value previous;
+    for (size_t i = 0; i < values.size(); i++) {
+        const KeyString::Value value = KeyString::Value::deserializeForSorter(
+            reader, KeyString::Value::SorterDeserializeSettings(), i ? &previous : nullptr);
+        ASSERT_EQ(0, value.compare(values[i]));
+        ASSERT_EQ(values[i].getTypeBits().getSize(), value.getTypeBits().getSize());
+        ASSERT_EQ(0,
+                  memcmp(values[i].getTypeBits().getBuffer(),
+                         value.getTypeBits().getBuffer(),
+                         value.getTypeBits().getSize()));
+        previous = value;
+    }
+    ASSERT(reader.atEof());
+}
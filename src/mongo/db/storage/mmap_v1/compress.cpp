@@ -33,6 +33,10 @@
 #include "mongo/db/storage/mmap_v1/compress.h"
 
 #include <snappy.h>
+#include <zlib.h>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
@@ -54,4 +58,35 @@ size_t compress(const char* input, size_t input_length, std::string* output) {
 bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed) {
     return snappy::Uncompress(compressed, compressed_length, uncompressed);
 }
+
+size_t zlibMaxCompressedLength(size_t source_len) {
+    return compressBound(source_len);
+}
+
+void zlibRawCompress(const char* input,
+                     size_t input_length,
+                     char* compressed,
+                     size_t* compressed_length) {
+    uLongf length = compressBound(input_length);
+    const int ret = compress2(reinterpret_cast<Bytef*>(compressed),
+                              &length,
+                              reinterpret_cast<const Bytef*>(input),
+                              input_length,
+                              Z_BEST_SPEED);
+    massert(28766, str::stream() << "zlib compression failed: " << ret, ret == Z_OK);
+    *compressed_length = length;
+}
+
+bool zlibUncompress(const char* compressed,
+                    size_t compressed_length,
+                    size_t uncompressed_length,
+                    std::string* uncompressed) {
+    uncompressed->resize(uncompressed_length);
+    uLongf length = uncompressed_length;
+    const int ret = ::uncompress(reinterpret_cast<Bytef*>(&(*uncompressed)[0]),
+                                 &length,
+                                 reinterpret_cast<const Bytef*>(compressed),
+                                 compressed_length);
+    return ret == Z_OK && length == uncompressed_length;
+}
 }
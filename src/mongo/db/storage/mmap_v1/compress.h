@@ -43,4 +43,16 @@ void rawCompress(const char* input,
                  size_t input_length,
                  char* compressed,
                  size_t* compressed_length);
+
+// zlib counterparts of the above, for callers that favor size over speed. Unlike snappy, zlib
+// does not record the uncompressed length, so the caller must know it to uncompress.
+size_t zlibMaxCompressedLength(size_t source_len);
+void zlibRawCompress(const char* input,
+                     size_t input_length,
+                     char* compressed,
+                     size_t* compressed_length);
+bool zlibUncompress(const char* compressed,
+                    size_t compressed_length,
+                    size_t uncompressed_length,
+                    std::string* uncompressed);
 }
@@ -33,6 +33,9 @@
        we will build an output buffer ourself and then use O_DIRECT
        we could be in read lock for this
        for very large objects write directly to redo log in situ?
+     COMPRESSFORJOURNAL
+       compress the buffer into a journal section with the chosen compressor.  done by its own
+       thread, so that it overlaps with WRITETOJOURNAL of the previous group commit.
      WRITETOJOURNAL
        we could be unlocked (the main db lock that is...) for this, with sufficient care, but there
        is some complexity have to handle falling behind which would use too much ram (going back
@@ -58,6 +61,7 @@
      READLOCK mmmutex
        commitJob.reset()
      UNLOCK dbMutex                      // now other threads can write
+       COMPRESSFORJOURNAL()
        WRITETOJOURNAL()
        WRITETODATAFILES()
      UNLOCK mmmutex
@@ -135,10 +139,10 @@ enum {
     // How many commit cycles to do before considering doing a remap
     NumCommitsBeforeRemap = 10,
 
-    // How many outstanding journal flushes should be allowed before applying writer back
-    // pressure. Size of 1 allows two journal blocks to be in the process of being written -
-    // one on the journal writer's buffer and one blocked waiting to be picked up.
-    NumAsyncJournalWrites = 1,
+    // How many journal buffers there are, which bounds how many group commits may be in the
+    // process of being written before applying writer back pressure. Size of 2 lets one group
+    // commit be prepared or compressed while the previous one is written.
+    NumAsyncJournalWrites = 2,
 };
 
 // Remap loop state
@@ -447,6 +451,21 @@ BSONObj Stats::asObj() const {
     BSONObjBuilder builder;
     stats._asObj(&builder);
 
+    BSONObjBuilder latency(builder.subobjStart("latencyMicros"));
+    const std::pair<const char*, const LatencyHistogram*> histograms[] = {
+        {"prepLogBuffer", &prepLogBufferLatency},
+        {"compress", &compressLatency},
+        {"writeToJournal", &writeToJournalLatency},
+        {"fsync", &fsyncLatency},
+        {"writeToDataFiles", &writeToDataFilesLatency},
+    };
+    for (auto&& histogram : histograms) {
+        BSONObjBuilder phase(latency.subobjStart(histogram.first));
+        histogram.second->append(&phase);
+        phase.doneFast();
+    }
+    latency.doneFast();
+
     return builder.obj();
 }
 
@@ -479,7 +498,8 @@ void Stats::S::_asObj(BSONObjBuilder* builder) const {
       << _journaledBytes / (_uncompressedBytes + 1.0) << "commitsInWriteLock" << _commitsInWriteLock
       << "earlyCommits" << 0 << "timeMs"
       << BSON("dt" << _durationMillis << "prepLogBuffer" << (unsigned)(_prepLogBufferMicros / 1000)
-                   << "writeToJournal" << (unsigned)(_writeToJournalMicros / 1000)
+                   << "compress" << (unsigned)(_compressMicros / 1000) << "writeToJournal"
+                   << (unsigned)(_writeToJournalMicros / 1000)
                    << "writeToDataFiles" << (unsigned)(_writeToDataFilesMicros / 1000)
                    << "remapPrivateView" << (unsigned)(_remapPrivateViewMicros / 1000) << "commits"
                    << (unsigned)(_commitsMicros / 1000) << "commitsInWriteLock"
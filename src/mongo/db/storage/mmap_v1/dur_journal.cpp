@@ -37,9 +37,12 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include "mongo/base/disallow_copying.h"
 #include "mongo/base/init.h"
 #include "mongo/config.h"
 #include "mongo/db/client.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/storage/mmap_v1/mmap.h"
 #include "mongo/db/storage/mmap_v1/aligned_builder.h"
 #include "mongo/db/storage/mmap_v1/compress.h"
@@ -50,6 +53,7 @@
 #include "mongo/db/storage/mmap_v1/mmap_v1_options.h"
 #include "mongo/db/storage/paths.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/random.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/exit.h"
@@ -103,6 +107,99 @@ static_assert(sizeof(JSectFooter) == 32, "sizeof(JSectFooter) == 32");
 static_assert(sizeof(JEntry) == 12, "sizeof(JEntry) == 12");
 static_assert(sizeof(LSNFile) == 88, "sizeof(LSNFile) == 88");
 
+namespace {
+
+AtomicUInt32 journalCompressor(static_cast<unsigned>(JournalCompressor::kSnappy));
+
+JournalCompressor getJournalCompressor() {
+    return static_cast<JournalCompressor>(journalCompressor.load());
+}
+
+StringData journalCompressorName(JournalCompressor compressor) {
+    switch (compressor) {
+        case JournalCompressor::kSnappy:
+            return "snappy";
+        case JournalCompressor::kNone:
+            return "none";
+        case JournalCompressor::kZlib:
+            return "zlib";
+    }
+    MONGO_UNREACHABLE;
+}
+
+/**
+ * Binaries that predate the journalCompressor parameter read every section as snappy, so they
+ * cannot recover a journal holding sections written with none or zlib. Those compressors are only
+ * accepted when this is set at startup. To downgrade afterwards, set journalCompressor back to
+ * snappy, then shut down cleanly, which leaves no journal to recover, before starting the older
+ * binary.
+ */
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalAllowNewCompressors, bool, false);
+
+Status checkCompressorAllowed(JournalCompressor compressor) {
+    if (compressor == JournalCompressor::kSnappy || journalAllowNewCompressors) {
+        return Status::OK();
+    }
+    return Status(ErrorCodes::BadValue,
+                  str::stream() << "journalCompressor " << journalCompressorName(compressor)
+                                << " writes journals that older versions cannot recover, and"
+                                   " requires the journalAllowNewCompressors startup parameter");
+}
+
+/**
+ * Chooses how new journal sections are compressed. Every section records its compressor, so it
+ * may change at any time. Snappy is cheap, zlib writes less at a higher CPU cost, and none suits
+ * devices that are fast enough for compression to only cost time. Compressors other than snappy
+ * require journalAllowNewCompressors. So as not to depend on the order startup parameters are
+ * applied in, that is checked when set at runtime and by journalMakeDir() for the startup value.
+ */
+class JournalCompressorParameter : public ServerParameter {
+    MONGO_DISALLOW_COPYING(JournalCompressorParameter);
+
+public:
+    JournalCompressorParameter()
+        : ServerParameter(ServerParameterSet::getGlobal(), "journalCompressor", true, true) {}
+
+    virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
+        b.append(name, journalCompressorName(getJournalCompressor()));
+    }
+
+    virtual Status set(const BSONElement& newValueElement) {
+        if (newValueElement.type() != String) {
+            return Status(ErrorCodes::TypeMismatch,
+                          str::stream() << "Expected server parameter " << name()
+                                        << " to be a string, but found "
+                                        << typeName(newValueElement.type()));
+        }
+        const std::string str = newValueElement.String();
+        for (auto compressor :
+             {JournalCompressor::kSnappy, JournalCompressor::kNone, JournalCompressor::kZlib}) {
+            if (str == journalCompressorName(compressor)) {
+                Status status = checkCompressorAllowed(compressor);
+                if (!status.isOK()) {
+                    return status;
+                }
+            }
+        }
+        return setFromString(str);
+    }
+
+    virtual Status setFromString(const std::string& str) {
+        for (auto compressor :
+             {JournalCompressor::kSnappy, JournalCompressor::kNone, JournalCompressor::kZlib}) {
+            if (str == journalCompressorName(compressor)) {
+                journalCompressor.store(static_cast<unsigned>(compressor));
+                return Status::OK();
+            }
+        }
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "journalCompressor must be one of \"none\", \"snappy\" "
+                                       "or \"zlib\", not \"" << str << "\"");
+    }
+} journalCompressorParameter;
+
+}  // namespace
+
 bool usingPreallocate = false;
 
 void removeOldJournalFile(boost::filesystem::path p);
@@ -134,13 +231,33 @@ JSectFooter::JSectFooter() {
     sentinel = JEntry::OpCode_Footer;
 }
 
-JSectFooter::JSectFooter(const void* begin, int len) {  // needs buffer to compute hash
+JSectFooter::JSectFooter(const void* begin,
+                         int len,
+                         JournalCompressor compressor,
+                         unsigned uncompressedLen) {  // needs buffer to compute hash
     sentinel = JEntry::OpCode_Footer;
-    reserved = 0;
+    this->compressor = static_cast<unsigned char>(compressor);
+    memset(reserved, 0, sizeof(reserved));
+    this->uncompressedLen = uncompressedLen;
     magic[0] = magic[1] = magic[2] = magic[3] = '\n';
+    computeHash(begin, len);
+}
 
+namespace {
+Checksum sectionHash(const JSectFooter& f, const void* begin, int len) {
     Checksum c;
     c.gen(begin, (unsigned)len);
+    if (f.getCompressor() != JournalCompressor::kSnappy) {
+        const unsigned long long covered[4] = {
+            c.words[0], c.words[1], f.compressor, f.uncompressedLen};
+        c.gen(covered, sizeof(covered));
+    }
+    return c;
+}
+}  // namespace
+
+void JSectFooter::computeHash(const void* begin, int len) {
+    Checksum c = sectionHash(*this, begin, len);
     memcpy(hash, c.bytes, sizeof(hash));
 }
 
@@ -149,8 +266,7 @@ bool JSectFooter::checkHash(const void* begin, int len) const {
         log() << "journal footer not valid" << endl;
         return false;
     }
-    Checksum c;
-    c.gen(begin, len);
+    Checksum c = sectionHash(*this, begin, len);
     DEV log() << "checkHash len:" << len << " hash:" << toHex(hash, 16)
               << " current:" << toHex(c.bytes, 16) << endl;
     if (memcmp(hash, c.bytes, sizeof(hash)) == 0)
@@ -495,6 +611,7 @@ boost::filesystem::path findPrealloced() {
 
 /** assure journal/ dir exists. throws. call during startup. */
 void journalMakeDir() {
+    uassertStatusOK(checkCompressorAllowed(getJournalCompressor()));
     j.init();
 
     boost::filesystem::path p = getJournalDir();
@@ -717,26 +834,51 @@ void Journal::_rotate() {
     }
 }
 
-/** write (append) the buffer we have built to the journal and fsync it.
+/** compress the buffer we have built into a section for the journal.
+    does no i/o, so the journal writer may do this for one group commit while it is still
+    writing the previous one.
+    @param uncompressed - a buffer of operations that will be compressed into 'section'
+*/
+void COMPRESSFORJOURNAL(const JSectHeader& h,
+                        const AlignedBuilder& uncompressed,
+                        AlignedBuilder* section) {
+    Timer t;
+    j.buildSection(h, uncompressed, section);
+    const long long micros = t.micros();
+    stats.curr()->_compressMicros += micros;
+    stats.compressLatency.record(micros);
+}
+
+/** write (append) a section built by COMPRESSFORJOURNAL to the journal and fsync it.
     outside of dbMutex lock as this could be slow.
-    @param uncompressed - a buffer that will be written to the journal after compression
     will not return until on disk
 */
-void WRITETOJOURNAL(const JSectHeader& h, const AlignedBuilder& uncompressed) {
+void WRITETOJOURNAL(AlignedBuilder* section, unsigned uncompressedLen) {
     Timer t;
-    j.journal(h, uncompressed);
-    stats.curr()->_writeToJournalMicros += t.micros();
+    j.journal(section, uncompressedLen);
+    const long long micros = t.micros();
+    stats.curr()->_writeToJournalMicros += micros;
+    stats.writeToJournalLatency.record(micros);
 }
 
-void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
-    static AlignedBuilder b(32 * 1024 * 1024);
+void Journal::buildSection(const JSectHeader& h,
+                           const AlignedBuilder& uncompressed,
+                           AlignedBuilder* section) {
+    AlignedBuilder& b = *section;
     /* buffer to journal will be
        JSectHeader
        compressed operations
        JSectFooter
     */
+    const JournalCompressor compressor = getJournalCompressor();
     const unsigned headTailSize = sizeof(JSectHeader) + sizeof(JSectFooter);
-    const unsigned max = maxCompressedLength(uncompressed.len()) + headTailSize;
+    size_t maxLength = uncompressed.len();
+    if (compressor == JournalCompressor::kSnappy) {
+        maxLength = maxCompressedLength(uncompressed.len());
+    } else if (compressor == JournalCompressor::kZlib) {
+        maxLength = zlibMaxCompressedLength(uncompressed.len());
+    }
+    const unsigned max = maxLength + headTailSize;
     b.reset(max);
 
     {
@@ -745,9 +887,20 @@ void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed)
     }
 
     size_t compressedLength = 0;
-    rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+    switch (compressor) {
+        case JournalCompressor::kSnappy:
+            rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+            break;
+        case JournalCompressor::kNone:
+            memcpy(b.cur(), uncompressed.buf(), uncompressed.len());
+            compressedLength = uncompressed.len();
+            break;
+        case JournalCompressor::kZlib:
+            zlibRawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
+            break;
+    }
     verify(compressedLength < 0xffffffff);
-    verify(compressedLength < max);
+    verify(compressedLength <= maxLength);
     b.skip(compressedLength);
 
     // footer
@@ -761,13 +914,20 @@ void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed)
 
         ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded);
 
-        JSectFooter f(b.buf(), b.len());  // computes checksum
+        JSectFooter f(b.buf(), b.len(), compressor, uncompressed.len());  // computes checksum
         b.appendStruct(f);
         dassert(b.len() == lenUnpadded);
 
         b.skip(L - lenUnpadded);
         dassert(b.len() % Alignment == 0);
     }
+}
+
+void Journal::journal(AlignedBuilder* section, unsigned uncompressedLen) {
+    AlignedBuilder& b = *section;
+    JSectHeader* h = (JSectHeader*)b.atOfs(0);
+    const unsigned L = h->sectionLenWithPadding();
+    verify(b.len() == L);
 
     try {
         stdx::lock_guard<SimpleMutex> lk(_curLogFileMutex);
@@ -775,12 +935,23 @@ void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed)
         // must already be open -- so that _curFileId is correct for previous buffer building
         verify(_curLogFile);
 
-        stats.curr()->_uncompressedBytes += uncompressed.len();
-        unsigned w = b.len();
-        _written += w;
-        verify(w <= L);
+        // The section was prepared while an earlier one was written, and that write may have
+        // rotated to a new file since. Recovery stops at a section of another file, so claim
+        // this one for the current file.
+        if (h->fileId != _curFileId) {
+            h->fileId = _curFileId;
+            const unsigned footerOfs = h->sectionLen() - sizeof(JSectFooter);
+            ((JSectFooter*)b.atOfs(footerOfs))->computeHash(b.buf(), footerOfs);
+        }
+
+        stats.curr()->_uncompressedBytes += uncompressedLen;
+        _written += L;
         stats.curr()->_journaledBytes += L;
-        _curLogFile->synchronousAppend((const void*)b.buf(), L);
+
+        unsigned long long syncMicros = 0;
+        _curLogFile->synchronousAppend((const void*)b.buf(), L, &syncMicros);
+        stats.fsyncLatency.record(syncMicros);
+
         _rotate();
     } catch (std::exception& e) {
         log() << "error exception in dur::journal " << e.what() << endl;
@@ -77,9 +77,17 @@ unsigned long long getLastDataFileFlushTime();
 bool haveJournalFiles(bool anyFiles = false);
 
 /**
- * Writes the specified uncompressed buffer to the journal.
+ * Compresses the specified uncompressed buffer into a section ready to be written to the
+ * journal. Does no I/O, so it may overlap with writing the previous section.
  */
-void WRITETOJOURNAL(const JSectHeader& h, const AlignedBuilder& uncompressed);
+void COMPRESSFORJOURNAL(const JSectHeader& h,
+                        const AlignedBuilder& uncompressed,
+                        AlignedBuilder* section);
+
+/**
+ * Writes a section built by COMPRESSFORJOURNAL to the journal.
+ */
+void WRITETOJOURNAL(AlignedBuilder* section, unsigned uncompressedLen);
 
 // in case disk controller buffers writes
 const long long ExtraKeepTimeMs = 10000;
@@ -63,10 +63,47 @@ void WRITETODATAFILES(const JSectHeader& h, const AlignedBuilder& uncompressed)
 
     const long long m = t.micros();
     stats.curr()->_writeToDataFilesMicros += m;
+    stats.writeToDataFilesLatency.record(m);
 
     LOG(4) << "journal WRITETODATAFILES " << m / 1000.0 << "ms";
 }
 
+/**
+ * Runs the loop of one of the journal threads. Any exception is fatal, because the journal
+ * could not be written in order anymore.
+ */
+void runJournalThread(const char* threadName, stdx::function<void()> loop) {
+    Client::initThread(threadName);
+
+    log() << "Journal thread " << threadName << " started";
+
+    try {
+        loop();
+    } catch (const DBException& e) {
+        severe() << "dbexception in " << threadName
+                 << " thread causing immediate shutdown: " << e.toString();
+        invariant(false);
+    } catch (const std::ios_base::failure& e) {
+        severe() << "ios_base exception in " << threadName
+                 << " thread causing immediate shutdown: " << e.what();
+        invariant(false);
+    } catch (const std::bad_alloc& e) {
+        severe() << "bad_alloc exception in " << threadName
+                 << " thread causing immediate shutdown: " << e.what();
+        invariant(false);
+    } catch (const std::exception& e) {
+        severe() << "exception in " << threadName
+                 << " thread causing immediate shutdown: " << e.what();
+        invariant(false);
+    } catch (...) {
+        severe() << "unhandled exception in " << threadName
+                 << " thread causing immediate shutdown";
+        invariant(false);
+    }
+
+    log() << "Journal thread " << threadName << " stopped";
+}
+
 }  // namespace
 
 
@@ -113,13 +150,16 @@ JournalWriter::JournalWriter(NotifyAll* commitNotify,
       _shutdownRequested(false),
       _journalQueue(numBuffers),
       _lastCommitNumber(0),
+      _compressedQueue(numBuffers),
       _readyQueue(numBuffers) {
     invariant(_journalQueue.maxSize() == _readyQueue.maxSize());
+    invariant(_compressedQueue.maxSize() == _readyQueue.maxSize());
 }
 
 JournalWriter::~JournalWriter() {
     // Never close the journal writer with outstanding or unaccounted writes
     invariant(_journalQueue.empty());
+    invariant(_compressedQueue.empty());
     invariant(_readyQueue.empty());
 }
 
@@ -132,9 +172,12 @@ void JournalWriter::start() {
         _readyQueue.push(new Buffer(InitialBufferSizeBytes));
     }
 
-    // Start the thread
-    stdx::thread t(stdx::bind(&JournalWriter::_journalWriterThread, this));
-    _journalWriterThreadHandle.swap(t);
+    // Start the threads
+    stdx::thread compressor(stdx::bind(&JournalWriter::_journalCompressorThread, this));
+    _journalCompressorThreadHandle.swap(compressor);
+
+    stdx::thread writer(stdx::bind(&JournalWriter::_journalWriterThread, this));
+    _journalWriterThreadHandle.swap(writer);
 }
 
 void JournalWriter::shutdown() {
@@ -148,11 +191,12 @@ void JournalWriter::shutdown() {
     Buffer* const shutdownBuffer = newBuffer();
     shutdownBuffer->_setShutdown();
 
-    // This will terminate the journal thread. No need to specify commit number, since we are
+    // This will terminate the journal threads. No need to specify commit number, since we are
     // shutting down and nothing will be notified anyways.
     writeBuffer(shutdownBuffer, 0);
 
-    // Ensure the journal thread has stopped and everything accounted for.
+    // Ensure the journal threads have stopped and everything accounted for.
+    _journalCompressorThreadHandle.join();
     _journalWriterThreadHandle.join();
     assertIdle();
 
@@ -166,6 +210,7 @@ void JournalWriter::shutdown() {
 void JournalWriter::assertIdle() {
     // All buffers are in the ready queue means there is nothing pending.
     invariant(_journalQueue.empty());
+    invariant(_compressedQueue.empty());
     invariant(_readyQueue.count() == _readyQueue.maxSize());
 }
 
@@ -200,14 +245,33 @@ void JournalWriter::flush() {
     }
 }
 
-void JournalWriter::_journalWriterThread() {
-    Client::initThread("journal writer");
+void JournalWriter::_journalCompressorThread() {
+    runJournalThread("journal compressor", [this] {
+        while (true) {
+            Buffer* const buffer = _journalQueue.blockingPop();
 
-    log() << "Journal writer thread started";
+            if (!buffer->_isShutdown && !buffer->_isNoop) {
+                // This only uses CPU, so it overlaps with the writer thread's I/O for the
+                // previous buffer.
+                COMPRESSFORJOURNAL(buffer->_header, buffer->_builder, &buffer->_section);
+            }
 
-    try {
+            // Pass every buffer on in order, so that notifications keep the order of commits.
+            // This never blocks, because there are only as many buffers as the queue holds.
+            invariant(_compressedQueue.count() < _compressedQueue.maxSize());
+            _compressedQueue.push(buffer);
+
+            if (buffer->_isShutdown) {
+                break;
+            }
+        }
+    });
+}
+
+void JournalWriter::_journalWriterThread() {
+    runJournalThread("journal writer", [this] {
         while (true) {
-            Buffer* const buffer = _journalQueue.blockingPop();
+            Buffer* const buffer = _compressedQueue.blockingPop();
             BufferGuard bufferGuard(buffer, &_readyQueue);
 
             if (buffer->_isShutdown) {
@@ -231,7 +295,7 @@ void JournalWriter::_journalWriterThread() {
                    << ", size " << buffer->_builder.len() << " bytes)";
 
             // This performs synchronous I/O to the journal file and will block.
-            WRITETOJOURNAL(buffer->_header, buffer->_builder);
+            WRITETOJOURNAL(&buffer->_section, buffer->_builder.len());
 
             // Data is now persisted in the journal, which is sufficient for acknowledging
             // getLastError
@@ -245,27 +309,7 @@ void JournalWriter::_journalWriterThread() {
             // cleanup waiters.
             _applyToDataFilesNotify->notifyAll(buffer->_commitNumber);
         }
-    } catch (const DBException& e) {
-        severe() << "dbexception in journalWriterThread causing immediate shutdown: "
-                 << e.toString();
-        invariant(false);
-    } catch (const std::ios_base::failure& e) {
-        severe() << "ios_base exception in journalWriterThread causing immediate shutdown: "
-                 << e.what();
-        invariant(false);
-    } catch (const std::bad_alloc& e) {
-        severe() << "bad_alloc exception in journalWriterThread causing immediate shutdown: "
-                 << e.what();
-        invariant(false);
-    } catch (const std::exception& e) {
-        severe() << "exception in journalWriterThread causing immediate shutdown: " << e.what();
-        invariant(false);
-    } catch (...) {
-        severe() << "unhandled exception in journalWriterThread causing immediate shutdown";
-        invariant(false);
-    }
-
-    log() << "Journal writer thread stopped";
+    });
 }
 
 
@@ -274,7 +318,12 @@ void JournalWriter::_journalWriterThread() {
 //
 
 JournalWriter::Buffer::Buffer(size_t initialSize)
-    : _commitNumber(0), _isNoop(false), _isShutdown(false), _header(), _builder(initialSize) {}
+    : _commitNumber(0),
+      _isNoop(false),
+      _isShutdown(false),
+      _header(),
+      _builder(initialSize),
+      _section(initialSize) {}
 
 JournalWriter::Buffer::~Buffer() {
     _assertEmpty();
@@ -289,6 +338,7 @@ void JournalWriter::Buffer::_reset() {
     _commitNumber = 0;
     _isNoop = false;
     _builder.reset();
+    _section.reset();
 }
 
 }  // namespace dur
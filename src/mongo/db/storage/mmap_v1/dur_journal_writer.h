@@ -39,9 +39,14 @@ namespace mongo {
 namespace dur {
 
 /**
- * Manages the thread and queues used for writing the journal to disk and notify parties with
+ * Manages the threads and queues used for writing the journal to disk and notify parties with
  * are waiting on the write concern.
  *
+ * Buffers pass through two threads. The journal compressor thread compresses each buffer into a
+ * journal section, and the journal writer thread writes the sections in the same order and
+ * applies them to the shared view. So one buffer may be compressed while the previous one is
+ * written.
+ *
  * NOTE: Not thread-safe and must not be used from more than one thread.
  */
 class JournalWriter {
@@ -88,12 +93,16 @@ public:
         // completed.
         bool _isNoop;
 
-        // Special buffer that's posted when the receiving thread must terminate. This should
+        // Special buffer that's posted when the receiving threads must terminate. This should
         // be the last entry posted to the queue and the commit number should be zero.
         bool _isShutdown;
 
         JSectHeader _header;
         AlignedBuilder _builder;
+
+        // The compressed journal section built from _header and _builder, which is what gets
+        // written to the journal.
+        AlignedBuilder _section;
     };
 
 
@@ -116,13 +125,13 @@ public:
     ~JournalWriter();
 
     /**
-     * Allocates buffer memory and starts the journal writer thread.
+     * Allocates buffer memory and starts the journal compressor and writer threads.
      */
     void start();
 
     /**
-     * Terminates the journal writer thread and frees memory for the buffers. Must not be
-     * called if there are any pending journal writes.
+     * Terminates the journal compressor and writer threads and frees memory for the buffers.
+     * Must not be called if there are any pending journal writes.
      */
     void shutdown();
 
@@ -167,6 +176,7 @@ private:
     enum { InitialBufferSizeBytes = 4 * 1024 * 1024 };
 
 
+    void _journalCompressorThread();
     void _journalWriterThread();
 
 
@@ -177,16 +187,20 @@ private:
     // This gets notified as journal buffers are done being applied to the shared view
     NotifyAll* const _applyToDataFilesNotify;
 
-    // Wraps and controls the journal writer thread
+    // Wrap and control the journal compressor and writer threads
+    stdx::thread _journalCompressorThreadHandle;
     stdx::thread _journalWriterThreadHandle;
 
     // Indicates that shutdown has been requested. Used for idempotency of the shutdown call.
     bool _shutdownRequested;
 
-    // Queue of buffers, which need to be written by the journal writer thread
+    // Queue of buffers, which need to be compressed by the journal compressor thread
     BufferQueue _journalQueue;
     NotifyAll::When _lastCommitNumber;
 
+    // Queue of compressed buffers, which need to be written by the journal writer thread
+    BufferQueue _compressedQueue;
+
     // Queue of buffers, whose write has been completed by the journal writer thread.
     BufferQueue _readyQueue;
 };
@@ -174,14 +174,36 @@ struct JEntry {
     }
 };
 
+/** how the operations of a section are compressed. kept in the section footer, where sections
+    written before the compressor could be chosen have zero, so snappy must stay zero. binaries
+    that predate this field read every section as snappy, so the others are only written when
+    the journalAllowNewCompressors startup parameter is set (see dur_journal.cpp).
+*/
+enum class JournalCompressor : unsigned char { kSnappy = 0, kNone = 1, kZlib = 2 };
+
 /** group commit section footer. md5 is a key field. */
 struct JSectFooter {
     JSectFooter();
-    JSectFooter(const void* begin, int len);  // needs buffer to compute hash
+    JSectFooter(const void* begin,
+                int len,
+                JournalCompressor compressor = JournalCompressor::kSnappy,
+                unsigned uncompressedLen = 0);  // needs buffer to compute hash
     unsigned sentinel;
     unsigned char hash[16];
-    unsigned long long reserved;
-    char magic[4];  // "\n\n\n\n"
+    unsigned char compressor;  // a JournalCompressor
+    char reserved[3];
+    unsigned uncompressedLen;  // 0 in sections written before the compressor could be chosen
+    char magic[4];             // "\n\n\n\n"
+
+    /** (re)computes the hash of the section that precedes this footer. unless the section is
+        snappy compressed, the hash also covers compressor and uncompressedLen; snappy sections
+        keep the hash older binaries expect.
+    */
+    void computeHash(const void* begin, int len);
+
+    JournalCompressor getCompressor() const {
+        return static_cast<JournalCompressor>(compressor);
+    }
 
     /** used by recovery to see if buffer is valid
         @param begin the buffer
@@ -53,9 +53,17 @@ public:
      */
     void rotate();
 
-    /** append to the journal file
+    /** build the section for a group commit into 'section': the header, the operations of
+        'uncompressed' compressed with the chosen compressor, and the footer, padded to Alignment.
+        thread: journal compressor. does no i/o.
     */
-    void journal(const JSectHeader& h, const AlignedBuilder& b);
+    void buildSection(const JSectHeader& h,
+                      const AlignedBuilder& uncompressed,
+                      AlignedBuilder* section);
+
+    /** append a section built by buildSection() to the journal file
+    */
+    void journal(AlignedBuilder* section, unsigned uncompressedLen);
 
     boost::filesystem::path getFilePathFor(int filenumber) const;
 
@@ -196,7 +196,9 @@ void PREPLOGBUFFER(/*out*/ JSectHeader& outHeader, AlignedBuilder& outBuffer) {
     Timer t;
     j.assureLogFileOpen();  // so fileId is set
     _PREPLOGBUFFER(outHeader, outBuffer);
-    stats.curr()->_prepLogBufferMicros += t.micros();
+    const long long micros = t.micros();
+    stats.curr()->_prepLogBufferMicros += micros;
+    stats.prepLogBufferLatency.record(micros);
 }
 }
 }
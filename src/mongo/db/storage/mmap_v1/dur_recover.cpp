@@ -143,11 +143,12 @@ public:
     JournalSectionIterator(const JSectHeader& h,
                            const void* compressed,
                            unsigned compressedLen,
+                           const JSectFooter& f,
                            bool doDurOpsRecovering)
         : _h(h), _lastDbName(0), _doDurOps(doDurOpsRecovering) {
         verify(doDurOpsRecovering);
 
-        if (!uncompress((const char*)compressed, compressedLen, &_uncompressed)) {
+        if (!_uncompress((const char*)compressed, compressedLen, f)) {
             // We check the checksum before we uncompress, but this may still fail as the
             // checksum isn't foolproof.
             log() << "couldn't uncompress journal section" << endl;
@@ -227,6 +228,20 @@ public:
 
 
 private:
+    bool _uncompress(const char* compressed, unsigned compressedLen, const JSectFooter& f) {
+        switch (f.getCompressor()) {
+            case JournalCompressor::kSnappy:
+                return uncompress(compressed, compressedLen, &_uncompressed);
+            case JournalCompressor::kNone:
+                _uncompressed.assign(compressed, compressedLen);
+                return compressedLen == f.uncompressedLen;
+            case JournalCompressor::kZlib:
+                return zlibUncompress(compressed, compressedLen, f.uncompressedLen, &_uncompressed);
+        }
+        log() << "unknown journal section compressor " << static_cast<int>(f.compressor);
+        return false;
+    }
+
     unique_ptr<BufReader> _entries;
     const JSectHeader _h;
     const char* _lastDbName;  // pointer into mmaped journal file
@@ -406,7 +421,8 @@ void RecoveryJob::processSection(const JSectHeader* h,
 
     unique_ptr<JournalSectionIterator> i;
     if (_recovering) {
-        i = unique_ptr<JournalSectionIterator>(new JournalSectionIterator(*h, p, len, _recovering));
+        i = unique_ptr<JournalSectionIterator>(
+            new JournalSectionIterator(*h, p, len, *f, _recovering));
     } else {
         i = unique_ptr<JournalSectionIterator>(
             new JournalSectionIterator(*h, /*after header*/ p, /*w/out header*/ len));
@@ -29,6 +29,7 @@
 */
 
 #include "mongo/db/jsobj.h"
+#include "mongo/db/stats/latency_histogram.h"
 
 namespace mongo {
 namespace dur {
@@ -66,6 +67,7 @@ struct Stats {
         uint64_t _writeToDataFilesBytes;
 
         uint64_t _prepLogBufferMicros;
+        uint64_t _compressMicros;
         uint64_t _writeToJournalMicros;
         uint64_t _writeToDataFilesMicros;
         uint64_t _remapPrivateViewMicros;
@@ -86,6 +88,14 @@ struct Stats {
         return &_stats[_currIdx];
     }
 
+    // Latencies of the phases of each group commit. Unlike the statistics above, which cover a
+    // few seconds, these are never reset. The fsync is part of writing to the journal.
+    LatencyHistogram prepLogBufferLatency;
+    LatencyHistogram compressLatency;
+    LatencyHistogram writeToJournalLatency;
+    LatencyHistogram fsyncLatency;
+    LatencyHistogram writeToDataFilesLatency;
+
 private:
     S _stats[5];
     unsigned _currIdx;
@@ -42,6 +42,7 @@
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/startup_test.h"
 #include "mongo/util/text.h"
+#include "mongo/util/timer.h"
 
 
 using namespace mongoutils;
@@ -107,7 +108,7 @@ void LogFile::readAt(unsigned long long offset, void* _buf, size_t _len) {
     }
 }
 
-void LogFile::synchronousAppend(const void* _buf, size_t _len) {
+void LogFile::synchronousAppend(const void* _buf, size_t _len, unsigned long long* syncMicros) {
     const size_t BlockSize = 8 * 1024 * 1024;
     verify(_fd);
     verify(_len % g_minOSPageSizeBytes == 0);
@@ -130,6 +131,10 @@ void LogFile::synchronousAppend(const void* _buf, size_t _len) {
         left -= written;
         buf += written;
     }
+
+    // The file is not buffered, so there is no separate sync.
+    if (syncMicros)
+        *syncMicros = 0;
 }
 }
 
@@ -225,7 +230,7 @@ void LogFile::readAt(unsigned long long offset, void* _buf, size_t _len) {
     verify(rd != -1);
 }
 
-void LogFile::synchronousAppend(const void* b, size_t len) {
+void LogFile::synchronousAppend(const void* b, size_t len, unsigned long long* syncMicros) {
     const char* buf = static_cast<const char*>(b);
     ssize_t charsToWrite = static_cast<ssize_t>(len);
 
@@ -249,6 +254,7 @@ void LogFile::synchronousAppend(const void* b, size_t len) {
         charsToWrite -= written;
     }
 
+    Timer syncTimer;
     if (
 #if defined(__linux__)
         fdatasync(_fd) < 0
@@ -259,6 +265,8 @@ void LogFile::synchronousAppend(const void* b, size_t len) {
         log() << "error appending to file on fsync " << ' ' << errnoWithDescription();
         fassertFailed(13514);
     }
+    if (syncMicros)
+        *syncMicros = syncTimer.micros();
 
 #ifdef POSIX_FADV_DONTNEED
     if (!_direct)
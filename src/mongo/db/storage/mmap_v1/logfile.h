@@ -48,8 +48,9 @@ public:
     /** append to file.  does not return until sync'd.  uses direct i/o when possible.
         throws UserAssertion on an i/o error
         note direct i/o may have alignment requirements
+        @param syncMicros if not NULL, set to the time spent syncing after the write
     */
-    void synchronousAppend(const void* buf, size_t len);
+    void synchronousAppend(const void* buf, size_t len, unsigned long long* syncMicros = NULL);
 
     /** write at specified offset. must be aligned.  noreturn until physically written. thread safe
      * */
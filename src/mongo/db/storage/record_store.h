@@ -429,6 +429,16 @@ public:
         return out;
     }
 
+    /**
+     * Like getManyCursors(), but for callers which scan the returned cursors with several threads,
+     * so a store may split itself into more, smaller pieces. getManyCursors() backs the
+     * parallelCollectionScan command, which is why the two are separate.
+     */
+    virtual std::vector<std::unique_ptr<RecordCursor>> getParallelCursors(
+        OperationContext* txn) const {
+        return getManyCursors(txn);
+    }
+
     // higher level
 
 
@@ -111,4 +111,49 @@ TEST(RecordStoreTestHarness, GetManyIteratorsNonEmpty) {
     }
 }
 
+// Create parallel iterators over a record store large enough that an engine may split it into
+// several ranges, and check that each record is returned by exactly one of them even when the
+// iterators are saved and restored while in use.
+TEST(RecordStoreTestHarness, GetParallelIteratorsLarge) {
+    unique_ptr<HarnessHelper> harnessHelper(newHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    const int nToInsert = 5000;
+    set<RecordId> remain;
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        for (int i = 0; i < nToInsert; i++) {
+            stringstream ss;
+            ss << "record " << i;
+            string data = ss.str();
+
+            StatusWith<RecordId> res =
+                rs->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, false);
+            ASSERT_OK(res.getStatus());
+            remain.insert(res.getValue());
+        }
+        uow.commit();
+    }
+
+    {
+        unique_ptr<OperationContext> opCtx(harnessHelper->newOperationContext());
+        ASSERT_EQUALS(nToInsert, rs->numRecords(opCtx.get()));
+
+        int seen = 0;
+        for (auto&& cursor : rs->getParallelCursors(opCtx.get())) {
+            while (auto record = cursor->next()) {
+                ASSERT_EQ(remain.erase(record->id), size_t(1));
+                if (++seen % 100 == 0) {
+                    cursor->savePositioned();
+                    ASSERT(cursor->restore());
+                }
+            }
+
+            ASSERT(!cursor->next());
+        }
+        ASSERT(remain.empty());
+    }
+}
+
 }  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/index_entry_comparison.h"
+#include "mongo/db/storage/key_string.h"
 
 #pragma once
 
@@ -82,6 +83,25 @@ public:
      */
     virtual SortedDataBuilderInterface* getBulkBuilder(OperationContext* txn, bool dupsAllowed) = 0;
 
+    /**
+     * Returns true if this index stores its keys as KeyStrings encoded with its ordering. Bulk
+     * builds of such indexes sort keys in that form and load them with
+     * SortedDataBuilderInterface::addKeyString(), so that keys are neither compared as BSON nor
+     * encoded again.
+     */
+    virtual bool storesKeyStrings() const {
+        return false;
+    }
+
+    /**
+     * Returns KeyTooLong if 'key' is too long to be added to this index, as addKey() and insert()
+     * would. Only needed by callers of SortedDataBuilderInterface::addKeyString(), which cannot
+     * tell how long a key was as BSON.
+     */
+    virtual Status checkKeyLength(const BSONObj& key) const {
+        return Status::OK();
+    }
+
     /**
      * Insert an entry into the index with the specified key and RecordId.
      *
@@ -377,6 +397,16 @@ public:
      */
     virtual Status addKey(const BSONObj& key, const RecordId& loc) = 0;
 
+    /**
+     * Like addKey(), but for a key already encoded as a KeyString with the index's ordering and
+     * followed by its RecordId. Only supported by builders of indexes whose storesKeyStrings()
+     * is true. The caller must have checked the key with SortedDataInterface::checkKeyLength().
+     */
+    virtual Status addKeyString(const KeyString::Value& keyString) {
+        invariant(false);
+        return Status::OK();
+    }
+
     /**
      * Do any necessary work to finish building the tree.
      *
@@ -118,6 +118,10 @@ Status checkKeySize(const BSONObj& key) {
 
 }  // namespace
 
+Status WiredTigerIndex::checkKeyLength(const BSONObj& key) const {
+    return checkKeySize(key);
+}
+
 Status WiredTigerIndex::dupKeyError(const BSONObj& key) {
     StringBuilder sb;
     sb << "E11000 duplicate key error";
@@ -489,6 +493,23 @@ public:
         return Status::OK();
     }
 
+    Status addKeyString(const KeyString::Value& keyString) override {
+        // The key is already in the form it is stored in.
+        WiredTigerItem item(keyString.getBuffer(), keyString.getSize());
+        _cursor->set_key(_cursor, item.Get());
+
+        const KeyString::TypeBits typeBits = keyString.getTypeBits();
+        WiredTigerItem valueItem = typeBits.isAllZeros()
+            ? emptyItem
+            : WiredTigerItem(typeBits.getBuffer(), typeBits.getSize());
+
+        _cursor->set_value(_cursor, valueItem.Get());
+
+        invariantWTOK(_cursor->insert(_cursor));
+
+        return Status::OK();
+    }
+
     void commit(bool mayInterrupt) {
         // TODO do we still need this?
         // this is bizarre, but required as part of the contract
@@ -546,6 +567,33 @@ public:
         return Status::OK();
     }
 
+    Status addKeyString(const KeyString::Value& keyString) override {
+        // Unique indexes store the key without its RecordId, which goes in the value instead.
+        const size_t keySize =
+            KeyString::sizeWithoutRecordIdAtEnd(keyString.getBuffer(), keyString.getSize());
+        const RecordId loc =
+            KeyString::decodeRecordIdAtEnd(keyString.getBuffer(), keyString.getSize());
+
+        // _records is only empty before the first call.
+        const bool isDup = !_records.empty() && keySize == _keyString.getSize() &&
+            memcmp(keyString.getBuffer(), _keyString.getBuffer(), keySize) == 0;
+        if (!isDup) {
+            if (!_records.empty()) {
+                // We are done with dups of the last key so we can insert it now.
+                doInsert();
+            }
+            invariant(_records.empty());
+        } else if (!_dupsAllowed) {
+            return _idx->dupKeyError(KeyString::toBson(
+                keyString.getBuffer(), keySize, _ordering, keyString.getTypeBits()));
+        }
+
+        _keyString.resetFromBuffer(keyString.getBuffer(), keySize);
+        _records.push_back(std::make_pair(loc, keyString.getTypeBits()));
+
+        return Status::OK();
+    }
+
     void commit(bool mayInterrupt) {
         WriteUnitOfWork uow(_txn);
         if (!_records.empty()) {
@@ -99,6 +99,12 @@ public:
 
     virtual long long getSpaceUsedBytes(OperationContext* txn) const;
 
+    bool storesKeyStrings() const override {
+        return true;
+    }
+
+    Status checkKeyLength(const BSONObj& key) const override;
+
     bool isDup(WT_CURSOR* c, const BSONObj& key, const RecordId& loc);
 
     virtual Status initAsEmpty(OperationContext* txn);
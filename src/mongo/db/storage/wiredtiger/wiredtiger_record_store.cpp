@@ -35,6 +35,7 @@
 
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 
+#include <algorithm>
 #include <wiredtiger.h>
 
 #include "mongo/base/checked_cast.h"
@@ -76,6 +77,11 @@ static_assert(kCurrentRecordStoreVersion >= kMinimumRecordStoreVersion,
 static_assert(kCurrentRecordStoreVersion <= kMaximumRecordStoreVersion,
               "kCurrentRecordStoreVersion <= kMaximumRecordStoreVersion");
 
+// getParallelCursors() splits a table into at most this many key ranges, each of which should hold
+// at least kMinRecordsPerCursorRange records.
+const long long kMaxCursorRanges = 16;
+const long long kMinRecordsPerCursorRange = 1000;
+
 bool shouldUseOplogHack(OperationContext* opCtx, const std::string& uri) {
     StatusWith<BSONObj> appMetadata = WiredTigerUtil::getApplicationMetadata(opCtx, uri);
     if (!appMetadata.isOK()) {
@@ -101,6 +107,20 @@ public:
         _cursor.emplace(rs.getURI(), rs.tableId(), true, txn);
     }
 
+    /**
+     * A forward cursor over the records with ids in [start, end). A null start means the
+     * beginning of the table and a null end means the end of it.
+     */
+    Cursor(OperationContext* txn,
+           const WiredTigerRecordStore& rs,
+           const RecordId& start,
+           const RecordId& end)
+        : Cursor(txn, rs, /*forward=*/true) {
+        invariant(!rs._isCapped);
+        _start = start;
+        _end = end;
+    }
+
     boost::optional<Record> next() final {
         if (_eof)
             return {};
@@ -131,6 +151,21 @@ public:
             }
         }
 
+        if (_lastReturnedId.isNull() && !_start.isNull()) {
+            // Position on the first record of our range rather than the start of the table.
+            c->set_key(c, _makeKey(_start));
+            int cmp;
+            int seekRet = WT_OP_CHECK(c->search_near(c, &cmp));
+            if (seekRet == WT_NOTFOUND) {
+                _eof = true;
+                return {};
+            }
+            invariantWTOK(seekRet);
+
+            // If we landed before the start of the range, the next record is the first one in it.
+            mustAdvance = cmp < 0;
+        }
+
         if (mustAdvance) {
             // Nothing after the next line can throw WCEs.
             // Note that an unpositioned (or eof) WT_CURSOR returns the first/last entry in the
@@ -147,7 +182,7 @@ public:
         invariantWTOK(c->get_key(c, &key));
         const RecordId id = _fromKey(key);
 
-        if (!isVisible(id)) {
+        if (!isVisible(id) || (!_end.isNull() && id >= _end)) {
             _eof = true;
             return {};
         }
@@ -284,6 +319,10 @@ private:
     bool _eof = false;
     RecordId _lastReturnedId;  // If null, need to seek to first/last record.
     const RecordId _readUntilForOplog;
+
+    // Bounds of the range this cursor is restricted to. Null means unbounded.
+    RecordId _start;
+    RecordId _end;
 };
 
 StatusWith<std::string> WiredTigerRecordStore::parseOptionsField(const BSONObj options) {
@@ -890,6 +929,51 @@ std::vector<std::unique_ptr<RecordCursor>> WiredTigerRecordStore::getManyCursors
     return cursors;
 }
 
+std::vector<std::unique_ptr<RecordCursor>> WiredTigerRecordStore::getParallelCursors(
+    OperationContext* txn) const {
+    std::vector<std::unique_ptr<RecordCursor>> cursors;
+
+    // Capped collections must be read in insertion order with their visibility rules applied, so
+    // they always get a single cursor.
+    const long long numRanges =
+        std::min(kMaxCursorRanges, numRecords(txn) / kMinRecordsPerCursorRange);
+    if (_isCapped || numRanges <= 1) {
+        cursors.push_back(stdx::make_unique<Cursor>(txn, *this, /*forward=*/true));
+        return cursors;
+    }
+
+    // Split the key space between the current first and last records into equal ranges. Records
+    // ids are assigned in increasing order, so this roughly divides the records evenly. The first
+    // and last ranges are unbounded so that records inserted outside of [first, last] while the
+    // cursors are in use are still seen.
+    int64_t first;
+    int64_t last;
+    {
+        WiredTigerCursor curwrap(_uri, _tableId, true, txn);
+        WT_CURSOR* c = curwrap.get();
+        int ret = WT_OP_CHECK(c->next(c));
+        if (ret == WT_NOTFOUND) {
+            cursors.push_back(stdx::make_unique<Cursor>(txn, *this, /*forward=*/true));
+            return cursors;
+        }
+        invariantWTOK(ret);
+        invariantWTOK(c->get_key(c, &first));
+
+        invariantWTOK(c->reset(c));
+        invariantWTOK(WT_OP_CHECK(c->prev(c)));
+        invariantWTOK(c->get_key(c, &last));
+    }
+
+    const int64_t step = std::max<int64_t>(1, (last - first) / numRanges + 1);
+    RecordId start;
+    for (long long i = 1; i <= numRanges; i++) {
+        const RecordId end = (i == numRanges) ? RecordId() : _fromKey(first + i * step);
+        cursors.push_back(stdx::make_unique<Cursor>(txn, *this, start, end));
+        start = end;
+    }
+    return cursors;
+}
+
 Status WiredTigerRecordStore::truncate(OperationContext* txn) {
     WiredTigerCursor startWrap(_uri, _tableId, true, txn);
     WT_CURSOR* start = startWrap.get();
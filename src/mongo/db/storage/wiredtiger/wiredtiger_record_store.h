@@ -138,6 +138,8 @@ public:
 
     std::unique_ptr<RecordCursor> getCursor(OperationContext* txn, bool forward) const final;
     std::vector<std::unique_ptr<RecordCursor>> getManyCursors(OperationContext* txn) const final;
+    std::vector<std::unique_ptr<RecordCursor>> getParallelCursors(
+        OperationContext* txn) const final;
 
     virtual Status truncate(OperationContext* txn);
 
@@ -40,7 +40,8 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
-#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/adaptive_concurrency_controller.h"
+#include "mongo/util/concurrency/priority_ticketholder.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/stacktrace.h"
@@ -89,6 +90,7 @@ WiredTigerRecoveryUnit::WiredTigerRecoveryUnit(WiredTigerSessionCache* sc)
 WiredTigerRecoveryUnit::~WiredTigerRecoveryUnit() {
     invariant(!_inUnitOfWork);
     _abort();
+    _releaseTicket();
     if (_session) {
         _sessionCache->releaseSession(_session);
         _session = NULL;
@@ -233,15 +235,31 @@ void WiredTigerRecoveryUnit::setOplogReadTill(const RecordId& loc) {
 namespace {
 
 
+/**
+ * A pool of tickets for transactions of one kind, along with the controller which sizes it when
+ * adaptive concurrency control is enabled.
+ */
+struct TicketPool {
+    explicit TicketPool(int num)
+        : holder(num), controller(AdaptiveConcurrencyController::Options(), num) {}
+
+    PriorityTicketHolder holder;
+    AdaptiveConcurrencyController controller;
+
+    // Value of holder.totalQueued() at the end of the previous sampling window. Guarded by
+    // adaptiveWindowMutex.
+    long long lastTotalQueued = 0;
+};
+
 class TicketServerParameter : public ServerParameter {
     MONGO_DISALLOW_COPYING(TicketServerParameter);
 
 public:
-    TicketServerParameter(TicketHolder* holder, const std::string& name)
-        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true), _holder(holder) {}
+    TicketServerParameter(TicketPool* pool, const std::string& name)
+        : ServerParameter(ServerParameterSet::getGlobal(), name, true, true), _pool(pool) {}
 
     virtual void append(OperationContext* txn, BSONObjBuilder& b, const std::string& name) {
-        b.append(name, _holder->outof());
+        b.append(name, _pool->holder.outof());
     }
 
     virtual Status set(const BSONElement& newValueElement) {
@@ -263,36 +281,115 @@ public:
             return Status(ErrorCodes::BadValue, str::stream() << name() << " has to be > 0");
         }
 
-        return _holder->resize(newNum);
+        // The adaptive controller, if enabled, continues from the new size.
+        _pool->controller.setTargetTickets(newNum);
+        return _pool->holder.resize(newNum);
     }
 
 private:
-    TicketHolder* _holder;
+    TicketPool* _pool;
 };
 
-TicketHolder openWriteTransaction(128);
+TicketPool openWriteTransaction(128);
 TicketServerParameter openWriteTransactionParam(&openWriteTransaction,
                                                 "wiredTigerConcurrentWriteTransactions");
 
-TicketHolder openReadTransaction(128);
+TicketPool openReadTransaction(128);
 TicketServerParameter openReadTransactionParam(&openReadTransaction,
                                                "wiredTigerConcurrentReadTransactions");
+
+// When enabled, the read and write ticket pools are resized periodically based on the latency of
+// the transactions holding their tickets, within the bounds below.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerAdaptiveConcurrency, bool, false);
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerAdaptiveConcurrencyMinTickets, int, 8);
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerAdaptiveConcurrencyMaxTickets, int, 512);
+
+// Operations which have held tickets for longer than this in total wait behind operations which
+// have not when tickets are scarce.
+MONGO_EXPORT_SERVER_PARAMETER(wiredTigerTicketPriorityThresholdMillis, int, 50);
+
+const Milliseconds kAdaptiveWindow(100);
+
+stdx::mutex adaptiveWindowMutex;
+Date_t adaptiveWindowStart;  // guarded by adaptiveWindowMutex
+
+void resizeTicketPool_inlock(TicketPool* pool,
+                             const AdaptiveConcurrencyController::Options& options) {
+    const long long totalQueued = pool->holder.totalQueued();
+    const bool saturated = totalQueued > pool->lastTotalQueued;
+    pool->lastTotalQueued = totalQueued;
+
+    pool->controller.setOptions(options);
+    const int target = pool->controller.endWindow(saturated);
+    if (target != pool->holder.outof()) {
+        LOG(2) << "resizing WiredTiger ticket pool from " << pool->holder.outof() << " to "
+               << target;
+        pool->holder.resize(target);
+    }
+}
+
+/**
+ * Feeds the time a ticket from "pool" was held to its controller and, once per sampling window,
+ * resizes both ticket pools. Resizing never blocks, so this is cheap enough to be done inline by
+ * whichever thread happens to close a window.
+ */
+void recordTicketHeld(TicketPool* pool, Microseconds held) {
+    if (!wiredTigerAdaptiveConcurrency) {
+        return;
+    }
+    pool->controller.recordLatency(held);
+
+    stdx::unique_lock<stdx::mutex> lk(adaptiveWindowMutex, stdx::try_to_lock);
+    if (!lk.owns_lock()) {
+        return;
+    }
+
+    const Date_t now = Date_t::now();
+    if (now - adaptiveWindowStart < kAdaptiveWindow) {
+        return;
+    }
+    adaptiveWindowStart = now;
+
+    AdaptiveConcurrencyController::Options options;
+    options.minTickets = std::max(1, wiredTigerAdaptiveConcurrencyMinTickets);
+    options.maxTickets = std::max(options.minTickets, wiredTigerAdaptiveConcurrencyMaxTickets);
+    resizeTicketPool_inlock(&openWriteTransaction, options);
+    resizeTicketPool_inlock(&openReadTransaction, options);
+}
+
+void appendTicketPoolStats(const TicketPool& pool, BSONObjBuilder* b) {
+    b->append("out", pool.holder.used());
+    b->append("available", pool.holder.available());
+    b->append("totalTickets", pool.holder.outof());
+    {
+        BSONObjBuilder queued(b->subobjStart("queued"));
+        queued.append("highPriority", pool.holder.queued(PriorityTicketHolder::Priority::kHigh));
+        queued.append("normalPriority",
+                      pool.holder.queued(PriorityTicketHolder::Priority::kNormal));
+        queued.appendNumber("total", pool.holder.totalQueued());
+    }
+    if (wiredTigerAdaptiveConcurrency) {
+        const auto stats = pool.controller.getStats();
+        BSONObjBuilder adaptive(b->subobjStart("adaptive"));
+        adaptive.append("targetTickets", stats.targetTickets);
+        adaptive.appendNumber("baselineLatencyMicros", stats.baselineLatencyMicros);
+        adaptive.appendNumber("lastWindowLatencyMicros", stats.lastWindowLatencyMicros);
+        adaptive.appendNumber("increases", stats.increases);
+        adaptive.appendNumber("decreases", stats.decreases);
+    }
+}
 }
 
 void WiredTigerRecoveryUnit::appendGlobalStats(BSONObjBuilder& b) {
     BSONObjBuilder bb(b.subobjStart("concurrentTransactions"));
     {
         BSONObjBuilder bbb(bb.subobjStart("write"));
-        bbb.append("out", openWriteTransaction.used());
-        bbb.append("available", openWriteTransaction.available());
-        bbb.append("totalTickets", openWriteTransaction.outof());
+        appendTicketPoolStats(openWriteTransaction, &bbb);
         bbb.done();
     }
     {
         BSONObjBuilder bbb(bb.subobjStart("read"));
-        bbb.append("out", openReadTransaction.used());
-        bbb.append("available", openReadTransaction.available());
-        bbb.append("totalTickets", openReadTransaction.outof());
+        appendTicketPoolStats(openReadTransaction, &bbb);
         bbb.done();
     }
     bb.done();
@@ -312,7 +409,7 @@ void WiredTigerRecoveryUnit::_txnClose(bool commit) {
     }
     _active = false;
     _myTransactionCount++;
-    _ticket.reset(NULL);
+    _releaseTicket();
 }
 
 SnapshotId WiredTigerRecoveryUnit::getSnapshotId() const {
@@ -354,10 +451,27 @@ void WiredTigerRecoveryUnit::_getTicket(OperationContext* opCtx) {
         writeLocked = _everStartedWrite;
     }
 
-    TicketHolder* holder = writeLocked ? &openWriteTransaction : &openReadTransaction;
+    TicketPool* pool = writeLocked ? &openWriteTransaction : &openReadTransaction;
+    const auto priority = _ticketHeldMicros < wiredTigerTicketPriorityThresholdMillis * 1000LL
+        ? PriorityTicketHolder::Priority::kHigh
+        : PriorityTicketHolder::Priority::kNormal;
+
+    pool->holder.waitForTicket(priority);
+    _ticket.reset(&pool->holder);
+    _ticketTimer.reset();
+}
+
+void WiredTigerRecoveryUnit::_releaseTicket() {
+    if (!_ticket.hasTicket())
+        return;
 
-    holder->waitForTicket();
-    _ticket.reset(holder);
+    TicketPool* pool = _ticket.getHolder() == &openWriteTransaction.holder
+        ? &openWriteTransaction
+        : &openReadTransaction;
+    const long long heldMicros = _ticketTimer.micros();
+    _ticketHeldMicros += heldMicros;
+    _ticket.reset();
+    recordTicketHeld(pool, Microseconds(heldMicros));
 }
 
 void WiredTigerRecoveryUnit::_txnOpen(OperationContext* opCtx) {
@@ -39,7 +39,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/recovery_unit.h"
-#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/priority_ticketholder.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -141,7 +141,16 @@ private:
 
     bool _noTicketNeeded;
     void _getTicket(OperationContext* opCtx);
-    TicketHolderReleaser _ticket;
+    void _releaseTicket();
+    PriorityTicketHolderReleaser _ticket;
+
+    // Measures how long the current ticket has been held.
+    Timer _ticketTimer;
+
+    // Total time tickets have been held by this recovery unit. Once this exceeds a threshold,
+    // further tickets are requested at normal rather than high priority, so that short operations
+    // are not queued behind long running ones.
+    long long _ticketHeldMicros = 0;
 };
 
 /**
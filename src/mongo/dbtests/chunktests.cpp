@@ -59,7 +59,7 @@ public:
             _chunkMap[mySplitPoints[i]] = chunk;
         }
 
-        _chunkRanges.reloadAll(_chunkMap);
+        _setRoutingTable(_makeRoutingTable(_chunkMap));
     }
 };
 
@@ -48,6 +48,7 @@
 #include <iostream>
 #include <fstream>
 #include <mutex>
+#include <vector>
 
 #include "mongo/config.h"
 #include "mongo/db/client.h"
@@ -330,6 +331,13 @@ public:
         return false;
     }
 
+    /** the numbers of threads testThreaded() runs with. with more than one, each result is
+        named after its thread count, so that the rates show how the test scales.
+    */
+    virtual std::vector<int> threadCounts() {
+        return {8};
+    }
+
     int howLong() {
         int hlm = howLongMillis();
         DEV {
@@ -387,11 +395,17 @@ public:
         }
 
         if (testThreaded()) {
-            const int nThreads = 8;
-            // cout << "testThreaded nThreads:" << nThreads << endl;
-            mongo::Timer t;
-            const unsigned long long result = launchThreads(nThreads);
-            say(result / nThreads, t.micros(), test2name + "-threaded");
+            const std::vector<int> counts = threadCounts();
+            for (int nThreads : counts) {
+                // cout << "testThreaded nThreads:" << nThreads << endl;
+                mongo::Timer t;
+                const unsigned long long result = launchThreads(nThreads);
+                string threadedName = test2name + "-threaded";
+                if (counts.size() > 1) {
+                    threadedName = str::stream() << threadedName << nThreads;
+                }
+                say(result / nThreads, t.micros(), threadedName);
+            }
         }
     }
 
@@ -792,6 +806,10 @@ public:
     virtual bool testThreaded() {
         return true;
     }
+    // The rates are per thread, so they stay flat for as long as locking scales
+    virtual std::vector<int> threadCounts() {
+        return {1, 2, 4, 8, 16, 32, 64};
+    }
     virtual void prep() {
         resId.reset(new ResourceId(RESOURCE_COLLECTION, std::string("TestDB.collection")));
         locker.reset(new MMAPV1LockerImpl());
@@ -32,6 +32,7 @@
 
 #include "mongo/s/chunk_manager.h"
 
+#include <algorithm>
 #include <boost/next_prior.hpp>
 #include <map>
 #include <set>
@@ -91,6 +92,7 @@ public:
 
     pair<BSONObj, shared_ptr<Chunk>> rangeFor(const ChunkType& chunk) const final {
         shared_ptr<Chunk> c(new Chunk(_manager, chunk.toBSON()));
+        _newChunks.push_back(c);
         return make_pair(chunk.getMax(), c);
     }
 
@@ -99,8 +101,30 @@ public:
         return shard->getId();
     }
 
+    /**
+     * Returns the chunks that the diffs added to 'chunkMap' and that are still in it, sorted by
+     * their bounds.
+     */
+    vector<ChunkRoutingTable::ChunkInfo> getNewChunks(const ChunkMap& chunkMap) const {
+        vector<ChunkRoutingTable::ChunkInfo> newChunks;
+        for (const auto& chunk : _newChunks) {
+            const auto it = chunkMap.find(chunk->getMax());
+            if (it != chunkMap.end() && it->second == chunk) {
+                newChunks.emplace_back(chunk->getMin(), chunk->getMax(), chunk->getShardId());
+            }
+        }
+        std::sort(newChunks.begin(),
+                  newChunks.end(),
+                  [](const ChunkRoutingTable::ChunkInfo& lhs,
+                     const ChunkRoutingTable::ChunkInfo& rhs) { return lhs.max < rhs.max; });
+        return newChunks;
+    }
+
 private:
     ChunkManager* const _manager;
+
+    // Every chunk made by rangeFor(), including those that later diffs replaced.
+    mutable vector<shared_ptr<Chunk>> _newChunks;
 };
 
 
@@ -160,15 +184,13 @@ ChunkManager::ChunkManager(const string& ns, const ShardKeyPattern& pattern, boo
     : _ns(ns),
       _keyPattern(pattern.getKeyPattern()),
       _unique(unique),
-      _sequenceNumber(NextSequenceNumber.addAndFetch(1)),
-      _chunkRanges() {}
+      _sequenceNumber(NextSequenceNumber.addAndFetch(1)) {}
 
 ChunkManager::ChunkManager(const CollectionType& coll)
     : _ns(coll.getNs().ns()),
       _keyPattern(coll.getKeyPattern()),
       _unique(coll.getUnique()),
-      _sequenceNumber(NextSequenceNumber.addAndFetch(1)),
-      _chunkRanges() {
+      _sequenceNumber(NextSequenceNumber.addAndFetch(1)) {
     _version = ChunkVersion::fromBSON(coll.toBSON());
 }
 
@@ -179,10 +201,11 @@ void ChunkManager::loadExistingRanges(const ChunkManager* oldManager) {
         ChunkMap chunkMap;
         set<ShardId> shardIds;
         ShardVersionMap shardVersions;
+        boost::optional<vector<ChunkRoutingTable::ChunkInfo>> changedChunks;
 
         Timer t;
 
-        bool success = _load(chunkMap, shardIds, &shardVersions, oldManager);
+        bool success = _load(chunkMap, shardIds, &shardVersions, oldManager, &changedChunks);
         if (success) {
             log() << "ChunkManager: time to load chunks for " << _ns << ": " << t.millis() << "ms"
                   << " sequenceNumber: " << _sequenceNumber << " version: " << _version.toString()
@@ -194,7 +217,19 @@ void ChunkManager::loadExistingRanges(const ChunkManager* oldManager) {
                 _chunkMap.swap(chunkMap);
                 _shardIds.swap(shardIds);
                 _shardVersions.swap(shardVersions);
-                _chunkRanges.reloadAll(_chunkMap);
+
+                // Only encode the bounds of the chunks that changed since the old manager.
+                std::shared_ptr<const ChunkRoutingTable> routingTable;
+                if (changedChunks && oldManager->_routingTable) {
+                    routingTable = changedChunks->empty()
+                        ? oldManager->_routingTable
+                        : ChunkRoutingTable::makeUpdated(*oldManager->_routingTable,
+                                                         *changedChunks);
+                }
+                if (!routingTable || routingTable->size() != _chunkMap.size()) {
+                    routingTable = _makeRoutingTable(_chunkMap);
+                }
+                _setRoutingTable(std::move(routingTable));
 
                 return;
             }
@@ -218,13 +253,15 @@ void ChunkManager::loadExistingRanges(const ChunkManager* oldManager) {
 bool ChunkManager::_load(ChunkMap& chunkMap,
                          set<ShardId>& shardIds,
                          ShardVersionMap* shardVersions,
-                         const ChunkManager* oldManager) {
+                         const ChunkManager* oldManager,
+                         boost::optional<vector<ChunkRoutingTable::ChunkInfo>>* changedChunks) {
     // Reset the max version, but not the epoch, when we aren't loading from the oldManager
     _version = ChunkVersion(0, 0, _version.epoch());
 
     // If we have a previous version of the ChunkManager to work from, use that info to reduce
     // our config query
-    if (oldManager && oldManager->getVersion().isSet()) {
+    const bool loadingFromOldManager = oldManager && oldManager->getVersion().isSet();
+    if (loadingFromOldManager) {
         // Get the old max version
         _version = oldManager->getVersion();
 
@@ -269,6 +306,10 @@ bool ChunkManager::_load(ChunkMap& chunkMap,
         LOG(2) << "loaded " << diffsApplied << " chunks into new chunk manager for " << _ns
                << " with version " << _version;
 
+        if (loadingFromOldManager) {
+            *changedChunks = differ.getNewChunks(chunkMap);
+        }
+
         // Add all existing shards we find to the shards set
         for (ShardVersionMap::iterator it = shardVersions->begin(); it != shardVersions->end();) {
             shared_ptr<Shard> shard = grid.shardRegistry()->getShard(it->first);
@@ -325,6 +366,14 @@ shared_ptr<ChunkManager> ChunkManager::reload(bool force) const {
     return config->getChunkManager(getns(), force);
 }
 
+void ChunkManager::scheduleReload() const {
+    const NamespaceString nss(_ns);
+    auto status = grid.catalogCache()->getDatabase(nss.db().toString());
+    shared_ptr<DBConfig> config = uassertStatusOK(status);
+
+    config->scheduleChunkManagerRefresh(getns());
+}
+
 void ChunkManager::_printChunks() const {
     for (ChunkMap::const_iterator it = _chunkMap.begin(), end = _chunkMap.end(); it != end; ++it) {
         log() << *it->second;
@@ -437,11 +486,11 @@ ChunkPtr ChunkManager::findIntersectingChunk(const BSONObj& shardKey) const {
     {
         BSONObj chunkMin;
         ChunkPtr chunk;
-        {
-            ChunkMap::const_iterator it = _chunkMap.upper_bound(shardKey);
-            if (it != _chunkMap.end()) {
-                chunkMin = it->first;
-                chunk = it->second;
+        if (_routingTable) {
+            const size_t i = _routingTable->upperBound(shardKey);
+            if (i < _chunks.size()) {
+                chunk = _chunks[i];
+                chunkMin = chunk->getMin();
             }
         }
 
@@ -503,26 +552,28 @@ void ChunkManager::getShardIdsForQuery(set<ShardId>& shardIds, const BSONObj& qu
     // returned.  For now, we satisfy that assumption by adding a shard with no matches rather
     // than return an empty set of shards.
     if (shardIds.empty()) {
-        massert(16068, "no chunk ranges available", !_chunkRanges.ranges().empty());
-        shardIds.insert(_chunkRanges.ranges().begin()->second->getShardId());
+        massert(16068, "no chunk ranges available", !_chunks.empty());
+        shardIds.insert(_chunks.front()->getShardId());
     }
 }
 
 void ChunkManager::getShardIdsForRange(set<ShardId>& shardIds,
                                        const BSONObj& min,
                                        const BSONObj& max) const {
-    ChunkRangeMap::const_iterator it = _chunkRanges.upper_bound(min);
-    ChunkRangeMap::const_iterator end = _chunkRanges.upper_bound(max);
+    const size_t size = _routingTable ? _routingTable->size() : 0;
+    size_t i = size ? _routingTable->upperBound(min) : 0;
+    size_t end = size ? _routingTable->upperBound(max) : 0;
 
     massert(13507,
             str::stream() << "no chunks found between bounds " << min << " and " << max,
-            it != _chunkRanges.ranges().end());
+            i < size);
 
-    if (end != _chunkRanges.ranges().end())
+    if (end < size)
         ++end;
 
-    for (; it != end; ++it) {
-        shardIds.insert(it->second->getShardId());
+    // Consecutive chunks on the same shard are skipped together.
+    for (; i < end; i = _routingTable->endOfShardRun(i)) {
+        shardIds.insert(_routingTable->getShardId(i));
 
         // once we know we need to visit all shards no need to keep looping
         if (shardIds.size() == _shardIds.size())
@@ -677,113 +728,28 @@ string ChunkManager::toString() const {
 }
 
 
-ChunkRange::ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end)
-    : _manager(begin->second->getManager()),
-      _shardId(begin->second->getShardId()),
-      _min(begin->second->getMin()),
-      _max(boost::prior(end)->second->getMax()) {
-    invariant(begin != end);
-
-    DEV while (begin != end) {
-        dassert(begin->second->getManager() == _manager);
-        dassert(begin->second->getShardId() == _shardId);
-        ++begin;
+std::shared_ptr<const ChunkRoutingTable> ChunkManager::_makeRoutingTable(const ChunkMap& chunkMap) {
+    ChunkRoutingTable::Builder builder;
+    for (const auto& chunkMapEntry : chunkMap) {
+        builder.append(chunkMapEntry.first, chunkMapEntry.second->getShardId());
     }
+    return builder.done();
 }
 
-ChunkRange::ChunkRange(const ChunkRange& min, const ChunkRange& max)
-    : _manager(min.getManager()),
-      _shardId(min.getShardId()),
-      _min(min.getMin()),
-      _max(max.getMax()) {
-    invariant(min.getShardId() == max.getShardId());
-    invariant(min.getManager() == max.getManager());
-    invariant(min.getMax() == max.getMin());
-}
-
-string ChunkRange::toString() const {
-    StringBuilder sb;
-    sb << "ChunkRange(min=" << _min << ", max=" << _max << ", shard=" << _shardId << ")";
-
-    return sb.str();
-}
-
-
-void ChunkRangeManager::assertValid() const {
-    if (_ranges.empty())
-        return;
-
-    try {
-        // No Nulls
-        for (ChunkRangeMap::const_iterator it = _ranges.begin(), end = _ranges.end(); it != end;
-             ++it) {
-            verify(it->second);
-        }
-
-        // Check endpoints
-        verify(allOfType(MinKey, _ranges.begin()->second->getMin()));
-        verify(allOfType(MaxKey, boost::prior(_ranges.end())->second->getMax()));
-
-        // Make sure there are no gaps or overlaps
-        for (ChunkRangeMap::const_iterator it = boost::next(_ranges.begin()), end = _ranges.end();
-             it != end;
-             ++it) {
-            ChunkRangeMap::const_iterator last = boost::prior(it);
-            verify(it->second->getMin() == last->second->getMax());
+void ChunkManager::_setRoutingTable(std::shared_ptr<const ChunkRoutingTable> routingTable) {
+    invariant(routingTable->size() == _chunkMap.size());
+
+    _routingTable = std::move(routingTable);
+    _chunks.clear();
+    _chunks.reserve(_chunkMap.size());
+    for (const auto& chunkMapEntry : _chunkMap) {
+        DEV {
+            const size_t i = _chunks.size();
+            invariant(_routingTable->getShardId(i) == chunkMapEntry.second->getShardId());
+            invariant(_routingTable->getEncodedMax(i) ==
+                      ChunkRoutingTable::encode(chunkMapEntry.first));
         }
-
-        // Check Map keys
-        for (ChunkRangeMap::const_iterator it = _ranges.begin(), end = _ranges.end(); it != end;
-             ++it) {
-            verify(it->first == it->second->getMax());
-        }
-
-        // Make sure we match the original chunks
-        const ChunkMap chunks = _ranges.begin()->second->getManager()->_chunkMap;
-        for (ChunkMap::const_iterator i = chunks.begin(); i != chunks.end(); ++i) {
-            const ChunkPtr chunk = i->second;
-
-            ChunkRangeMap::const_iterator min = _ranges.upper_bound(chunk->getMin());
-            ChunkRangeMap::const_iterator max = _ranges.lower_bound(chunk->getMax());
-
-            verify(min != _ranges.end());
-            verify(max != _ranges.end());
-            verify(min == max);
-            verify(min->second->getShardId() == chunk->getShardId());
-            verify(min->second->containsKey(chunk->getMin()));
-            verify(min->second->containsKey(chunk->getMax()) ||
-                   (min->second->getMax() == chunk->getMax()));
-        }
-
-    } catch (...) {
-        error() << "\t invalid ChunkRangeMap! printing ranges:";
-
-        for (ChunkRangeMap::const_iterator it = _ranges.begin(), end = _ranges.end(); it != end;
-             ++it) {
-            log() << it->first << ": " << it->second->toString();
-        }
-
-        throw;
-    }
-}
-
-void ChunkRangeManager::reloadAll(const ChunkMap& chunks) {
-    _ranges.clear();
-    _insertRange(chunks.begin(), chunks.end());
-
-    DEV assertValid();
-}
-
-void ChunkRangeManager::_insertRange(ChunkMap::const_iterator begin,
-                                     const ChunkMap::const_iterator end) {
-    while (begin != end) {
-        ChunkMap::const_iterator first = begin;
-        ShardId shardId = first->second->getShardId();
-        while (begin != end && (begin->second->getShardId() == shardId))
-            ++begin;
-
-        shared_ptr<ChunkRange> cr(new ChunkRange(first, begin));
-        _ranges[cr->getMax()] = cr;
+        _chunks.push_back(chunkMapEntry.second);
     }
 }
 
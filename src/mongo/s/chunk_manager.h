@@ -28,12 +28,14 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <map>
 #include <string>
 #include <vector>
 
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/s/chunk.h"
+#include "mongo/s/chunk_routing_table.h"
 #include "mongo/s/shard_key_pattern.h"
 
 namespace mongo {
@@ -45,80 +47,9 @@ struct QuerySolutionNode;
 
 typedef std::shared_ptr<ChunkManager> ChunkManagerPtr;
 
-// The key for the map is max for each Chunk or ChunkRange
+// The key for the map is max for each Chunk
 typedef std::map<BSONObj, std::shared_ptr<Chunk>, BSONObjCmp> ChunkMap;
 
-class ChunkRange {
-public:
-    ChunkRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
-
-    // Merge min and max (must be adjacent ranges)
-    ChunkRange(const ChunkRange& min, const ChunkRange& max);
-
-    const ChunkManager* getManager() const {
-        return _manager;
-    }
-    ShardId getShardId() const {
-        return _shardId;
-    }
-
-    const BSONObj& getMin() const {
-        return _min;
-    }
-    const BSONObj& getMax() const {
-        return _max;
-    }
-
-    // clones of Chunk methods
-    // Returns true if this ChunkRange contains the given shard key, and false otherwise
-    //
-    // Note: this function takes an extracted *key*, not an original document
-    // (the point may be computed by, say, hashing a given field or projecting
-    //  to a subset of fields).
-    bool containsKey(const BSONObj& shardKey) const;
-
-    std::string toString() const;
-
-private:
-    const ChunkManager* _manager;
-    const ShardId _shardId;
-    const BSONObj _min;
-    const BSONObj _max;
-};
-
-typedef std::map<BSONObj, std::shared_ptr<ChunkRange>, BSONObjCmp> ChunkRangeMap;
-
-
-class ChunkRangeManager {
-public:
-    const ChunkRangeMap& ranges() const {
-        return _ranges;
-    }
-
-    void clear() {
-        _ranges.clear();
-    }
-
-    void reloadAll(const ChunkMap& chunks);
-
-    // Slow operation -- wrap with DEV
-    void assertValid() const;
-
-    ChunkRangeMap::const_iterator upper_bound(const BSONObj& o) const {
-        return _ranges.upper_bound(o);
-    }
-    ChunkRangeMap::const_iterator lower_bound(const BSONObj& o) const {
-        return _ranges.lower_bound(o);
-    }
-
-private:
-    // assumes nothing in this range exists in _ranges
-    void _insertRange(ChunkMap::const_iterator begin, const ChunkMap::const_iterator end);
-
-    ChunkRangeMap _ranges;
-};
-
-
 /* config.sharding
      { ns: 'alleyinsider.fs.chunks' ,
        key: { ts : 1 } ,
@@ -240,12 +171,22 @@ public:
 
     std::shared_ptr<ChunkManager> reload(bool force = true) const;  // doesn't modify self!
 
+    // Like reload(), but returns without waiting for the new chunk manager.
+    void scheduleReload() const;
+
 private:
-    // returns true if load was consistent
+    // returns true if load was consistent. If 'changedChunks' is set on return, the chunks are
+    // those of 'oldManager' with 'changedChunks' applied.
     bool _load(ChunkMap& chunks,
                std::set<ShardId>& shardIds,
                ShardVersionMap* shardVersions,
-               const ChunkManager* oldManager);
+               const ChunkManager* oldManager,
+               boost::optional<std::vector<ChunkRoutingTable::ChunkInfo>>* changedChunks);
+
+    static std::shared_ptr<const ChunkRoutingTable> _makeRoutingTable(const ChunkMap& chunkMap);
+
+    // Routes with 'routingTable', which must hold the chunks of _chunkMap.
+    void _setRoutingTable(std::shared_ptr<const ChunkRoutingTable> routingTable);
 
 
     // All members should be const for thread-safety
@@ -259,7 +200,13 @@ private:
     const unsigned long long _sequenceNumber;
 
     ChunkMap _chunkMap;
-    ChunkRangeManager _chunkRanges;
+
+    // Finds the chunks of _chunkMap by their bounds. Shared with the ChunkManagers loaded from
+    // this one when their chunks are the same.
+    std::shared_ptr<const ChunkRoutingTable> _routingTable;
+
+    // The chunks of _chunkMap, in the order of _routingTable.
+    std::vector<std::shared_ptr<Chunk>> _chunks;
 
     std::set<ShardId> _shardIds;
 
@@ -299,7 +246,6 @@ private:
     //
 
     friend class Chunk;
-    friend class ChunkRangeManager;  // only needed for CRM::assertValid()
     static AtomicUInt32 NextSequenceNumber;
 
     friend class TestableChunkManager;
@@ -0,0 +1,175 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_routing_table.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "mongo/db/storage/key_string.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+namespace {
+
+// Bounds are ordered as BSONObjCmp orders them, which is ascending on every field.
+const Ordering kAllAscending = Ordering::make(BSONObj());
+
+void encodeKey(const BSONObj& key, KeyString* out) {
+    // KeyStrings are made from objects without field names, like index keys.
+    BSONObjBuilder keyWithoutFieldNames(key.objsize());
+    for (auto&& elem : key) {
+        keyWithoutFieldNames.appendAs(elem, "");
+    }
+    out->resetToKey(keyWithoutFieldNames.done(), kAllAscending);
+}
+
+}  // namespace
+
+ChunkRoutingTable::Builder::Builder() : _table(new ChunkRoutingTable()) {}
+
+void ChunkRoutingTable::Builder::append(const BSONObj& max, const ShardId& shardId) {
+    KeyString encodedMax;
+    encodeKey(max, &encodedMax);
+    appendEncoded(StringData(encodedMax.getBuffer(), encodedMax.getSize()), shardId);
+}
+
+void ChunkRoutingTable::Builder::appendEncoded(StringData encodedMax, const ShardId& shardId) {
+    dassert(_table->empty() || _table->getEncodedMax(_table->size() - 1) < encodedMax);
+    _table->_bounds.append(encodedMax.rawData(), encodedMax.size());
+    massert(28763,
+            "chunk routing table is too large",
+            _table->_bounds.size() <= std::numeric_limits<uint32_t>::max());
+    _table->_boundEnds.push_back(_table->_bounds.size());
+    _table->_shardIndexes.push_back(_getShardIndex(shardId));
+}
+
+void ChunkRoutingTable::Builder::appendFrom(const ChunkRoutingTable& table,
+                                            size_t begin,
+                                            size_t end) {
+    invariant(begin <= end && end <= table.size());
+    if (begin == end) {
+        return;
+    }
+
+    const uint32_t bytesBegin = begin == 0 ? 0 : table._boundEnds[begin - 1];
+    const uint32_t bytesEnd = table._boundEnds[end - 1];
+    const uint32_t offset = _table->_bounds.size();
+    _table->_bounds.append(table._bounds, bytesBegin, bytesEnd - bytesBegin);
+    massert(28764,
+            "chunk routing table is too large",
+            _table->_bounds.size() <= std::numeric_limits<uint32_t>::max());
+
+    // The shards of 'table' may be at other positions in the table being built.
+    std::vector<uint32_t> shardIndexes;
+    for (const auto& shardId : table._shardIds) {
+        shardIndexes.push_back(_getShardIndex(shardId));
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        _table->_boundEnds.push_back(table._boundEnds[i] - bytesBegin + offset);
+        _table->_shardIndexes.push_back(shardIndexes[table._shardIndexes[i]]);
+    }
+}
+
+std::shared_ptr<const ChunkRoutingTable> ChunkRoutingTable::Builder::done() {
+    ChunkRoutingTable& table = *_table;
+    table._shardRunEnds.resize(table.size());
+    for (size_t i = table.size(); i-- > 0;) {
+        const bool runContinues =
+            i + 1 < table.size() && table._shardIndexes[i + 1] == table._shardIndexes[i];
+        table._shardRunEnds[i] = runContinues ? table._shardRunEnds[i + 1] : i + 1;
+    }
+    return std::shared_ptr<const ChunkRoutingTable>(_table.release());
+}
+
+uint32_t ChunkRoutingTable::Builder::_getShardIndex(const ShardId& shardId) {
+    // There are few shards, and consecutive chunks are often on the same one.
+    if (!_table->_shardIndexes.empty() &&
+        _table->_shardIds[_table->_shardIndexes.back()] == shardId) {
+        return _table->_shardIndexes.back();
+    }
+
+    const auto it = std::find(_table->_shardIds.begin(), _table->_shardIds.end(), shardId);
+    if (it != _table->_shardIds.end()) {
+        return it - _table->_shardIds.begin();
+    }
+    _table->_shardIds.push_back(shardId);
+    return _table->_shardIds.size() - 1;
+}
+
+std::shared_ptr<const ChunkRoutingTable> ChunkRoutingTable::makeUpdated(
+    const ChunkRoutingTable& previous, const std::vector<ChunkInfo>& changedChunks) {
+    Builder builder;
+    size_t next = 0;  // The first chunk of 'previous' that is neither copied nor replaced yet.
+    for (const auto& chunk : changedChunks) {
+        const std::string min = encode(chunk.min);
+        const std::string max = encode(chunk.max);
+
+        // Keep the chunks that end at or before the changed chunk's min, and replace those that
+        // end within it.
+        const size_t firstReplaced = previous._upperBound(min, next);
+        builder.appendFrom(previous, next, firstReplaced);
+        next = previous._upperBound(max, firstReplaced);
+        builder.appendEncoded(max, chunk.shardId);
+    }
+    builder.appendFrom(previous, next, previous.size());
+    return builder.done();
+}
+
+size_t ChunkRoutingTable::upperBound(const BSONObj& key) const {
+    KeyString encodedKey;
+    encodeKey(key, &encodedKey);
+    return _upperBound(StringData(encodedKey.getBuffer(), encodedKey.getSize()), 0);
+}
+
+size_t ChunkRoutingTable::_upperBound(StringData key, size_t begin) const {
+    // Binary search on positions, comparing the bounds they refer to.
+    size_t low = begin;
+    size_t high = size();
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if (key < getEncodedMax(middle)) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+std::string ChunkRoutingTable::encode(const BSONObj& key) {
+    KeyString encodedKey;
+    encodeKey(key, &encodedKey);
+    return std::string(encodedKey.getBuffer(), encodedKey.getSize());
+}
+
+}  // namespace mongo
@@ -0,0 +1,163 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/s/client/shard.h"
+
+namespace mongo {
+
+/**
+ * An immutable index of a sharded collection's chunks, in the order of their bounds, for routing
+ * shard keys and ranges of them to chunks and shards.
+ *
+ * The max bound of each chunk is encoded once as a KeyString, and the encodings are stored end to
+ * end in one buffer, so a lookup is a binary search over contiguous memory that compares bytes.
+ * Tables are shared as shared_ptr<const ChunkRoutingTable>. Changing chunks makes a new table,
+ * which copies the encoded bounds of the chunks that did not change, and leaves the old table as
+ * it was for anyone still reading it.
+ *
+ * Bounds are compared as BSONObj::woCompare() with the default ordering compares them, and must
+ * all have the fields of the collection's shard key.
+ */
+class ChunkRoutingTable {
+    MONGO_DISALLOW_COPYING(ChunkRoutingTable);
+
+public:
+    /**
+     * The bounds and shard of a chunk.
+     */
+    struct ChunkInfo {
+        ChunkInfo(BSONObj min, BSONObj max, ShardId shardId)
+            : min(std::move(min)), max(std::move(max)), shardId(std::move(shardId)) {}
+
+        BSONObj min;
+        BSONObj max;
+        ShardId shardId;
+    };
+
+    /**
+     * Builds a table from chunks appended in the order of their bounds.
+     */
+    class Builder {
+        MONGO_DISALLOW_COPYING(Builder);
+
+    public:
+        Builder();
+
+        void append(const BSONObj& max, const ShardId& shardId);
+
+        /**
+         * Appends a chunk whose max bound is already encoded, as by encode().
+         */
+        void appendEncoded(StringData encodedMax, const ShardId& shardId);
+
+        /**
+         * Appends the chunks of 'table' in positions [begin, end) without encoding them again.
+         */
+        void appendFrom(const ChunkRoutingTable& table, size_t begin, size_t end);
+
+        std::shared_ptr<const ChunkRoutingTable> done();
+
+    private:
+        uint32_t _getShardIndex(const ShardId& shardId);
+
+        std::unique_ptr<ChunkRoutingTable> _table;
+    };
+
+    /**
+     * Returns a table of the chunks of 'previous' with 'changedChunks' applied to them, encoding
+     * only the bounds of 'changedChunks'. Each changed chunk replaces the chunks of 'previous'
+     * whose max bound is in (min, max] of the changed chunk, as ConfigDiffTracker replaces them.
+     *
+     * 'changedChunks' must be sorted by their bounds and must not overlap each other.
+     */
+    static std::shared_ptr<const ChunkRoutingTable> makeUpdated(
+        const ChunkRoutingTable& previous, const std::vector<ChunkInfo>& changedChunks);
+
+    size_t size() const {
+        return _boundEnds.size();
+    }
+
+    bool empty() const {
+        return _boundEnds.empty();
+    }
+
+    /**
+     * Returns the position of the first chunk whose max bound is greater than 'key', or size()
+     * if there is none. This is the chunk that contains 'key', if any does.
+     */
+    size_t upperBound(const BSONObj& key) const;
+
+    const ShardId& getShardId(size_t i) const {
+        return _shardIds[_shardIndexes[i]];
+    }
+
+    /**
+     * Returns the position after the run of chunks that starts at 'i' and are all on the same
+     * shard as the chunk at 'i'.
+     */
+    size_t endOfShardRun(size_t i) const {
+        return _shardRunEnds[i];
+    }
+
+    /**
+     * Returns the encoded max bound of the chunk at 'i'.
+     */
+    StringData getEncodedMax(size_t i) const {
+        const uint32_t begin = i == 0 ? 0 : _boundEnds[i - 1];
+        return StringData(_bounds.data() + begin, _boundEnds[i] - begin);
+    }
+
+    /**
+     * Returns the encoding of 'key' that getEncodedMax() returns for bounds equal to it.
+     */
+    static std::string encode(const BSONObj& key);
+
+private:
+    ChunkRoutingTable() = default;
+
+    // Returns the position of the first chunk whose encoded max bound is greater than 'key'.
+    size_t _upperBound(StringData key, size_t begin) const;
+
+    std::string _bounds;                 // The encoded max bounds of all chunks, end to end.
+    std::vector<uint32_t> _boundEnds;    // The offset in _bounds where each bound ends.
+    std::vector<uint32_t> _shardIndexes;  // The position in _shardIds of each chunk's shard.
+    std::vector<uint32_t> _shardRunEnds;  // See endOfShardRun().
+    std::vector<ShardId> _shardIds;
+};
+
+}  // namespace mongo
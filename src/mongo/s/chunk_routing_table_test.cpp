@@ -0,0 +1,174 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_routing_table.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using ChunkInfo = ChunkRoutingTable::ChunkInfo;
+
+// Chunks on key {a: 1} that split the key space at 'splitPoints', which must be sorted.
+std::vector<ChunkInfo> makeChunks(const std::vector<BSONObj>& splitPoints,
+                                  const std::vector<ShardId>& shardIds) {
+    std::vector<ChunkInfo> chunks;
+    BSONObj min = BSON("a" << MINKEY);
+    for (size_t i = 0; i <= splitPoints.size(); i++) {
+        const BSONObj max = i < splitPoints.size() ? splitPoints[i] : BSON("a" << MAXKEY);
+        chunks.emplace_back(min, max, shardIds[i % shardIds.size()]);
+        min = max;
+    }
+    return chunks;
+}
+
+std::shared_ptr<const ChunkRoutingTable> makeTable(const std::vector<ChunkInfo>& chunks) {
+    ChunkRoutingTable::Builder builder;
+    for (const auto& chunk : chunks) {
+        builder.append(chunk.max, chunk.shardId);
+    }
+    return builder.done();
+}
+
+void assertSameTable(const ChunkRoutingTable& expected, const ChunkRoutingTable& actual) {
+    ASSERT_EQUALS(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQUALS(expected.getEncodedMax(i), actual.getEncodedMax(i));
+        ASSERT_EQUALS(expected.getShardId(i), actual.getShardId(i));
+        ASSERT_EQUALS(expected.endOfShardRun(i), actual.endOfShardRun(i));
+    }
+}
+
+TEST(ChunkRoutingTableTest, UpperBoundMatchesBSONOrder) {
+    // Split points of several types, in BSON order.
+    std::vector<BSONObj> splitPoints;
+    splitPoints.push_back(BSON("a" << BSONNULL));
+    for (int i = -50; i < 50; i++) {
+        splitPoints.push_back(i % 2 ? BSON("a" << i * 10) : BSON("a" << i * 10 + 0.5));
+    }
+    for (int i = 0; i < 50; i++) {
+        splitPoints.push_back(BSON("a" << std::string(1, 'a' + i % 26) + std::to_string(i)));
+    }
+    std::sort(splitPoints.begin(), splitPoints.end());
+    splitPoints.push_back(BSON("a" << OID()));
+
+    const auto chunks = makeChunks(splitPoints, {"shard0", "shard1", "shard2"});
+    const auto table = makeTable(chunks);
+    ASSERT_EQUALS(chunks.size(), table->size());
+
+    std::map<BSONObj, size_t, BSONObjCmp> chunkMap;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        chunkMap[chunks[i].max] = i;
+    }
+
+    std::vector<BSONObj> keys(splitPoints);
+    keys.push_back(BSON("a" << MINKEY));
+    keys.push_back(BSON("a" << MAXKEY));
+    PseudoRandom random(1);
+    for (int i = 0; i < 1000; i++) {
+        keys.push_back(BSON("a" << random.nextInt32(1200) - 600));
+        keys.push_back(BSON("a" << (random.nextInt32(1200) - 600) / 3.0));
+    }
+    keys.push_back(BSON("a"
+                        << "z"));
+
+    for (const auto& key : keys) {
+        const auto it = chunkMap.upper_bound(key);
+        const size_t expected = it == chunkMap.end() ? chunks.size() : it->second;
+        ASSERT_EQUALS(expected, table->upperBound(key)) << key;
+    }
+}
+
+TEST(ChunkRoutingTableTest, ShardRuns) {
+    const std::vector<BSONObj> splitPoints = {
+        BSON("a" << 1), BSON("a" << 2), BSON("a" << 3), BSON("a" << 4), BSON("a" << 5)};
+    const auto table =
+        makeTable(makeChunks(splitPoints, {"shard0", "shard0", "shard1", "shard0", "shard0"}));
+
+    // The chunks are on shard0, shard0, shard1, shard0, shard0 and shard0.
+    ASSERT_EQUALS(6U, table->size());
+    ASSERT_EQUALS(2U, table->endOfShardRun(0));
+    ASSERT_EQUALS(2U, table->endOfShardRun(1));
+    ASSERT_EQUALS(3U, table->endOfShardRun(2));
+    ASSERT_EQUALS(6U, table->endOfShardRun(3));
+    ASSERT_EQUALS(6U, table->endOfShardRun(5));
+    ASSERT_EQUALS("shard1", table->getShardId(2));
+}
+
+TEST(ChunkRoutingTableTest, EmptyTable) {
+    const auto table = ChunkRoutingTable::Builder().done();
+    ASSERT(table->empty());
+    ASSERT_EQUALS(0U, table->upperBound(BSON("a" << 1)));
+}
+
+TEST(ChunkRoutingTableTest, MakeUpdatedMatchesRebuild) {
+    std::vector<BSONObj> splitPoints;
+    for (int i = 1; i < 100; i++) {
+        splitPoints.push_back(BSON("a" << i * 10));
+    }
+    auto chunks = makeChunks(splitPoints, {"shard0", "shard1"});
+    const auto original = makeTable(chunks);
+
+    // Split the chunk [10, 20) at 15, move [500, 510) to a new shard, merge [980, 990) and
+    // [990, MaxKey), and replace [MinKey, 10) with an identical chunk.
+    const std::vector<ChunkInfo> changedChunks = {
+        ChunkInfo(BSON("a" << MINKEY), BSON("a" << 10), chunks[0].shardId),
+        ChunkInfo(BSON("a" << 10), BSON("a" << 15), "shard1"),
+        ChunkInfo(BSON("a" << 15), BSON("a" << 20), "shard1"),
+        ChunkInfo(BSON("a" << 500), BSON("a" << 510), "shard2"),
+        ChunkInfo(BSON("a" << 980), BSON("a" << MAXKEY), "shard0")};
+    const auto updated = ChunkRoutingTable::makeUpdated(*original, changedChunks);
+
+    chunks.erase(chunks.begin() + 98, chunks.end());
+    chunks.push_back(changedChunks[4]);
+    chunks[50] = changedChunks[3];
+    chunks[1] = changedChunks[2];
+    chunks.insert(chunks.begin() + 1, changedChunks[1]);
+    assertSameTable(*makeTable(chunks), *updated);
+    ASSERT_EQUALS(100U, updated->size());
+    ASSERT_EQUALS(2U, updated->upperBound(BSON("a" << 15)));
+    ASSERT_EQUALS("shard2", updated->getShardId(updated->upperBound(BSON("a" << 505))));
+
+    // The original table is unchanged.
+    assertSameTable(*makeTable(makeChunks(splitPoints, {"shard0", "shard1"})), *original);
+
+    // Applying no changes copies the table.
+    assertSameTable(*original, *ChunkRoutingTable::makeUpdated(*original, {}));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -38,7 +38,9 @@
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/matcher.h"
 #include "mongo/s/commands/run_on_all_shards_cmd.h"
+#include "mongo/s/query/cluster_find.h"
 #include "mongo/s/strategy.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
@@ -130,7 +132,9 @@ public:
         return originalResult;
     }
 
-    void aggregateResults(const std::vector<ShardAndReply>& results, BSONObjBuilder& output) final {
+    void aggregateResults(const BSONObj& cmdObj,
+                          const std::vector<ShardAndReply>& results,
+                          BSONObjBuilder& output) final {
         // Each shard responds with a document containing an array of subdocuments.
         // Each subdocument represents an operation running on that shard.
         // We merge the responses into a single document containg an array
@@ -201,6 +205,30 @@ public:
                 aggregatedOpsBab.append(modifiedShardOpBob.obj());
             }
         }
+
+        // The queries this mongos is merging the results of are not known to any shard, so they
+        // are filtered here the way each shard filters its own operations.
+        BSONArrayBuilder activeQueriesBab;
+        ClusterFind::appendActiveQueries(&activeQueriesBab);
+        const BSONArray activeQueries = activeQueriesBab.arr();
+        if (!activeQueries.isEmpty()) {
+            const bool includeAll = cmdObj["$all"].trueValue();
+
+            BSONObjBuilder filterBob;
+            for (auto&& cmdElem : cmdObj) {
+                auto fieldName = cmdElem.fieldNameStringData();
+                if (fieldName != kCommandName && fieldName != "$all") {
+                    filterBob.append(cmdElem);
+                }
+            }
+            const Matcher matcher(filterBob.obj());
+
+            for (auto&& activeQuery : activeQueries) {
+                if (includeAll || matcher.matches(activeQuery.Obj())) {
+                    aggregatedOpsBab.append(activeQuery);
+                }
+            }
+        }
         aggregatedOpsBab.done();
     }
 
@@ -48,7 +48,9 @@ public:
         out->push_back(Privilege(ResourcePattern::forDatabaseName(dbname), actions));
     }
 
-    virtual void aggregateResults(const vector<ShardAndReply>& results, BSONObjBuilder& output) {
+    virtual void aggregateResults(const BSONObj& cmdObj,
+                                  const vector<ShardAndReply>& results,
+                                  BSONObjBuilder& output) {
         long long objects = 0;
         long long unscaledDataSize = 0;
         long long dataSize = 0;
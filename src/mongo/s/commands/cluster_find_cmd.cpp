@@ -48,6 +48,22 @@ using std::unique_ptr;
 using std::string;
 using std::vector;
 
+/**
+ * Extracts the read preference of a find command. If none is specified, returns "primaryOnly".
+ */
+StatusWith<ReadPreferenceSetting> extractReadPref(const BSONObj& cmdObj) {
+    BSONElement readPrefElt;
+    auto status = bsonExtractTypedField(
+        cmdObj, LiteParsedQuery::kFindCommandReadPrefField, BSONType::Object, &readPrefElt);
+    if (status == ErrorCodes::NoSuchKey) {
+        return ReadPreferenceSetting(ReadPreference::PrimaryOnly, TagSet::primaryOnly());
+    }
+    if (!status.isOK()) {
+        return status;
+    }
+    return ReadPreferenceSetting::fromBSON(readPrefElt.Obj());
+}
+
 /**
  * Implements the find command on mongos.
  */
@@ -141,8 +157,30 @@ public:
 
         const char* mongosStageName = ClusterExplain::getStageNameForReadOp(shardResults, cmdObj);
 
-        return ClusterExplain::buildExplainResult(
+        Status explainStatus = ClusterExplain::buildExplainResult(
             shardResults, mongosStageName, millisElapsed, out);
+        if (!explainStatus.isOK() || verbosity < ExplainCommon::EXEC_STATS) {
+            return explainStatus;
+        }
+
+        // The shards explained their part of the query, so run the query through the merge to
+        // report the results received from each host and how long the merge waited for it.
+        auto readPref = extractReadPref(cmdObj);
+        if (!readPref.isOK()) {
+            return readPref.getStatus();
+        }
+
+        auto cq = CanonicalQuery::canonicalize(lpq.release());
+        if (!cq.isOK()) {
+            return cq.getStatus();
+        }
+
+        std::vector<BSONObj> batch;
+        BSONArrayBuilder remoteStats(out->subarrayStart("remoteStats"));
+        auto cursorId =
+            ClusterFind::runQuery(txn, *cq.getValue(), readPref.getValue(), &batch, &remoteStats);
+        remoteStats.doneFast();
+        return cursorId.getStatus();
     }
 
     bool run(OperationContext* txn,
@@ -172,26 +210,15 @@ public:
             return appendCommandStatus(result, cq.getStatus());
         }
 
-        // Extract read preference. If no read preference is specified in the query, will we pass
-        // down a "primaryOnly" read pref.
-        ReadPreferenceSetting readPref(ReadPreference::PrimaryOnly, TagSet::primaryOnly());
-        BSONElement readPrefElt;
-        auto status = bsonExtractTypedField(
-            cmdObj, LiteParsedQuery::kFindCommandReadPrefField, BSONType::Object, &readPrefElt);
-        if (status.isOK()) {
-            auto statusWithReadPref = ReadPreferenceSetting::fromBSON(readPrefElt.Obj());
-            if (!statusWithReadPref.isOK()) {
-                return appendCommandStatus(result, statusWithReadPref.getStatus());
-            }
-            readPref = statusWithReadPref.getValue();
-        } else if (status != ErrorCodes::NoSuchKey) {
-            return appendCommandStatus(result, status);
+        auto readPref = extractReadPref(cmdObj);
+        if (!readPref.isOK()) {
+            return appendCommandStatus(result, readPref.getStatus());
         }
 
         // Do the work to generate the first batch of results. This blocks waiting to get responses
         // from the shard(s).
         std::vector<BSONObj> batch;
-        auto cursorId = ClusterFind::runQuery(txn, *cq.getValue(), readPref, &batch);
+        auto cursorId = ClusterFind::runQuery(txn, *cq.getValue(), readPref.getValue(), &batch);
         if (!cursorId.isOK()) {
             return appendCommandStatus(result, cursorId.getStatus());
         }
@@ -41,6 +41,8 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/cursor_responses.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/s/catalog/catalog_cache.h"
 #include "mongo/s/chunk_manager.h"
@@ -62,6 +64,10 @@ using std::vector;
 
 namespace {
 
+// Lets mongos merge the shards' output itself when the merge only streams that output and all of
+// the results fit in the first batch. Otherwise the merge runs on the database's primary shard.
+MONGO_EXPORT_SERVER_PARAMETER(internalAggregationMergeInRouter, bool, true);
+
 /**
  * Implements the aggregation (pipeline command for sharding).
  */
@@ -98,6 +104,21 @@ public:
                      int options,
                      std::string& errmsg,
                      BSONObjBuilder& result) {
+        return runAggregate(txn, dbname, cmdObj, options, errmsg, result, true);
+    }
+
+private:
+    /**
+     * Runs the aggregation. If 'allowMergeInRouter' is false, the shards' output is always merged
+     * on the primary shard.
+     */
+    bool runAggregate(OperationContext* txn,
+                      const std::string& dbname,
+                      BSONObj& cmdObj,
+                      int options,
+                      std::string& errmsg,
+                      BSONObjBuilder& result,
+                      bool allowMergeInRouter) {
         const string fullns = parseNs(dbname, cmdObj);
 
         auto status = grid.catalogCache()->getDatabase(dbname);
@@ -158,6 +179,21 @@ public:
             commandBuilder[field] = Value(cmdObj[field]);
         }
 
+        // Pick where to merge. Mongos has no estimate of how many documents the shards will
+        // return, so it only merges when the merging part of the pipeline streams the shards'
+        // output and is bounded to return everything in the first batch. Then no cursor has to
+        // outlive this command and the results do not take an extra hop through a shard. The
+        // size of the documents is not known up front, so if they turn out not to fit in one
+        // reply, the aggregation is run again with the merge on the primary shard.
+        long long maxMergeResults = -1;  // The inline form returns all results at once.
+        if (cmdObj.hasField("cursor")) {
+            const long long defaultBatchSize = 101;  // Same as the mongod aggregate command.
+            uassertStatusOK(
+                Command::parseCommandCursorOptions(cmdObj, defaultBatchSize, &maxMergeResults));
+        }
+        const bool mergeInRouter = needSplit && allowMergeInRouter &&
+            internalAggregationMergeInRouter && pipeline->canMergeInRouter(maxMergeResults);
+
         BSONObj shardedCommand = commandBuilder.freeze().toBson();
         BSONObj shardQuery = shardPipeline->getInitialQuery();
 
@@ -174,6 +210,7 @@ public:
                 result << "splitPipeline"
                        << DOC("shardsPart" << shardPipeline->writeExplainOps() << "mergerPart"
                                            << pipeline->writeExplainOps());
+                result << "mergeLocation" << (mergeInRouter ? "mongos" : "primaryShard");
             } else {
                 result << "splitPipeline" << BSONNULL;
             }
@@ -199,6 +236,15 @@ public:
         DocumentSourceMergeCursors::CursorIds cursorIds = parseCursors(shardResults, fullns);
         pipeline->addInitialSource(DocumentSourceMergeCursors::create(cursorIds, mergeCtx));
 
+        if (mergeInRouter) {
+            if (mergeOnRouter(pipeline, fullns, cmdObj, result)) {
+                return true;
+            }
+            LOG(1) << "results of aggregation on " << fullns << " do not fit in one reply, "
+                   << "merging on the primary shard instead";
+            return runAggregate(txn, dbname, cmdObj, options, errmsg, result, false);
+        }
+
         MutableDocument mergeCmd(pipeline->serialize());
         mergeCmd["cursor"] = Value(cmdObj["cursor"]);
 
@@ -233,11 +279,20 @@ public:
         return mergedResults["ok"].trueValue();
     }
 
-private:
     DocumentSourceMergeCursors::CursorIds parseCursors(
         const vector<Strategy::CommandResult>& shardResults, const string& fullns);
 
     void killAllCursors(const vector<Strategy::CommandResult>& shardResults);
+
+    // Runs the merging part of the pipeline, whose first source reads the shards' cursors, on
+    // this mongos and appends all of its results to 'result', with no cursor left open. Returns
+    // false, having appended nothing and closed the shards' cursors, if the results do not fit in
+    // one reply.
+    bool mergeOnRouter(const intrusive_ptr<Pipeline>& pipeline,
+                       const string& fullns,
+                       const BSONObj& cmdObj,
+                       BSONObjBuilder& result);
+
     void uassertAllShardsSupportExplain(const vector<Strategy::CommandResult>& shardResults);
 
     // These are temporary hacks because the runCommand method doesn't report the exact
@@ -302,6 +357,36 @@ DocumentSourceMergeCursors::CursorIds PipelineCommand::parseCursors(
     }
 }
 
+bool PipelineCommand::mergeOnRouter(const intrusive_ptr<Pipeline>& pipeline,
+                                    const string& fullns,
+                                    const BSONObj& cmdObj,
+                                    BSONObjBuilder& result) {
+    pipeline->stitch();
+
+    // Reading the merged stream to its end returns the connections to the shards. The extra 1KB
+    // leaves room for the headers of the reply, as in Pipeline::run().
+    BSONArrayBuilder resultArray;
+    DocumentSource* finalSource = pipeline->output();
+    while (boost::optional<Document> next = finalSource->getNext()) {
+        BSONObjBuilder documentBuilder(resultArray.subobjStart());
+        next->toBson(&documentBuilder);
+        documentBuilder.doneFast();
+        if (resultArray.len() >= BSONObjMaxUserSize - 1024) {
+            // Kills the shards' cursors and returns their connections.
+            finalSource->dispose();
+            return false;
+        }
+    }
+
+    if (cmdObj.hasField("cursor")) {
+        appendCursorResponseObject(0, fullns, resultArray.arr(), &result);
+    } else {
+        result.appendArray("result", resultArray.arr());
+    }
+
+    return true;
+}
+
 void PipelineCommand::uassertAllShardsSupportExplain(
     const vector<Strategy::CommandResult>& shardResults) {
     for (size_t i = 0; i < shardResults.size(); i++) {
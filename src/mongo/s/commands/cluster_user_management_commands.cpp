@@ -50,6 +50,26 @@ using std::string;
 using std::stringstream;
 using std::vector;
 
+namespace {
+
+/**
+ * Invalidates the cached users who are members of the role named by a role management command,
+ * or the whole user cache if the command does not name a role.
+ */
+void invalidateUsersWithRoleFromCommand(const std::string& dbname, const BSONObj& cmdObj) {
+    AuthorizationManager* authzManager = getGlobalAuthorizationManager();
+    invariant(authzManager);
+
+    const BSONElement roleElement = cmdObj.firstElement();
+    if (roleElement.type() != String) {
+        authzManager->invalidateUserCache();
+        return;
+    }
+    authzManager->invalidateUsersWithRole(RoleName(roleElement.valueStringData(), dbname));
+}
+
+}  // namespace
+
 class CmdCreateUser : public Command {
 public:
     CmdCreateUser() : Command("createUser") {}
@@ -422,9 +442,7 @@ public:
         const bool ok = grid.catalogManager()->runUserManagementWriteCommand(
             this->name, dbname, cmdObj, &result);
 
-        AuthorizationManager* authzManager = getGlobalAuthorizationManager();
-        invariant(authzManager);
-        authzManager->invalidateUserCache();
+        invalidateUsersWithRoleFromCommand(dbname, cmdObj);
 
         return ok;
     }
@@ -462,9 +480,7 @@ public:
         const bool ok = grid.catalogManager()->runUserManagementWriteCommand(
             this->name, dbname, cmdObj, &result);
 
-        AuthorizationManager* authzManager = getGlobalAuthorizationManager();
-        invariant(authzManager);
-        authzManager->invalidateUserCache();
+        invalidateUsersWithRoleFromCommand(dbname, cmdObj);
 
         return ok;
     }
@@ -502,9 +518,7 @@ public:
         const bool ok = grid.catalogManager()->runUserManagementWriteCommand(
             this->name, dbname, cmdObj, &result);
 
-        AuthorizationManager* authzManager = getGlobalAuthorizationManager();
-        invariant(authzManager);
-        authzManager->invalidateUserCache();
+        invalidateUsersWithRoleFromCommand(dbname, cmdObj);
 
         return ok;
     }
@@ -542,9 +556,7 @@ public:
         const bool ok = grid.catalogManager()->runUserManagementWriteCommand(
             this->name, dbname, cmdObj, &result);
 
-        AuthorizationManager* authzManager = getGlobalAuthorizationManager();
-        invariant(authzManager);
-        authzManager->invalidateUserCache();
+        invalidateUsersWithRoleFromCommand(dbname, cmdObj);
 
         return ok;
     }
@@ -582,9 +594,7 @@ public:
         const bool ok = grid.catalogManager()->runUserManagementWriteCommand(
             this->name, dbname, cmdObj, &result);
 
-        AuthorizationManager* authzManager = getGlobalAuthorizationManager();
-        invariant(authzManager);
-        authzManager->invalidateUserCache();
+        invalidateUsersWithRoleFromCommand(dbname, cmdObj);
 
         return ok;
     }
@@ -625,9 +635,7 @@ public:
         const bool ok = grid.catalogManager()->runUserManagementWriteCommand(
             this->name, dbname, cmdObj, &result);
 
-        AuthorizationManager* authzManager = getGlobalAuthorizationManager();
-        invariant(authzManager);
-        authzManager->invalidateUserCache();
+        invalidateUsersWithRoleFromCommand(dbname, cmdObj);
 
         return ok;
     }
@@ -336,7 +336,9 @@ public:
         actions.addAction(ActionType::validate);
         out->push_back(Privilege(parseResourcePattern(dbname, cmdObj), actions));
     }
-    virtual void aggregateResults(const vector<ShardAndReply>& results, BSONObjBuilder& output) {
+    virtual void aggregateResults(const BSONObj& cmdObj,
+                                  const vector<ShardAndReply>& results,
+                                  BSONObjBuilder& output) {
         for (vector<ShardAndReply>::const_iterator it(results.begin()), end(results.end());
              it != end;
              it++) {
@@ -52,7 +52,8 @@ RunOnAllShardsCommand::RunOnAllShardsCommand(const char* name,
       _useShardConn(useShardConn),
       _implicitCreateDb(implicitCreateDb) {}
 
-void RunOnAllShardsCommand::aggregateResults(const std::vector<ShardAndReply>& results,
+void RunOnAllShardsCommand::aggregateResults(const BSONObj& cmdObj,
+                                             const std::vector<ShardAndReply>& results,
                                              BSONObjBuilder& output) {}
 
 BSONObj RunOnAllShardsCommand::specialErrorHandler(const std::string& server,
@@ -165,7 +166,7 @@ bool RunOnAllShardsCommand::run(OperationContext* txn,
         return false;
     }
 
-    aggregateResults(results, output);
+    aggregateResults(cmdObj, results, output);
     return true;
 }
 }
@@ -71,7 +71,8 @@ public:
     // This can be used to create an instance of Shard
     using ShardAndReply = std::tuple<StringData, BSONObj>;
 
-    virtual void aggregateResults(const std::vector<ShardAndReply>& results,
+    virtual void aggregateResults(const BSONObj& cmdObj,
+                                  const std::vector<ShardAndReply>& results,
                                   BSONObjBuilder& output);
 
     // The default implementation is the identity function.
@@ -32,11 +32,13 @@
 
 #include "mongo/s/config.h"
 
-
+#include "mongo/base/counter.h"
 #include "mongo/client/connpool.h"
 #include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/db/write_concern.h"
 #include "mongo/s/catalog/catalog_cache.h"
 #include "mongo/s/catalog/catalog_manager.h"
@@ -53,7 +55,10 @@
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/cluster_write.h"
 #include "mongo/s/grid.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -63,6 +68,47 @@ using std::string;
 using std::unique_ptr;
 using std::vector;
 
+namespace {
+
+// Collections are refreshed independently, so a few threads serve all databases.
+const int kMaxChunkManagerRefreshThreads = 4;
+
+stdx::mutex chunkManagerRefreshPoolMutex;
+ThreadPool* chunkManagerRefreshPool = nullptr;
+
+ThreadPool* getChunkManagerRefreshPool() {
+    stdx::lock_guard<stdx::mutex> lk(chunkManagerRefreshPoolMutex);
+    if (!chunkManagerRefreshPool) {
+        ThreadPool::Options options;
+        options.poolName = "ChunkManagerRefresh";
+        options.threadNamePrefix = "chunkManagerRefresh-";
+        options.minThreads = 0;
+        options.maxThreads = kMaxChunkManagerRefreshThreads;
+
+        // Intentionally leaked, so that it never has to be shut down.
+        chunkManagerRefreshPool = new ThreadPool(options);
+        chunkManagerRefreshPool->startup();
+    }
+    return chunkManagerRefreshPool;
+}
+
+// How long chunk manager reloads take.
+TimerStats chunkManagerRefreshStats;
+ServerStatusMetricField<TimerStats> displayChunkManagerRefreshStats(
+    "chunkManager.refresh.latency", &chunkManagerRefreshStats);
+
+// Requests for a reload that waited for one already in progress rather than starting another.
+Counter64 chunkManagerRefreshesCoalesced;
+ServerStatusMetricField<Counter64> displayChunkManagerRefreshesCoalesced(
+    "chunkManager.refresh.coalesced", &chunkManagerRefreshesCoalesced);
+
+// Reloads started without anyone waiting for them.
+Counter64 chunkManagerRefreshesInBackground;
+ServerStatusMetricField<Counter64> displayChunkManagerRefreshesInBackground(
+    "chunkManager.refresh.background", &chunkManagerRefreshesInBackground);
+
+}  // namespace
+
 CollectionInfo::CollectionInfo(const CollectionType& coll) {
     _dropped = coll.getDropped();
 
@@ -265,7 +311,6 @@ std::shared_ptr<ChunkManager> DBConfig::getChunkManager(const string& ns,
                                                         bool forceReload) {
     BSONObj key;
     ChunkVersion oldVersion;
-    ChunkManagerPtr oldManager;
 
     {
         stdx::lock_guard<stdx::mutex> lk(_lock);
@@ -288,7 +333,6 @@ std::shared_ptr<ChunkManager> DBConfig::getChunkManager(const string& ns,
         key = ci.key().copy();
 
         if (ci.getCM()) {
-            oldManager = ci.getCM();
             oldVersion = ci.getCM()->getVersion();
         }
     }
@@ -322,40 +366,157 @@ std::shared_ptr<ChunkManager> DBConfig::getChunkManager(const string& ns,
     }
 
     // we are not locked now, and want to load a new ChunkManager
+    return _waitForChunkManagerRefresh(
+        ns, forceReload, newestChunk.empty() ? ChunkVersion() : newestChunk[0].getVersion());
+}
 
-    unique_ptr<ChunkManager> tempChunkManager;
+void DBConfig::scheduleChunkManagerRefresh(const string& ns) {
+    stdx::lock_guard<stdx::mutex> lk(_lock);
 
-    {
-        stdx::lock_guard<stdx::mutex> lll(_hitConfigServerLock);
+    CollectionInfoMap::const_iterator it = _collections.find(ns);
+    if (it == _collections.end() || !it->second.isSharded()) {
+        return;
+    }
 
-        if (!newestChunk.empty() && !forceReload) {
-            // If we have a target we're going for see if we've hit already
-            stdx::lock_guard<stdx::mutex> lk(_lock);
+    bool started;
+    _startChunkManagerRefresh_inlock(ns, false, &started);
+    if (started) {
+        chunkManagerRefreshesInBackground.increment();
+    }
+}
 
-            CollectionInfo& ci = _collections[ns];
+std::shared_ptr<ChunkManager> DBConfig::_waitForChunkManagerRefresh(
+    const string& ns, bool forceReload, const ChunkVersion& targetVersion) {
+    stdx::unique_lock<stdx::mutex> lk(_lock);
 
-            if (ci.isSharded() && ci.getCM()) {
-                ChunkVersion currentVersion = newestChunk[0].getVersion();
+    while (true) {
+        if (!forceReload && targetVersion.isSet()) {
+            // If we have a target we're going for see if we've hit already
+            CollectionInfo& ci = _collections[ns];
 
-                // Only reload if the version we found is newer than our own in the same epoch
-                if (currentVersion <= ci.getCM()->getVersion() &&
-                    ci.getCM()->getVersion().hasEqualEpoch(currentVersion)) {
-                    return ci.getCM();
-                }
+            // Only reload if the version we found is newer than our own in the same epoch
+            if (ci.isSharded() && targetVersion <= ci.getCM()->getVersion() &&
+                ci.getCM()->getVersion().hasEqualEpoch(targetVersion)) {
+                return ci.getCM();
             }
         }
 
-        tempChunkManager.reset(new ChunkManager(
-            oldManager->getns(), oldManager->getShardKeyPattern(), oldManager->isUnique()));
-        tempChunkManager->loadExistingRanges(oldManager.get());
+        bool started;
+        const auto refresh = _startChunkManagerRefresh_inlock(ns, forceReload, &started);
+        _chunkManagerRefreshDone.wait(lk, [&refresh] { return refresh->done; });
+
+        if (started) {
+            uassertStatusOK(refresh->status);
+            return refresh->manager;
+        }
+
+        // A reload that was already in progress may not have been forced, or may have read the
+        // config server before the chunk we are after was written, in which case we start our
+        // own.
+        if (forceReload && !refresh->forced) {
+            continue;
+        }
 
-        if (tempChunkManager->numChunks() == 0) {
-            // Maybe we're not sharded any more, so do a full reload
-            reload();
+        uassertStatusOK(refresh->status);
 
-            return getChunkManager(ns, false);
+        if (!targetVersion.isSet()) {
+            return refresh->manager;
         }
     }
+}
+
+std::shared_ptr<DBConfig::ChunkManagerRefresh> DBConfig::_startChunkManagerRefresh_inlock(
+    const string& ns, bool forceReload, bool* started) {
+    std::shared_ptr<ChunkManagerRefresh>& refresh = _chunkManagerRefreshes[ns];
+    if (refresh) {
+        chunkManagerRefreshesCoalesced.increment();
+        *started = false;
+        return refresh;
+    }
+
+    refresh = std::make_shared<ChunkManagerRefresh>(forceReload);
+    *started = true;
+
+    // The task keeps this DBConfig alive until the refresh is published.
+    const auto self = shared_from_this();
+    const auto newRefresh = refresh;
+    Status status = getChunkManagerRefreshPool()->schedule(
+        [self, ns, newRefresh] { self->_runChunkManagerRefresh(ns, newRefresh); });
+    if (!status.isOK()) {
+        refresh->done = true;
+        refresh->status = status;
+        _chunkManagerRefreshes.erase(ns);
+        return newRefresh;
+    }
+
+    return refresh;
+}
+
+void DBConfig::_runChunkManagerRefresh(const string& ns,
+                                       std::shared_ptr<ChunkManagerRefresh> refresh) {
+    Client::initThreadIfNotAlready("chunkManagerRefresh");
+
+    // Only replaced once the load has finished, so the waiters see an error if an exception
+    // escapes it.
+    Status status(ErrorCodes::InternalError,
+                  str::stream() << "chunk manager refresh for collection '" << ns
+                                << "' did not complete");
+    std::shared_ptr<ChunkManager> manager;
+
+    // Release the waiters however the refresh ends.
+    ScopeGuard completeGuard = MakeGuard([&] {
+        stdx::lock_guard<stdx::mutex> lk(_lock);
+        refresh->done = true;
+        refresh->status = std::move(status);
+        refresh->manager = std::move(manager);
+
+        auto it = _chunkManagerRefreshes.find(ns);
+        if (it != _chunkManagerRefreshes.end() && it->second == refresh) {
+            _chunkManagerRefreshes.erase(it);
+        }
+        _chunkManagerRefreshDone.notify_all();
+    });
+
+    Timer timer;
+    try {
+        manager = _loadChunkManager(ns, refresh->forced);
+        status = Status::OK();
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    } catch (const std::exception& ex) {
+        status = Status(ErrorCodes::UnknownError, ex.what());
+    }
+    chunkManagerRefreshStats.record(timer);
+
+    if (!status.isOK()) {
+        warning() << "failed to reload chunk manager for collection '" << ns << "'"
+                  << causedBy(status);
+    }
+}
+
+std::shared_ptr<ChunkManager> DBConfig::_loadChunkManager(const string& ns, bool forceReload) {
+    ChunkManagerPtr oldManager;
+    {
+        stdx::lock_guard<stdx::mutex> lk(_lock);
+
+        CollectionInfo& ci = _collections[ns];
+        uassert(28765,
+                str::stream() << "not sharded when reloading chunks : " << ns,
+                ci.isSharded());
+
+        oldManager = ci.getCM();
+    }
+
+    unique_ptr<ChunkManager> tempChunkManager(new ChunkManager(
+        oldManager->getns(), oldManager->getShardKeyPattern(), oldManager->isUnique()));
+    tempChunkManager->loadExistingRanges(oldManager.get());
+
+    if (tempChunkManager->numChunks() == 0) {
+        // Maybe we're not sharded any more, so do a full reload
+        reload();
+
+        return getChunkManager(ns, false);
+    }
 
     stdx::lock_guard<stdx::mutex> lk(_lock);
 
@@ -28,10 +28,14 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <set>
 
 #include "mongo/db/jsobj.h"
+#include "mongo/s/chunk_version.h"
 #include "mongo/s/client/shard.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
@@ -95,7 +99,7 @@ private:
 /**
  * top level configuration for a database
  */
-class DBConfig {
+class DBConfig : public std::enable_shared_from_this<DBConfig> {
 public:
     DBConfig(std::string name, const DatabaseType& dbt);
 
@@ -135,6 +139,15 @@ public:
                                   std::shared_ptr<ChunkManager>& manager,
                                   std::shared_ptr<Shard>& primary);
 
+    /**
+     * Returns the chunk manager of the sharded collection 'ns', and throws if it is not sharded.
+     *
+     * With 'reload', the chunk manager is first brought up to date with the config server. The
+     * new chunk manager is loaded on a background thread, by applying only the chunks changed
+     * since the current one, and is published once it is complete. Other operations on 'ns'
+     * keep using the current chunk manager meanwhile, and callers that ask for a reload while
+     * one is in progress wait for that one rather than start another.
+     */
     std::shared_ptr<ChunkManager> getChunkManager(const std::string& ns,
                                                   bool reload = false,
                                                   bool forceReload = false);
@@ -142,6 +155,12 @@ public:
                                                           bool reload = false,
                                                           bool forceReload = false);
 
+    /**
+     * Starts reloading the chunk manager of 'ns' in the background, unless a reload is already
+     * in progress, and returns without waiting for it. Does nothing if 'ns' is not sharded.
+     */
+    void scheduleChunkManagerRefresh(const std::string& ns);
+
     /**
      * Returns shard id for primary shard for the database for which this DBConfig represents.
      */
@@ -171,10 +190,52 @@ protected:
                                  std::set<ShardId>& shardIds,
                                  std::string& errmsg);
 
+    // A chunk manager reload running in the background, which callers may wait for.
+    struct ChunkManagerRefresh {
+        explicit ChunkManagerRefresh(bool forced) : forced(forced) {}
+
+        const bool forced;
+
+        // Set when the refresh completes, along with its outcome.
+        bool done = false;
+        Status status = Status::OK();
+        std::shared_ptr<ChunkManager> manager;
+    };
+
     bool _load();
     bool _reload();
     void _save(bool db = true, bool coll = true);
 
+    /**
+     * Waits for a reload of the chunk manager of 'ns', starting one unless one is in progress,
+     * and returns the resulting chunk manager. A reload that was already in progress is only
+     * used if it was forced or 'forceReload' is false, and if the resulting chunk manager is at
+     * least at 'targetVersion', when that is set.
+     */
+    std::shared_ptr<ChunkManager> _waitForChunkManagerRefresh(const std::string& ns,
+                                                              bool forceReload,
+                                                              const ChunkVersion& targetVersion);
+
+    /**
+     * Returns the reload in progress for 'ns', or schedules a new one. Sets 'started' to whether
+     * it is a new one. Must be called with _lock held.
+     */
+    std::shared_ptr<ChunkManagerRefresh> _startChunkManagerRefresh_inlock(const std::string& ns,
+                                                                          bool forceReload,
+                                                                          bool* started);
+
+    /**
+     * Runs 'refresh' for 'ns' on a background thread and publishes its outcome.
+     */
+    void _runChunkManagerRefresh(const std::string& ns,
+                                 std::shared_ptr<ChunkManagerRefresh> refresh);
+
+    /**
+     * Loads a new chunk manager for 'ns' from the config server, starting from the current one,
+     * and installs it if it is newer.
+     */
+    std::shared_ptr<ChunkManager> _loadChunkManager(const std::string& ns, bool forceReload);
+
 
     // Name of the database which this entry caches
     const std::string _name;
@@ -189,9 +250,10 @@ protected:
     stdx::mutex _lock;
     CollectionInfoMap _collections;
 
-    // Ensures that only one thread at a time loads collection configuration data from
-    // the config server
-    stdx::mutex _hitConfigServerLock;
+    // Chunk manager reloads in progress, by namespace, and the condition signalled whenever
+    // one completes. Both are protected by _lock.
+    std::map<std::string, std::shared_ptr<ChunkManagerRefresh>> _chunkManagerRefreshes;
+    stdx::condition_variable _chunkManagerRefreshDone;
 };
 
 
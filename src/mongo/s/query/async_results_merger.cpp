@@ -32,6 +32,9 @@
 
 #include "mongo/s/query/async_results_merger.h"
 
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/getmore_response.h"
 #include "mongo/db/query/killcursors_request.h"
@@ -39,9 +42,18 @@
 #include "mongo/executor/remote_command_response.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
+namespace {
+
+// Batches sized to fill the prefetch buffer grow at most this many times over each time the merge
+// has to wait for a remote.
+const long long kMaxBatchGrowth = 16;
+
+}  // namespace
+
 AsyncResultsMerger::AsyncResultsMerger(executor::TaskExecutor* executor,
                                        const ClusterClientCursorParams& params,
                                        const std::vector<HostAndPort>& remotes)
@@ -137,8 +149,7 @@ boost::optional<BSONObj> AsyncResultsMerger::nextReadySorted() {
     invariant(!_remotes[smallestRemote].docBuffer.empty());
     invariant(_remotes[smallestRemote].status.isOK());
 
-    BSONObj front = _remotes[smallestRemote].docBuffer.front();
-    _remotes[smallestRemote].docBuffer.pop();
+    BSONObj front = _remotes[smallestRemote].popNext();
 
     // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
     // next result.
@@ -146,6 +157,10 @@ boost::optional<BSONObj> AsyncResultsMerger::nextReadySorted() {
         _mergeQueue.push(smallestRemote);
     }
 
+    if (shouldPrefetch_inlock(smallestRemote)) {
+        _remotes[smallestRemote].status = askForNextBatch_inlock(smallestRemote);
+    }
+
     return front;
 }
 
@@ -156,8 +171,10 @@ boost::optional<BSONObj> AsyncResultsMerger::nextReadyUnsorted() {
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            BSONObj front = _remotes[_gettingFromRemote].docBuffer.front();
-            _remotes[_gettingFromRemote].docBuffer.pop();
+            BSONObj front = _remotes[_gettingFromRemote].popNext();
+            if (shouldPrefetch_inlock(_gettingFromRemote)) {
+                _remotes[_gettingFromRemote].status = askForNextBatch_inlock(_gettingFromRemote);
+            }
             return front;
         }
 
@@ -194,27 +211,20 @@ StatusWith<executor::TaskExecutor::EventHandle> AsyncResultsMerger::nextEvent()
         // It is illegal to call this method if there is an error received from any shard.
         invariant(remote.status.isOK());
 
-        if (!remote.hasNext() && !remote.exhausted() && !remote.cbHandle.isValid()) {
-            // If we already have established a cursor with this remote, and there is no outstanding
-            // request for which we have a valid callback handle, send a getMore with the
-            // appropriate cursorId. Otherwise, send the cursor-establishing command.
-            BSONObj cmdObj = remote.cursorId
-                ? GetMoreRequest(_params.nsString, *remote.cursorId, _params.batchSize, boost::none)
-                      .toBSON()
-                : _params.cmdObj;
+        if (remote.hasNext() || remote.exhausted()) {
+            continue;
+        }
 
-            executor::RemoteCommandRequest request(
-                remote.hostAndPort, _params.nsString.db().toString(), cmdObj);
+        // The merge is waiting for this remote until its next batch arrives.
+        if (!remote.waitStartMicros) {
+            remote.waitStartMicros = static_cast<long long>(curTimeMicros64());
+        }
 
-            auto callbackStatus = _executor->scheduleRemoteCommand(
-                request,
-                stdx::bind(
-                    &AsyncResultsMerger::handleBatchResponse, this, stdx::placeholders::_1, i));
-            if (!callbackStatus.isOK()) {
-                return callbackStatus.getStatus();
+        if (!remote.cbHandle.isValid()) {
+            Status status = askForNextBatch_inlock(i);
+            if (!status.isOK()) {
+                return status;
             }
-
-            remote.cbHandle = callbackStatus.getValue();
         }
     }
 
@@ -290,22 +300,91 @@ void AsyncResultsMerger::handleBatchResponse(
 
     remote.cursorId = getMoreResponse.cursorId;
 
+    if (remote.waitStartMicros) {
+        remote.waitMicros += static_cast<long long>(curTimeMicros64()) - *remote.waitStartMicros;
+        remote.waitStartMicros = boost::none;
+
+        // The consumer caught up with this remote, so ask it for more at a time.
+        remote.batchGrowth = std::min(remote.batchGrowth * 2, kMaxBatchGrowth);
+    }
+
+    // A remote with buffered results is already on the merge queue, if the merge is sorted.
+    const bool wasOnMergeQueue = remote.hasNext();
+
+    ++remote.batchesReceived;
     for (const auto& obj : getMoreResponse.batch) {
         remote.docBuffer.push(obj);
+        remote.bufferedBytes += obj.objsize();
+        remote.bytesReceived += obj.objsize();
     }
+    remote.docsReceived += getMoreResponse.batch.size();
 
     // If we're doing a sorted merge, then we have to make sure to put this remote onto the
     // merge queue.
-    if (!_params.sort.isEmpty() && !getMoreResponse.batch.empty()) {
+    if (!_params.sort.isEmpty() && !wasOnMergeQueue && !getMoreResponse.batch.empty()) {
         _mergeQueue.push(remoteIndex);
     }
 
+    // Keep reading ahead while little of this remote's results are buffered.
+    if (shouldPrefetch_inlock(remoteIndex)) {
+        remote.status = askForNextBatch_inlock(remoteIndex);
+    }
+
     // ScopeGuard requires dismiss on success, but we want waiter to be signalled on success as
     // well as failure.
     signaller.Dismiss();
     signalCurrentEvent_inlock();
 }
 
+bool AsyncResultsMerger::shouldPrefetch_inlock(size_t remoteIndex) const {
+    const auto& remote = _remotes[remoteIndex];
+    return _lifecycleState == kAlive && _params.prefetchBufferBytes > 0 && remote.status.isOK() &&
+        remote.cursorId && !remote.exhausted() && !remote.cbHandle.isValid() && remote.hasNext() &&
+        remote.bufferedBytes < _params.prefetchBufferBytes;
+}
+
+boost::optional<long long> AsyncResultsMerger::getNextBatchSize_inlock(size_t remoteIndex) const {
+    const auto& remote = _remotes[remoteIndex];
+    if (_params.batchSize || _params.prefetchBufferBytes <= 0 || remote.docsReceived == 0) {
+        return _params.batchSize;
+    }
+
+    // Enough of the remote's documents, at their average size so far, to fill the buffer.
+    const long long avgDocBytes = std::max(remote.bytesReceived / remote.docsReceived, 1LL);
+    return std::max(_params.prefetchBufferBytes * remote.batchGrowth / avgDocBytes, 1LL);
+}
+
+Status AsyncResultsMerger::askForNextBatch_inlock(size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+    invariant(!remote.cbHandle.isValid());
+
+    // If we already have established a cursor with this remote, send a getMore with the
+    // appropriate cursorId. Otherwise, send the cursor-establishing command.
+    BSONObj cmdObj = remote.cursorId
+        ? GetMoreRequest(_params.nsString,
+                         *remote.cursorId,
+                         getNextBatchSize_inlock(remoteIndex),
+                         boost::none).toBSON()
+        : _params.cmdObj;
+
+    executor::RemoteCommandRequest request(
+        remote.hostAndPort, _params.nsString.db().toString(), cmdObj);
+
+    auto callbackStatus = _executor->scheduleRemoteCommand(
+        request,
+        stdx::bind(
+            &AsyncResultsMerger::handleBatchResponse, this, stdx::placeholders::_1, remoteIndex));
+    if (!callbackStatus.isOK()) {
+        return callbackStatus.getStatus();
+    }
+
+    remote.cbHandle = callbackStatus.getValue();
+    if (remote.hasNext()) {
+        ++remote.prefetches;
+    }
+    return Status::OK();
+}
+
 void AsyncResultsMerger::signalCurrentEvent_inlock() {
     if (ready_inlock() && _currentEvent.isValid()) {
         // To prevent ourselves from signalling the event twice, we set '_currentEvent' as
@@ -391,6 +470,25 @@ executor::TaskExecutor::EventHandle AsyncResultsMerger::kill() {
     return _killCursorsScheduledEvent;
 }
 
+void AsyncResultsMerger::appendRemoteStats(BSONArrayBuilder* builder) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+
+    for (const auto& remote : _remotes) {
+        long long waitMicros = remote.waitMicros;
+        if (remote.waitStartMicros) {
+            waitMicros += static_cast<long long>(curTimeMicros64()) - *remote.waitStartMicros;
+        }
+
+        BSONObjBuilder remoteBuilder(builder->subobjStart());
+        remoteBuilder.append("host", remote.hostAndPort.toString());
+        remoteBuilder.append("batches", remote.batchesReceived);
+        remoteBuilder.append("docs", remote.docsReceived);
+        remoteBuilder.append("prefetches", remote.prefetches);
+        remoteBuilder.append("bufferedDocs", static_cast<long long>(remote.docBuffer.size()));
+        remoteBuilder.append("waitMicros", waitMicros);
+    }
+}
+
 //
 // AsyncResultsMerger::RemoteCursorData
 //
@@ -406,6 +504,13 @@ bool AsyncResultsMerger::RemoteCursorData::exhausted() const {
     return cursorId && (*cursorId == 0);
 }
 
+BSONObj AsyncResultsMerger::RemoteCursorData::popNext() {
+    BSONObj front = docBuffer.front();
+    docBuffer.pop();
+    bufferedBytes -= front.objsize();
+    return front;
+}
+
 //
 // AsyncResultsMerger::MergingComparator
 //
@@ -43,6 +43,8 @@
 
 namespace mongo {
 
+class BSONArrayBuilder;
+
 /**
  * AsyncResultsMerger is used to generate results from cursor-generating commands on one or more
  * remote hosts. A cursor-generating command (e.g. the find command) is one that establishes a
@@ -61,6 +63,13 @@ namespace mongo {
  * This requires waiting until we have a response from every remote before returning results.
  * Without a sort, we are ready to return results as soon as we have *any* response from a remote.
  *
+ * If 'prefetchBufferBytes' is set in the ClusterClientCursorParams, the next batch of a remote is
+ * requested as soon as fewer than that many bytes of its results are buffered, rather than once
+ * they have all been returned, so that the merge rarely has to wait for the slowest remote. At
+ * most one request is outstanding per remote. Unless a batch size was specified, batches are sized
+ * to fill the buffer given the size of the remote's documents so far, and grow each time the
+ * merge has to wait for the remote anyway.
+ *
  * On any error, the caller is responsible for shutting down the ARM using the kill() method.
  *
  * Does not throw exceptions.
@@ -142,6 +151,13 @@ public:
      */
     executor::TaskExecutor::EventHandle kill();
 
+    /**
+     * Appends a document per remote to 'builder' with its host, the batches and documents received
+     * from it, the requests sent to it ahead of time, and how long the merge waited for it while
+     * none of its results were buffered.
+     */
+    void appendRemoteStats(BSONArrayBuilder* builder);
+
 private:
     /**
      * We instantiate one of these per remote host. It contains the buffer of results we've
@@ -162,11 +178,35 @@ private:
          */
         bool exhausted() const;
 
+        /**
+         * Removes and returns the next buffered result.
+         */
+        BSONObj popNext();
+
         HostAndPort hostAndPort;
         boost::optional<CursorId> cursorId;
         std::queue<BSONObj> docBuffer;
         executor::TaskExecutor::CallbackHandle cbHandle;
         Status status = Status::OK();
+
+        // Total size of the documents in 'docBuffer'.
+        long long bufferedBytes = 0;
+
+        // What has been received from the remote so far, and the number of requests sent to it
+        // while some of its results were still buffered.
+        long long batchesReceived = 0;
+        long long docsReceived = 0;
+        long long bytesReceived = 0;
+        long long prefetches = 0;
+
+        // Factor applied to the size of the batches requested, doubled each time the merge has
+        // to wait for this remote.
+        long long batchGrowth = 1;
+
+        // When the merge started waiting for this remote, if it is waiting now, and the total
+        // time it has waited for it.
+        boost::optional<long long> waitStartMicros;
+        long long waitMicros = 0;
     };
 
     class MergingComparator {
@@ -205,6 +245,27 @@ private:
     boost::optional<BSONObj> nextReadySorted();
     boost::optional<BSONObj> nextReadyUnsorted();
 
+    //
+    // Helpers for requesting batches.
+    //
+
+    /**
+     * Returns whether the next batch of the remote at 'remoteIndex' should be requested before
+     * its buffered results run out.
+     */
+    bool shouldPrefetch_inlock(size_t remoteIndex) const;
+
+    /**
+     * Returns the batch size for the next getMore sent to the remote at 'remoteIndex'.
+     */
+    boost::optional<long long> getNextBatchSize_inlock(size_t remoteIndex) const;
+
+    /**
+     * Schedules a request for the next batch of the remote at 'remoteIndex', which must not have
+     * a request outstanding.
+     */
+    Status askForNextBatch_inlock(size_t remoteIndex);
+
     /**
      * When nextEvent() schedules remote work, it passes this method as a callback. The TaskExecutor
      * will call this function, passing the response from the remote.
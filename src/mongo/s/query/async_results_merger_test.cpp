@@ -67,7 +67,9 @@ protected:
      * Given a find command specification, 'findCmd', and a list of remote host:port pairs,
      * constructs the appropriate arm.
      */
-    void makeCursorFromFindCmd(const BSONObj& findCmd, const std::vector<HostAndPort>& remotes) {
+    void makeCursorFromFindCmd(const BSONObj& findCmd,
+                               const std::vector<HostAndPort>& remotes,
+                               long long prefetchBufferBytes = 0) {
         const bool isExplain = true;
         lpq = unittest::assertGet(LiteParsedQuery::makeFromFindCommand(_nss, findCmd, isExplain));
         params = ClusterClientCursorParams(_nss);
@@ -79,6 +81,7 @@ protected:
         if (lpq->getSkip()) {
             params.skip = lpq->getSkip();
         }
+        params.prefetchBufferBytes = prefetchBufferBytes;
 
         arm = stdx::make_unique<AsyncResultsMerger>(executor, params, remotes);
     }
@@ -111,6 +114,32 @@ protected:
         net->exitNetwork();
     }
 
+    /**
+     * Returns the command of the next request sent to a remote, and responds to it with
+     * 'response'.
+     */
+    BSONObj respondToNextRequest(const GetMoreResponse& response) {
+        executor::NetworkInterfaceMock* net = getNet();
+        net->enterNetwork();
+        ASSERT_TRUE(net->hasReadyRequests());
+        auto request = net->getNextReadyRequest();
+        BSONObj cmdObj = request->getRequest().cmdObj.getOwned();
+        RemoteCommandResponse commandResponse(response.toBSON(), BSONObj(), Milliseconds(0));
+        executor::TaskExecutor::ResponseStatus responseStatus(commandResponse);
+        net->scheduleResponse(request, net->now(), responseStatus);
+        net->runReadyNetworkOperations();
+        net->exitNetwork();
+        return cmdObj;
+    }
+
+    bool hasReadyRequests() {
+        executor::NetworkInterfaceMock* net = getNet();
+        net->enterNetwork();
+        bool hasReadyRequests = net->hasReadyRequests();
+        net->exitNetwork();
+        return hasReadyRequests;
+    }
+
     void scheduleErrorResponse(Status status) {
         invariant(!status.isOK());
         executor::NetworkInterfaceMock* net = getNet();
@@ -646,6 +675,122 @@ TEST_F(AsyncResultsMergerTest, KillCalledTwice) {
     executor->waitForEvent(killedEvent2);
 }
 
+
+TEST_F(AsyncResultsMergerTest, PrefetchesNextBatchBeforeBufferRunsOut) {
+    BSONObj findCmd = fromjson("{find: 'testcoll', batchSize: 2}");
+    makeCursorFromFindCmd(findCmd, {_remotes[0]}, 1024 * 1024);
+
+    ASSERT_FALSE(arm->ready());
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    ASSERT_EQ(findCmd, respondToNextRequest(GetMoreResponse(_nss, CursorId(123), batch1)));
+    executor->waitForEvent(readyEvent);
+
+    // The next batch is requested before any result of the first one has been returned, with the
+    // batch size of the query.
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}"), fromjson("{_id: 4}")};
+    BSONObj getMore = respondToNextRequest(GetMoreResponse(_nss, CursorId(0), batch2));
+    ASSERT_EQ(123, getMore["getMore"].numberLong());
+    ASSERT_EQ(2, getMore["batchSize"].numberLong());
+    ASSERT_FALSE(hasReadyRequests());
+
+    for (int i = 1; i <= 4; i++) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_EQ(BSON("_id" << i), *unittest::assertGet(arm->nextReady()));
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+}
+
+TEST_F(AsyncResultsMergerTest, PrefetchSizesBatchesToBuffer) {
+    BSONObj findCmd = fromjson("{find: 'testcoll'}");
+    const long long prefetchBufferBytes = 1000;
+    makeCursorFromFindCmd(findCmd, {_remotes[0]}, prefetchBufferBytes);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    respondToNextRequest(GetMoreResponse(_nss, CursorId(123), batch1));
+    executor->waitForEvent(readyEvent);
+
+    // The merge waited for the first batch, so the next one is twice the size of the buffer.
+    const long long docBytes = batch1[0].objsize();
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}")};
+    BSONObj getMore = respondToNextRequest(GetMoreResponse(_nss, CursorId(0), batch2));
+    ASSERT_EQ(2 * prefetchBufferBytes / docBytes, getMore["batchSize"].numberLong());
+
+    for (int i = 1; i <= 3; i++) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_EQ(BSON("_id" << i), *unittest::assertGet(arm->nextReady()));
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+}
+
+TEST_F(AsyncResultsMergerTest, NoPrefetchWhileBufferIsFull) {
+    BSONObj findCmd = fromjson("{find: 'testcoll', batchSize: 3}");
+    const std::vector<BSONObj> batch1 = {
+        fromjson("{_id: 1}"), fromjson("{_id: 2}"), fromjson("{_id: 3}")};
+    makeCursorFromFindCmd(findCmd, {_remotes[0]}, batch1[0].objsize() * 2);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    respondToNextRequest(GetMoreResponse(_nss, CursorId(123), batch1));
+    executor->waitForEvent(readyEvent);
+
+    // Three documents are buffered, which is more than the buffer holds.
+    ASSERT_FALSE(hasReadyRequests());
+    ASSERT_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_FALSE(hasReadyRequests());
+
+    // Once fewer than two documents are buffered, the next batch is requested.
+    ASSERT_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(hasReadyRequests());
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 4}")};
+    respondToNextRequest(GetMoreResponse(_nss, CursorId(0), batch2));
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->ready());
+    ASSERT_EQ(fromjson("{_id: 4}"), *unittest::assertGet(arm->nextReady()));
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+}
+
+TEST_F(AsyncResultsMergerTest, SortedMergeWithPrefetch) {
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {_id: 1}, batchSize: 2}");
+    makeCursorFromFindCmd(findCmd, {_remotes[0], _remotes[1]}, 1024 * 1024);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<GetMoreResponse> responses;
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 4}")};
+    responses.emplace_back(_nss, CursorId(123), batch1);
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 2}"), fromjson("{_id: 3}")};
+    responses.emplace_back(_nss, CursorId(0), batch2);
+    scheduleNetworkResponses(responses);
+    executor->waitForEvent(readyEvent);
+
+    // The first remote's next batch arrives while its first one is still buffered.
+    std::vector<BSONObj> batch3 = {fromjson("{_id: 5}"), fromjson("{_id: 6}")};
+    respondToNextRequest(GetMoreResponse(_nss, CursorId(0), batch3));
+
+    for (int i = 1; i <= 6; i++) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_EQ(BSON("_id" << i), *unittest::assertGet(arm->nextReady()));
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT(!unittest::assertGet(arm->nextReady()));
+
+    BSONArrayBuilder remoteStats;
+    arm->appendRemoteStats(&remoteStats);
+    const BSONObj stats = remoteStats.arr();
+    ASSERT_EQ(_remotes[0].toString(), stats["0"]["host"].str());
+    ASSERT_EQ(2, stats["0"]["batches"].numberLong());
+    ASSERT_EQ(4, stats["0"]["docs"].numberLong());
+    ASSERT_EQ(1, stats["0"]["prefetches"].numberLong());
+    ASSERT_EQ(1, stats["1"]["batches"].numberLong());
+    ASSERT_EQ(0, stats["1"]["prefetches"].numberLong());
+    ASSERT_GTE(stats["1"]["waitMicros"].numberLong(), 0);
+}
+
 }  // namespace
 
 }  // namespace mongo
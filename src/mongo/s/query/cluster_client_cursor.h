@@ -70,6 +70,12 @@ public:
      * May block waiting for responses from remote hosts.
      */
     virtual void kill() = 0;
+
+    /**
+     * Appends a document per remote host that results are merged from to 'builder', with the
+     * results received from it and how long the cursor waited for it.
+     */
+    virtual void appendRemoteStats(BSONArrayBuilder* builder) = 0;
 };
 
 }  // namespace mongo
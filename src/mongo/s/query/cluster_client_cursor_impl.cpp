@@ -51,6 +51,10 @@ void ClusterClientCursorImpl::kill() {
     _root->kill();
 }
 
+void ClusterClientCursorImpl::appendRemoteStats(BSONArrayBuilder* builder) {
+    _root->appendRemoteStats(builder);
+}
+
 std::unique_ptr<RouterExecStage> ClusterClientCursorImpl::buildMergerPlan(
     executor::TaskExecutor* executor,
     const ClusterClientCursorParams& params,
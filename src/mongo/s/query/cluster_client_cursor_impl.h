@@ -53,6 +53,8 @@ public:
 
     void kill() final;
 
+    void appendRemoteStats(BSONArrayBuilder* builder) final;
+
 private:
     /**
      * Constructs the pipeline of MergerPlanStages which will be used to answer the query.
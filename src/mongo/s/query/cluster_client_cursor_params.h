@@ -63,6 +63,11 @@ struct ClusterClientCursorParams {
     // Limits the number of results returned by the ClusterClientCursor to this many. Optional.
     // Should be forwarded to the remote hosts in 'cmdObj'.
     boost::optional<long long> limit;
+
+    // The next batch of a remote is requested before its results run out, while fewer than this
+    // many bytes of them are buffered. Also sizes the batches requested when 'batchSize' is not
+    // specified. Zero turns reading ahead off.
+    long long prefetchBufferBytes = 0;
 };
 
 }  // mongo
@@ -32,25 +32,52 @@
 
 #include "mongo/s/query/cluster_find.h"
 
+#include <list>
 #include <set>
 #include <vector>
 
 #include "mongo/base/status_with.h"
 #include "mongo/client/read_preference.h"
 #include "mongo/client/remote_command_targeter.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/catalog/catalog_cache.h"
 #include "mongo/s/chunk_manager.h"
 #include "mongo/s/client/shard_registry.h"
 #include "mongo/s/config.h"
 #include "mongo/s/grid.h"
 #include "mongo/s/query/cluster_client_cursor_impl.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
+namespace {
+
+// Bytes of each shard's results buffered ahead of the merge. Zero turns reading ahead off.
+MONGO_EXPORT_SERVER_PARAMETER(internalQueryMongosPrefetchBufferBytes, int, 1024 * 1024);
+
+/**
+ * A query whose results are being merged, as reported by currentOp.
+ */
+struct ActiveQuery {
+    std::string ns;
+    BSONObj cmdObj;
+    long long startMicros;
+    ClusterClientCursor* cursor;
+};
+
+// Guards 'activeQueries'. A query is removed from the list before its cursor is destroyed.
+stdx::mutex activeQueriesMutex;
+std::list<ActiveQuery> activeQueries;
+
+}  // namespace
+
 StatusWith<CursorId> ClusterFind::runQuery(OperationContext* txn,
                                            const CanonicalQuery& query,
                                            const ReadPreferenceSetting& readPref,
-                                           std::vector<BSONObj>* results) {
+                                           std::vector<BSONObj>* results,
+                                           BSONArrayBuilder* remoteStats) {
     invariant(results);
 
     auto dbConfig = grid.catalogCache()->getDatabase(query.nss().db().toString());
@@ -94,9 +121,23 @@ StatusWith<CursorId> ClusterFind::runQuery(OperationContext* txn,
     params.cmdObj = query.getParsed().asFindCommand();
     params.sort = query.getParsed().getSort();
     params.limit = query.getParsed().getLimit();
+    params.batchSize = query.getParsed().getBatchSize();
+    params.prefetchBufferBytes = internalQueryMongosPrefetchBufferBytes;
 
     ClusterClientCursorImpl ccc(shardRegistry->getExecutor(), params, remotes);
 
+    std::list<ActiveQuery>::iterator activeQuery;
+    {
+        stdx::lock_guard<stdx::mutex> lk(activeQueriesMutex);
+        activeQuery = activeQueries.insert(
+            activeQueries.end(),
+            {query.nss().ns(), params.cmdObj, static_cast<long long>(curTimeMicros64()), &ccc});
+    }
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<stdx::mutex> lk(activeQueriesMutex);
+        activeQueries.erase(activeQuery);
+    });
+
     // TODO: this should implement the batching logic rather than fully exhausting the cursor. It
     // should allocate a cursor id and save the ClusterClientCursor rather than always returning a
     // cursor id of 0.
@@ -112,7 +153,28 @@ StatusWith<CursorId> ClusterFind::runQuery(OperationContext* txn,
         return nextObj.getStatus();
     }
 
+    if (remoteStats) {
+        ccc.appendRemoteStats(remoteStats);
+    }
+
     return CursorId(0);
 }
 
+void ClusterFind::appendActiveQueries(BSONArrayBuilder* ops) {
+    const long long nowMicros = curTimeMicros64();
+
+    stdx::lock_guard<stdx::mutex> lk(activeQueriesMutex);
+    for (const auto& activeQuery : activeQueries) {
+        BSONObjBuilder opBuilder(ops->subobjStart());
+        opBuilder.appendBool("active", true);
+        opBuilder.append("microsecs_running", nowMicros - activeQuery.startMicros);
+        opBuilder.append("op", "query");
+        opBuilder.append("ns", activeQuery.ns);
+        opBuilder.append("query", activeQuery.cmdObj);
+
+        BSONArrayBuilder remoteStats(opBuilder.subarrayStart("remoteStats"));
+        activeQuery.cursor->appendRemoteStats(&remoteStats);
+    }
+}
+
 }  // namespace mongo
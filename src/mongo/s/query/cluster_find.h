@@ -37,6 +37,7 @@ namespace mongo {
 
 template <typename T>
 class StatusWith;
+class BSONArrayBuilder;
 class CanonicalQuery;
 class OperationContext;
 struct ReadPreferenceSetting;
@@ -52,11 +53,21 @@ public:
      * On success, fills out 'results' with the first batch of query results and returns the cursor
      * id which the caller can use on subsequent getMore operations. If no cursor needed to be saved
      * (e.g. the cursor was exhausted without need for a getMore), returns a cursor id of 0.
+     *
+     * If 'remoteStats' is not null, appends a document per remote host to it with the results
+     * received from the host and how long the merge waited for it.
      */
     static StatusWith<CursorId> runQuery(OperationContext* txn,
                                          const CanonicalQuery& query,
                                          const ReadPreferenceSetting& readPref,
-                                         std::vector<BSONObj>* results);
+                                         std::vector<BSONObj>* results,
+                                         BSONArrayBuilder* remoteStats = nullptr);
+
+    /**
+     * Appends a currentOp entry to 'ops' for each query whose results are being merged, with the
+     * same statistics of its remote hosts so far.
+     */
+    static void appendActiveQueries(BSONArrayBuilder* ops);
 };
 
 }  // namespace mongo
@@ -36,6 +36,8 @@
 
 namespace mongo {
 
+class BSONArrayBuilder;
+
 /**
  * This is the lightweight mongoS analogue of the PlanStage abstraction used to execute queries on
  * mongoD (see mongo/db/plan_stage.h).
@@ -66,6 +68,16 @@ public:
      */
     virtual void kill() = 0;
 
+    /**
+     * Appends statistics about each remote host that results are merged from to 'builder'. Stages
+     * other than the merging stage append those of their child, if they have one.
+     */
+    virtual void appendRemoteStats(BSONArrayBuilder* builder) {
+        if (_child) {
+            _child->appendRemoteStats(builder);
+        }
+    }
+
 protected:
     /**
      * Returns an unowned pointer to the child stage, or nullptr if there is no child.
@@ -68,4 +68,8 @@ void RouterStageMerge::kill() {
     _executor->waitForEvent(killEvent);
 }
 
+void RouterStageMerge::appendRemoteStats(BSONArrayBuilder* builder) {
+    _arm.appendRemoteStats(builder);
+}
+
 }  // namespace mongo
@@ -53,6 +53,8 @@ public:
 
     void kill() final;
 
+    void appendRemoteStats(BSONArrayBuilder* builder) final;
+
 private:
     // Not owned here.
     executor::TaskExecutor* _executor;
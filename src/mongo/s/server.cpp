@@ -32,6 +32,7 @@
 
 #include "mongo/s/server.h"
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/base/init.h"
 #include "mongo/base/initializer.h"
 #include "mongo/base/status.h"
@@ -118,6 +119,17 @@ static BSONObj buildErrReply(const DBException& ex) {
     return errB.obj();
 }
 
+/**
+ * Holds a connection's Client while it is detached from any thread between messages.
+ */
+class ClientSessionState : public MessageHandler::SessionState {
+public:
+    explicit ClientSessionState(ServiceContext::UniqueClient client)
+        : client(std::move(client)) {}
+
+    ServiceContext::UniqueClient client;
+};
+
 class ShardedMessageHandler : public MessageHandler {
 public:
     virtual ~ShardedMessageHandler() {}
@@ -163,6 +175,17 @@ public:
         // Release connections back to pool, if any still cached
         ShardConnection::releaseMyConnections();
     }
+
+    virtual std::unique_ptr<SessionState> detachSession(AbstractMessagingPort* p) {
+        if (!haveClient()) {
+            return {};
+        }
+        return stdx::make_unique<ClientSessionState>(Client::releaseCurrent());
+    }
+
+    virtual void attachSession(AbstractMessagingPort* p, std::unique_ptr<SessionState> state) {
+        Client::setCurrent(std::move(checked_cast<ClientSessionState*>(state.get())->client));
+    }
 };
 
 void start(const MessageServer::Options& opts) {
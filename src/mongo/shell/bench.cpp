@@ -34,13 +34,17 @@
 
 #include "mongo/shell/bench.h"
 
+#include <algorithm>
+#include <cmath>
 #include <pcrecpp.h>
 #include <iostream>
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/platform/bits.h"
 #include "mongo/scripting/bson_template_evaluator.h"
 #include "mongo/scripting/engine.h"
+#include "mongo/stdx/chrono.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/log.h"
 #include "mongo/util/md5.h"
@@ -77,6 +81,125 @@ using std::cout;
 using std::endl;
 using std::map;
 
+namespace {
+
+/**
+ * The event counters of BenchRunStats, by the name of the operation type they count.
+ */
+const struct {
+    const char* name;
+    BenchRunEventCounter BenchRunStats::*counter;
+} kOpCounters[] = {{"findOne", &BenchRunStats::findOneCounter},
+                   {"insert", &BenchRunStats::insertCounter},
+                   {"delete", &BenchRunStats::deleteCounter},
+                   {"update", &BenchRunStats::updateCounter},
+                   {"query", &BenchRunStats::queryCounter},
+                   {"command", &BenchRunStats::commandCounter}};
+
+const size_t kNumOpCounters = sizeof(kOpCounters) / sizeof(kOpCounters[0]);
+
+}  // namespace
+
+void BenchRunLatencyHistogram::record(long long micros) {
+    micros = std::max(micros, 0LL);
+    // Only one thread records, so the maximum cannot change between the load and the store.
+    if (micros > _maxMicros.loadRelaxed())
+        _maxMicros.store(micros);
+    // The interval maximum is raised before the event is counted, so that an interval never
+    // reports a maximum below one of its events. takeIntervalMaxMicros() may clear it in
+    // between, in which case the event also raises the maximum of the next interval.
+    if (micros > _intervalMaxMicros.loadRelaxed())
+        _intervalMaxMicros.store(micros);
+    _counts[getBucket(micros)].fetchAndAdd(1);
+}
+
+void BenchRunLatencyHistogram::reset() {
+    for (int i = 0; i < kNumBuckets; ++i)
+        _counts[i].store(0);
+    _maxMicros.store(0);
+    _intervalMaxMicros.store(0);
+}
+
+void BenchRunLatencyHistogram::updateFrom(const BenchRunLatencyHistogram& other) {
+    for (int i = 0; i < kNumBuckets; ++i) {
+        const unsigned long long count = other._counts[i].loadRelaxed();
+        if (count)
+            _counts[i].fetchAndAdd(count);
+    }
+    const long long otherMax = other._maxMicros.loadRelaxed();
+    if (otherMax > _maxMicros.loadRelaxed())
+        _maxMicros.store(otherMax);
+}
+
+void BenchRunLatencyHistogram::subtract(const BenchRunLatencyHistogram& other,
+                                        long long maxMicros) {
+    for (int i = 0; i < kNumBuckets; ++i) {
+        const unsigned long long count = other._counts[i].loadRelaxed();
+        if (count)
+            _counts[i].fetchAndSubtract(count);
+    }
+    _maxMicros.store(maxMicros);
+}
+
+long long BenchRunLatencyHistogram::takeIntervalMaxMicros() const {
+    return _intervalMaxMicros.swap(0);
+}
+
+unsigned long long BenchRunLatencyHistogram::getCount() const {
+    unsigned long long count = 0;
+    for (int i = 0; i < kNumBuckets; ++i)
+        count += _counts[i].loadRelaxed();
+    return count;
+}
+
+long long BenchRunLatencyHistogram::getPercentileMicros(double percentile) const {
+    const unsigned long long count = getCount();
+    if (count == 0)
+        return 0;
+
+    unsigned long long rank = static_cast<unsigned long long>(std::ceil(percentile / 100 * count));
+    rank = std::min(std::max(rank, 1ULL), count);
+
+    const long long maxMicros = _maxMicros.loadRelaxed();
+    unsigned long long seen = 0;
+    for (int i = 0; i < kNumBuckets; ++i) {
+        seen += _counts[i].loadRelaxed();
+        if (seen >= rank)
+            return std::min(getBucketLowerBound(i + 1) - 1, maxMicros);
+    }
+    return maxMicros;
+}
+
+void BenchRunLatencyHistogram::appendPercentiles(BSONObjBuilder* builder) const {
+    builder->append("count", static_cast<long long>(getCount()));
+    builder->append("p50", getPercentileMicros(50));
+    builder->append("p95", getPercentileMicros(95));
+    builder->append("p99", getPercentileMicros(99));
+    builder->append("p999", getPercentileMicros(99.9));
+    builder->append("max", getPercentileMicros(100));
+}
+
+int BenchRunLatencyHistogram::getBucket(long long micros) {
+    micros = std::min(std::max(micros, 0LL), (1LL << kMaxMicrosBits) - 1);
+    if (micros < 2 * kSubBucketCount)
+        return static_cast<int>(micros);
+
+    // Values whose highest bit is "msb" are counted in kSubBucketCount buckets, of width
+    // 2^shift.
+    const int msb = 63 - countLeadingZeros64(micros);
+    const int shift = msb - kSubBucketBits;
+    return shift * kSubBucketCount + static_cast<int>(micros >> shift);
+}
+
+long long BenchRunLatencyHistogram::getBucketLowerBound(int bucket) {
+    if (bucket < 2 * kSubBucketCount)
+        return bucket;
+
+    const int shift = bucket / kSubBucketCount - 1;
+    const long long subBucket = bucket - shift * kSubBucketCount;
+    return subBucket << shift;
+}
+
 BenchRunEventCounter::BenchRunEventCounter() {
     reset();
 }
@@ -86,11 +209,13 @@ BenchRunEventCounter::~BenchRunEventCounter() {}
 void BenchRunEventCounter::reset() {
     _numEvents = 0;
     _totalTimeMicros = 0;
+    _latency.reset();
 }
 
 void BenchRunEventCounter::updateFrom(const BenchRunEventCounter& other) {
     _numEvents += other._numEvents;
     _totalTimeMicros += other._totalTimeMicros;
+    _latency.updateFrom(other._latency);
 }
 
 BenchRunStats::BenchRunStats() {
@@ -156,6 +281,9 @@ void BenchRunConfig::initializeToDefaults() {
     throwGLE = false;
     breakOnTrap = true;
     randomSeed = 1314159265358979323;
+
+    opsPerSecond = 0;
+    reportIntervalSeconds = 0;
 }
 
 BenchRunConfig* BenchRunConfig::createFromBson(const BSONObj& args) {
@@ -193,7 +321,16 @@ void BenchRunConfig::initializeFromBson(const BSONObj& args) {
     if (!args["breakOnTrap"].eoo())
         this->breakOnTrap = args["breakOnTrap"].trueValue();
 
+    if (args["opsPerSecond"].isNumber())
+        this->opsPerSecond = args["opsPerSecond"].number();
+    if (args["reportIntervalSeconds"].isNumber())
+        this->reportIntervalSeconds = args["reportIntervalSeconds"].number();
+
     uassert(16164, "loopCommands config not supported", args["loopCommands"].eoo());
+    uassert(28767, "opsPerSecond must not be negative", this->opsPerSecond >= 0);
+    uassert(28768,
+            "reportIntervalSeconds must not be negative",
+            this->reportIntervalSeconds >= 0);
 
     if (!args["trapPattern"].eoo()) {
         const char* regex = args["trapPattern"].regex();
@@ -373,11 +510,31 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
         }
     }
 
+    // With a target rate, each worker starts its operations at fixed intervals of this many
+    // microseconds from when it started, measured by "timer".
+    const double scheduleIntervalMicros =
+        _config->opsPerSecond > 0 ? _config->parallel * 1000000.0 / _config->opsPerSecond : 0;
+    double nextScheduledMicros = 0;
+
     while (!shouldStop()) {
         BSONObjIterator i(_config->ops);
         while (i.more()) {
             if (shouldStop())
                 break;
+
+            // How long after its scheduled start time this operation starts.  It is counted in
+            // the latency of the operation, so that latencies reflect what a client issuing
+            // requests at the target rate would observe, even when the server stalls.
+            long long opLagMicros = 0;
+            if (scheduleIntervalMicros > 0) {
+                const long long scheduledMicros = static_cast<long long>(nextScheduledMicros);
+                const long long waitMicros = scheduledMicros - timer.micros();
+                if (waitMicros > 0)
+                    sleepmicros(waitMicros);
+                opLagMicros = std::max(0LL, timer.micros() - scheduledMicros);
+                nextScheduledMicros += scheduleIntervalMicros;
+            }
+
             auto& stats = shouldCollectStats() ? _stats : _statsBlackHole;
             BSONElement e = i.next();
 
@@ -423,7 +580,7 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
                 } else if (op == "findOne") {
                     BSONObj result;
                     {
-                        BenchRunEventTrace _bret(&stats.findOneCounter);
+                        BenchRunEventTrace _bret(&stats.findOneCounter, opLagMicros);
                         result =
                             conn->findOne(ns, fixQuery(e["query"].Obj(), bsonTemplateEvaluator));
                     }
@@ -447,7 +604,7 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
                     bool ok;
                     BSONObj result;
                     {
-                        BenchRunEventTrace _bret(&stats.commandCounter);
+                        BenchRunEventTrace _bret(&stats.commandCounter, opLagMicros);
                         ok = conn->runCommand(ns,
                                               fixQuery(e["command"].Obj(), bsonTemplateEvaluator),
                                               result,
@@ -485,11 +642,11 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
 
                     // use special query function for exhaust query option
                     if (options & QueryOption_Exhaust) {
-                        BenchRunEventTrace _bret(&stats.queryCounter);
+                        BenchRunEventTrace _bret(&stats.queryCounter, opLagMicros);
                         stdx::function<void(const BSONObj&)> castedDoNothing(doNothing);
                         count = conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                     } else {
-                        BenchRunEventTrace _bret(&stats.queryCounter);
+                        BenchRunEventTrace _bret(&stats.queryCounter, opLagMicros);
                         cursor =
                             conn->query(ns, fixedQuery, limit, skip, &filter, options, batchSize);
                         count = cursor->itcount();
@@ -526,7 +683,7 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
                     bool safe = e["safe"].trueValue();
 
                     {
-                        BenchRunEventTrace _bret(&stats.updateCounter);
+                        BenchRunEventTrace _bret(&stats.updateCounter, opLagMicros);
                         BSONObj query = fixQuery(queryOrginal, bsonTemplateEvaluator);
                         BSONObj update = fixQuery(updateOriginal, bsonTemplateEvaluator);
 
@@ -575,7 +732,7 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
                     BSONObj result;
 
                     {
-                        BenchRunEventTrace _bret(&stats.insertCounter);
+                        BenchRunEventTrace _bret(&stats.insertCounter, opLagMicros);
 
                         BSONObj insertDoc;
                         if (useWriteCmd) {
@@ -641,7 +798,7 @@ void BenchRunWorker::generateLoadOnConnection(DBClientBase* conn) {
                     bool safe = e["safe"].trueValue();
                     BSONObj result;
                     {
-                        BenchRunEventTrace _bret(&stats.deleteCounter);
+                        BenchRunEventTrace _bret(&stats.deleteCounter, opLagMicros);
                         BSONObj predicate = fixQuery(query, bsonTemplateEvaluator);
                         if (useWriteCmd) {
                             // TODO: Replace after SERVER-11774.
@@ -836,10 +993,22 @@ void BenchRunner::start() {
         // initial stats
         _brState.tellWorkersToCollectStats();
         _brTimer = new mongo::Timer();
+
+        if (_config->reportIntervalSeconds > 0)
+            _reporter = stdx::thread(stdx::bind(&BenchRunner::reportIntervals, this));
     }
 }
 
 void BenchRunner::stop() {
+    if (_reporter.joinable()) {
+        {
+            stdx::lock_guard<stdx::mutex> lk(_reporterMutex);
+            _stopReporting = true;
+        }
+        _reporterCondition.notify_all();
+        _reporter.join();
+    }
+
     _brState.tellWorkersToFinish();
     _brState.waitForState(BenchRunState::BRS_FINISHED);
     _microsElapsed = _brTimer->micros();
@@ -883,6 +1052,64 @@ void BenchRunner::populateStats(BenchRunStats* stats) {
         stats->updateFrom(_workers[i]->stats());
 }
 
+void BenchRunner::reportIntervals() {
+    const auto interval = stdx::chrono::microseconds(
+        static_cast<long long>(_config->reportIntervalSeconds * 1000000));
+
+    // The latencies recorded by all workers up to the end of the previous interval.
+    std::unique_ptr<BenchRunLatencyHistogram[]> previous(
+        new BenchRunLatencyHistogram[kNumOpCounters]);
+    BenchRunLatencyHistogram current;
+    Timer timer;
+    long long previousMicros = 0;
+    auto deadline = stdx::chrono::steady_clock::now();
+
+    stdx::unique_lock<stdx::mutex> lk(_reporterMutex);
+    while (true) {
+        deadline += interval;
+        if (_reporterCondition.wait_until(lk, deadline, [this] { return _stopReporting; }))
+            return;
+
+        // The workers keep counting events while their histograms are read, so an event may
+        // be reported in the interval after the one in which it completed.
+        const long long nowMicros = timer.micros();
+        const double intervalSeconds = (nowMicros - previousMicros) / 1000000.0;
+        previousMicros = nowMicros;
+
+        BSONObjBuilder buf;
+        buf.append("seconds", nowMicros / 1000000.0);
+        unsigned long long totalOps = 0;
+        for (size_t i = 0; i < kNumOpCounters; ++i) {
+            current.reset();
+            long long intervalMaxMicros = 0;
+            for (size_t w = 0; w < _workers.size(); ++w) {
+                const BenchRunLatencyHistogram& latency =
+                    (_workers[w]->stats().*kOpCounters[i].counter).getLatency();
+                // Read after the counts, so that it covers every event they include.
+                current.updateFrom(latency);
+                intervalMaxMicros = std::max(intervalMaxMicros, latency.takeIntervalMaxMicros());
+            }
+            current.subtract(previous[i], intervalMaxMicros);
+            previous[i].updateFrom(current);
+
+            const unsigned long long count = current.getCount();
+            totalOps += count;
+            if (count == 0)
+                continue;
+
+            BSONObjBuilder opBuilder(buf.subobjStart(kOpCounters[i].name));
+            opBuilder.append("ops/s", count / intervalSeconds);
+            current.appendPercentiles(&opBuilder);
+            opBuilder.doneFast();
+        }
+        buf.append("totalOps/s", totalOps / intervalSeconds);
+
+        BSONObj intervalObj = buf.obj();
+        log() << "benchRun interval: " << intervalObj;
+        _intervals.push_back(intervalObj);
+    }
+}
+
 static void appendAverageMicrosIfAvailable(BSONObjBuilder& buf,
                                            const std::string& name,
                                            const BenchRunEventCounter& counter) {
@@ -914,6 +1141,17 @@ BSONObj BenchRunner::finish(BenchRunner* runner) {
     appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
     appendAverageMicrosIfAvailable(buf, "commandsLatencyAverageMicros", stats.commandCounter);
 
+    {
+        BSONObjBuilder percentilesBuilder(buf.subobjStart("latencyPercentilesMicros"));
+        for (size_t i = 0; i < kNumOpCounters; ++i) {
+            const BenchRunLatencyHistogram& latency = (stats.*kOpCounters[i].counter).getLatency();
+            if (latency.getCount() == 0)
+                continue;
+            BSONObjBuilder opBuilder(percentilesBuilder.subobjStart(kOpCounters[i].name));
+            latency.appendPercentiles(&opBuilder);
+        }
+    }
+
     buf.append("totalOps", static_cast<long long>(stats.opCount));
 
     auto appendPerSec = [&buf, runner](StringData name, double total) {
@@ -928,6 +1166,9 @@ BSONObj BenchRunner::finish(BenchRunner* runner) {
     appendPerSec("query", stats.queryCounter.getNumEvents());
     appendPerSec("command", stats.commandCounter.getNumEvents());
 
+    if (!runner->getIntervals().empty())
+        buf.append("intervals", runner->getIntervals());
+
     BSONObj zoo = buf.obj();
 
     delete runner;
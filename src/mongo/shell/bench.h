@@ -35,6 +35,7 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/timer.h"
 
 namespace pcrecpp {
@@ -127,15 +128,125 @@ public:
     bool throwGLE;
     bool breakOnTrap;
 
+    /**
+     * Target rate of operations per second, summed over all threads.  Zero means to run the
+     * operations as fast as possible.
+     *
+     * When set, every thread starts its operations on a fixed schedule, and the latency of an
+     * operation is measured from the time it was scheduled to start rather than from the time
+     * it actually started.  This keeps a slow operation from hiding the latency of the
+     * operations that queued up behind it ("coordinated omission").
+     */
+    double opsPerSecond;
+
+    /**
+     * If positive, the throughput and latency percentiles of each interval of this many seconds
+     * are logged while the activity runs, and returned with the final results.
+     */
+    double reportIntervalSeconds;
+
 private:
     /// Initialize a config object to its default values.
     void initializeToDefaults();
 };
 
+/**
+ * A histogram of event latencies in microseconds, with log-linear buckets in the style of
+ * HdrHistogram.
+ *
+ * Latencies below 2 * kSubBucketCount microseconds are recorded exactly.  Each larger power of
+ * two range is split into kSubBucketCount linear buckets, so that the value reported for a
+ * bucket is within 1 / kSubBucketCount (about 3%) of every latency recorded in it.
+ *
+ * Only one thread may record into a histogram, but the counts may be read by other threads
+ * while it is recording, without locking.
+ */
+class BenchRunLatencyHistogram {
+    MONGO_DISALLOW_COPYING(BenchRunLatencyHistogram);
+
+public:
+    static const int kSubBucketBits = 5;
+    static const int kSubBucketCount = 1 << kSubBucketBits;
+
+    /**
+     * Latencies of 2^kMaxMicrosBits microseconds (about 38 hours) or more are counted as
+     * 2^kMaxMicrosBits - 1.
+     */
+    static const int kMaxMicrosBits = 37;
+    static const int kNumBuckets = (kMaxMicrosBits - kSubBucketBits + 1) * kSubBucketCount;
+
+    BenchRunLatencyHistogram() = default;
+
+    /**
+     * Counts one event which took "micros" microseconds.
+     */
+    void record(long long micros);
+
+    /**
+     * Zero out the histogram.  Must not be called concurrently with record().
+     */
+    void reset();
+
+    /**
+     * Adds the counts of "other" into this.
+     */
+    void updateFrom(const BenchRunLatencyHistogram& other);
+
+    /**
+     * Subtracts the counts of "other", an earlier copy of this histogram, from this, leaving
+     * the events recorded since.  The maximum latency becomes "maxMicros", which should be the
+     * largest of those events, as returned by takeIntervalMaxMicros().
+     */
+    void subtract(const BenchRunLatencyHistogram& other, long long maxMicros);
+
+    /**
+     * Returns the largest latency recorded since the previous call, or since the histogram was
+     * reset, and starts over.  Meant for the one thread that reports intervals, which may call
+     * it while another thread records; an event being recorded may then count towards either
+     * call.
+     */
+    long long takeIntervalMaxMicros() const;
+
+    /**
+     * Get the number of recorded events.
+     */
+    unsigned long long getCount() const;
+
+    /**
+     * Get the latency, in microseconds, at or below which "percentile" percent of the recorded
+     * events fall.  The result is the largest latency that maps to the same bucket as the
+     * event at that rank, capped at the largest recorded latency.  Returns 0 if the histogram
+     * is empty.
+     */
+    long long getPercentileMicros(double percentile) const;
+
+    /**
+     * Appends {count, p50, p95, p99, p999, max} to "builder", in microseconds.
+     */
+    void appendPercentiles(BSONObjBuilder* builder) const;
+
+    /**
+     * Returns the bucket that counts latencies of "micros" microseconds.
+     */
+    static int getBucket(long long micros);
+
+    /**
+     * Returns the smallest latency, in microseconds, counted by "bucket".
+     */
+    static long long getBucketLowerBound(int bucket);
+
+private:
+    AtomicUInt64 _counts[kNumBuckets];
+    AtomicInt64 _maxMicros;
+    // Cleared by the reporting thread, which otherwise only reads the histogram.
+    mutable AtomicInt64 _intervalMaxMicros;
+};
+
 /**
  * An event counter for events that have an associated duration.
  *
- * Not thread safe.  Expected use is one instance per thread during parallel execution.
+ * Not thread safe.  Expected use is one instance per thread during parallel execution.  The
+ * latency histogram alone may be read while the owning thread counts events.
  */
 class BenchRunEventCounter {
     MONGO_DISALLOW_COPYING(BenchRunEventCounter);
@@ -161,6 +272,7 @@ public:
     void countOne(long long timeMicros) {
         ++_numEvents;
         _totalTimeMicros += timeMicros;
+        _latency.record(timeMicros);
     }
 
     /**
@@ -177,9 +289,17 @@ public:
         return _numEvents;
     }
 
+    /**
+     * Get the distribution of the durations of the observed events.
+     */
+    const BenchRunLatencyHistogram& getLatency() const {
+        return _latency;
+    }
+
 private:
     unsigned long long _numEvents;
     long long _totalTimeMicros;
+    BenchRunLatencyHistogram _latency;
 };
 
 /**
@@ -203,6 +323,15 @@ public:
         initialize(eventCounter, eventCounter, false);
     }
 
+    /**
+     * Traces an event which was scheduled to start "startLagMicros" microseconds before now.
+     * The lag is counted as part of the duration of the event.
+     */
+    BenchRunEventTrace(BenchRunEventCounter* eventCounter, long long startLagMicros) {
+        initialize(eventCounter, eventCounter, false);
+        _startLagMicros = startLagMicros;
+    }
+
     BenchRunEventTrace(BenchRunEventCounter* successCounter,
                        BenchRunEventCounter* failCounter,
                        bool defaultToFailure = true) {
@@ -210,7 +339,7 @@ public:
     }
 
     ~BenchRunEventTrace() {
-        (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+        (_succeeded ? _successCounter : _failCounter)->countOne(_startLagMicros + _timer.micros());
     }
 
     void succeed() {
@@ -227,9 +356,11 @@ private:
         _successCounter = successCounter;
         _failCounter = failCounter;
         _succeeded = !defaultToFailure;
+        _startLagMicros = 0;
     }
 
     Timer _timer;
+    long long _startLagMicros;
     BenchRunEventCounter* _successCounter;
     BenchRunEventCounter* _failCounter;
     bool _succeeded;
@@ -454,6 +585,16 @@ public:
      */
     void populateStats(BenchRunStats* stats);
 
+    /**
+     * Get the throughput and latency percentiles of each reporting interval of a completed
+     * bench run activity.  Empty unless the configuration sets reportIntervalSeconds.
+     *
+     * Illegal to call until after stop() returns.
+     */
+    const std::vector<BSONObj>& getIntervals() const {
+        return _intervals;
+    }
+
     OID oid() const {
         return _oid;
     }
@@ -468,6 +609,9 @@ public:
     static BSONObj benchRunSync(const BSONObj& argsFake, void* data);
 
 private:
+    /// Main method of the thread that reports the statistics of each interval.
+    void reportIntervals();
+
     // TODO: Same as for createWithConfig.
     static stdx::mutex _staticMutex;
     static std::map<OID, BenchRunner*> _activeRuns;
@@ -478,6 +622,13 @@ private:
     unsigned long long _microsElapsed;
     std::unique_ptr<BenchRunConfig> _config;
     std::vector<BenchRunWorker*> _workers;
+
+    // Interval reporting, only used when _config->reportIntervalSeconds is positive.
+    stdx::thread _reporter;
+    stdx::mutex _reporterMutex;
+    stdx::condition_variable _reporterCondition;
+    bool _stopReporting = false;
+    std::vector<BSONObj> _intervals;
 };
 
 }  // namespace mongo
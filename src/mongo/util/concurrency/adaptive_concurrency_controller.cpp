@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/adaptive_concurrency_controller.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+AdaptiveConcurrencyController::AdaptiveConcurrencyController(Options options, int initialTickets)
+    : _options(std::move(options)), _targetTickets(_clampTarget_inlock(initialTickets)) {}
+
+void AdaptiveConcurrencyController::recordLatency(Microseconds latency) {
+    _windowSamples.fetchAndAdd(1);
+    _windowTotalMicros.fetchAndAdd(durationCount<Microseconds>(latency));
+}
+
+int AdaptiveConcurrencyController::endWindow(bool saturated) {
+    const long long samples = _windowSamples.swap(0);
+    const long long totalMicros = _windowTotalMicros.swap(0);
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (samples < _options.minSamplesPerWindow) {
+        return _targetTickets;
+    }
+
+    const long long averageMicros = totalMicros / samples;
+    _lastWindowLatencyMicros = averageMicros;
+
+    if (_baselineLatencyMicros == 0 || averageMicros < _baselineLatencyMicros) {
+        _baselineLatencyMicros = averageMicros;
+    } else {
+        _baselineLatencyMicros += static_cast<long long>(
+            (averageMicros - _baselineLatencyMicros) * _options.baselineDrift);
+    }
+
+    if (averageMicros > _baselineLatencyMicros * _options.latencyTolerance) {
+        int decreased = _clampTarget_inlock(_targetTickets * _options.decreaseFactor);
+        if (decreased < _targetTickets) {
+            _targetTickets = decreased;
+            _decreases++;
+        }
+    } else if (saturated) {
+        int increased = _clampTarget_inlock(_targetTickets + _options.increment);
+        if (increased > _targetTickets) {
+            _targetTickets = increased;
+            _increases++;
+        }
+    }
+
+    return _targetTickets;
+}
+
+void AdaptiveConcurrencyController::setTargetTickets(int tickets) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _targetTickets = _clampTarget_inlock(tickets);
+}
+
+void AdaptiveConcurrencyController::setOptions(Options options) {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _options = std::move(options);
+    _targetTickets = _clampTarget_inlock(_targetTickets);
+}
+
+AdaptiveConcurrencyController::Stats AdaptiveConcurrencyController::getStats() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    Stats stats;
+    stats.targetTickets = _targetTickets;
+    stats.baselineLatencyMicros = _baselineLatencyMicros;
+    stats.lastWindowLatencyMicros = _lastWindowLatencyMicros;
+    stats.increases = _increases;
+    stats.decreases = _decreases;
+    return stats;
+}
+
+int AdaptiveConcurrencyController::_clampTarget_inlock(int tickets) const {
+    return std::max(_options.minTickets, std::min(_options.maxTickets, tickets));
+}
+
+}  // namespace mongo
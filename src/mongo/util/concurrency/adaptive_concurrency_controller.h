@@ -0,0 +1,118 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+/**
+ * Computes the number of tickets a pool should hand out from the time its tickets are held,
+ * using additive-increase/multiplicative-decrease.
+ *
+ * Latencies are accumulated over a sampling window, which the owner ends by calling endWindow().
+ * The controller tracks a baseline latency, which follows the lowest window average immediately
+ * and drifts slowly towards higher ones. If a window's average latency exceeds the baseline by
+ * more than Options::latencyTolerance, admission is assumed to be causing queueing inside the
+ * storage engine and the target is cut by Options::decreaseFactor. Otherwise, if callers had to
+ * wait for tickets during the window, the target grows by Options::increment.
+ */
+class AdaptiveConcurrencyController {
+    MONGO_DISALLOW_COPYING(AdaptiveConcurrencyController);
+
+public:
+    struct Options {
+        int minTickets = 8;
+        int maxTickets = 512;
+
+        // Multiple of the baseline latency above which the target is decreased.
+        double latencyTolerance = 2.0;
+
+        // Factor by which the target is multiplied on a decrease.
+        double decreaseFactor = 0.75;
+
+        // Number of tickets added on an increase.
+        int increment = 4;
+
+        // Windows with fewer latency samples than this leave the target unchanged.
+        int minSamplesPerWindow = 16;
+
+        // Fraction of the distance to a higher window average which the baseline moves by.
+        double baselineDrift = 0.01;
+    };
+
+    struct Stats {
+        int targetTickets;
+        long long baselineLatencyMicros;
+        long long lastWindowLatencyMicros;
+        long long increases;
+        long long decreases;
+    };
+
+    AdaptiveConcurrencyController(Options options, int initialTickets);
+
+    /**
+     * Records that a ticket was held for "latency". May be called concurrently from any thread.
+     */
+    void recordLatency(Microseconds latency);
+
+    /**
+     * Ends the current sampling window and returns the new target number of tickets. "saturated"
+     * indicates whether any caller had to wait for a ticket during the window.
+     */
+    int endWindow(bool saturated);
+
+    /**
+     * Overrides the current target, for example when the pool is resized by hand.
+     */
+    void setTargetTickets(int tickets);
+
+    void setOptions(Options options);
+
+    Stats getStats() const;
+
+private:
+    int _clampTarget_inlock(int tickets) const;
+
+    AtomicInt64 _windowSamples;
+    AtomicInt64 _windowTotalMicros;
+
+    mutable stdx::mutex _mutex;
+    Options _options;
+    int _targetTickets;
+    long long _baselineLatencyMicros = 0;
+    long long _lastWindowLatencyMicros = 0;
+    long long _increases = 0;
+    long long _decreases = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/adaptive_concurrency_controller.h"
+
+namespace {
+using namespace mongo;
+
+AdaptiveConcurrencyController::Options makeOptions() {
+    AdaptiveConcurrencyController::Options options;
+    options.minTickets = 4;
+    options.maxTickets = 64;
+    options.increment = 2;
+    options.decreaseFactor = 0.5;
+    options.minSamplesPerWindow = 10;
+    return options;
+}
+
+void recordSamples(AdaptiveConcurrencyController* controller, int count, Microseconds latency) {
+    for (int i = 0; i < count; i++) {
+        controller->recordLatency(latency);
+    }
+}
+
+TEST(AdaptiveConcurrencyControllerTest, InitialTargetIsClamped) {
+    ASSERT_EQUALS(64, AdaptiveConcurrencyController(makeOptions(), 128).getStats().targetTickets);
+    ASSERT_EQUALS(4, AdaptiveConcurrencyController(makeOptions(), 1).getStats().targetTickets);
+}
+
+TEST(AdaptiveConcurrencyControllerTest, SparseWindowsLeaveTargetUnchanged) {
+    AdaptiveConcurrencyController controller(makeOptions(), 16);
+    recordSamples(&controller, 9, Microseconds(100));
+    ASSERT_EQUALS(16, controller.endWindow(true));
+    ASSERT_EQUALS(0, controller.getStats().baselineLatencyMicros);
+}
+
+TEST(AdaptiveConcurrencyControllerTest, IncreasesAdditivelyOnlyWhenSaturated) {
+    AdaptiveConcurrencyController controller(makeOptions(), 16);
+    recordSamples(&controller, 10, Microseconds(100));
+    ASSERT_EQUALS(16, controller.endWindow(false));
+
+    recordSamples(&controller, 10, Microseconds(100));
+    ASSERT_EQUALS(18, controller.endWindow(true));
+    recordSamples(&controller, 10, Microseconds(150));
+    ASSERT_EQUALS(20, controller.endWindow(true));
+
+    auto stats = controller.getStats();
+    ASSERT_EQUALS(2, stats.increases);
+    ASSERT_EQUALS(0, stats.decreases);
+    ASSERT_EQUALS(150, stats.lastWindowLatencyMicros);
+}
+
+TEST(AdaptiveConcurrencyControllerTest, DecreasesMultiplicativelyOnLatencySpike) {
+    AdaptiveConcurrencyController controller(makeOptions(), 32);
+    recordSamples(&controller, 10, Microseconds(100));
+    controller.endWindow(false);
+
+    recordSamples(&controller, 10, Microseconds(1000));
+    ASSERT_EQUALS(16, controller.endWindow(true));
+    recordSamples(&controller, 10, Microseconds(1000));
+    ASSERT_EQUALS(8, controller.endWindow(true));
+    recordSamples(&controller, 10, Microseconds(1000));
+    ASSERT_EQUALS(4, controller.endWindow(true));
+    recordSamples(&controller, 10, Microseconds(1000));
+    ASSERT_EQUALS(4, controller.endWindow(true));
+
+    auto stats = controller.getStats();
+    ASSERT_EQUALS(3, stats.decreases);
+    ASSERT_GREATER_THAN(stats.baselineLatencyMicros, 100);
+}
+
+TEST(AdaptiveConcurrencyControllerTest, BaselineFollowsLowerLatencyImmediately) {
+    AdaptiveConcurrencyController controller(makeOptions(), 16);
+    recordSamples(&controller, 10, Microseconds(500));
+    controller.endWindow(false);
+    recordSamples(&controller, 10, Microseconds(200));
+    controller.endWindow(false);
+    ASSERT_EQUALS(200, controller.getStats().baselineLatencyMicros);
+}
+
+TEST(AdaptiveConcurrencyControllerTest, SetTargetTicketsIsClamped) {
+    AdaptiveConcurrencyController controller(makeOptions(), 16);
+    controller.setTargetTickets(1000);
+    ASSERT_EQUALS(64, controller.getStats().targetTickets);
+}
+
+}  // namespace
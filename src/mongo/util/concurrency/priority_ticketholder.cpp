@@ -0,0 +1,143 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/priority_ticketholder.h"
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+const int PriorityTicketHolder::kMaxConsecutiveHighPriorityGrants;
+
+PriorityTicketHolder::PriorityTicketHolder(int num) : _outof(num) {}
+
+PriorityTicketHolder::~PriorityTicketHolder() {
+    invariant(_normalPriorityWaiters.empty());
+    invariant(_highPriorityWaiters.empty());
+}
+
+bool PriorityTicketHolder::tryAcquire() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    if (_used >= _outof || !_normalPriorityWaiters.empty() || !_highPriorityWaiters.empty()) {
+        return false;
+    }
+    _used++;
+    return true;
+}
+
+void PriorityTicketHolder::waitForTicket(Priority priority) {
+    stdx::unique_lock<stdx::mutex> lk(_mutex);
+    if (_used < _outof && _normalPriorityWaiters.empty() && _highPriorityWaiters.empty()) {
+        _used++;
+        return;
+    }
+
+    Waiter waiter;
+    auto& queue = priority == Priority::kHigh ? _highPriorityWaiters : _normalPriorityWaiters;
+    queue.push_back(&waiter);
+    _totalQueued++;
+
+    while (!waiter.granted) {
+        waiter.condvar.wait(lk);
+    }
+}
+
+void PriorityTicketHolder::release() {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    invariant(_used > 0);
+    _used--;
+    _grantTickets_inlock();
+}
+
+Status PriorityTicketHolder::resize(int newSize) {
+    if (newSize <= 0) {
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Number of tickets must be positive; given " << newSize);
+    }
+
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    _outof = newSize;
+    _grantTickets_inlock();
+    return Status::OK();
+}
+
+int PriorityTicketHolder::available() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return std::max(_outof - _used, 0);
+}
+
+int PriorityTicketHolder::used() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _used;
+}
+
+int PriorityTicketHolder::outof() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _outof;
+}
+
+int PriorityTicketHolder::queued(Priority priority) const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return priority == Priority::kHigh ? _highPriorityWaiters.size()
+                                       : _normalPriorityWaiters.size();
+}
+
+long long PriorityTicketHolder::totalQueued() const {
+    stdx::lock_guard<stdx::mutex> lk(_mutex);
+    return _totalQueued;
+}
+
+void PriorityTicketHolder::_grantTickets_inlock() {
+    while (_used < _outof) {
+        std::deque<Waiter*>* queue;
+        if (_highPriorityWaiters.empty() ||
+            (!_normalPriorityWaiters.empty() &&
+             _consecutiveHighPriorityGrants >= kMaxConsecutiveHighPriorityGrants)) {
+            queue = &_normalPriorityWaiters;
+            _consecutiveHighPriorityGrants = 0;
+        } else {
+            queue = &_highPriorityWaiters;
+            _consecutiveHighPriorityGrants++;
+        }
+
+        if (queue->empty()) {
+            return;
+        }
+
+        Waiter* waiter = queue->front();
+        queue->pop_front();
+        _used++;
+        waiter->granted = true;
+        waiter->condvar.notify_one();
+    }
+}
+
+}  // namespace mongo
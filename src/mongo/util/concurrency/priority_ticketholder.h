@@ -0,0 +1,140 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+
+namespace mongo {
+
+/**
+ * A pool of tickets which admits waiters in FIFO order within each of two priority classes.
+ *
+ * Unlike TicketHolder, a released ticket is handed directly to the longest waiting high priority
+ * waiter, so newly arriving requests can never barge ahead of queued ones, and resize() never
+ * blocks: when shrinking below the number of tickets in use, the excess is absorbed as tickets
+ * are released.
+ *
+ * Normal priority waiters are not starved: after kMaxConsecutiveHighPriorityGrants tickets in a
+ * row have gone to high priority waiters, the next ticket goes to a normal priority waiter.
+ */
+class PriorityTicketHolder {
+    MONGO_DISALLOW_COPYING(PriorityTicketHolder);
+
+public:
+    enum class Priority { kNormal, kHigh };
+
+    static const int kMaxConsecutiveHighPriorityGrants = 8;
+
+    explicit PriorityTicketHolder(int num);
+    ~PriorityTicketHolder();
+
+    /**
+     * Acquires a ticket if one is available and nobody is waiting for one.
+     */
+    bool tryAcquire();
+
+    void waitForTicket(Priority priority = Priority::kNormal);
+
+    void release();
+
+    Status resize(int newSize);
+
+    int available() const;
+
+    int used() const;
+
+    int outof() const;
+
+    /**
+     * Returns the number of callers currently waiting for a ticket at "priority".
+     */
+    int queued(Priority priority) const;
+
+    /**
+     * Returns the total number of acquisitions which had to wait for a ticket.
+     */
+    long long totalQueued() const;
+
+private:
+    struct Waiter {
+        stdx::condition_variable condvar;
+        bool granted = false;
+    };
+
+    /**
+     * Hands out free tickets to waiters, in priority order.
+     */
+    void _grantTickets_inlock();
+
+    mutable stdx::mutex _mutex;
+    int _outof;
+    int _used = 0;
+    long long _totalQueued = 0;
+    int _consecutiveHighPriorityGrants = 0;
+
+    // Not owned. Each waiter lives on the stack of the thread waiting on it.
+    std::deque<Waiter*> _normalPriorityWaiters;
+    std::deque<Waiter*> _highPriorityWaiters;
+};
+
+class PriorityTicketHolderReleaser {
+    MONGO_DISALLOW_COPYING(PriorityTicketHolderReleaser);
+
+public:
+    PriorityTicketHolderReleaser() = default;
+
+    ~PriorityTicketHolderReleaser() {
+        reset();
+    }
+
+    bool hasTicket() const {
+        return _holder != nullptr;
+    }
+
+    PriorityTicketHolder* getHolder() const {
+        return _holder;
+    }
+
+    void reset(PriorityTicketHolder* holder = nullptr) {
+        if (_holder) {
+            _holder->release();
+        }
+        _holder = holder;
+    }
+
+private:
+    PriorityTicketHolder* _holder = nullptr;
+};
+
+}  // namespace mongo
@@ -0,0 +1,174 @@
+/**
+ *    Copyright (C) 2015 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/priority_ticketholder.h"
+#include "mongo/util/time_support.h"
+
+namespace {
+using namespace mongo;
+
+using Priority = PriorityTicketHolder::Priority;
+
+/**
+ * Starts a thread which waits for a ticket at "priority" and records its "id" in "order" once
+ * the ticket is granted. Returns once the thread is queued.
+ */
+stdx::thread startWaiter(PriorityTicketHolder* holder,
+                         Priority priority,
+                         int id,
+                         stdx::mutex* mutex,
+                         std::vector<int>* order) {
+    const int queuedBefore = holder->queued(priority);
+    stdx::thread waiter([=] {
+        holder->waitForTicket(priority);
+        stdx::lock_guard<stdx::mutex> lk(*mutex);
+        order->push_back(id);
+    });
+    while (holder->queued(priority) == queuedBefore) {
+        sleepmillis(1);
+    }
+    return waiter;
+}
+
+TEST(PriorityTicketHolderTest, AcquireAndRelease) {
+    PriorityTicketHolder holder(2);
+    ASSERT_EQUALS(2, holder.available());
+    ASSERT(holder.tryAcquire());
+    ASSERT(holder.tryAcquire());
+    ASSERT_FALSE(holder.tryAcquire());
+    ASSERT_EQUALS(0, holder.available());
+    ASSERT_EQUALS(2, holder.used());
+    holder.release();
+    ASSERT_EQUALS(1, holder.available());
+    holder.waitForTicket();
+    ASSERT_EQUALS(2, holder.used());
+    holder.release();
+    holder.release();
+    ASSERT_EQUALS(0, holder.used());
+    ASSERT_EQUALS(0, holder.totalQueued());
+}
+
+TEST(PriorityTicketHolderTest, ResizeDoesNotBlock) {
+    PriorityTicketHolder holder(4);
+    for (int i = 0; i < 4; i++) {
+        ASSERT(holder.tryAcquire());
+    }
+
+    ASSERT_OK(holder.resize(2));
+    ASSERT_EQUALS(2, holder.outof());
+    ASSERT_EQUALS(0, holder.available());
+
+    // The excess tickets are absorbed as they are released.
+    holder.release();
+    holder.release();
+    ASSERT_EQUALS(0, holder.available());
+    holder.release();
+    ASSERT_EQUALS(1, holder.available());
+    holder.release();
+
+    ASSERT_NOT_OK(holder.resize(0));
+}
+
+TEST(PriorityTicketHolderTest, WaitersAreGrantedInPriorityThenFifoOrder) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    stdx::mutex mutex;
+    std::vector<int> order;
+    std::vector<stdx::thread> waiters;
+    waiters.push_back(startWaiter(&holder, Priority::kNormal, 1, &mutex, &order));
+    waiters.push_back(startWaiter(&holder, Priority::kHigh, 2, &mutex, &order));
+    waiters.push_back(startWaiter(&holder, Priority::kNormal, 3, &mutex, &order));
+    waiters.push_back(startWaiter(&holder, Priority::kHigh, 4, &mutex, &order));
+    ASSERT_EQUALS(4, holder.totalQueued());
+
+    // New arrivals may not barge ahead of queued waiters.
+    ASSERT_FALSE(holder.tryAcquire());
+
+    for (size_t granted = 0; granted < waiters.size(); granted++) {
+        holder.release();
+        while (true) {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (order.size() == granted + 1) {
+                break;
+            }
+        }
+    }
+    holder.release();
+
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    ASSERT_EQUALS(4U, order.size());
+    ASSERT_EQUALS(2, order[0]);
+    ASSERT_EQUALS(4, order[1]);
+    ASSERT_EQUALS(1, order[2]);
+    ASSERT_EQUALS(3, order[3]);
+}
+
+TEST(PriorityTicketHolderTest, NormalPriorityIsNotStarved) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    stdx::mutex mutex;
+    std::vector<int> order;
+    std::vector<stdx::thread> waiters;
+    waiters.push_back(startWaiter(&holder, Priority::kNormal, 0, &mutex, &order));
+    const int numHighPriority = PriorityTicketHolder::kMaxConsecutiveHighPriorityGrants + 1;
+    for (int i = 1; i <= numHighPriority; i++) {
+        waiters.push_back(startWaiter(&holder, Priority::kHigh, i, &mutex, &order));
+    }
+
+    for (size_t granted = 0; granted < waiters.size(); granted++) {
+        holder.release();
+        while (true) {
+            stdx::lock_guard<stdx::mutex> lk(mutex);
+            if (order.size() == granted + 1) {
+                break;
+            }
+        }
+    }
+    holder.release();
+
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    ASSERT_EQUALS(PriorityTicketHolder::kMaxConsecutiveHighPriorityGrants,
+                  std::find(order.begin(), order.end(), 0) - order.begin());
+}
+
+}  // namespace
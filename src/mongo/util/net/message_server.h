@@ -36,10 +36,22 @@
 
 #include "mongo/platform/basic.h"
 
+#include <memory>
+
 namespace mongo {
 
 class MessageHandler {
 public:
+    /**
+     * Per-connection state established by connected(), such as the Client, which a handler
+     * detaches from the current thread between messages when connections are multiplexed over a
+     * pool of worker threads.
+     */
+    class SessionState {
+    public:
+        virtual ~SessionState() {}
+    };
+
     virtual ~MessageHandler() {}
 
     /**
@@ -52,6 +64,23 @@ public:
      * handler is responsible for responding to client
      */
     virtual void process(Message& m, AbstractMessagingPort* p) = 0;
+
+    /**
+     * Called after connected() or process() when the next message for "p" may be processed on a
+     * different thread. Returns the per-connection state detached from the current thread, which
+     * is handed back to attachSession() before that next message is processed.
+     *
+     * Also called when connected() throws, so that nothing it set up stays on the thread. In that
+     * case there may be no state to detach.
+     */
+    virtual std::unique_ptr<SessionState> detachSession(AbstractMessagingPort* p) {
+        return {};
+    }
+
+    /**
+     * Attaches state previously returned by detachSession() to the current thread.
+     */
+    virtual void attachSession(AbstractMessagingPort* p, std::unique_ptr<SessionState> state) {}
 };
 
 class MessageServer {
@@ -34,15 +34,25 @@
 #include <memory>
 #include <system_error>
 
+#ifndef _WIN32
+#include <asio.hpp>
+#endif
+
+#include "mongo/base/counter.h"
 #include "mongo/base/disallow_copying.h"
+#include "mongo/base/init.h"
 #include "mongo/config.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/server_options.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/stdx/functional.h"
+#include "mongo/stdx/memory.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/concurrency/synchronization.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/exit.h"
@@ -53,6 +63,8 @@
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/scopeguard.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
@@ -70,6 +82,49 @@ using std::endl;
 
 namespace {
 
+const char kServiceExecutorThreadPerConnection[] = "threadPerConnection";
+const char kServiceExecutorPooled[] = "pooled";
+
+}  // namespace
+
+/**
+ * Selects how accepted connections are serviced. "threadPerConnection" dedicates a thread to each
+ * connection for its lifetime. "pooled" waits for idle connections to become readable on a single
+ * poller thread and processes each incoming message on a bounded pool of worker threads.
+ */
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(serviceExecutor,
+                                      std::string,
+                                      kServiceExecutorThreadPerConnection);
+MONGO_INITIALIZER(serviceExecutor)(InitializerContext*) {
+    if (serviceExecutor != kServiceExecutorThreadPerConnection &&
+        serviceExecutor != kServiceExecutorPooled) {
+        return Status(ErrorCodes::BadValue, "unsupported service executor: " + serviceExecutor);
+    }
+    return Status::OK();
+}
+
+/**
+ * Maximum number of worker threads used by the "pooled" service executor. A value of 0 sizes the
+ * pool from the number of cores. Operations which block for a long time (such as awaitData
+ * getMores) occupy a worker for their duration, so this should stay well above the number of
+ * such operations expected to run concurrently.
+ */
+MONGO_EXPORT_STARTUP_SERVER_PARAMETER(serviceExecutorMaxThreads, int, 0);
+
+namespace {
+
+// Gauges describing the connections serviced by the "pooled" service executor.
+Counter64 sessionsIdle;
+Counter64 sessionsQueued;
+Counter64 sessionsInProgress;
+
+ServerStatusMetricField<Counter64> displaySessionsIdle("serviceExecutor.sessionsIdle",
+                                                       &sessionsIdle);
+ServerStatusMetricField<Counter64> displaySessionsQueued("serviceExecutor.sessionsQueued",
+                                                         &sessionsQueued);
+ServerStatusMetricField<Counter64> displaySessionsInProgress("serviceExecutor.sessionsInProgress",
+                                                             &sessionsInProgress);
+
 class MessagingPortWithHandler : public MessagingPort {
     MONGO_DISALLOW_COPYING(MessagingPortWithHandler);
 
@@ -90,6 +145,227 @@ private:
     MessageHandler* const _handler;
 };
 
+/**
+ * Runs "func" against the connection on "port", logging and closing the connection if it throws.
+ *
+ * Returns false if the connection was closed because of an exception.
+ */
+template <typename Func>
+bool runGuarded(MessagingPortWithHandler* port, Func&& func) {
+    try {
+        func();
+        return true;
+    } catch (AssertionException& e) {
+        log() << "AssertionException handling request, closing client connection: " << e << endl;
+    } catch (SocketException& e) {
+        log() << "SocketException handling request, closing client connection: " << e << endl;
+    } catch (const DBException& e) {  // must be right above std::exception to avoid catching
+                                      // subclasses
+        log() << "DBException handling request, closing client connection: " << e << endl;
+    } catch (std::exception& e) {
+        error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+        dbexit(EXIT_UNCAUGHT);
+    }
+    port->shutdown();
+    return false;
+}
+
+/**
+ * Receives and processes a single message from "port".
+ *
+ * Returns false if the connection was closed by the remote end.
+ */
+bool handleOneMessage(MessagingPortWithHandler* port, Message& m, int64_t* counter) {
+    m.reset();
+    port->psock->clearCounters();
+
+    if (!port->recv(m)) {
+        if (!serverGlobalParams.quiet) {
+            int conns = Listener::globalTicketHolder.used() - 1;
+            const char* word = (conns == 1 ? " connection" : " connections");
+            log() << "end connection " << port->psock->remoteString() << " (" << conns << word
+                  << " now open)" << endl;
+        }
+        port->shutdown();
+        return false;
+    }
+
+    port->getHandler()->process(m, port);
+    networkCounter.hit(port->psock->getBytesIn(), port->psock->getBytesOut());
+
+    // Occasionally we want to see if we're using too much memory.
+    if (((*counter)++ & 0xf) == 0) {
+        markThreadIdle();
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+/**
+ * Multiplexes connections over a bounded pool of worker threads.
+ *
+ * Connections waiting for their next message are registered with an asio io_service, which is
+ * run on a single poller thread and uses epoll (or the platform equivalent) to wait for
+ * readability. Once a connection becomes readable, the receipt and processing of exactly one
+ * message is scheduled on the worker pool, after which the connection is handed back to the
+ * poller. The handler's per-connection state is detached from the worker thread in between
+ * messages, so that idle connections cost neither a thread nor a stack.
+ */
+class PooledSessionDispatcher {
+    MONGO_DISALLOW_COPYING(PooledSessionDispatcher);
+
+public:
+    explicit PooledSessionDispatcher(size_t maxThreads)
+        : _work(stdx::make_unique<asio::io_service::work>(_ioService)),
+          _workers(_makePoolOptions(maxThreads)) {
+        _workers.startup();
+        _pollerThread = stdx::thread([this] {
+            setThreadName("serviceExecutorPoller");
+            _ioService.run();
+        });
+    }
+
+    ~PooledSessionDispatcher() {
+        _work.reset();
+        _ioService.stop();
+        _pollerThread.join();
+        _workers.shutdown();
+        _workers.join();
+    }
+
+    /**
+     * Takes ownership of a newly accepted connection, for which a connection ticket has already
+     * been acquired, and begins servicing it.
+     */
+    void startSession(std::unique_ptr<MessagingPortWithHandler> port) {
+        port->psock->setLogLevel(logger::LogSeverity::Debug(1));
+        auto session = std::make_shared<Session>(std::move(port), &_ioService);
+
+        // Nothing runs on a worker until the first message arrives, so connections which never
+        // send anything cannot use up the pool.
+        _waitForMessage(session);
+    }
+
+private:
+    struct Session {
+        Session(std::unique_ptr<MessagingPortWithHandler> port, asio::io_service* ioService)
+            : port(std::move(port)), descriptor(*ioService, this->port->psock->rawFD()) {}
+
+        ~Session() {
+            // The socket is owned and closed by the messaging port.
+            descriptor.release();
+        }
+
+        std::unique_ptr<MessagingPortWithHandler> port;
+        asio::posix::stream_descriptor descriptor;
+        std::unique_ptr<MessageHandler::SessionState> state;
+        bool connected = false;
+        Message message;
+        int64_t messageCount = 0;
+    };
+
+    using SessionTask = stdx::function<void(const std::shared_ptr<Session>&)>;
+
+    static ThreadPool::Options _makePoolOptions(size_t maxThreads) {
+        ThreadPool::Options options;
+        options.poolName = "serviceExecutor";
+        options.threadNamePrefix = "serviceExecutor-";
+        options.minThreads = 1;
+        options.maxThreads = maxThreads;
+        return options;
+    }
+
+    void _schedule(const std::shared_ptr<Session>& session, SessionTask task) {
+        sessionsQueued.increment();
+        Status status = _workers.schedule([session, task] {
+            sessionsQueued.decrement();
+            sessionsInProgress.increment();
+            ON_BLOCK_EXIT([] { sessionsInProgress.decrement(); });
+            task(session);
+        });
+        if (!status.isOK()) {
+            sessionsQueued.decrement();
+            log() << "failed to schedule connection " << session->port->connectionId()
+                  << " on the service executor, closing connection: " << status;
+            session->port->shutdown();
+            _endSession(session);
+        }
+    }
+
+    /**
+     * Detaches the handler's state from the current thread and waits for the next message.
+     */
+    void _suspend(const std::shared_ptr<Session>& session) {
+        session->state = session->port->getHandler()->detachSession(session->port.get());
+        _waitForMessage(session);
+    }
+
+    /**
+     * Waits on the poller thread for the connection to become readable, then schedules the
+     * processing of its next message.
+     */
+    void _waitForMessage(const std::shared_ptr<Session>& session) {
+        sessionsIdle.increment();
+        session->descriptor.async_read_some(
+            asio::null_buffers(), [this, session](std::error_code ec, size_t) {
+                sessionsIdle.decrement();
+                if (ec) {
+                    if (ec != asio::error::operation_aborted) {
+                        log() << "error waiting for a message on connection "
+                              << session->port->connectionId() << ", closing connection: "
+                              << ec.message();
+                    }
+                    session->port->shutdown();
+                    _endSession(session);
+                    return;
+                }
+                _schedule(session, [this](const std::shared_ptr<Session>& session) {
+                    _processMessage(session);
+                });
+            });
+    }
+
+    void _processMessage(const std::shared_ptr<Session>& session) {
+        MessagingPortWithHandler* port = session->port.get();
+        if (session->connected) {
+            port->getHandler()->attachSession(port, std::move(session->state));
+        } else {
+            if (!runGuarded(port, [port] { port->getHandler()->connected(port); })) {
+                // Leave nothing that connected() set up on this pooled thread.
+                port->getHandler()->detachSession(port);
+                _endSession(session);
+                return;
+            }
+            session->connected = true;
+        }
+
+        bool keepOpen = false;
+        if (runGuarded(port, [&] {
+                keepOpen = handleOneMessage(port, session->message, &session->messageCount);
+            }) &&
+            keepOpen && !inShutdown()) {
+            _suspend(session);
+            return;
+        }
+
+        // Destroys the handler's state on this thread, while it is still attached.
+        port->getHandler()->detachSession(port);
+        _endSession(session);
+    }
+
+    void _endSession(const std::shared_ptr<Session>& session) {
+        Listener::globalTicketHolder.release();
+    }
+
+    asio::io_service _ioService;
+    std::unique_ptr<asio::io_service::work> _work;
+    stdx::thread _pollerThread;
+    ThreadPool _workers;
+};
+
+#endif  // _WIN32
+
 }  // namespace
 
 class PortMessageServer : public MessageServer, public Listener {
@@ -102,7 +378,28 @@ public:
      *     and should make sure that it lives longer than this server.
      */
     PortMessageServer(const MessageServer::Options& opts, MessageHandler* handler)
-        : Listener("", opts.ipList, opts.port), _handler(handler) {}
+        : Listener("", opts.ipList, opts.port), _handler(handler) {
+        if (serviceExecutor == kServiceExecutorPooled) {
+#ifdef _WIN32
+            warning() << "the pooled service executor is not supported on this platform, "
+                      << "using a thread per connection";
+#else
+            if (sslGlobalParams.sslMode.load() != SSLParams::SSLMode_disabled) {
+                // Data already decrypted into the SSL buffers would not wake the poller.
+                warning() << "the pooled service executor is not supported with SSL, "
+                          << "using a thread per connection";
+            } else {
+                size_t maxThreads = serviceExecutorMaxThreads;
+                if (maxThreads == 0) {
+                    maxThreads = std::max(16u, 4 * ProcessInfo().getNumCores());
+                }
+                log() << "servicing connections on a pool of up to " << maxThreads
+                      << " worker threads";
+                _dispatcher = stdx::make_unique<PooledSessionDispatcher>(maxThreads);
+            }
+#endif
+        }
+    }
 
     virtual void accepted(std::shared_ptr<Socket> psocket, long long connectionId) {
         ScopeGuard sleepAfterClosingPort = MakeGuard(sleepmillis, 2);
@@ -115,6 +412,14 @@ public:
             return;
         }
 
+#ifndef _WIN32
+        if (_dispatcher) {
+            _dispatcher->startSession(std::move(portWithHandler));
+            sleepAfterClosingPort.Dismiss();
+            return;
+        }
+#endif
+
         try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
             {
@@ -183,6 +488,11 @@ public:
 private:
     MessageHandler* _handler;
 
+#ifndef _WIN32
+    // Only set when connections are serviced by the "pooled" service executor.
+    std::unique_ptr<PooledSessionDispatcher> _dispatcher;
+#endif
+
     /**
      * Handles incoming messages from a given socket.
      *
@@ -208,47 +518,12 @@ private:
 
         Message m;
         int64_t counter = 0;
-        try {
-            handler->connected(portWithHandler.get());
-
-            while (!inShutdown()) {
-                m.reset();
-                portWithHandler->psock->clearCounters();
-
-                if (!portWithHandler->recv(m)) {
-                    if (!serverGlobalParams.quiet) {
-                        int conns = Listener::globalTicketHolder.used() - 1;
-                        const char* word = (conns == 1 ? " connection" : " connections");
-                        log() << "end connection " << portWithHandler->psock->remoteString() << " ("
-                              << conns << word << " now open)" << endl;
-                    }
-                    portWithHandler->shutdown();
-                    break;
-                }
-
-                handler->process(m, portWithHandler.get());
-                networkCounter.hit(portWithHandler->psock->getBytesIn(),
-                                   portWithHandler->psock->getBytesOut());
-
-                // Occasionally we want to see if we're using too much memory.
-                if ((counter++ & 0xf) == 0) {
-                    markThreadIdle();
-                }
+        MessagingPortWithHandler* const port = portWithHandler.get();
+        if (runGuarded(port, [port, handler] { handler->connected(port); })) {
+            bool keepOpen = true;
+            while (keepOpen && !inShutdown() &&
+                   runGuarded(port, [&] { keepOpen = handleOneMessage(port, m, &counter); })) {
             }
-        } catch (AssertionException& e) {
-            log() << "AssertionException handling request, closing client connection: " << e
-                  << endl;
-            portWithHandler->shutdown();
-        } catch (SocketException& e) {
-            log() << "SocketException handling request, closing client connection: " << e << endl;
-            portWithHandler->shutdown();
-        } catch (const DBException&
-                     e) {  // must be right above std::exception to avoid catching subclasses
-            log() << "DBException handling request, closing client connection: " << e << endl;
-            portWithHandler->shutdown();
-        } catch (std::exception& e) {
-            error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
-            dbexit(EXIT_UNCAUGHT);
         }
 
 // Normal disconnect path.
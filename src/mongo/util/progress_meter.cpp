@@ -48,10 +48,16 @@ void ProgressMeter::reset(unsigned long long total, int secondsBetween, int chec
     _done = 0;
     _hits = 0;
     _lastTime = (int)time(0);
+    _timer.reset();
 
     _active = 1;
 }
 
+double ProgressMeter::ratePerSecond() const {
+    const long long micros = _timer.micros();
+    return micros > 0 ? _done * 1000000.0 / micros : 0;
+}
+
 
 bool ProgressMeter::hit(int n) {
     if (!_active) {
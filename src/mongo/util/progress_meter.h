@@ -30,6 +30,7 @@
 #pragma once
 
 #include "mongo/util/thread_safe_string.h"
+#include "mongo/util/timer.h"
 
 #include <string>
 
@@ -95,6 +96,11 @@ public:
         return _hits;
     }
 
+    /**
+     * Returns the average number of units done per second since the meter was last reset.
+     */
+    double ratePerSecond() const;
+
     unsigned long long total() const {
         return _total;
     }
@@ -120,6 +126,7 @@ private:
     unsigned long long _done;
     unsigned long long _hits;
     int _lastTime;
+    Timer _timer;
 
     std::string _units;
     ThreadSafeString _name;